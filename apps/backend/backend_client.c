@@ -72,22 +72,152 @@
 #include "backend_client.h"
 #include "backend_handle.h"
 
-/*! Find client by session-id 
+/*! Find client by session-id
+ * A session may have several clients, ie connections, eg for asynchronous rpcs, see
+ * clicon_rpc_async
  * @param[in] ce_list   List of clients
  * @param[in] id        Session id
+ * @param[in] except    Skip this client, or NULL
  */
 static struct client_entry *
 ce_find_byid(struct client_entry *ce_list,
-	     uint32_t            id)
+	     uint32_t             id,
+	     struct client_entry *except)
 {
     struct client_entry *ce;
 
     for (ce = ce_list; ce; ce = ce->ce_next)
-	if (ce->ce_id == id)
+	if (ce->ce_id == id && ce != except)
 	    return ce;
     return NULL;
 }
 
+static int from_client_flush(int s, void *arg);
+
+/*! Discard the reply of a client, and the rest of it not yet written
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ */
+int
+backend_client_reply_reset(struct client_entry *ce)
+{
+    if (ce->ce_stream){
+	clicon_msg_stream_free(ce->ce_stream);
+	ce->ce_stream = NULL;
+    }
+    if (ce->ce_reply){
+	xml_free(ce->ce_reply);
+	ce->ce_reply = NULL;
+    }
+    return 0;
+}
+
+/*! Write queued replies and notifications to a client without blocking
+ * If the socket does not accept all data, stop reading requests from the client
+ * and write the rest when the socket is writable, see from_client_flush.
+ * A large reply is queued in parts of CLICON_MSG_SND_HIWAT, the next part when the
+ * previous is written, so that other clients are served meanwhile.
+ * If the client has closed the socket, queued data is discarded.
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_flush(struct client_entry *ce)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    int                ret;
+
+    if ((ret = clicon_msg_flush(ce->ce_s, &ce->ce_snd)) == 1 &&
+	ce->ce_stream != NULL){
+	/* Send buffer is written, queue next part of reply */
+	if ((ret = clicon_msg_stream_write(ce->ce_s, &ce->ce_snd, ce->ce_stream)) == 1){
+	    backend_client_reply_reset(ce);
+	    /* Queue notifications received while the reply was written */
+	    while ((ret = clicon_msg_buf_get(&ce->ce_ntf, &msg)) == 1){
+		if (clicon_msg_buf_put(&ce->ce_snd, msg) < 0)
+		    goto done;
+		free(msg);
+		msg = NULL;
+	    }
+	    if (ret < 0)
+		goto done;
+	}
+	if (ret >= 0)
+	    ret = clicon_msg_flush(ce->ce_s, &ce->ce_snd);
+    }
+    if (ret < 0){
+	switch (errno){
+	case EPIPE:      /* see from_client_msg */
+	case ECONNRESET:
+	    clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	    clicon_msg_buf_reset(&ce->ce_snd);
+	    clicon_msg_buf_reset(&ce->ce_ntf);
+	    backend_client_reply_reset(ce);
+	    ret = 1;
+	    break;
+	default:
+	    goto done;
+	}
+    }
+    /* Also wait for writable socket if a part of the reply remains */
+    if ((ret == 0 || ce->ce_stream != NULL) && !ce->ce_blocked){
+	clicon_debug(1, "%s client %d blocked", __FUNCTION__, ce->ce_nr);
+	clixon_event_unreg_fd(ce->ce_s, from_client);
+	if (clixon_event_reg_fd_out(ce->ce_s, from_client_flush, (void*)ce, "local netconf client output") < 0)
+	    goto done;
+	ce->ce_blocked = 1;
+    }
+    else if (ret == 1 && ce->ce_stream == NULL && ce->ce_blocked){
+	clicon_debug(1, "%s client %d unblocked", __FUNCTION__, ce->ce_nr);
+	clixon_event_unreg_fd_out(ce->ce_s, from_client_flush);
+	if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0)
+	    goto done;
+	ce->ce_blocked = 0;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    return retval;
+}
+
+/*! Queue a notification while a reply is written in parts
+ * It is not written in the middle of the reply, but moved to the send buffer when the
+ * reply is done, see ce_flush
+ * @param[in]  ce     Client entry
+ * @param[in]  event  Event as XML
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+ce_notify_defer(struct client_entry *ce,
+		cxobj               *event)
+{
+    int                retval = -1;
+    cbuf              *cb = NULL;
+    struct clicon_msg *msg = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cb, event, 0, 0, -1) < 0)
+	goto done;
+    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+	goto done;
+    if (clicon_msg_buf_put(&ce->ce_ntf, msg) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Stream callback for netconf stream notification (RFC 5277)
  * @param[in]  h     Clicon handle
  * @param[in]  op    0:event, 1:rm
@@ -101,8 +231,9 @@ ce_event_cb(clicon_handle h,
 	    cxobj        *event,
 	    void         *arg)
 {
-    struct client_entry *ce = (struct client_entry *)arg;
-    
+    struct client_entry   *ce = (struct client_entry *)arg;
+    struct clicon_msg_buf *mb;
+
     clicon_debug(1, "%s op:%d", __FUNCTION__, op);
     switch (op){
     case 1:
@@ -111,12 +242,32 @@ ce_event_cb(clicon_handle h,
 	    backend_client_rm(h, ce);
 	break;
     default:
-	if (send_msg_notify_xml(h, ce->ce_s, event) < 0){
+	/* Subscriber does not read: do not queue more, disconnect it instead.
+	 * It is removed when the closed socket is read, see from_client */
+	mb = ce->ce_stream ? &ce->ce_ntf : &ce->ce_snd;
+	if (clicon_msg_buf_len(mb) > CLICON_MSG_SND_HIWAT){
+	    clicon_log(LOG_WARNING, "client %d: %zu bytes of notifications not read, disconnecting",
+		       ce->ce_nr, clicon_msg_buf_len(mb));
+	    clicon_msg_buf_reset(&ce->ce_snd);
+	    clicon_msg_buf_reset(&ce->ce_ntf);
+	    backend_client_reply_reset(ce);
+	    shutdown(ce->ce_s, SHUT_RDWR);
+	    break;
+	}
+	if (ce->ce_stream){
+	    if (ce_notify_defer(ce, event) < 0)
+		return -1;
+	    break;
+	}
+	if (send_msg_notify_xml(h, ce->ce_s, &ce->ce_snd, event) < 0){
 	    if (errno == ECONNRESET || errno == EPIPE){
 		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+		clicon_msg_buf_reset(&ce->ce_snd);
 	    }
 	    break;
 	}
+	if (ce_flush(ce) < 0)
+	    return -1;
     }
     return 0;
 }
@@ -144,10 +295,15 @@ backend_client_rm(clicon_handle        h,
     for (c = *ce_prev; c; c = c->ce_next){
 	if (c == ce){
 	    if (ce->ce_s){
-		clixon_event_unreg_fd(ce->ce_s, from_client);
+		if (ce->ce_blocked)
+		    clixon_event_unreg_fd_out(ce->ce_s, from_client_flush);
+		else
+		    clixon_event_unreg_fd(ce->ce_s, from_client);
 		close(ce->ce_s);
 		ce->ce_s = 0;
-		xmldb_unlock_all(h, ce->ce_id);
+		/* Locks are released with the last connection of the session */
+		if (ce_find_byid(c0, ce->ce_id, ce) == NULL)
+		    xmldb_unlock_all(h, ce->ce_id);
 	    }
 	    break;
 	}
@@ -391,6 +547,74 @@ client_statedata(clicon_handle h,
     goto done;
 }
 
+/*! Reply with data from a get or get-config request
+ * 
+ * The reply tree is kept in the client entry and sent by from_client_msg, binary
+ * encoded if the request was, otherwise streamed as XML text.
+ * Without client entry, or if an earlier operation of the same rpc already wrote a
+ * reply in cbret, the reply is printed as XML text in cbret.
+ * @param[in]     ce      Client entry, or NULL
+ * @param[in,out] xretp   Data tree, renamed to <data>. Consumed if ce is set (set to NULL)
+ * @param[in]     depth   Nr of levels to print, -1 is all, 0 is none
+ * @param[out]    cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+client_get_reply(struct client_entry *ce,
+		 cxobj              **xretp,
+		 int32_t              depth,
+		 cbuf                *cbret)
+{
+    int    retval = -1;
+    cxobj *xret = *xretp;
+    cxobj *xr = NULL;
+    cxobj *xa;
+
+    if (xret != NULL &&
+	xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+	goto done;
+    if (ce != NULL && cbuf_len(cbret) == 0){
+	if ((xr = xml_new("rpc-reply", NULL, CX_ELMNT)) == NULL)
+	    goto done;
+	if ((xa = xml_new("xmlns", xr, CX_ATTR)) == NULL)
+	    goto done;
+	if (xml_value_set(xa, NETCONF_BASE_NAMESPACE) < 0)
+	    goto done;
+	if (xret == NULL){
+	    if (xml_new(NETCONF_OUTPUT_DATA, xr, CX_ELMNT) == NULL)
+		goto done;
+	}
+	else{
+	    if (xml_addsub(xr, xret) < 0)
+		goto done;
+	    *xretp = NULL;
+	}
+	/* Top level is rpc-reply and data, adjust depth if significant */
+	ce->ce_depth = depth<0?depth:(depth==0?1:depth+2);
+	if (ce->ce_reply)
+	    xml_free(ce->ce_reply);
+	ce->ce_reply = xr;
+	xr = NULL;
+	goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (xret==NULL)
+	cprintf(cbret, "<data/>");
+    else{
+	/* Top level is data, so add 1 to depth if significant */
+	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
+	    goto done;
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (xr)
+	xml_free(xr);
+    return retval;
+}
+
 /*! Retrieve all or part of a specified configuration.
  * 
  * Function reused from both from_client_get() and from_client_get_config
@@ -400,6 +624,7 @@ client_statedata(clicon_handle h,
  * @param[in]  username
  * @param[in]  content
  * @param[in]  depth
+ * @param[in]  ce      Client entry
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
  * @retval     0       OK
  * @retval    -1       Error
@@ -413,6 +638,7 @@ client_get_config_only(clicon_handle h,
 		       char         *xpath,
 		       char         *username,
 		       int32_t       depth,
+		       struct client_entry *ce,
 		       cbuf         *cbret)
 {
     int     retval = -1;
@@ -446,16 +672,8 @@ client_get_config_only(clicon_handle h,
 	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
-    if (xret==NULL)
-	cprintf(cbret, "<data/>");
-    else{
-	if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
-	    goto done;
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
-	    goto done;
-    }
-    cprintf(cbret, "</rpc-reply>");
+    if (client_get_reply(ce, &xret, depth, cbret) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -499,6 +717,7 @@ from_client_get_config(clicon_handle h,
     char      *attr;
     char      *xpath0;
     cvec      *nsc1 = NULL;
+    struct client_entry *ce = (struct client_entry *)arg;
     
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -550,7 +769,7 @@ from_client_get_config(clicon_handle h,
 	    goto ok;
 	}
     }
-    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, cbret)) < 0)
+    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, ce, cbret)) < 0)
 	goto done;
  ok:
     retval = 0;
@@ -1077,6 +1296,7 @@ from_client_get(clicon_handle h,
     cxobj          *xerr = NULL;
     int             ret;
     char           *reason = NULL;
+    struct client_entry *ce = (struct client_entry *)arg;
     
     clicon_debug(1, "%s", __FUNCTION__);
     username = clicon_username_get(h);
@@ -1119,7 +1339,7 @@ from_client_get(clicon_handle h,
 	}
     }
     if (content == CONTENT_CONFIG){ /* config only, no state */
-	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, cbret) < 0)
+	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, ce, cbret) < 0)
 	    goto done;
 	goto ok;
     }
@@ -1223,17 +1443,8 @@ from_client_get(clicon_handle h,
 	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
-    if (xret==NULL)
-	cprintf(cbret, "<data/>");
-    else{
-	if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
-	    goto done;
-	/* Top level is data, so add 1 to depth if significant */
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
-	    goto done;
-    }
-    cprintf(cbret, "</rpc-reply>");
+    if (client_get_reply(ce, &xret, depth, cbret) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -1296,6 +1507,7 @@ from_client_kill_session(clicon_handle h,
 			 void         *regarg)
 {
     int                  retval = -1;
+    struct client_entry *ce0 = (struct client_entry *)arg;
     uint32_t             id; /* session id */
     char                *str;
     struct client_entry *ce;
@@ -1319,10 +1531,12 @@ from_client_kill_session(clicon_handle h,
 	    goto done;
 	goto done;
     }
-    /* may or may not be in active client list, probably not */
-    if ((ce = ce_find_byid(backend_client_list(h), id)) != NULL){
+    /* may or may not be in active client list, probably not
+     * Remove all clients of the session, except the one making this request */
+    if (ce_find_byid(backend_client_list(h), id, ce0) != NULL){
 	xmldb_unlock_all(h, id);  /* Removes locks on all databases */
-	backend_client_rm(h, ce); /* Removes client struct */
+	while ((ce = ce_find_byid(backend_client_list(h), id, ce0)) != NULL)
+	    backend_client_rm(h, ce); /* Removes client struct */
     }
     if (xmldb_islocked(h, db) == id)
 	xmldb_unlock(h, db);
@@ -1509,17 +1723,27 @@ from_client_stats(clicon_handle h,
 {
     int      retval = -1;
     uint64_t nr;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t entries;
     
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
     nr=0;
     xml_stats_global(&nr);
-    cprintf(cbret, "<global><xmlnr>%" PRIu64 "</xmlnr></global>", nr);
+    xpath_cache_stats(&hits, &misses, &entries);
+    cprintf(cbret, "<global><xmlnr>%" PRIu64 "</xmlnr>", nr);
+    cprintf(cbret, "<xpath-cache-hits>%" PRIu64 "</xpath-cache-hits>", hits);
+    cprintf(cbret, "<xpath-cache-misses>%" PRIu64 "</xpath-cache-misses>", misses);
+    cprintf(cbret, "<xpath-cache-entries>%" PRIu64 "</xpath-cache-entries>", entries);
+    cprintf(cbret, "</global>");
     if (clixon_stats_get_db(h, "running", cbret) < 0)
 	goto done;
     if (clixon_stats_get_db(h, "candidate", cbret) < 0)
 	goto done;
     if (clixon_stats_get_db(h, "startup", cbret) < 0)
 	goto done;
+    if (rpc_callback_stats(h, cbret) < 0)
+	goto done;
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
@@ -1690,6 +1914,8 @@ from_client_msg(clicon_handle        h,
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
     }
+    /* Reply using the same encoding as the request */
+    ce->ce_bin = clicon_msg_binary(msg);
     /* Decode msg from client -> xml top (ct) and session id */
     if ((ret = clicon_msg_decode(msg, yspec, &id, &xt, &xret)) < 0){
 	if (netconf_malformed_message(cbret, "XML parse error") < 0)
@@ -1768,6 +1994,14 @@ from_client_msg(clicon_handle        h,
     /* May be used by callbacks, etc */
     clicon_username_set(h, username);
     while ((xe = xml_child_each(x, xe, CX_ELMNT)) != NULL) {
+	/* Print the get reply of an earlier operation first, so that replies of
+	 * several operations are sent in order */
+	if (ce->ce_reply != NULL){
+	    if (clicon_xml2cbuf(cbret, ce->ce_reply, 0, 0, ce->ce_depth) < 0)
+		goto done;
+	    xml_free(ce->ce_reply);
+	    ce->ce_reply = NULL;
+	}
 	rpc = xml_name(xe);
 	if ((ye = xml_spec(xe)) == NULL){
 	    if (netconf_operation_not_supported(cbret, "protocol", rpc) < 0)
@@ -1826,13 +2060,33 @@ from_client_msg(clicon_handle        h,
 	}
     } /* while */
  reply:
-    if (cbuf_len(cbret) == 0)
-	if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
-	    goto done;
-    clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
-    /* XXX problem here is that cbret has not been parsed so may contain 
-       parse errors */
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+    if (ce->ce_reply != NULL && cbuf_len(cbret) == 0){
+	/* Parts of a large reply above CLICON_MSG_SND_HIWAT are left in ce_stream,
+	 * and queued by ce_flush when the client has read the previous part */
+	if (ce->ce_bin){
+	    clicon_debug(1, "%s binary reply", __FUNCTION__);
+	    ret = send_msg_reply_xml(ce->ce_s, &ce->ce_snd, ce->ce_reply, ce->ce_depth,
+				     &ce->ce_stream);
+	}
+	else{
+	    clicon_debug(1, "%s streamed reply", __FUNCTION__);
+	    ret = send_msg_reply_stream(ce->ce_s, &ce->ce_snd, ce->ce_reply, ce->ce_depth,
+					&ce->ce_stream);
+	}
+    }
+    else {
+	if (cbuf_len(cbret) == 0)
+	    if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
+		goto done;
+	clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
+	/* XXX problem here is that cbret has not been parsed so may contain 
+	   parse errors */
+	ret = send_msg_reply(ce->ce_s, &ce->ce_snd, cbuf_get(cbret), cbuf_len(cbret)+1);
+    }
+    /* Reply is queued in ce_snd, write what the socket accepts now */
+    if (ret == 0)
+	ret = ce_flush(ce);
+    if (ret < 0){
 	switch (errno){
 	case EPIPE:
 	    /* man (2) write: 
@@ -1844,6 +2098,8 @@ from_client_msg(clicon_handle        h,
 	     */
 	case ECONNRESET:
 	    clicon_log(LOG_WARNING, "client rpc reset");
+	    clicon_msg_buf_reset(&ce->ce_snd);
+	    backend_client_reply_reset(ce);
 	    break;
 	default:
 	    goto done;
@@ -1858,6 +2114,11 @@ from_client_msg(clicon_handle        h,
 	if (clicon_nacm_cache_set(h, NULL) < 0)
 	    goto done;
     }
+    /* A text reply in ce_stream is printed from ce_reply, which is freed when done */
+    if (ce->ce_reply && (ce->ce_stream == NULL || ce->ce_bin)){
+	xml_free(ce->ce_reply);
+	ce->ce_reply = NULL;
+    }
     if (xret)
 	xml_free(xret);
     if (xt)
@@ -1872,7 +2133,47 @@ from_client_msg(clicon_handle        h,
     return retval;// -1 here terminates backend
 }
 
-/*! An internal clicon message has arrived from a client. Receive and dispatch.
+/*! Dispatch complete messages received from a client
+ * Stop when a reply cannot be written without blocking. The remaining messages are
+ * dispatched when the reply is written, see from_client_flush.
+ * A client sending a malformed message is removed.
+ * @param[in]   h    Clicon handle
+ * @param[in]   ce   Client entry
+ * @retval      0    OK, ce may be removed
+ * @retval      -1   Error
+ */
+static int
+from_client_dispatch(clicon_handle        h,
+		     struct client_entry *ce)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    int                ret;
+
+    while (!ce->ce_blocked){
+	if ((ret = clicon_msg_buf_get(&ce->ce_rcv, &msg)) < 0){
+	    clicon_log(LOG_WARNING, "client %d: %s", ce->ce_nr, clicon_err_reason);
+	    clicon_err_reset();
+	    backend_client_rm(h, ce);
+	    break;
+	}
+	if (ret == 0)
+	    break;
+	if (from_client_msg(h, ce, msg) < 0)
+	    goto done;
+	free(msg);
+	msg = NULL;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    return retval;
+}
+
+/*! Input from a client has arrived. Receive and dispatch complete messages.
+ * Reads what is available on the socket without blocking. Partially received
+ * messages are kept in the client entry until complete.
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
@@ -1884,28 +2185,51 @@ from_client(int   s,
 	    void* arg)
 {
     int                  retval = -1;
-    struct clicon_msg   *msg = NULL;
     struct client_entry *ce = (struct client_entry *)arg;
     clicon_handle        h = ce->ce_handle;
     int                  eof = 0;
 
     clicon_debug(1, "%s", __FUNCTION__);
     // assert(s == ce->ce_s);
-    if (clicon_msg_rcv(ce->ce_s, &msg, &eof) < 0)
+    if (clicon_msg_rcv_nb(ce->ce_s, &ce->ce_rcv, &eof) < 0)
 	goto done;
     if (eof)
 	backend_client_rm(h, ce); 
     else
-	if (from_client_msg(h, ce, msg) < 0)
+	if (from_client_dispatch(h, ce) < 0)
 	    goto done;
     retval = 0;
   done:
     clicon_debug(1, "%s retval=%d", __FUNCTION__, retval);
-    if (msg)
-	free(msg);
     return retval; /* -1 here terminates backend */
 }
 
+/*! A client socket with queued output is writable. Write and resume input if done.
+ * @param[in]   s    Client socket
+ * @param[in]   arg  Client entry
+ * @retval      0    OK
+ * @retval      -1   Error
+ * @see ce_flush
+ */
+static int
+from_client_flush(int   s, 
+		  void* arg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if (ce_flush(ce) < 0)
+	goto done;
+    /* Dispatch messages received while blocked */
+    if (!ce->ce_blocked &&
+	from_client_dispatch(ce->ce_handle, ce) < 0)
+	goto done;
+    retval = 0;
+  done:
+    return retval;
+}
+
 /*! Init backend rpc: Set up standard netconf rpc callbacks
  * @param[in]  h     Clicon handle
  * @retval       -1       Error (fatal)
@@ -54,12 +54,21 @@ struct client_entry{
     int                   ce_id;      /* Session id */
     char                 *ce_username;/* Translated from peer user cred */
     clicon_handle         ce_handle;  /* clicon config handle (all clients have same?) */
+    int                   ce_bin;     /* Current request is binary encoded, reply likewise */
+    cxobj                *ce_reply;   /* Get reply tree of current request, or NULL */
+    int32_t               ce_depth;   /* Depth of ce_reply, -1 is all */
+    clicon_msg_stream    *ce_stream;  /* Rest of reply not yet in ce_snd, or NULL */
+    struct clicon_msg_buf ce_rcv;     /* Partially received requests from client */
+    struct clicon_msg_buf ce_snd;     /* Replies and notifications not yet written */
+    struct clicon_msg_buf ce_ntf;     /* Notifications received during ce_stream */
+    int                   ce_blocked; /* Input paused until ce_snd and ce_stream are written */
 };
 
 /*
  * Prototypes
  */ 
 int backend_client_rm(clicon_handle h, struct client_entry *ce);
+int backend_client_reply_reset(struct client_entry *ce);
 int from_client(int fd, void *arg);
 int backend_rpc_init(clicon_handle h);
 
@@ -102,8 +102,16 @@ generic_validate(clicon_handle       h,
     cbuf      *cb = NULL;
     yang_stmt *yp;
 
-    /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
+    /* All entries, or only those that may be affected by changes from a valid source */
+    if (td->td_src != NULL && clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL")){
+	if ((ret = xml_yang_validate_changed(h, td->td_target,
+					     td->td_avec, td->td_alen,
+					     td->td_dvec, td->td_dlen,
+					     td->td_tcvec, td->td_clen,
+					     xret)) < 0) 
+	    goto done;
+    }
+    else if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
 	goto done;
     if (ret == 0)
 	goto fail;
@@ -518,7 +526,11 @@ validate_common(clicon_handle       h,
     /* Clear flags xpath for get */
     xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
 	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
-    /* 3. Compute differences */
+    /* 3. Compute differences 
+     * If db only differs from running in subtrees edited since it was copied, 
+     * only compare those */
+    if (xmldb_dirtymark_get(h, db))
+	xml_flag_set(td->td_target, XML_FLAG_DIFFDIRTY);
     if (xml_diff(yspec, 
 		 td->td_src,
 		 td->td_target,
@@ -530,6 +542,7 @@ validate_common(clicon_handle       h,
 		 &td->td_tcvec,     /* changed: wanted values */
 		 &td->td_clen) < 0)
 	goto done;
+    xml_flag_reset(td->td_target, XML_FLAG_DIFFDIRTY);
     if (clicon_debug_get()>1)
 	transaction_print(stderr, td);
     /* Mark as changed in tree */
@@ -659,6 +672,7 @@ candidate_commit(clicon_handle h,
     transaction_data_t *td = NULL;
     int                 ret;
     cxobj              *xret = NULL;
+    int                 moved = 0; /* target tree moved to running cache */
 
      /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
@@ -689,8 +703,17 @@ candidate_commit(clicon_handle h,
 	 goto done;
 
      /* 8. Success: Copy candidate to running 
+      * With datastore cache, the target tree already is a copy of candidate and is 
+      * used as running cache instead of copying the candidate cache once more.
+      * It is installed after the end callbacks, since it still has default values
+      * that the callbacks may refer to. Until then running is read from file.
       */
-     if (xmldb_copy(h, db, "running") < 0)
+     if (clicon_datastore_cache(h) == DATASTORE_CACHE){
+	 if (xmldb_copy_tree(h, db, "running", NULL) < 0)
+	     goto done;
+	 moved++;
+     }
+     else if (xmldb_copy(h, db, "running") < 0)
 	 goto done;
      xmldb_modified_set(h, db, 0); /* reset dirty bit */
      /* Here pointers to old (source) tree are obsolete */
@@ -706,7 +729,14 @@ candidate_commit(clicon_handle h,
 
     /* 9. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
-    
+    if (moved){
+	/* Clear target tree from default values and install it as running cache */
+	if (xml_tree_prune_flagged(td->td_target, XML_FLAG_DEFAULT, 1) < 0)
+	    goto done;
+	if (xmldb_cache_set(h, "running", td->td_target) < 0)
+	    goto done;
+	td->td_target = NULL;
+    }
     retval = 1;
  done:
      /* In case of failure (or error), call plugin transaction termination callbacks */
@@ -131,6 +131,7 @@ backend_terminate(clicon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_cache_exit();
 
     if (pidfile)
 	unlink(pidfile);   
@@ -257,6 +258,15 @@ xmldb_drop_priv(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "chown");
 	goto done;
     }
+    free(filename);
+    filename = NULL;
+    /* Journal of edits, if any, see CLICON_XMLDB_JOURNAL */
+    if (xmldb_db2journal(h, db, &filename) < 0)
+	goto done;
+    if (chown(filename, uid, gid) < 0 && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "chown");
+	goto done;
+    }
     retval = 0;
  done:
     if (filename)
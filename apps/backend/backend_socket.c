@@ -287,6 +287,11 @@ backend_accept_client(int   fd,
 	break;
     }
     ce->ce_s = s;
+    /* Messages are received and replies written without blocking, see from_client */
+    if (fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
 
     /*
      * Here we register callbacks for actual data socket 
@@ -180,6 +180,10 @@ backend_client_delete(clicon_handle        h,
 	    *ce_prev = c->ce_next;
 	    if (ce->ce_username)
 		free(ce->ce_username);
+	    clicon_msg_buf_reset(&ce->ce_rcv);
+	    clicon_msg_buf_reset(&ce->ce_snd);
+	    clicon_msg_buf_reset(&ce->ce_ntf);
+	    backend_client_reply_reset(ce);
 	    free(ce);
 	    break;
 	}
@@ -178,6 +178,7 @@ cli_terminate(clicon_handle h)
 	xml_free(x);
     clicon_data_cvec_del(h, "cli-edit-cvv");;
     xpath_optimize_exit();
+    xpath_cache_exit();
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
     /* Delete CLI syntax et al */
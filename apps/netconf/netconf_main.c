@@ -81,6 +81,15 @@
  */
 #define NETCONF_HASH_BUF "netconf_input_cbuf"
 
+/* clixon-data value to save end-of-frame detection state between invocations.
+ * Necessary if the end-of-frame marker is split, such as: <foo/>]]> ..wait.. ]]>
+ */
+#define NETCONF_HASH_STATE "netconf_input_state"
+
+/* Frame buffers larger than this are freed after the frame is processed, so that
+ * memory of a large request is not kept for the rest of the session */
+#define NETCONF_FRAME_BUFLEN (1024*1024)
+
 /*! Ignore errors on packet errors: continue */
 static int ignore_packet_errors = 1;
 
@@ -357,7 +366,7 @@ netconf_input_frame(clicon_handle h,
 		    cbuf         *cb)
 {
     int        retval = -1;
-    char      *str = NULL;
+    char      *str;
     cxobj     *xtop = NULL; /* Request (in) */
     cxobj     *xreq = NULL;
     cxobj     *xret = NULL; /* Return (out) */
@@ -368,12 +377,10 @@ netconf_input_frame(clicon_handle h,
     clicon_debug(1, "%s", __FUNCTION__);
     clicon_debug(2, "%s: \"%s\"", __FUNCTION__, cbuf_get(cb));
     yspec = clicon_dbspec_yang(h);
-    if ((str = strdup(cbuf_get(cb))) == NULL){
-	clicon_err(OE_UNIX, errno, "strdup");
-	goto done;
-    }
+    /* Parse directly from frame buffer, do not copy */
+    str = cbuf_get(cb);
     /* Special case:  */
-    if (strlen(str) == 0){
+    if (*str == '\0'){
 	if ((cbret = cbuf_new()) == NULL){ 
 	    clicon_err(OE_UNIX, errno, "cbuf_new");
 	    goto done;
@@ -436,8 +443,6 @@ netconf_input_frame(clicon_handle h,
  ok:
     retval = 0;
  done:
-    if (str)
-	free(str);
     if (xtop)
 	xml_free(xtop);
     if (xret)
@@ -453,6 +458,8 @@ netconf_input_frame(clicon_handle h,
  * This routine continuously reads until no more data on s. There could
  * be risk of starvation, but the netconf client does little else than
  * read data so I do not see a danger of true starvation here.
+ * Data is scanned for end-of-frame as it arrives and appended to the frame buffer
+ * in segments, not byte by byte.
  * @note data is saved in clicon-handle at NETCONF_HASH_BUF since there is a potential issue if data
  * is not completely present on the s, ie if eg:
  *   <a>foo ..pause.. </a>]]>]]>
@@ -467,6 +474,8 @@ netconf_input_cb(int   s,
     unsigned char buf[BUFSIZ]; /* from stdio.h, typically 8K */
     int           i;
     int           len;
+    int           start;      /* Start of segment in buf not yet in cb */
+    unsigned char c;
     cbuf         *cb=NULL;
     int           xml_state = 0;
     int           poll;
@@ -482,6 +491,10 @@ netconf_input_cb(int   s,
 	}
 	cb = *(cbuf**)ptr;
 	clicon_hash_del(cdat, NETCONF_HASH_BUF);
+	if ((ptr = clicon_hash_value(cdat, NETCONF_HASH_STATE, &cdatlen)) != NULL){
+	    xml_state = *(int*)ptr;
+	    clicon_hash_del(cdat, NETCONF_HASH_STATE);
+	}
     }
     else{
 	if ((cb = cbuf_new()) == NULL){
@@ -489,9 +502,9 @@ netconf_input_cb(int   s,
 	    goto done;
 	}
     }
-    memset(buf, 0, sizeof(buf));
     while (1){
-	if ((len = read(s, buf, sizeof(buf))) < 0){
+	/* Leave room for null-termination of segments */
+	if ((len = read(s, buf, sizeof(buf)-1)) < 0){
 	    if (errno == ECONNRESET)
 		len = 0; /* emulate EOF */
 	    else{
@@ -505,14 +518,31 @@ netconf_input_cb(int   s,
 	    retval = 0;
 	    goto done;
 	}
+	buf[len] = '\0';
+	start = 0;
 	for (i=0; i<len; i++){
-	    if (buf[i] == 0)
-		continue; /* Skip NULL chars (eg from terminals) */
-	    cprintf(cb, "%c", buf[i]);
+	    if (buf[i] == 0){
+		/* Skip NULL chars (eg from terminals): append segment before it */
+		if (cbuf_append_str(cb, (char*)buf+start) < 0){
+		    clicon_err(OE_UNIX, errno, "cbuf_append_str");
+		    goto done;
+		}
+		start = i+1;
+		continue;
+	    }
 	    if (detect_endtag("]]>]]>",
 			      buf[i],
 			      &xml_state)) {
 		/* OK, we have an xml string from a client */
+		/* Append segment up to and including trailer */
+		c = buf[i+1];
+		buf[i+1] = '\0';
+		if (cbuf_append_str(cb, (char*)buf+start) < 0){
+		    clicon_err(OE_UNIX, errno, "cbuf_append_str");
+		    goto done;
+		}
+		buf[i+1] = c;
+		start = i+1;
 		/* Remove trailer */
 		*(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
 		if (netconf_input_frame(h, cb) < 0 &&
@@ -521,9 +551,25 @@ netconf_input_cb(int   s,
 		if (cc_closed){
 		    break;
 		}
-		cbuf_reset(cb);
+		if (cbuf_buflen(cb) > NETCONF_FRAME_BUFLEN){
+		    cbuf_free(cb);
+		    if ((cb = cbuf_new()) == NULL){
+			clicon_err(OE_XML, errno, "cbuf_new");
+			goto done;
+		    }
+		}
+		else
+		    cbuf_reset(cb);
 	    }
 	}
+	if (cc_closed)
+	    break;
+	/* Append rest of read data */
+	if (start < len &&
+	    cbuf_append_str(cb, (char*)buf+start) < 0){
+	    clicon_err(OE_UNIX, errno, "cbuf_append_str");
+	    goto done;
+	}
 	/* poll==1 if more, poll==0 if none */
 	if ((poll = clixon_event_poll(s)) < 0)
 	    goto done;
@@ -532,6 +578,8 @@ netconf_input_cb(int   s,
 	    if (cbuf_len(cb) != 0){
 		if (clicon_hash_add(cdat, NETCONF_HASH_BUF, &cb, sizeof(cb)) == NULL)
 		    return -1;
+		if (clicon_hash_add(cdat, NETCONF_HASH_STATE, &xml_state, sizeof(xml_state)) == NULL)
+		    return -1;
 		cb = NULL;
 	    }
 	    break; 
@@ -597,6 +645,7 @@ netconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clicon_handle_exit(h);
     clixon_err_exit();
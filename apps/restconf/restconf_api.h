@@ -52,4 +52,9 @@ int restconf_reply_send(void *req, int code, cbuf *cb, int head);
 
 cbuf *restconf_get_indata(void *req);
 
+int restconf_reply_async(void *req);
+int restconf_reply_suspend(void *req, uint32_t id);
+int restconf_reply_resume(void *req);
+int restconf_reply_offload(void *req, int (*fn)(void*), int (*done)(clicon_handle, int, void*), void *arg);
+
 #endif /* _RESTCONF_API_H_ */
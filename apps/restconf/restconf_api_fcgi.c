@@ -239,3 +239,53 @@ restconf_get_indata(void *req0)
 	cprintf(cb, "%c", c);
     return cb;
 }
+
+/*! Check if reply to request can be sent later, when an asynchronous rpc replies
+ * @param[in]  req   Fastcgi request handle
+ * @retval     0     No, fastcgi requests are replied one at a time
+ */
+int
+restconf_reply_async(void *req0)
+{
+    return 0;
+}
+
+/*! Suspend request until asynchronous rpc replies, not supported in fastcgi
+ * @param[in]  req   Fastcgi request handle
+ * @param[in]  id    Request id of asynchronous rpc
+ * @retval    -1     Error
+ */
+int
+restconf_reply_suspend(void    *req0,
+		       uint32_t id)
+{
+    clicon_err(OE_RESTCONF, EOPNOTSUPP, "Asynchronous reply not supported in fastcgi");
+    return -1;
+}
+
+/*! Send reply of suspended request, not supported in fastcgi
+ * @param[in]  req   Fastcgi request handle
+ * @retval    -1     Error
+ */
+int
+restconf_reply_resume(void *req0)
+{
+    clicon_err(OE_RESTCONF, EOPNOTSUPP, "Asynchronous reply not supported in fastcgi");
+    return -1;
+}
+
+/*! Make a job of a suspended request in a thread, not supported in fastcgi
+ * @param[in]  req   Fastcgi request handle
+ * @param[in]  fn    Job
+ * @param[in]  done  Done callback
+ * @param[in]  arg   Argument to fn and done
+ * @retval     0     No, make the job inline
+ */
+int
+restconf_reply_offload(void  *req0,
+		       int  (*fn)(void*),
+		       int  (*done)(clicon_handle, int, void*),
+		       void  *arg)
+{
+    return 0;
+}
@@ -69,6 +69,10 @@
 #include "restconf_lib.h"
 #include "restconf_api.h"  /* Virtual api */
 #include "restconf_native.h"
+#include "restconf_threads.h"
+#ifdef HAVE_LIBNGHTTP2
+#include "restconf_nghttp2.h"
+#endif
 
 /*! Add HTTP header field name and value to reply, evhtp specific
  * @param[in]  req   Evhtp http request handle
@@ -191,3 +195,106 @@ restconf_get_indata(void *req0)
     return cb;
 }
 
+/*! Check if reply to request can be sent later, when an asynchronous rpc replies
+ * This is the case for http/2 streams, where other streams are handled meanwhile.
+ * @param[in]  req   Request handle
+ * @retval     1     Yes, see restconf_reply_suspend
+ * @retval     0     No
+ * @see CLICON_RPC_ASYNC_SOCKETS
+ */
+int
+restconf_reply_async(void *req0)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+    restconf_conn        *rc;
+
+    if (sd == NULL || (rc = sd->sd_conn) == NULL)
+	return 0;
+#ifdef HAVE_LIBNGHTTP2
+    if (sd->sd_proto == HTTP_2 && rc->rc_ngsession != NULL &&
+	clicon_option_int(rc->rc_h, "CLICON_RPC_ASYNC_SOCKETS") > 0)
+	return 1;
+#endif
+    return 0;
+}
+
+/*! Suspend request until asynchronous rpc replies
+ * No reply is sent when the request handler returns. Instead the rpc callback
+ * makes the reply and calls restconf_reply_resume. If the stream is closed before,
+ * the rpc is canceled.
+ * @param[in]  req   Request handle
+ * @param[in]  id    Request id of asynchronous rpc, see clicon_rpc_async
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+restconf_reply_suspend(void    *req0,
+		       uint32_t id)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+
+    if (sd == NULL){
+	clicon_err(OE_CFG, EINVAL, "sd is NULL");
+	return -1;
+    }
+    sd->sd_rpc_id = id;
+    return 0;
+}
+
+/*! Send reply of suspended request
+ * @param[in]  req   Request handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see restconf_reply_suspend
+ */
+int
+restconf_reply_resume(void *req0)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+
+    if (sd == NULL){
+	clicon_err(OE_CFG, EINVAL, "sd is NULL");
+	return -1;
+    }
+    sd->sd_rpc_id = 0;
+    sd->sd_job_id = 0;
+#ifdef HAVE_LIBNGHTTP2
+    if (sd->sd_proto == HTTP_2)
+	return http2_resume(sd);
+#endif
+    return 0;
+}
+
+/*! Make a job of a suspended request in a thread, eg encoding of the reply
+ * The done callback is called from the event loop when the job is done. It sends the
+ * reply and calls restconf_reply_resume. If the stream is closed before, the job is
+ * canceled and done is called with status 0.
+ * @param[in]  req   Request handle
+ * @param[in]  fn    Job, made in a thread, see restconf_threads.c for restrictions
+ * @param[in]  done  Called from event loop with status 1: done, 0: canceled, -1: failed
+ * @param[in]  arg   Argument to fn and done, owned by the job until done is called
+ * @retval     1     Job submitted
+ * @retval     0     No, make the job inline: no threads, queue full or request not suspended
+ * @retval    -1     Error
+ * @see restconf_reply_suspend
+ */
+int
+restconf_reply_offload(void  *req0,
+		       int  (*fn)(void*),
+		       int  (*done)(clicon_handle, int, void*),
+		       void  *arg)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+    uint32_t              id;
+    int                   ret;
+
+    if (sd == NULL){
+	clicon_err(OE_CFG, EINVAL, "sd is NULL");
+	return -1;
+    }
+    if (!restconf_threads_enabled() || !restconf_reply_async(sd))
+	return 0;
+    if ((ret = restconf_threads_submit(fn, done, arg, &id)) == 1)
+	sd->sd_job_id = id;
+    return ret;
+}
@@ -82,6 +82,7 @@
 #include "restconf_err.h"
 #include "restconf_root.h"
 #include "restconf_native.h"   /* Restconf-openssl mode specific headers*/
+#include "restconf_worker.h"
 #ifdef HAVE_LIBEVHTP
 #include "restconf_evhtp.h"    /* evhtp http/1 */
 #endif
@@ -511,6 +512,7 @@ restconf_path_root(evhtp_request_t *req,
     }
     sd->sd_req = req;
     sd->sd_proto = (req->proto == EVHTP_PROTO_10)?HTTP_10:HTTP_11;
+    restconf_worker_self()->rw_requests++;
     /* input debug */
     if (clicon_debug_get())
 	evhtp_headers_for_each(req->headers_in, evhtp_print_header, h);
@@ -614,6 +616,7 @@ restconf_path_wellknown(evhtp_request_t *req,
     }
     sd->sd_req = req;
     sd->sd_proto = (req->proto == EVHTP_PROTO_10)?HTTP_10:HTTP_11;
+    restconf_worker_self()->rw_requests++;
     /* input debug */
     if (clicon_debug_get())
 	evhtp_headers_for_each(req->headers_in, evhtp_print_header, h);
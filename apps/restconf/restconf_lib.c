@@ -367,6 +367,7 @@ restconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     restconf_handle_exit(h);
     clixon_err_exit();
     clicon_debug(1, "%s pid:%u done", __FUNCTION__, getpid());
@@ -793,7 +794,7 @@ restconf_config_init(clicon_handle h,
  * @param[in]  addrtype  One of inet:ipv4-address or inet:ipv6-address
  * @param[in]  port      TCP port
  * @param[in]  backlog  Listen backlog, queie of pending connections
- * @param[in]  flags    Socket flags OR:ed in with the socket(2) type parameter
+ * @param[in]  flags    Socket flags OR:ed in with the socket(2) type parameter, and CLIXON_SOCK_REUSEPORT
  * @param[out] ss        Server socket (bound for accept)
  */
 int
@@ -130,6 +130,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <fcntl.h>
 #include <syslog.h>
 #include <pwd.h>
 #include <ctype.h>
@@ -173,6 +174,8 @@
 #include "restconf_err.h"
 #include "restconf_root.h"
 #include "restconf_native.h"   /* Restconf-openssl mode specific headers*/
+#include "restconf_worker.h"
+#include "restconf_threads.h"
 #ifdef HAVE_LIBEVHTP
 #include "restconf_evhtp.h"   /* http/1 */
 #endif
@@ -198,8 +201,12 @@
 /* Cert verify depth: dont know what to set here? */
 #define VERIFY_DEPTH 5
 
+/* Default max number of jobs waiting for a thread, see thread-queue-length in clixon-restconf.yang */
+#define RESTCONF_THREAD_QUEUE_LEN 64
+
 /* Forward */
 static int restconf_connection(int s, void* arg);
+static int restconf_ssl_accept(int s, void* arg);
 
 static int             session_id_context = 1;
 
@@ -237,98 +244,6 @@ restconf_native_handle_set(clicon_handle   h,
     return 0;
 }
 
-/* Write evbuf to socket
- * see also this function in restcont_api_openssl.c
- */
-static int
-buf_write(char   *buf,
-	  size_t  buflen,
-	  int     s,
-	  SSL    *ssl)
-{
-    int     retval = -1;
-    ssize_t len;
-    ssize_t totlen = 0;
-    int     er;
-
-    /* Two problems with debugging buffers from libevent that this fixes:
-     * 1. they are not "strings" in the sense they are not NULL-terminated
-     * 2. they are often very long
-     */
-    if (clicon_debug_get()) { 
-	char *dbgstr = NULL;
-	size_t sz;
-	sz = buflen>256?256:buflen; /* Truncate to 256 */
-	if ((dbgstr = malloc(sz+1)) == NULL){
-	    clicon_err(OE_UNIX, errno, "malloc");
-	    goto done;
-	}
-	memcpy(dbgstr, buf, sz);
-	dbgstr[sz] = '\0';
-	clicon_debug(1, "%s buflen:%zu buf:%s", __FUNCTION__, buflen, dbgstr);
-	free(dbgstr);
-    }
-    while (totlen < buflen){
-	if (ssl){
-	    if ((len = SSL_write(ssl, buf+totlen, buflen-totlen)) <= 0){
-		er = errno;
-		switch (SSL_get_error(ssl, len)){
-		case SSL_ERROR_SYSCALL:              /* 5 */
-		    if (er == ECONNRESET) {/* Connection reset by peer */
-			if (ssl)
-			    SSL_free(ssl);
-			close(s);
-			clixon_event_unreg_fd(s, restconf_connection);
-			goto ok; /* Close socket and ssl */
-		    }
-		    else if (er == EAGAIN){
-			clicon_debug(1, "%s write EAGAIN", __FUNCTION__);
-			usleep(10000);
-			continue;
-		    }
-		    else{
-			clicon_err(OE_RESTCONF, er, "SSL_write %d", er);
-			goto done;
-		    }
-		    break;
-		default:
-		    clicon_err(OE_SSL, 0, "SSL_write");
-		    goto done;
-		    break;
-		}
-		goto done;
-	    }
-	}
-	else{
-	    if ((len = write(s, buf+totlen, buflen-totlen)) < 0){
-		if (errno == EAGAIN){
-		    clicon_debug(1, "%s write EAGAIN", __FUNCTION__);
-		    usleep(10000);
-		    continue;
-		}
-#if 1
-		else if (errno == ECONNRESET) {/* Connection reset by peer */
-		    close(s);
-		    clixon_event_unreg_fd(s, restconf_connection);
-		    goto ok; /* Close socket and ssl */
-		}
-#endif
-		else{
-		    clicon_err(OE_UNIX, errno, "write");
-		    goto done;
-		}
-	    }
-	    assert(len != 0);
-	}
-	totlen += len;
-    } /* while */
- ok:
-    retval = 0;
- done:
-    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
-    return retval;
-}
-
 /* util function to append log string
  */
 static int
@@ -515,6 +430,9 @@ restconf_ssl_context_create(clicon_handle h)
     SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv3 | SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1);
 
     SSL_CTX_set_options(ctx, SSL_MODE_RELEASE_BUFFERS | SSL_OP_NO_COMPRESSION);
+    /* Non-blocking writes: SSL_write may write parts, and is retried from the connection
+     * output buffer which may have moved, see restconf_conn_write */
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
     //    SSL_CTX_set_timeout(ctx, cfg->ssl_ctx_timeout); /* default 300s */
     /* Application Layer Protocol Negotiation (alpn) callback */
     SSL_CTX_set_alpn_select_cb(ctx, alpn_select_proto_cb, h);
@@ -601,8 +519,11 @@ restconf_close_ssl_socket(restconf_conn *rc,
 Note that in this case SSL_ERROR_ZERO_RETURN does not necessarily indicate that the underlying transport has been closed.
 #endif
 	    int e = SSL_get_error(rc->rc_ssl, ret);
-	    clicon_err(OE_SSL, 0, "SSL_shutdown, err:%d", e);
-	    goto done;
+	    /* Non-blocking socket: do not wait for close_notify to be sent */
+	    if (e != SSL_ERROR_WANT_WRITE && e != SSL_ERROR_WANT_READ){
+		clicon_err(OE_SSL, 0, "SSL_shutdown, err:%d", e);
+		goto done;
+	    }
 	}
 	SSL_free(rc->rc_ssl);
 	rc->rc_ssl = NULL;
@@ -624,15 +545,13 @@ Note that in this case SSL_ERROR_ZERO_RETURN does not necessarily indicate that
 
 /*! Send early handcoded bad request reply before actual packet received, just after accept
  * @param[in]  h    Clixon handle
- * @param[in]  s    Socket
- * @param[in]  ssl  If set, it will be freed
+ * @param[in]  rc   Restconf connection, reply is sent using ssl if rc_ssl is set
  * @param[in]  body If given add message body using media 
  * @see restconf_badrequest which can only be called in a request context
  */
 static int
 send_badrequest(clicon_handle       h,
-		int                 s,
-		SSL                *ssl,
+		restconf_conn      *rc,
 		char               *media,
     		char               *body)
 {
@@ -654,7 +573,7 @@ send_badrequest(clicon_handle       h,
     cprintf(cb, "\r\n");
     if (body)
 	cprintf(cb, "%s\r\n", body);
-    if (buf_write(cbuf_get(cb), cbuf_len(cb), s, ssl) < 0)
+    if (restconf_conn_write(rc, cbuf_get(cb), cbuf_len(cb)) < 0)
 	goto done;
     retval = 0;
  done:
@@ -663,8 +582,52 @@ send_badrequest(clicon_handle       h,
     return retval;
 }
 
+/*! Read input of a connection again when its output is below the high-water mark
+ * @param[in]  s    Socket
+ * @param[in]  arg  Restconf connection
+ * @see restconf_connection_pause
+ */
+static int
+restconf_connection_unpause(int   s,
+			    void *arg)
+{
+    restconf_conn *rc = (restconf_conn *)arg;
+
+    if (restconf_conn_output_full(rc))
+	return restconf_conn_resume(rc, restconf_connection_unpause);
+    clicon_debug(1, "%s %d", __FUNCTION__, s);
+    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+	return -1;
+    rc->rc_paused = 0;
+    /* Input may already be read by SSL, and is then not signalled by the socket */
+    return restconf_connection(s, rc);
+}
+
+/*! Stop reading input of a connection while its output is above the high-water mark
+ * Eg a client sending pipelined requests without reading the replies. Not if SSL_write
+ * needs input first.
+ * @param[in]  rc   Restconf connection
+ * @retval     1    Paused, input is read again when output is written
+ * @retval     0    Not paused
+ * @retval    -1    Error
+ */
+static int
+restconf_connection_pause(restconf_conn *rc)
+{
+    if (!restconf_conn_output_full(rc) || rc->rc_outp_wantread)
+	return 0;
+    clicon_debug(1, "%s %d", __FUNCTION__, rc->rc_s);
+    if (!rc->rc_paused){
+	clixon_event_unreg_fd(rc->rc_s, restconf_connection);
+	rc->rc_paused = 1;
+    }
+    if (restconf_conn_resume(rc, restconf_connection_unpause) < 0)
+	return -1;
+    return 1;
+}
+
 /*! New data connection after accept, receive and reply on data sockte
- *
+*
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
@@ -675,6 +638,8 @@ send_badrequest(clicon_handle       h,
  * with 100 Continue, in which case that is replied and the function returns and the client sends 
  * more data.
  * OR evhtp returns 0 with no reply, then this is assumed to mean read more data from the socket.
+ * @note The socket is non-blocking: if no more data is available the function returns and is
+ * called again on the next input, or when writable if SSL needs to write first.
  */
 static int
 restconf_connection(int   s,
@@ -686,6 +651,7 @@ restconf_connection(int   s,
     char                  buf[BUFSIZ]; /* from stdio.h, typically 8K XXX: reduce for test */
     int                   readmore = 1;
     int                   sslerr;
+    int                   paused;
 #ifdef HAVE_LIBNGHTTP2
     int                   ret;
 #endif
@@ -701,33 +667,46 @@ restconf_connection(int   s,
 	goto done;
     }
     assert(s == rc->rc_s);
+    /* Output that waited for SSL input */
+    if (rc->rc_outp_wantread && restconf_conn_flush(rc) < 0)
+	goto done;
     while (readmore) {
 	clicon_debug(1, "%s readmore", __FUNCTION__);
 	readmore = 0;
-	/* Example: curl -Ssik -u wilma:bar -X GET https://localhost/restconf/data/example:x */
+	/* Do not read more requests until replies are written */
+	if ((paused = restconf_connection_pause(rc)) < 0)
+	    goto done;
+	if (paused)
+	    goto ok;
+/* Example: curl -Ssik -u wilma:bar -X GET https://localhost/restconf/data/example:x */
 	if (rc->rc_ssl){
 	    /* Non-ssl gets n == 0 here!
 	       curl -Ssik --key /var/tmp/./test_restconf_ssl_certs.sh/certs/limited.key --cert /var/tmp/./test_restconf_ssl_certs.sh/certs/limited.crt -X GET https://localhost/restconf/data/example:x
 	    */
-	    if ((n = SSL_read(rc->rc_ssl, buf, sizeof(buf))) < 0){
+	    if ((n = SSL_read(rc->rc_ssl, buf, sizeof(buf))) <= 0){
 		sslerr = SSL_get_error(rc->rc_ssl, n);
 		clicon_debug(1, "%s SSL_read() n:%zd errno:%d sslerr:%d", __FUNCTION__, n, errno, sslerr);
 		switch (sslerr){
 		case SSL_ERROR_WANT_READ:            /* 2 */
-		    /* SSL_ERROR_WANT_READ is returned when the last operation was a read operation 
-		     * from a nonblocking BIO. 
-		     * That is, it can happen if restconf_socket_init() below is called 
-		     * with SOCK_NONBLOCK
-		     */
+		    /* No more data on the nonblocking socket, wait for next input */
 		    clicon_debug(1, "%s SSL_read SSL_ERROR_WANT_READ", __FUNCTION__);
-		    usleep(1000);
-		    readmore = 1;
+		    goto ok;
+		    break;
+		case SSL_ERROR_WANT_WRITE:           /* 3 */
+		    /* eg renegotiation, read again when socket is writable */
+		    clicon_debug(1, "%s SSL_read SSL_ERROR_WANT_WRITE", __FUNCTION__);
+		    if (restconf_conn_resume(rc, restconf_connection) < 0)
+			goto done;
+		    goto ok;
+		    break;
+		case SSL_ERROR_ZERO_RETURN:          /* 6 */
+		case SSL_ERROR_SYSCALL:              /* 5 */
+		    n = 0; /* Closed by peer */
 		    break;
 		default:
 		    clicon_err(OE_XML, errno, "SSL_read");
 		    goto done;              
 		} /* switch */
-		continue; /* readmore */
 	    }
 	}
 	else{
@@ -740,10 +719,13 @@ restconf_connection(int   s,
 		    restconf_conn_free(rc);
 		    goto ok; /* Close socket and ssl */
 		    break;
+		case EINTR:
+		    readmore = 1;
+		    break;
 		case EAGAIN:
+		    /* No more data on the nonblocking socket, wait for next input */
 		    clicon_debug(1, "%s read EAGAIN", __FUNCTION__);
-		    usleep(1000);
-		    readmore = 1;
+		    goto ok;
 		    break;
 		default:;
 		    clicon_err(OE_XML, errno, "read");
@@ -777,19 +759,14 @@ restconf_connection(int   s,
 		/* XXX To get more nuanced evhtp error check
 		 * htparser_get_error(conn->parser)
 		 */
-		if (send_badrequest(h, rc->rc_s, rc->rc_ssl, "application/yang-data+xml",
+		if (send_badrequest(h, rc, "application/yang-data+xml",
 				    "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>The requested URL or a header is in some way badly formed</error-message></error></errors>") < 0)
 		    goto done;
-		SSL_free(rc->rc_ssl);
-		rc->rc_ssl = NULL;
-		evconn->ssl = NULL;
-		if (close(rc->rc_s) < 0){
-		    clicon_err(OE_UNIX, errno, "close");
-		    goto done;
-		}
+		/* Close when the reply is written */
 		clixon_event_unreg_fd(rc->rc_s, restconf_connection);
 		clicon_debug(1, "%s evconn-free (%p) 2", __FUNCTION__, evconn);
-		restconf_conn_free(rc);
+		if (restconf_conn_close_written(rc) < 0)
+		    goto done;
 		goto ok;
 	    } /* connection_parse_nobev */
 	    clicon_debug(1, "%s connection_parse OK", __FUNCTION__);
@@ -833,15 +810,17 @@ restconf_connection(int   s,
 		if (cbuf_len(sd->sd_outp_buf) == 0)
 		    readmore = 1;
 		else {
-		    if (buf_write(cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
-				  rc->rc_s, rc->rc_ssl) < 0)
+		    if (restconf_conn_write(rc, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf)) < 0)
 			goto done;
 		    cvec_reset(sd->sd_outp_hdrs); /* Can be done in native_send_reply */
 		    cbuf_reset(sd->sd_outp_buf);
+		    /* Input already decrypted is not signalled by the socket */
+		    if (rc->rc_ssl && SSL_pending(rc->rc_ssl))
+			readmore = 1;
 		}
 	    }
 	    else{
-		if (send_badrequest(h, rc->rc_s, rc->rc_ssl, "application/yang-data+xml",
+		if (send_badrequest(h, rc, "application/yang-data+xml",
 				    "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>No evhtp output</error-message></error></errors>") < 0)
 		    goto done;
 	    }
@@ -1021,10 +1000,15 @@ ssl_alpn_check(clicon_handle        h,
 	if (alpn != NULL){
 	    cprintf(cberr, "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>ALPN: protocol not recognized: %s</error-message></error></errors>", alpn);
 	    clicon_log(LOG_INFO, "%s Warning: %s", __FUNCTION__, cbuf_get(cberr));
-	    if (send_badrequest(h, rc->rc_s, rc->rc_ssl,
+	    if (send_badrequest(h, rc,
 				"application/yang-data+xml",
 				cbuf_get(cberr)) < 0)
 		goto done;
+	    /* Close when the reply is written */
+	    if (restconf_conn_close_written(rc) < 0)
+		goto done;
+	    retval = 0; /* ALPN not OK */
+	    goto done;
 	}
 	else{
 	    /* XXX Sending badrequest here gives a segv in SSL_shutdown() later or a SIGPIPE here */
@@ -1058,6 +1042,358 @@ ssl_alpn_check(clicon_handle        h,
     return retval;
 } /* ssl_alpn_check */
 
+/*! Start a restconf connection after accept, and TLS handshake if ssl
+ * Create protocol specific structs and register input callback
+ * @param[in]  h      Clixon handle
+ * @param[in]  rc     Restconf connection
+ * @param[in]  proto  HTTP protocol
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_connection_start(clicon_handle       h,
+			  restconf_conn      *rc,
+			  restconf_http_proto proto)
+{
+    int                     retval = -1;
+    restconf_native_handle *rh = NULL;
+
+    if ((rh = restconf_native_handle_get(h)) == NULL){
+	clicon_err(OE_XML, EFAULT, "No openssl handle");
+	goto done;
+    }
+    rc->rc_proto = proto;
+    switch (rc->rc_proto){
+#ifdef HAVE_LIBEVHTP
+    case HTTP_10:
+    case HTTP_11:{
+	evhtp_t             *evhtp = (evhtp_t *)rh->rh_arg;
+	evhtp_connection_t  *evconn;
+
+	/* Create evhtp-specific struct */
+	if ((evconn = evhtp_connection_new_server(evhtp, rc->rc_s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "evhtp_connection_new_server");
+	    goto done;
+	}
+	/* Mutual pointers, from generic rc to evhtp specific and from evhtp conn to generic
+	 */
+	rc->rc_evconn = evconn; /* Generic to specific */
+	evconn->arg = rc;    /* Specific to generic */
+	evconn->ssl = rc->rc_ssl; /* evhtp */
+	/* Create a default stream for http/1 */
+	if (restconf_stream_data_new(rc, 0) == NULL)
+	    goto done;
+    }
+	break;
+#endif /* HAVE_LIBEVHTP */
+#ifdef HAVE_LIBNGHTTP2
+    case HTTP_2:{
+	if (http2_session_init(rc) < 0){
+	    restconf_close_ssl_socket(rc, 1);
+	    goto done;
+	}
+	if (http2_send_server_connection(rc) < 0){
+	    restconf_close_ssl_socket(rc, 1);
+#ifdef NYI
+	    if (ssl) {
+		SSL_shutdown(ssl);
+	    }
+	    bufferevent_free(session_data->bev);
+	    nghttp2_session_del(session_data->session);
+	    for (stream_data = session_data->root.next; stream_data;) {
+		http2_stream_data *next = stream_data->next;
+		delete_http2_stream_data(stream_data);
+		stream_data = next;
+	    }
+	    free(session_data->client_addr);
+	    free(session_data);
+#endif
+	    goto done;
+	}
+	break;
+    }
+#endif /* HAVE_LIBNGHTTP2 */
+    default:
+	break;
+    } /* switch proto */
+    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/* TLS handshake step made in a thread, see restconf_ssl_accept
+ */
+struct restconf_ssl_job {
+    restconf_conn *sj_rc;    /* Restconf connection */
+    int            sj_ret;   /* Return value of SSL_accept */
+    int            sj_err;   /* SSL_get_error, if sj_ret is not 1 */
+    int            sj_errno; /* errno, if sj_ret is not 1 */
+};
+
+/*! Continue TLS handshake after a step of SSL_accept
+ * @param[in]  h    Clixon handle
+ * @param[in]  rc   Restconf connection
+ * @param[in]  ret  Return value of SSL_accept
+ * @param[in]  e    SSL_get_error, if ret is not 1
+ * @param[in]  er   errno, if ret is not 1
+ * @see restconf_ssl_accept
+ */
+static int
+restconf_ssl_accept_result(clicon_handle  h,
+			   restconf_conn *rc,
+			   int            ret,
+			   int            e,
+			   int            er)
+{
+    int                     retval = -1;
+    const unsigned char    *alpn = NULL;
+    unsigned int            alpnlen = 0;
+    restconf_http_proto     proto = HTTP_11;
+
+    /* 1: OK, -1 fatal, 0: TLS/SSL handshake was not successful
+     * Both error cases: Call SSL_get_error() with the return value ret 
+     */
+    if (ret != 1) {
+	clicon_debug(1, "%s SSL_accept() ret:%d errno:%d", __FUNCTION__, ret, er);
+	switch (e){
+	case SSL_ERROR_SSL:                  /* 1 */
+	    clicon_debug(1, "%s SSL_ERROR_SSL (non-ssl message on ssl socket)", __FUNCTION__);
+	    clixon_event_unreg_fd(rc->rc_s, restconf_ssl_accept);
+	    SSL_free(rc->rc_ssl);
+	    rc->rc_ssl = NULL;
+#if 1
+	    if (send_badrequest(h, rc, "application/yang-data+xml",
+				"<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>The plain HTTP request was sent to HTTPS port</error-message></error></errors>") < 0)
+		goto done;
+#endif
+	    /* Close when the reply is written */
+	    if (restconf_conn_close_written(rc) < 0)
+		goto done;
+	    goto ok;
+	    break;
+	case SSL_ERROR_SYSCALL:              /* 5 */
+	    /* Some non-recoverable, fatal I/O error occurred. The OpenSSL error queue 
+	       may contain more information on the error. For socket I/O on Unix systems, 
+	       consult errno for details. If this error occurs then no further I/O
+	       operations should be performed on the connection and SSL_shutdown() must 
+	       not be called.*/
+	    clicon_debug(1, "%s SSL_accept() SSL_ERROR_SYSCALL %d", __FUNCTION__, er);
+	    clixon_event_unreg_fd(rc->rc_s, restconf_ssl_accept);
+	    if (restconf_close_ssl_socket(rc, 0) < 0)
+		goto done;
+	    restconf_conn_free(rc);    
+	    rc = NULL;
+	    goto ok;
+	    break;
+	case SSL_ERROR_WANT_READ:            /* 2 */
+	    /* Wait for next input */
+	    clicon_debug(1, "%s SSL_ERROR_WANT_READ", __FUNCTION__);
+	    goto ok;
+	    break;
+	case SSL_ERROR_WANT_WRITE:           /* 3 */
+	    /* Continue when socket is writable */
+	    clicon_debug(1, "%s SSL_ERROR_WANT_WRITE", __FUNCTION__);
+	    if (restconf_conn_resume(rc, restconf_ssl_accept) < 0)
+		goto done;
+	    goto ok;
+	    break;
+	case SSL_ERROR_NONE:                 /* 0 */
+	case SSL_ERROR_ZERO_RETURN:          /* 6 */
+	case SSL_ERROR_WANT_CONNECT:         /* 7 */
+	case SSL_ERROR_WANT_ACCEPT:          /* 8 */
+	case SSL_ERROR_WANT_X509_LOOKUP:     /* 4 */
+	case SSL_ERROR_WANT_ASYNC:           /* 8 */
+	case SSL_ERROR_WANT_ASYNC_JOB:       /* 10 */
+#ifdef SSL_ERROR_WANT_CLIENT_HELLO_CB
+	case SSL_ERROR_WANT_CLIENT_HELLO_CB: /* 11 */
+#endif
+	default:
+	    clicon_err(OE_SSL, 0, "SSL_accept:%d", e);
+	    goto done;
+	    break;
+	}
+    } /* SSL_accept */
+    /* Handshake done */
+    clixon_event_unreg_fd(rc->rc_s, restconf_ssl_accept);
+    /* Sets data and len to point to the client's requested protocol for this connection. */
+#ifndef OPENSSL_NO_NEXTPROTONEG
+    SSL_get0_next_proto_negotiated(rc->rc_ssl, &alpn, &alpnlen);
+#endif /* !OPENSSL_NO_NEXTPROTONEG */
+    if (alpn == NULL) {
+	/* Returns a pointer to the selected protocol in data with length len. */
+	SSL_get0_alpn_selected(rc->rc_ssl, &alpn, &alpnlen);
+    }
+    if ((ret = ssl_alpn_check(h, alpn, alpnlen, rc, &proto)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    clicon_debug(1, "%s proto:%s", __FUNCTION__, restconf_proto2str(proto));
+
+#if 0 /* Seems too early to fail here, instead let authentication callback deal with this */
+    /* For client-cert authentication, check if any certs are present,
+    * if not, send bad request
+    * Alt: set SSL_CTX_set_verify(ctx, SSL_VERIFY_FAIL_IF_NO_PEER_CERT)
+    * but then SSL_accept fails.
+    */
+    if (restconf_auth_type_get(h) == CLIXON_AUTH_CLIENT_CERTIFICATE){
+        X509 *peercert;
+
+        if ((peercert = SSL_get_peer_certificate(rc->rc_ssl)) != NULL){
+    	X509_free(peercert);
+        }
+        else { /* Get certificates (if available) */
+    	if (proto != HTTP_2 &&
+    	    send_badrequest(h, rc, "application/yang-data+xml",
+    			    "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>Peer certificate required</error-message></error></errors>") < 0)
+    	    goto done;
+    	restconf_conn_free(rc);
+    	if (rc->rc_ssl){
+    	    if ((ret = SSL_shutdown(rc->rc_ssl)) < 0){
+    		int e = SSL_get_error(rc->rc_ssl, ret);
+    		clicon_err(OE_SSL, 0, "SSL_shutdown, err:%d", e);
+    		goto done;
+    	    }
+    	    SSL_free(rc->rc_ssl);
+    	    rc->rc_ssl = NULL;
+    	}
+    	goto ok;
+        }
+    }
+#endif
+    /* Get the actual peer, XXX this maybe could be done in ca-auth client-cert code ? 
+     * Note this _only_ works if SSL_set1_host() was set previously,...
+     */
+    if (SSL_get_verify_result(rc->rc_ssl) == X509_V_OK) { /* for peer cert */
+
+        const char *peername = SSL_get0_peername(rc->rc_ssl);
+
+ 	    if (peername != NULL) {
+    	/* Name checks were in scope and matched the peername */
+    	clicon_debug(1, "%s peername:%s", __FUNCTION__, peername);
+        }
+    }
+#if 0 /* debug */
+    if (clicon_debug_get())
+        restconf_listcerts(rc->rc_ssl);
+#endif
+    if (restconf_connection_start(h, rc, proto) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval %d", __FUNCTION__, retval);
+    return retval;
+} /* restconf_ssl_accept_result */
+
+/*! Thread: make a step of TLS handshake, see restconf_ssl_accept
+ * The OpenSSL error queue is per thread, so SSL_get_error is called here
+ * @param[in]  arg  TLS handshake job
+ */
+static int
+restconf_ssl_accept_job(void *arg)
+{
+    struct restconf_ssl_job *sj = (struct restconf_ssl_job *)arg;
+    SSL                     *ssl = sj->sj_rc->rc_ssl;
+
+    ERR_clear_error();
+    if ((sj->sj_ret = SSL_accept(ssl)) != 1){
+	sj->sj_errno = errno;
+	sj->sj_err = SSL_get_error(ssl, sj->sj_ret);
+    }
+    return 0;
+}
+
+/*! TLS handshake step made in a thread is done, continue handshake
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: done, 0: canceled (at exit), -1: failed
+ * @param[in]  arg     TLS handshake job, freed here
+ */
+static int
+restconf_ssl_accept_done(clicon_handle h,
+			 int           status,
+			 void         *arg)
+{
+    int                      retval = -1;
+    struct restconf_ssl_job *sj = (struct restconf_ssl_job *)arg;
+    restconf_conn           *rc = sj->sj_rc;
+
+    clicon_debug(1, "%s status:%d", __FUNCTION__, status);
+    if (status != 1){
+	if (restconf_close_ssl_socket(rc, 0) < 0)
+	    goto done;
+	restconf_conn_free(rc);
+	goto ok;
+    }
+    /* Input was deregistered while the job was made */
+    if (sj->sj_ret != 1 && sj->sj_err == SSL_ERROR_WANT_READ &&
+	clixon_event_reg_fd(rc->rc_s, restconf_ssl_accept, (void*)rc, "restconf client handshake") < 0)
+	goto done;
+    if (restconf_ssl_accept_result(h, rc, sj->sj_ret, sj->sj_err, sj->sj_errno) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    free(sj);
+    return retval;
+}
+
+/*! TLS handshake of new client, called on input until done
+ * The handshake is made on a non-blocking socket, waiting for input or output 
+ * between steps without blocking other connections.
+ * If there are restconf threads, each step is made in a thread, and the socket is not
+ * waited for until the step is done, see restconf_ssl_accept_done
+ * @param[in]  s    Socket
+ * @param[in]  arg  Restconf connection
+ * @see restconf_accept_client where this callback is registered
+ */
+static int
+restconf_ssl_accept(int   s,
+		    void *arg)
+{
+    int                      retval = -1;
+    restconf_conn           *rc = (restconf_conn *)arg;
+    struct restconf_ssl_job *sj = NULL;
+    int                      ret;
+    int                      e = 0;
+    int                      er = 0;
+
+    clicon_debug(1, "%s %d", __FUNCTION__, s);
+    if (restconf_threads_enabled()){
+	if ((sj = malloc(sizeof(*sj))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(sj, 0, sizeof(*sj));
+	sj->sj_rc = rc;
+	if ((ret = restconf_threads_submit(restconf_ssl_accept_job, restconf_ssl_accept_done,
+					   sj, NULL)) < 0)
+	    goto done;
+	if (ret == 1){
+	    sj = NULL; /* Owned by job */
+	    /* The thread uses the SSL session until done */
+	    clixon_event_unreg_fd(rc->rc_s, restconf_ssl_accept);
+	    if (restconf_conn_resume(rc, NULL) < 0)
+		goto done;
+	    goto ok;
+	}
+	/* Queue full, make it here */
+    }
+    if ((ret = SSL_accept(rc->rc_ssl)) != 1) {
+	er = errno;
+	e = SSL_get_error(rc->rc_ssl, ret);
+    }
+    if (restconf_ssl_accept_result(rc->rc_h, rc, ret, e, er) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (sj)
+	free(sj);
+    return retval;
+} /* restconf_ssl_accept */
+
 /*! Accept new socket client
  * @param[in]  fd   Socket (unix or ip)
  * @param[in]  arg  typecast clicon_handle
@@ -1075,13 +1411,7 @@ restconf_accept_client(int   fd,
     int                     s;
     struct sockaddr         from = {0,};
     socklen_t               len;
-    char                   *name = NULL;
-    int                     ret;
-    int                     e;
-    int                     er;
-    int                     readmore;
-    const unsigned char    *alpn = NULL;
-    unsigned int            alpnlen = 0;
+    int                     flags;
     restconf_http_proto     proto = HTTP_11;  /* Non-SSL negotiation NYI */
 
     clicon_debug(1, "%s %d", __FUNCTION__, fd);
@@ -1109,6 +1439,14 @@ restconf_accept_client(int   fd,
 	clicon_err(OE_UNIX, errno, "accept");
 	goto done;
     }
+    restconf_worker_self()->rw_accepts++;
+    /* A slow client must not block other connections */
+    if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+	fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	close(s);
+	goto done;
+    }
     /*
      * Register callbacks for actual data socket 
      */
@@ -1150,200 +1488,78 @@ restconf_accept_client(int   fd,
 	    clicon_err(OE_SSL, 0, "SSL_set_fd");
 	    goto done;
 	}
-	readmore = 1;
-	while (readmore){
-	    readmore = 0;
-	    /* 1: OK, -1 fatal, 0: TLS/SSL handshake was not successful
-	     * Both error cases: Call SSL_get_error() with the return value ret 
-	     */
-	    if ((ret = SSL_accept(rc->rc_ssl)) != 1) {
-		clicon_debug(1, "%s SSL_accept() ret:%d errno:%d", __FUNCTION__, ret, er=errno);
-		e = SSL_get_error(rc->rc_ssl, ret);
-		switch (e){
-		case SSL_ERROR_SSL:                  /* 1 */
-		    clicon_debug(1, "%s SSL_ERROR_SSL (non-ssl message on ssl socket)", __FUNCTION__);
-#if 1
-		    if (send_badrequest(h, rc->rc_s, NULL, "application/yang-data+xml",
-					"<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>The plain HTTP request was sent to HTTPS port</error-message></error></errors>") < 0)
-			goto done;
-#endif
-		    SSL_free(rc->rc_ssl);
-		    rc->rc_ssl = NULL;
-		    clixon_event_unreg_fd(rc->rc_s, restconf_connection);
-		    if (close(rc->rc_s) < 0){
-			clicon_err(OE_UNIX, errno, "close");
-			goto done;
-		    }
-		    restconf_conn_free(rc);
-		    goto ok;
-		    break;
-		case SSL_ERROR_SYSCALL:              /* 5 */
-		    /* Some non-recoverable, fatal I/O error occurred. The OpenSSL error queue 
-		       may contain more information on the error. For socket I/O on Unix systems, 
-		       consult errno for details. If this error occurs then no further I/O
-		       operations should be performed on the connection and SSL_shutdown() must 
-		       not be called.*/
-		    clicon_debug(1, "%s SSL_accept() SSL_ERROR_SYSCALL %d", __FUNCTION__, er);
-		    if (restconf_close_ssl_socket(rc, 0) < 0)
-			goto done;
-		    restconf_conn_free(rc);    
-		    rc = NULL;
-		    goto ok;
-		    break;
-		case SSL_ERROR_WANT_READ:            /* 2 */
-		case SSL_ERROR_WANT_WRITE:           /* 3 */
-		    /* SSL_ERROR_WANT_READ is returned when the last operation was a read operation 
-		     * from a nonblocking BIO. 
-		     * That is, it can happen if restconf_socket_init() below is called 
-		     * with SOCK_NONBLOCK
-		     */
-		    clicon_debug(1, "%s write SSL_ERROR_WANT_READ", __FUNCTION__);
-		    usleep(10000);
-		    readmore = 1;
-		    break;
-		case SSL_ERROR_NONE:                 /* 0 */
-		case SSL_ERROR_ZERO_RETURN:          /* 6 */
-		case SSL_ERROR_WANT_CONNECT:         /* 7 */
-		case SSL_ERROR_WANT_ACCEPT:          /* 8 */
-		case SSL_ERROR_WANT_X509_LOOKUP:     /* 4 */
-		case SSL_ERROR_WANT_ASYNC:           /* 8 */
-		case SSL_ERROR_WANT_ASYNC_JOB:       /* 10 */
-#ifdef SSL_ERROR_WANT_CLIENT_HELLO_CB
-		case SSL_ERROR_WANT_CLIENT_HELLO_CB: /* 11 */
-#endif
-		default:
-		    clicon_err(OE_SSL, 0, "SSL_accept:%d", e);
-		    goto done;
-		    break;
-		}
-	    } /* SSL_accept */
-	} /* while(readmore) */
-	/* Sets data and len to point to the client's requested protocol for this connection. */
-#ifndef OPENSSL_NO_NEXTPROTONEG
-	SSL_get0_next_proto_negotiated(rc->rc_ssl, &alpn, &alpnlen);
-#endif /* !OPENSSL_NO_NEXTPROTONEG */
-	if (alpn == NULL) {
-	    /* Returns a pointer to the selected protocol in data with length len. */
-	    SSL_get0_alpn_selected(rc->rc_ssl, &alpn, &alpnlen);
-	}
-	if ((ret = ssl_alpn_check(h, alpn, alpnlen, rc, &proto)) < 0)
+	/* TLS handshake continues on input, see restconf_ssl_accept */
+	if (clixon_event_reg_fd(rc->rc_s, restconf_ssl_accept, (void*)rc, "restconf client handshake") < 0)
 	    goto done;
-	if (ret == 0)
-	    goto ok;
-	clicon_debug(1, "%s proto:%s", __FUNCTION__, restconf_proto2str(proto));
-
-#if 0 /* Seems too early to fail here, instead let authentication callback deal with this */
-	/* For client-cert authentication, check if any certs are present,
-	* if not, send bad request
-	* Alt: set SSL_CTX_set_verify(ctx, SSL_VERIFY_FAIL_IF_NO_PEER_CERT)
-	* but then SSL_accept fails.
-	*/
-	if (restconf_auth_type_get(h) == CLIXON_AUTH_CLIENT_CERTIFICATE){
-	    X509 *peercert;
-
-	    if ((peercert = SSL_get_peer_certificate(rc->rc_ssl)) != NULL){
-		X509_free(peercert);
-	    }
-	    else { /* Get certificates (if available) */
-		if (proto != HTTP_2 &&
-		    send_badrequest(h, rc->rc_s, rc->rc_ssl, "application/yang-data+xml",
-				    "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>Peer certificate required</error-message></error></errors>") < 0)
-		    goto done;
-		restconf_conn_free(rc);
-		if (rc->rc_ssl){
-		    if ((ret = SSL_shutdown(rc->rc_ssl)) < 0){
-			int e = SSL_get_error(rc->rc_ssl, ret);
-			clicon_err(OE_SSL, 0, "SSL_shutdown, err:%d", e);
-			goto done;
-		    }
-		    SSL_free(rc->rc_ssl);
-		    rc->rc_ssl = NULL;
-		}
-		goto ok;
-	    }
-	}
-#endif
-	/* Get the actual peer, XXX this maybe could be done in ca-auth client-cert code ? 
-	 * Note this _only_ works if SSL_set1_host() was set previously,...
-	 */
-	if (SSL_get_verify_result(rc->rc_ssl) == X509_V_OK) { /* for peer cert */
+	if (restconf_ssl_accept(rc->rc_s, rc) < 0)
+	    goto done;
+	goto ok;
+    } /* if ssl */
+    if (restconf_connection_start(h, rc, proto) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval %d", __FUNCTION__, retval);
+    return retval;
+} /* restconf_accept_client */
 
-	    const char *peername = SSL_get0_peername(rc->rc_ssl);
+/*! Close and free restconf server socket
+ * @param[in]  rsock  Restconf server socket, removed from socket list
+ */
+static int
+restconf_socket_free(restconf_socket *rsock)
+{
+    clixon_event_unreg_fd(rsock->rs_ss, restconf_accept_client);
+    close(rsock->rs_ss);
+    if (rsock->rs_addrstr)
+	free(rsock->rs_addrstr);
+    if (rsock->rs_addrtype)
+	free(rsock->rs_addrtype);
+    free(rsock);
+    return 0;
+}
 
- 	    if (peername != NULL) {
-		/* Name checks were in scope and matched the peername */
-		clicon_debug(1, "%s peername:%s", __FUNCTION__, peername);
-	    }
-	}
-#if 0 /* debug */
-	if (clicon_debug_get())
-	    restconf_listcerts(rc->rc_ssl);
-#endif
-    } /* if ssl */
-    rc->rc_proto = proto;
-    switch (rc->rc_proto){
-#ifdef HAVE_LIBEVHTP
-    case HTTP_10:
-    case HTTP_11:{
-	evhtp_t             *evhtp = (evhtp_t *)rh->rh_arg;
-	evhtp_connection_t  *evconn;
+/*! Register server sockets of a worker for accept and close the sockets of other workers
+ * @param[in]  h   Clicon handle
+ * @param[in]  id  Worker index, see restconf_worker_id
+ * @see openssl_init_socket where the sockets are opened
+ */
+static int
+restconf_native_sockets_register(clicon_handle h,
+				 int           id)
+{
+    int                     retval = -1;
+    restconf_native_handle *rh;
+    restconf_socket        *rsock;
+    restconf_socket        *rsocks = NULL; /* Sockets of this worker */
 
-	/* Create evhtp-specific struct */
-	if ((evconn = evhtp_connection_new_server(evhtp, rc->rc_s)) == NULL){
-	    clicon_err(OE_UNIX, errno, "evhtp_connection_new_server");
-	    goto done;
-	}
-	/* Mutual pointers, from generic rc to evhtp specific and from evhtp conn to generic
-	 */
-	rc->rc_evconn = evconn; /* Generic to specific */
-	evconn->arg = rc;    /* Specific to generic */
-	evconn->ssl = rc->rc_ssl; /* evhtp */
-	/* Create a default stream for http/1 */
-	if (restconf_stream_data_new(rc, 0) == NULL)
-	    goto done;
+    if ((rh = restconf_native_handle_get(h)) == NULL){
+	clicon_err(OE_XML, EFAULT, "No openssl handle");
+	return -1;
     }
-	break;
-#endif /* HAVE_LIBEVHTP */
-#ifdef HAVE_LIBNGHTTP2
-    case HTTP_2:{
-	if (http2_session_init(rc) < 0){
-	    restconf_close_ssl_socket(rc, 1);
-	    goto done;
+    while ((rsock = rh->rh_sockets) != NULL){
+	DELQ(rsock, rh->rh_sockets, restconf_socket *);
+	if (rsock->rs_worker != id){
+	    restconf_socket_free(rsock);
+	    continue;
 	}
-	if (http2_send_server_connection(rc) < 0){
-	    restconf_close_ssl_socket(rc, 1);
-#ifdef NYI
-	    if (ssl) {
-		SSL_shutdown(ssl);
-	    }
-	    bufferevent_free(session_data->bev);
-	    nghttp2_session_del(session_data->session);
-	    for (stream_data = session_data->root.next; stream_data;) {
-		http2_stream_data *next = stream_data->next;
-		delete_http2_stream_data(stream_data);
-		stream_data = next;
-	    }
-	    free(session_data->client_addr);
-	    free(session_data);
-#endif
+	ADDQ(rsock, rsocks);
+	/* ss is a server socket that the clients connect to. The callback
+	   therefore accepts clients on ss */
+	if (clixon_event_reg_fd(rsock->rs_ss, restconf_accept_client, rsock, "restconf socket") < 0) 
 	    goto done;
-	}
-	break;
     }
-#endif /* HAVE_LIBNGHTTP2 */
-    default:
-	break;
-    } /* switch proto */
-    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
-	goto done;
- ok:
     retval = 0;
  done:
-    clicon_debug(1, "%s retval %d", __FUNCTION__, retval);
-    if (name)
-	free(name);
+    /* Not registered sockets are kept for restconf_native_terminate */
+    while ((rsock = rh->rh_sockets) != NULL){
+	DELQ(rsock, rh->rh_sockets, restconf_socket *);
+	ADDQ(rsock, rsocks);
+    }
+    rh->rh_sockets = rsocks;
     return retval;
-} /* restconf_accept_client */
+}
 
 static int
 restconf_native_terminate(clicon_handle h)
@@ -1352,16 +1568,13 @@ restconf_native_terminate(clicon_handle h)
     restconf_socket        *rsock;
 
     clicon_debug(1, "%s", __FUNCTION__);
+    /* Cancel jobs before rpcs, since jobs may hold replies of rpcs */
+    restconf_threads_exit(h);
+    clicon_rpc_async_exit(h);
     if ((rh = restconf_native_handle_get(h)) != NULL){
 	while ((rsock = rh->rh_sockets) != NULL){
-	    clixon_event_unreg_fd(rsock->rs_ss, restconf_accept_client);
-	    close(rsock->rs_ss);
 	    DELQ(rsock, rh->rh_sockets, restconf_socket *);
-	    if (rsock->rs_addrstr)
-		free(rsock->rs_addrstr);
-	    if (rsock->rs_addrtype)
-		free(rsock->rs_addrtype);
-	    free(rsock);
+	    restconf_socket_free(rsock);
 	}
 	if (rh->rh_ctx)
 	    SSL_CTX_free(rh->rh_ctx);
@@ -1453,6 +1666,8 @@ restconf_clixon_backend(clicon_handle h,
 }
 
 /*! Per-socket openssl inits
+ * Open one server socket per worker, bound to the same address with SO_REUSEPORT if more
+ * than one worker. The sockets are registered for accept in restconf_native_sockets_register
  * @param[in]  h        Clicon handle
  * @param[in]  xs       XML config of single restconf socket
  * @param[in]  nsc      Namespace context
@@ -1469,6 +1684,8 @@ openssl_init_socket(clicon_handle h,
     uint16_t        ssl = 0;
     uint16_t        port = 0;
     int             ss = -1;
+    int             flags;
+    int             i;
     restconf_native_handle *rh = NULL;
     restconf_socket *rsock = NULL; /* openssl per socket struct */
 
@@ -1476,54 +1693,57 @@ openssl_init_socket(clicon_handle h,
     /* Extract socket parameters from single socket config: ns, addr, port, ssl */
     if (restconf_socket_extract(h, xs, nsc, &netns, &address, &addrtype, &port, &ssl) < 0)
 	goto done;
-    /* Open restconf socket and bind */
-    if (restconf_socket_init(netns, address, addrtype, port,
-			     SOCKET_LISTEN_BACKLOG,
-#ifdef RESTCONF_OPENSSL_NONBLOCKING
-			     SOCK_NONBLOCK, /* Also 0 is possible */
-#else /* blocking */
-			     0,
-#endif
-			     &ss
-			     ) < 0)
-	goto done;
     if ((rh = restconf_native_handle_get(h)) == NULL){
 	clicon_err(OE_XML, EFAULT, "No openssl handle");
 	goto done;
     }
-    /*
-     * Create per-socket openssl handle
-     * See restconf_native_terminate for freeing
-     */
-    if ((rsock = malloc(sizeof *rsock)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
-	goto done;
-    }
-    memset(rsock, 0, sizeof *rsock);
-    rsock->rs_h = h;
-    rsock->rs_ss = ss;
-    rsock->rs_ssl = ssl;
-    if ((rsock->rs_addrstr = strdup(address)) == NULL){
-	clicon_err(OE_UNIX, errno, "strdup");
-	goto done;
-    }
-    if ((rsock->rs_addrtype = strdup(addrtype)) == NULL){
-	clicon_err(OE_UNIX, errno, "strdup");
-	goto done;
+#ifdef RESTCONF_OPENSSL_NONBLOCKING
+    flags = SOCK_NONBLOCK; /* Also 0 is possible */
+#else /* blocking */
+    flags = 0;
+#endif
+    if (rh->rh_workers > 1)
+	flags |= CLIXON_SOCK_REUSEPORT;
+    for (i=0; i<rh->rh_workers; i++){
+	/* Open restconf socket and bind */
+	if (restconf_socket_init(netns, address, addrtype, port,
+				 SOCKET_LISTEN_BACKLOG,
+				 flags,
+				 &ss
+				 ) < 0)
+	    goto done;
+	/*
+	 * Create per-socket openssl handle
+	 * See restconf_native_terminate for freeing
+	 */
+	if ((rsock = malloc(sizeof *rsock)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    close(ss);
+	    goto done;
+	}
+	memset(rsock, 0, sizeof *rsock);
+	rsock->rs_h = h;
+	rsock->rs_ss = ss;
+	rsock->rs_ssl = ssl;
+	rsock->rs_port = port;
+	rsock->rs_worker = i;
+	INSQ(rsock, rh->rh_sockets);
+	if ((rsock->rs_addrstr = strdup(address)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	if ((rsock->rs_addrtype = strdup(addrtype)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
     }
-    rsock->rs_port = port;
-    INSQ(rsock, rh->rh_sockets);
-
-    /* ss is a server socket that the clients connect to. The callback
-       therefore accepts clients on ss */
-    if (clixon_event_reg_fd(ss, restconf_accept_client, rsock, "restconf socket") < 0) 
-	goto done;
     retval = 0;
  done:
     return retval;
 }
 
-/*! Init openssl, open and register server socket (ready for accept)
+/*! Init openssl and open server sockets
+ * The sockets are registered for accept with restconf_native_sockets_register
  * @param[in]  h         Clicon handle
  * @param[in]  dbg0      Manually set debug flag, if set overrides configuration setting
  * @param[in]  xrestconf XML tree containing restconf config
@@ -1608,6 +1828,20 @@ restconf_openssl_init(clicon_handle h,
     }
     rh = restconf_native_handle_get(h);
     rh->rh_ctx = ctx;
+    rh->rh_workers = 1;
+    if ((x = xpath_first(xrestconf, nsc, "workers")) != NULL &&
+	(bstr = xml_body(x)) != NULL &&
+	atoi(bstr) > 1)
+	rh->rh_workers = atoi(bstr);
+    rh->rh_threads = 0;
+    if ((x = xpath_first(xrestconf, nsc, "threads")) != NULL &&
+	(bstr = xml_body(x)) != NULL)
+	rh->rh_threads = atoi(bstr);
+    rh->rh_thread_queue = RESTCONF_THREAD_QUEUE_LEN;
+    if ((x = xpath_first(xrestconf, nsc, "thread-queue-length")) != NULL &&
+	(bstr = xml_body(x)) != NULL &&
+	atoi(bstr) > 0)
+	rh->rh_thread_queue = atoi(bstr);
 #ifdef HAVE_LIBEVHTP
     /* evhtp stuff */ /* XXX move this to global level */
     if ((evbase = event_base_new()) == NULL){
@@ -2047,6 +2281,18 @@ main(int    argc,
      */
     if (restconf_drop_privileges(h) < 0)
 	goto done;
+    /* Fork worker processes if configured, the supervisor returns here when terminated */
+    if ((ret = restconf_workers_run(h, rh->rh_workers)) < 0)
+	goto done;
+    if (ret == 0){
+	retval = 0;
+	goto done;
+    }
+    if (restconf_native_sockets_register(h, restconf_worker_id()) < 0)
+	goto done;
+    /* Threads for TLS handshakes and encoding of replies, one pool per worker */
+    if (restconf_threads_init(h, rh->rh_threads, rh->rh_thread_queue) < 0)
+	goto done;
 
     /* Main event loop */ 
     if (clixon_event_loop(h) < 0)
@@ -63,6 +63,344 @@
 #include "restconf_err.h"
 #include "restconf_methods_get.h"
 
+/* GET waiting for asynchronous backend reply, see api_data_get2_async_cb
+ */
+struct api_data_get_async {
+    void          *ga_req;       /* Generic Www handle */
+    char          *ga_xpath;     /* Path of requested data */
+    cvec          *ga_nsc;       /* Namespace context of ga_xpath */
+    int            ga_pretty;
+    restconf_media ga_media_out;
+    int            ga_head;      /* HEAD or GET */
+};
+
+/* Encoding of GET reply, in a thread if possible, see api_data_get2_encode
+ */
+struct api_data_get_encode {
+    void          *ge_req;       /* Generic Www handle */
+    cxobj         *ge_xret;      /* Backend reply, owned if encoded in a thread */
+    cxobj        **ge_xvec;      /* Requested objects in ge_xret, or NULL for data root */
+    size_t         ge_xlen;
+    int            ge_pretty;
+    restconf_media ge_media_out;
+    int            ge_head;      /* HEAD or GET */
+    cbuf          *ge_cb;        /* Encoded reply */
+};
+
+static int
+api_data_get2_encode_free(struct api_data_get_encode *ge)
+{
+    if (ge->ge_xret)
+	xml_free(ge->ge_xret);
+    if (ge->ge_xvec)
+	free(ge->ge_xvec);
+    if (ge->ge_cb)
+	cbuf_free(ge->ge_cb);
+    free(ge);
+    return 0;
+}
+
+/*! Encode reply of GET as XML or JSON
+ * Only prints the tree, so that it can be made in a thread, see restconf_reply_offload
+ * @param[in]  arg   Encoding of GET reply
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+api_data_get2_encode(void *arg)
+{
+    int                         retval = -1;
+    struct api_data_get_encode *ge = (struct api_data_get_encode *)arg;
+    int                         i;
+
+    if (ge->ge_xvec == NULL){ /* Special case: data root */
+	switch (ge->ge_media_out){
+	case YANG_DATA_XML:
+	    if (clicon_xml2cbuf(ge->ge_cb, ge->ge_xret, 0, ge->ge_pretty, -1) < 0) /* Dont print top object?  */
+		goto done;
+	    break;
+	case YANG_DATA_JSON:
+	    if (xml2json_cbuf(ge->ge_cb, ge->ge_xret, ge->ge_pretty) < 0)
+		goto done;
+	    break;
+	default:
+	    break;
+	}
+    }
+    else{
+	switch (ge->ge_media_out){
+	case YANG_DATA_XML:
+	    for (i=0; i<ge->ge_xlen; i++)
+		if (clicon_xml2cbuf(ge->ge_cb, ge->ge_xvec[i], 0, ge->ge_pretty, -1) < 0) /* Dont print top object?  */
+		    goto done;
+	    break;
+	case YANG_DATA_JSON:
+	    /* In: <x xmlns="urn:example:clixon">0</x>
+	     * Out: {"example:x": {"0"}}
+	     */
+	    if (xml2json_cbuf_vec(ge->ge_cb, ge->ge_xvec, ge->ge_xlen, ge->ge_pretty) < 0)
+		goto done;
+	    break;
+	default:
+	    break;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send encoded reply of GET
+ * @param[in]  h     Clixon handle
+ * @param[in]  ge    Encoding of GET reply, reply buffer is consumed
+ */
+static int
+api_data_get2_encode_send(clicon_handle               h,
+			  struct api_data_get_encode *ge)
+{
+    int   retval = -1;
+    void *req = ge->ge_req;
+
+    clicon_debug(1, "%s cbuf:%s", __FUNCTION__, cbuf_get(ge->ge_cb));
+    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(ge->ge_media_out)) < 0)
+	goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+	goto done;
+    if (restconf_reply_send(req, 200, ge->ge_cb, ge->ge_head) < 0)
+	goto done;
+    ge->ge_cb = NULL;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Reply of GET encoded in a thread is done, send reply
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: encoded, 0: canceled, -1: failed
+ * @param[in]  arg     Encoding of GET reply, freed here
+ * @see api_data_get2_reply where the encoding is submitted
+ */
+static int
+api_data_get2_encode_done(clicon_handle h,
+			  int           status,
+			  void         *arg)
+{
+    int                         retval = -1;
+    struct api_data_get_encode *ge = (struct api_data_get_encode *)arg;
+    cxobj                      *xerr = NULL;
+
+    clicon_debug(1, "%s status:%d", __FUNCTION__, status);
+    switch (status){
+    case 1:
+	if (api_data_get2_encode_send(h, ge) < 0)
+	    goto done;
+	break;
+    case 0: /* Canceled, request is gone */
+	goto ok;
+	break;
+    default:
+	if (netconf_operation_failed_xml(&xerr, "application", "Encoding of reply failed") < 0)
+	    goto done;
+	if (api_return_err0(h, ge->ge_req, xerr, ge->ge_pretty, ge->ge_media_out, 0) < 0)
+	    goto done;
+	break;
+    }
+    if (restconf_reply_resume(ge->ge_req) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    api_data_get2_encode_free(ge);
+    return retval;
+}
+
+/*! Make reply of GET from backend get reply
+ * The reply is encoded in a thread if the request is suspended and there are restconf
+ * threads, otherwise here.
+ * @param[in]     h        Clixon handle
+ * @param[in]     req      Generic Www handle
+ * @param[in,out] xretp    Backend reply, data or error. Set to NULL if taken over by thread
+ * @param[in]     xpath    Path of requested data
+ * @param[in]     nsc      Namespace context of xpath
+ * @param[in]     pretty   Set to 1 for pretty-printed xml/json output
+ * @param[in]     media_out Output media
+ * @param[in]     head     If 1 is HEAD, otherwise GET
+ * @retval        0        OK, reply sent
+ * @retval        1        OK, reply is encoded in a thread and sent by api_data_get2_encode_done
+ * @retval       -1        Error
+ * @see api_data_get2
+ */
+static int
+api_data_get2_reply(clicon_handle  h,
+		    void          *req,
+		    cxobj        **xretp,
+		    char          *xpath,
+		    cvec          *nsc,
+		    int            pretty,
+		    restconf_media media_out,
+		    int            head)
+{
+    int        retval = -1;
+    cxobj     *xret = *xretp;
+    cxobj     *xerr = NULL; /* malloced */
+    cxobj     *xe = NULL;   /* not malloced */
+    cxobj    **xvec = NULL;
+    size_t     xlen = 0;
+    int        i;
+    cxobj     *x;
+    char      *namespace = NULL;
+    struct api_data_get_encode *ge = NULL;
+    int        ret;
+
+    /* We get return via netconf which is complete tree from root 
+     * We need to cut that tree to only the object.
+     */
+#if 0 /* DEBUG */
+    if (clicon_debug_get())
+	clicon_log_xml(LOG_DEBUG, xret, "%s xret:", __FUNCTION__);
+#endif
+    /* Check if error return  */
+    if ((xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Normal return, no error. Special case data root: whole reply, xvec is NULL */
+    if (xpath != NULL && strcmp(xpath,"/") != 0){
+	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath) < 0){
+	    if (netconf_operation_failed_xml(&xerr, "application", clicon_err_reason) < 0)
+		goto done;
+	    if (api_return_err0(h, req, xerr, pretty, media_out, 0) < 0)
+		goto done;
+	    goto ok;
+	}
+	/* Check if not exists */
+	if (xlen == 0){
+	    /* 4.3: If a retrieval request for a data resource represents an 
+	       instance that does not exist, then an error response containing 
+	       a "404 Not Found" status-line MUST be returned by the server.  
+	       The error-tag value "invalid-value" is used in this case. */
+	    if (netconf_invalid_value_xml(&xerr, "application", "Instance does not exist") < 0)
+		goto done;
+	    /* override invalid-value default 400 with 404 */
+	    if (api_return_err0(h, req, xerr, pretty, media_out, 404) < 0)
+		goto done;
+	    goto ok;
+	}
+	if (media_out == YANG_DATA_XML)
+	    for (i=0; i<xlen; i++){
+		char *prefix;
+		x = xvec[i];
+		/* Some complexities in grafting namespace in existing trees to new */
+		prefix = xml_prefix(x);
+		if (xml_find_type_value(x, prefix, "xmlns", CX_ATTR) == NULL){
+		    if (xml2ns(x, prefix, &namespace) < 0)
+			goto done;
+		    if (namespace && xmlns_set(x, prefix, namespace) < 0)
+			goto done;
+		}
+	    }
+    }
+    if ((ge = malloc(sizeof(*ge))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ge, 0, sizeof(*ge));
+    ge->ge_req = req;
+    ge->ge_xvec = xvec;
+    xvec = NULL;
+    ge->ge_xlen = xlen;
+    ge->ge_pretty = pretty;
+    ge->ge_media_out = media_out;
+    ge->ge_head = head;
+    if ((ge->ge_cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    ge->ge_xret = xret; /* Owned by ge if submitted */
+    if ((ret = restconf_reply_offload(req, api_data_get2_encode, api_data_get2_encode_done, ge)) < 0){
+	ge->ge_xret = NULL;
+	goto done;
+    }
+    if (ret == 1){
+	*xretp = NULL;
+	ge = NULL;
+	retval = 1;
+	goto done;
+    }
+    ge->ge_xret = NULL;
+    if (api_data_get2_encode(ge) < 0)
+	goto done;
+    if (api_data_get2_encode_send(h, ge) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (ge)
+	api_data_get2_encode_free(ge);
+    if (xerr)
+	xml_free(xerr);
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
+/*! Asynchronous backend get reply of GET, make and send reply
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: reply in xret, 0: canceled, -1: failed
+ * @param[in]  xret    Backend reply, data or error, freed here
+ * @param[in]  arg     GET state, freed here
+ * @see api_data_get2 where the get is sent
+ */
+static int
+api_data_get2_async_cb(clicon_handle h,
+		       int           status,
+		       cxobj        *xret,
+		       void         *arg)
+{
+    int                        retval = -1;
+    struct api_data_get_async *ga = (struct api_data_get_async *)arg;
+    cxobj                     *xerr = NULL;
+    int                        ret;
+
+    clicon_debug(1, "%s status:%d", __FUNCTION__, status);
+    switch (status){
+    case 1:
+	if ((ret = api_data_get2_reply(h, ga->ga_req, &xret, ga->ga_xpath, ga->ga_nsc,
+				       ga->ga_pretty, ga->ga_media_out, ga->ga_head)) < 0)
+	    goto done;
+	if (ret == 1) /* Reply is sent when encoded, see api_data_get2_encode_done */
+	    goto ok;
+	break;
+    case 0: /* Canceled, request is gone */
+	goto ok;
+	break;
+    default:
+	if (netconf_operation_failed_xml(&xerr, "protocol", clicon_err_reason) < 0)
+	    goto done;
+	if (api_return_err0(h, ga->ga_req, xerr, ga->ga_pretty, ga->ga_media_out, 0) < 0)
+	    goto done;
+	break;
+    }
+    if (restconf_reply_resume(ga->ga_req) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xret)
+	xml_free(xret);
+    if (xerr)
+	xml_free(xerr);
+    if (ga->ga_xpath)
+	free(ga->ga_xpath);
+    if (ga->ga_nsc)
+	xml_nsctx_free(ga->ga_nsc);
+    free(ga);
+    return retval;
+}
+
 /*! Generic GET (both HEAD and GET)
  * According to restconf 
  * @param[in]  h        Clixon handle
@@ -90,6 +428,8 @@
  * encoding is used in the response, then an error response containing a
  * "400 Bad Request" status-line MUST be returned by the server.
  * Netconf: <get-config>, <get>                        
+ * @note If the request can be replied later, eg a http/2 stream, the get is sent to the
+ * backend without waiting, and the reply is made by api_data_get2_async_cb.
  */
 static int
 api_data_get2(clicon_handle  h,
@@ -104,17 +444,11 @@ api_data_get2(clicon_handle  h,
 {
     int        retval = -1;
     char      *xpath = NULL;
-    cbuf      *cbx = NULL;
     yang_stmt *yspec;
     cxobj     *xret = NULL;
     cxobj     *xerr = NULL; /* malloced */
-    cxobj     *xe = NULL;   /* not malloced */
-    cxobj    **xvec = NULL;
-    size_t     xlen;
     int        i;
-    cxobj     *x;
     int        ret;
-    char      *namespace = NULL;
     cvec      *nsc = NULL;
     char      *attr; /* attribute value string */
     netconf_content content = CONTENT_ALL;
@@ -122,6 +456,8 @@ api_data_get2(clicon_handle  h,
     cxobj     *xtop = NULL;
     cxobj     *xbot = NULL;
     yang_stmt *y = NULL;
+    struct api_data_get_async *ga = NULL;
+    uint32_t   id;
     
     clicon_debug(1, "%s", __FUNCTION__);
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
@@ -187,7 +523,31 @@ api_data_get2(clicon_handle  h,
     case CONTENT_CONFIG:
     case CONTENT_NONCONFIG:
     case CONTENT_ALL:
-	ret = clicon_rpc_get(h, xpath, nsc, content, depth, &xret);
+	if (restconf_reply_async(req)){
+	    /* Reply when backend replies, meanwhile handle other requests */
+	    if ((ga = malloc(sizeof(*ga))) == NULL){
+		clicon_err(OE_UNIX, errno, "malloc");
+		goto done;
+	    }
+	    memset(ga, 0, sizeof(*ga));
+	    ga->ga_req = req;
+	    ga->ga_xpath = xpath;
+	    ga->ga_nsc = nsc;
+	    ga->ga_pretty = pretty;
+	    ga->ga_media_out = media_out;
+	    ga->ga_head = head;
+	    if ((ret = clicon_rpc_get_async(h, xpath, nsc, content, depth,
+					    api_data_get2_async_cb, ga, &id)) == 0){
+		xpath = NULL;  /* Now owned by ga */
+		nsc = NULL;
+		ga = NULL;
+		if (restconf_reply_suspend(req, id) < 0)
+		    goto done;
+		goto ok;
+	    }
+	}
+	else
+	    ret = clicon_rpc_get(h, xpath, nsc, content, depth, &xret);
 	break;
     default:
 	clicon_err(OE_XML, EINVAL, "Invalid content attribute %d", content);
@@ -201,111 +561,24 @@ api_data_get2(clicon_handle  h,
 	    goto done;
 	goto ok;
     }
-    /* We get return via netconf which is complete tree from root 
-     * We need to cut that tree to only the object.
-     */
-#if 0 /* DEBUG */
-    if (clicon_debug_get())
-	clicon_log_xml(LOG_DEBUG, xret, "%s xret:", __FUNCTION__);
-#endif
-    /* Check if error return  */
-    if ((xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
-	if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
-	    goto done;
-	goto ok;
-    }
-    /* Normal return, no error */
-    if ((cbx = cbuf_new()) == NULL)
-	goto done;
-    if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
-	switch (media_out){
-	case YANG_DATA_XML:
-	    if (clicon_xml2cbuf(cbx, xret, 0, pretty, -1) < 0) /* Dont print top object?  */
-		goto done;
-	    break;
-	case YANG_DATA_JSON:
-	    if (xml2json_cbuf(cbx, xret, pretty) < 0)
-		goto done;
-	    break;
-	default:
-	    break;
-	}
-    }
-    else{
-	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath) < 0){
-	    if (netconf_operation_failed_xml(&xerr, "application", clicon_err_reason) < 0)
-		goto done;
-	    if (api_return_err0(h, req, xerr, pretty, media_out, 0) < 0)
-		goto done;
-	    goto ok;
-	}
-	/* Check if not exists */
-	if (xlen == 0){
-	    /* 4.3: If a retrieval request for a data resource represents an 
-	       instance that does not exist, then an error response containing 
-	       a "404 Not Found" status-line MUST be returned by the server.  
-	       The error-tag value "invalid-value" is used in this case. */
-	    if (netconf_invalid_value_xml(&xerr, "application", "Instance does not exist") < 0)
-		goto done;
-	    /* override invalid-value default 400 with 404 */
-	    if (api_return_err0(h, req, xerr, pretty, media_out, 404) < 0)
-		goto done;
-	    goto ok;
-	}
-	switch (media_out){
-	case YANG_DATA_XML:
-	    for (i=0; i<xlen; i++){
-		char *prefix;
-		x = xvec[i];
-		/* Some complexities in grafting namespace in existing trees to new */
-		prefix = xml_prefix(x);
-		if (xml_find_type_value(x, prefix, "xmlns", CX_ATTR) == NULL){
-		    if (xml2ns(x, prefix, &namespace) < 0)
-			goto done;
-		    if (namespace && xmlns_set(x, prefix, namespace) < 0)
-			goto done;
-		}
-		if (clicon_xml2cbuf(cbx, x, 0, pretty, -1) < 0) /* Dont print top object?  */
-		    goto done;
-	    }
-	    break;
-	case YANG_DATA_JSON:
-	    /* In: <x xmlns="urn:example:clixon">0</x>
-	     * Out: {"example:x": {"0"}}
-	     */
-	    if (xml2json_cbuf_vec(cbx, xvec, xlen, pretty) < 0)
-		goto done;
-	    break;
-	default:
-	    break;
-	}
-    }
-    clicon_debug(1, "%s cbuf:%s", __FUNCTION__, cbuf_get(cbx));
-    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+    if (api_data_get2_reply(h, req, &xret, xpath, nsc, pretty, media_out, head) < 0)
 	goto done;
-    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
-	goto done;
-    if (restconf_reply_send(req, 200, cbx, head) < 0)
-	goto done;
-    cbx = NULL;
  ok:
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (ga)
+	free(ga);
     if (xpath)
 	free(xpath);
     if (nsc)
 	xml_nsctx_free(nsc);
     if (xtop)
         xml_free(xtop);
-    if (cbx)
-        cbuf_free(cbx);
     if (xret)
 	xml_free(xret);
     if (xerr)
 	xml_free(xerr);
-    if (xvec)
-	free(xvec);
     return retval;
 }
 
@@ -76,6 +76,18 @@
 #include <nghttp2/nghttp2.h>
 #endif
 #include "restconf_native.h"    /* Restconf-openssl mode specific headers*/
+#include "restconf_worker.h"
+#include "restconf_threads.h"
+
+/* Output buffers larger than this are freed when written, and compacted when
+ * this much is written */
+#define RESTCONF_OUTP_KEEP 65536
+
+/* High-water mark of unwritten output per connection: above it no more input is read
+ * and no more http/2 frames are sent, see restconf_conn_output_full */
+#define RESTCONF_OUTP_HIWAT (1024*1024)
+
+static int restconf_conn_output(int s, void *arg);
 
 restconf_stream_data *
 restconf_stream_data_new(restconf_conn *rc,
@@ -126,6 +138,10 @@ restconf_stream_find(restconf_conn *rc,
 int
 restconf_stream_free(restconf_stream_data *sd)
 {
+    if (sd->sd_rpc_id)
+	clicon_rpc_async_cancel(sd->sd_conn->rc_h, sd->sd_rpc_id);
+    if (sd->sd_job_id)
+	restconf_threads_cancel(sd->sd_conn->rc_h, sd->sd_job_id);
     if (sd->sd_fd != -1) {
 	close(sd->sd_fd);
     }
@@ -162,6 +178,7 @@ restconf_conn_new(clicon_handle h,
     memset(rc, 0, sizeof(restconf_conn));
     rc->rc_h = h;
     rc->rc_s = s;
+    restconf_worker_self()->rw_conns++;
     return rc;
 }
 
@@ -191,7 +208,296 @@ restconf_conn_free(restconf_conn *rc)
 	if (sd)
 	    restconf_stream_free(sd);
     }
+    if (rc->rc_outp_reg)
+	clixon_event_unreg_fd_out(rc->rc_s, restconf_conn_output);
+    if (rc->rc_outp)
+	cbuf_free(rc->rc_outp);
     free(rc);
+    restconf_worker_self()->rw_conns--;
+    return 0;
+}
+
+/*! Register or deregister output callback depending on connection state
+ * Output is waited for if there is unwritten output, or an operation to resume.
+ * @param[in]  rc   restconf connection
+ */
+static int
+restconf_conn_output_update(restconf_conn *rc)
+{
+    int want;
+
+    want = rc->rc_resume != NULL ||
+	(rc->rc_outp && rc->rc_outp_offset < cbuf_len(rc->rc_outp) && !rc->rc_outp_wantread);
+    if (want && !rc->rc_outp_reg){
+	if (clixon_event_reg_fd_out(rc->rc_s, restconf_conn_output, (void*)rc, "restconf client output") < 0)
+	    return -1;
+	rc->rc_outp_reg = 1;
+    }
+    else if (!want && rc->rc_outp_reg){
+	clixon_event_unreg_fd_out(rc->rc_s, restconf_conn_output);
+	rc->rc_outp_reg = 0;
+    }
+    return 0;
+}
+
+/*! Write data to connection socket without blocking
+ * @param[in]  rc    restconf connection
+ * @param[in]  buf   Data
+ * @param[in]  len   Length of data
+ * @param[out] nw    Number of bytes written
+ * @retval     1     All data written, or discarded since the peer has closed the connection
+ * @retval     0     Not all data written, socket would block or SSL needs input first
+ * @retval    -1     Error
+ */
+static int
+restconf_conn_send(restconf_conn *rc,
+		   char          *buf,
+		   size_t         len,
+		   size_t        *nw)
+{
+    ssize_t n;
+    int     er;
+
+    *nw = 0;
+    rc->rc_outp_wantread = 0;
+    while (*nw < len){
+	if (rc->rc_ssl){
+	    if ((n = SSL_write(rc->rc_ssl, buf + *nw, len - *nw)) <= 0){
+		er = errno;
+		switch (SSL_get_error(rc->rc_ssl, n)){
+		case SSL_ERROR_WANT_WRITE:           /* 3 */
+		    return 0;
+		case SSL_ERROR_WANT_READ:            /* 2 */
+		    clicon_debug(1, "%s SSL_ERROR_WANT_READ", __FUNCTION__);
+		    rc->rc_outp_wantread = 1;
+		    return 0;
+		case SSL_ERROR_SYSCALL:              /* 5 */
+		    if (er == EAGAIN || er == EWOULDBLOCK)
+			return 0;
+		    if (er == ECONNRESET || er == EPIPE) /* Closed when read returns eof */
+			return 1;
+		    clicon_err(OE_RESTCONF, er, "SSL_write %d", er);
+		    return -1;
+		default:
+		    clicon_err(OE_SSL, 0, "SSL_write");
+		    return -1;
+		}
+	    }
+	}
+	else if ((n = write(rc->rc_s, buf + *nw, len - *nw)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		return 0;
+	    if (errno == ECONNRESET || errno == EPIPE) /* Closed when read returns eof */
+		return 1;
+	    clicon_err(OE_UNIX, errno, "write");
+	    return -1;
+	}
+	*nw += n;
+    }
+    return 1;
+}
+
+/*! Write as much as possible of the unwritten output of a connection
+ * @param[in]  rc   restconf connection
+ * @retval     0    OK, unwritten output remains if socket would block
+ * @retval    -1    Error
+ */
+int
+restconf_conn_flush(restconf_conn *rc)
+{
+    int    ret;
+    size_t nw;
+
+    if (rc->rc_outp == NULL)
+	return 0;
+    if ((ret = restconf_conn_send(rc, cbuf_get(rc->rc_outp) + rc->rc_outp_offset,
+				  cbuf_len(rc->rc_outp) - rc->rc_outp_offset, &nw)) < 0)
+	return -1;
+    rc->rc_outp_offset += nw;
+    if (ret == 1){
+	if (cbuf_buflen(rc->rc_outp) > RESTCONF_OUTP_KEEP){
+	    cbuf_free(rc->rc_outp);
+	    rc->rc_outp = NULL;
+	}
+	else
+	    cbuf_reset(rc->rc_outp);
+	rc->rc_outp_offset = 0;
+    }
+    return restconf_conn_output_update(rc);
+}
+
+/*! Write data to a connection, queue what the socket does not accept without blocking
+ *
+ * Output is written in order. Queued output is written when the socket is writable,
+ * without blocking other connections.
+ * @param[in]  rc    restconf connection
+ * @param[in]  buf   Data
+ * @param[in]  len   Length of data
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+restconf_conn_write(restconf_conn *rc,
+		    char          *buf,
+		    size_t         len)
+{
+    int    retval = -1;
+    int    ret;
+    size_t nw = 0;
+    cbuf  *cb;
+
+    /* Two problems with debugging buffers from libevent that this fixes:
+     * 1. they are not "strings" in the sense they are not NULL-terminated
+     * 2. they are often very long
+     */
+    if (clicon_debug_get()) { 
+	char *dbgstr = NULL;
+	size_t sz;
+	sz = len>256?256:len; /* Truncate to 256 */
+	if ((dbgstr = malloc(sz+1)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memcpy(dbgstr, buf, sz);
+	dbgstr[sz] = '\0';
+	clicon_debug(1, "%s buflen:%zu buf:%s", __FUNCTION__, len, dbgstr);
+	free(dbgstr);
+    }
+    if (rc->rc_outp == NULL || rc->rc_outp_offset == cbuf_len(rc->rc_outp)){
+	/* Nothing queued: write directly */
+	if ((ret = restconf_conn_send(rc, buf, len, &nw)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
+    if (rc->rc_outp == NULL && (rc->rc_outp = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Compact: move unwritten output to a new buffer */
+    if (rc->rc_outp_offset >= RESTCONF_OUTP_KEEP &&
+	rc->rc_outp_offset >= cbuf_len(rc->rc_outp)/2){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (cbuf_append_buf(cb, cbuf_get(rc->rc_outp) + rc->rc_outp_offset,
+			    cbuf_len(rc->rc_outp) - rc->rc_outp_offset) < 0){
+	    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	    cbuf_free(cb);
+	    goto done;
+	}
+	cbuf_free(rc->rc_outp);
+	rc->rc_outp = cb;
+	rc->rc_outp_offset = 0;
+    }
+    if (cbuf_append_buf(rc->rc_outp, buf + nw, len - nw) < 0){
+	clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	goto done;
+    }
+    if (restconf_conn_output_update(rc) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Resume an operation on a connection when its socket is writable
+ * Used when an SSL operation, eg SSL_read or SSL_accept, needs to write
+ * @param[in]  rc    restconf connection
+ * @param[in]  fn    Function to call with socket and rc as arguments
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+restconf_conn_resume(restconf_conn *rc,
+		     int          (*fn)(int, void*))
+{
+    rc->rc_resume = fn;
+    return restconf_conn_output_update(rc);
+}
+
+/*! Check if unwritten output of a connection is above the high-water mark
+ * Then the connection should not produce more output: input is not read, and http/2
+ * frames are not sent, until output is written.
+ * @param[in]  rc   restconf connection
+ * @retval     1    Above high-water mark
+ * @retval     0    Below
+ */
+int
+restconf_conn_output_full(restconf_conn *rc)
+{
+    return rc->rc_outp != NULL &&
+	cbuf_len(rc->rc_outp) - rc->rc_outp_offset > RESTCONF_OUTP_HIWAT;
+}
+
+/*! Close a connection when its unwritten output is written, eg after an error reply
+ * The caller has stopped reading input from the connection.
+ * If SSL_write needs input first, the connection is closed and the output discarded.
+ * @param[in]  rc   restconf connection, freed here or when output is written
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see restconf_conn_output
+ */
+int
+restconf_conn_close_written(restconf_conn *rc)
+{
+    if (rc->rc_outp && rc->rc_outp_offset < cbuf_len(rc->rc_outp) &&
+	!rc->rc_outp_wantread){
+	clicon_debug(1, "%s %d close when written", __FUNCTION__, rc->rc_s);
+	rc->rc_close = 1;
+	rc->rc_resume = NULL;
+	return restconf_conn_output_update(rc);
+    }
+    if (restconf_close_ssl_socket(rc, 0) < 0)
+	return -1;
+    return restconf_conn_free(rc);
+}
+
+/*! Output callback: connection socket is writable
+ * Write unwritten output and resume a waiting operation
+ * @param[in]  s    Socket
+ * @param[in]  arg  restconf connection
+ * @see restconf_conn_write
+ * @see restconf_conn_resume
+ */
+static int
+restconf_conn_output(int   s,
+		     void *arg)
+{
+    restconf_conn *rc = (restconf_conn *)arg;
+    int          (*fn)(int, void*);
+#ifdef HAVE_LIBNGHTTP2
+    int            ngerr;
+#endif
+
+    clicon_debug(1, "%s %d", __FUNCTION__, s);
+    if (restconf_conn_flush(rc) < 0)
+	return -1;
+    if (rc->rc_close){
+	if (rc->rc_outp == NULL || rc->rc_outp_offset == cbuf_len(rc->rc_outp) ||
+	    rc->rc_outp_wantread)
+	    return restconf_conn_close_written(rc);
+	return 0;
+    }
+#ifdef HAVE_LIBNGHTTP2
+    /* Send frames that nghttp2 held back above the mark, see session_send_callback */
+    if (rc->rc_ngsession && !restconf_conn_output_full(rc) &&
+	nghttp2_session_want_write(rc->rc_ngsession)){
+	if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+	    clicon_err(OE_NGHTTP2, ngerr, "nghttp2_session_send");
+	    return -1;
+	}
+    }
+#endif
+    if ((fn = rc->rc_resume) != NULL){
+	if (restconf_conn_resume(rc, NULL) < 0)
+	    return -1;
+	return fn(s, rc);
+    }
     return 0;
 }
 
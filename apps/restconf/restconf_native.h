@@ -82,6 +82,8 @@ typedef struct  {
     void                 *sd_req;       /* Lib-specific request, eg evhtp_request_t * */
     int                   sd_upgrade2;  /* Upgrade to http/2 */
     uint8_t              *sd_settings2; /* Settings for upgrade to http/2 request */
+    uint32_t              sd_rpc_id;    /* Pending asynchronous backend rpc, see restconf_reply_suspend */
+    uint32_t              sd_job_id;    /* Pending job in thread, see restconf_reply_offload */
 } restconf_stream_data;
 
 /* Restconf connection handle 
@@ -95,6 +97,13 @@ typedef struct restconf_conn {
     clicon_handle       rc_h;         /* Clixon handle */
     SSL                *rc_ssl;       /* Structure for SSL connection */
     restconf_stream_data *rc_streams; /* List of http/2 session streams */
+    cbuf               *rc_outp;      /* Output not yet written to socket, or NULL */
+    size_t              rc_outp_offset; /* Start of unwritten output in rc_outp */
+    int                 rc_outp_reg;  /* Output callback registered, see restconf_conn_output */
+    int                 rc_outp_wantread; /* SSL_write needs input first, retried on input */
+    int               (*rc_resume)(int, void*); /* Resume when socket is writable, or NULL */
+    int                 rc_paused;    /* Input not read until output is written, see restconf_conn_output_full */
+    int                 rc_close;     /* Close when output is written, see restconf_conn_close_written */
     /* Decision to keep lib-specific data here, otherwise new struct necessary
      * drawback is specific includes need to go everywhere */
 #ifdef HAVE_LIBEVHTP
@@ -116,6 +125,7 @@ typedef struct {
                                    eg inet:ipv4-address or inet:ipv6-address */
     char         *rs_addrstr;   /* Address as string, eg 127.0.0.1, ::1 */
     uint16_t      rs_port;      /* Protocol port */
+    int           rs_worker;    /* Index of worker accepting on this socket, see restconf_worker_id */
 } restconf_socket;
 
 /* Restconf handle 
@@ -125,6 +135,9 @@ typedef struct {
     SSL_CTX         *rh_ctx;       /* SSL context */
     restconf_socket *rh_sockets;   /* List of restconf server (ready for accept) sockets */
     void            *rh_arg;       /* Packet specific handle (eg evhtp) */
+    int              rh_workers;   /* Number of worker processes, see restconf_workers_run */
+    int              rh_threads;   /* Number of threads per worker, see restconf_threads_init */
+    int              rh_thread_queue; /* Max number of jobs waiting for a thread */
 } restconf_native_handle;
 
 /*
@@ -135,6 +148,11 @@ restconf_stream_data *restconf_stream_find(restconf_conn *rc, int32_t id);
 int               restconf_stream_free(restconf_stream_data *sd);
 restconf_conn    *restconf_conn_new(clicon_handle h, int s);
 int               restconf_conn_free(restconf_conn *rc);
+int               restconf_conn_flush(restconf_conn *rc);
+int               restconf_conn_write(restconf_conn *rc, char *buf, size_t len);
+int               restconf_conn_resume(restconf_conn *rc, int (*fn)(int, void*));
+int               restconf_conn_output_full(restconf_conn *rc);
+int               restconf_conn_close_written(restconf_conn *rc);
 int               ssl_x509_name_oneline(SSL *ssl, char **oneline);
 
 int restconf_close_ssl_socket(restconf_conn *rc, int shutdown); /* XXX in restconf_main_native.c */
@@ -99,6 +99,7 @@
 #include "restconf_err.h"
 #include "restconf_root.h"
 #include "restconf_native.h"    /* Restconf-openssl mode specific headers*/
+#include "restconf_worker.h"
 #ifdef HAVE_LIBNGHTTP2 
 #include "restconf_nghttp2.h"   /* Restconf-openssl mode specific headers*/
 
@@ -166,7 +167,10 @@ nghttp2_print_headers(nghttp2_nv *nva,
  * `nghttp2_session_send()` to send data to the remote endpoint.  If
  * the application uses solely `nghttp2_session_mem_send()` instead,
  * this callback function is unnecessary.
- * XXX see buf_write
+ * Data that cannot be written without blocking is queued on the connection.
+ * Above the high-water mark of the queue, nghttp2 is told that the socket would block,
+ * and sends again when the queue is written, see restconf_conn_output
+ * @see restconf_conn_write
  */
 static ssize_t
 session_send_callback(nghttp2_session *session,
@@ -175,92 +179,14 @@ session_send_callback(nghttp2_session *session,
 		      int              flags,
 		      void            *user_data)
 {
-    int            retval = -1;
     restconf_conn *rc = (restconf_conn *)user_data;
-    int            er;
-    ssize_t        len;
-    ssize_t        totlen = 0;
-    int            s;
-    SSL           *ssl; 
-    int            sslerr;
-    
+
     clicon_debug(1, "%s buflen:%zu", __FUNCTION__, buflen);
-    s = rc->rc_s;
-    ssl = rc->rc_ssl;
-    while (totlen < buflen){
-	if (ssl){
-	    if ((len = SSL_write(ssl, buf+totlen, buflen-totlen)) <= 0){
-		er = errno;
-		sslerr = SSL_get_error(ssl, len);
-		clicon_debug(1, "%s errno:;%d sslerr:%d", __FUNCTION__, errno, sslerr);
-		switch (sslerr){
-		case SSL_ERROR_WANT_WRITE:           /* 3 */
-		    clicon_debug(1, "%s write SSL_ERROR_WANT_WRITE", __FUNCTION__);
-		    usleep(1000);
-		    continue;
-		    break;
-		case SSL_ERROR_SYSCALL:              /* 5 */
-		    if (er == ECONNRESET) {/* Connection reset by peer */
-			if (ssl)
-			    SSL_free(ssl);
-			close(s);
-			// XXX			clixon_event_unreg_fd(s, restconf_connection);
-			goto ok; /* Close socket and ssl */
-		    }
-		    else if (er == EAGAIN){
-			/* same as want_write above, but different behaviour on different 
-			 * platforms, linux here, freebsd want_write, or possibly differnt
-			 * ssl lib versions?
-			 */
-			clicon_debug(1, "%s write EAGAIN", __FUNCTION__);
-			usleep(1000);
-			continue;
-		    }
-		    else{
-			clicon_err(OE_RESTCONF, er, "SSL_write %d", er);
-			goto done;
-		    }
-		    break;
-		default:
-		    clicon_err(OE_SSL, 0, "SSL_write");
-		    goto done;
-		    break;
-		}
-		goto done;
-	    }
-	}
-	else{
-	    if ((len = write(s, buf+totlen, buflen-totlen)) < 0){
-		if (errno == EAGAIN){
-		    clicon_debug(1, "%s write EAGAIN", __FUNCTION__);
-		    usleep(10000);
-		    continue;
-		}
-#if 1
-		else if (errno == ECONNRESET) {/* Connection reset by peer */
-		    close(s);
-		    // XXX		    clixon_event_unreg_fd(s, restconf_connection);
-		    goto ok; /* Close socket and ssl */
-		}
-#endif
-		else{
-		    clicon_err(OE_UNIX, errno, "write");
-		    goto done;
-		}
-	    }
-	    assert(len != 0);
-	}
-	totlen += len;
-    } /* while */
- ok:
-    retval = 0;
- done:
-    if (retval < 0){
-	clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
-	return retval;
-    }
-    clicon_debug(1, "%s retval:%zd", __FUNCTION__, totlen);
-    return totlen;
+    if (restconf_conn_output_full(rc))
+	return NGHTTP2_ERR_WOULDBLOCK;
+    if (restconf_conn_write(rc, (char*)buf, buflen) < 0)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    return buflen;
 }
 
 /*! Invoked when |session| wants to receive data from the remote peer.  
@@ -320,6 +246,7 @@ restconf_nghttp2_path(restconf_stream_data *sd)
 	    }
 	}
     }
+    restconf_worker_self()->rw_requests++;
     /* call generic function */
     if (strcmp(sd->sd_path, RESTCONF_WELL_KNOWN) == 0){
 	if (api_well_known(h, sd) < 0)
@@ -454,6 +381,38 @@ restconf_submit_response(nghttp2_session      *session,
     return retval;
 }
 
+/*! Submit reply of a stream
+ */
+static int
+http2_reply(restconf_conn        *rc,
+	    restconf_stream_data *sd,
+	    nghttp2_session      *session,
+	    int32_t               stream_id)
+{
+    int retval = -1;
+
+    /* If body, add a content-length header 
+     *    A server MUST NOT send a Content-Length header field in any response
+     * with a status code of 1xx (Informational) or 204 (No Content).  A
+     * server MUST NOT send a Content-Length header field in any 2xx
+     * (Successful) response to a CONNECT request (Section 4.3.6 of
+     * [RFC7231]).
+     */
+    if (sd->sd_code != 204 && sd->sd_code > 199)
+	if (restconf_reply_header(sd, "Content-Length", "%zu", sd->sd_body_len) < 0)
+	    goto done;	
+    if (sd->sd_code){
+	if (restconf_submit_response(session, rc, stream_id, sd) < 0)
+	    goto done;
+    }
+    else {
+	/* 500 Internal server error ? */
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Simulate a received request in an upgrade scenario by talking the http/1 parameters
  */
 int
@@ -475,23 +434,40 @@ http2_exec(restconf_conn        *rc,
     }
     else
 	; /* ignore */
-    /* If body, add a content-length header 
-     *    A server MUST NOT send a Content-Length header field in any response
-     * with a status code of 1xx (Informational) or 204 (No Content).  A
-     * server MUST NOT send a Content-Length header field in any 2xx
-     * (Successful) response to a CONNECT request (Section 4.3.6 of
-     * [RFC7231]).
-     */
-    if (sd->sd_code != 204 && sd->sd_code > 199)
-	if (restconf_reply_header(sd, "Content-Length", "%zu", sd->sd_body_len) < 0)
-	    goto done;	
-    if (sd->sd_code){
-	if (restconf_submit_response(session, rc, stream_id, sd) < 0)
-	    goto done;
-    }
-    else {
-	/* 500 Internal server error ? */
+    /* Waiting for backend, reply is submitted by http2_resume */
+    if (sd->sd_rpc_id == 0 &&
+	http2_reply(rc, sd, session, stream_id) < 0)
+	goto done;
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    return retval;
+}
+
+/*! Submit and send reply of a stream that waited for an asynchronous backend rpc
+ * @param[in]  sd   Stream, with reply made by the rpc callback
+ * @retval     0    OK, also if the stream is closed meanwhile
+ * @retval    -1    Error
+ * @see restconf_reply_resume
+ */
+int
+http2_resume(restconf_stream_data *sd)
+{
+    int            retval = -1;
+    restconf_conn *rc = sd->sd_conn;
+    nghttp2_error  ngerr;
+
+    clicon_debug(1, "%s %d", __FUNCTION__, sd->sd_stream_id);
+    if (rc->rc_ngsession == NULL ||
+	nghttp2_session_get_stream_user_data(rc->rc_ngsession, sd->sd_stream_id) == NULL)
+	goto ok; /* Stream closed by peer */
+    if (http2_reply(rc, sd, rc->rc_ngsession, sd->sd_stream_id) < 0)
+	goto done;
+    if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+	clicon_err(OE_NGHTTP2, ngerr, "nghttp2_session_send");
+	goto done;
     }
+ ok:
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
@@ -0,0 +1,441 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Thread pool of native restconf for CPU-intensive jobs
+  * The event loop is single-threaded, and so is all handling of connections, requests
+  * and clixon state. Only CPU-intensive jobs, such as TLS handshakes and encoding of
+  * replies, are made by the threads:
+  *
+  *               submit   +---------------+         +---------+
+  *  event loop ---------> | queued jobs   | ------> | threads |
+  *      ^                 +---------------+         +---------+
+  *      |  done (pipe)    +---------------+             |
+  *      +---------------- | done jobs     | <-----------+
+  *                        +---------------+
+  *
+  * A job must only make computations on data owned by the job, and which is not read or
+  * modified by the event loop until the job is done. In particular a job must not create or
+  * free XML nodes (they share an allocator and interned names), use xpath (cache), or report
+  * errors with clicon_err. A job fails by returning -1, and the error is reported by the done
+  * callback in the event loop.
+  * Library code run by jobs, such as the JSON encoder or TLS callbacks in SSL_accept, may
+  * still call clicon_err and clicon_debug. These are disabled in the threads with
+  * clicon_log_thread_disable, so that they do not log or touch the global error state.
+  * The queue is bounded: if it is full, the job is not submitted and the caller makes it
+  * in the event loop instead.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+/* restconf */
+#include "restconf_worker.h"
+#include "restconf_threads.h"
+
+/* Job in one of the job lists of the pool */
+typedef struct {
+    qelem_t               rj_qelem;    /* List header */
+    uint32_t              rj_id;       /* Job id, see restconf_threads_cancel */
+    restconf_job_fn      *rj_fn;       /* Made in a thread */
+    restconf_job_done_fn *rj_done;     /* Called in event loop when job is done */
+    void                 *rj_arg;      /* Argument to rj_fn and rj_done */
+    int                   rj_status;   /* 1: done, -1: failed, set by thread */
+    int                   rj_canceled; /* Canceled while running or done */
+    struct timeval        rj_queued;   /* Time of submit, for statistics */
+} restconf_job;
+
+/* Lock of all data of pool that is shared with threads */
+static pthread_mutex_t  _threads_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Signaled when a job is queued or threads shall exit */
+static pthread_cond_t   _threads_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t       *_threads = NULL;
+static int              _threads_nr = 0;
+static int              _threads_exit = 0;
+
+/* Threads write to the pipe when a job is done, to wake up the event loop */
+static int              _threads_pipe[2] = {-1, -1};
+
+static restconf_job    *_jobs_queued = NULL;  /* Waiting for a thread, in submit order */
+static int              _jobs_queued_nr = 0;
+static int              _jobs_queued_len = 0; /* Max number of queued jobs */
+static restconf_job    *_jobs_running = NULL; /* Being made by a thread */
+static restconf_job    *_jobs_done = NULL;    /* Waiting for done callback in event loop */
+static uint32_t         _jobs_id = 0;         /* Last job id */
+
+/*! Find job with id in a job list
+ * @param[in]  list  Job list
+ * @param[in]  id    Job id
+ * @retval     rj    Job
+ * @retval     NULL  Not found
+ */
+static restconf_job *
+restconf_job_find(restconf_job *list,
+		  uint32_t      id)
+{
+    restconf_job *rj;
+
+    if ((rj = list) != NULL)
+	do {
+	    if (rj->rj_id == id)
+		return rj;
+	    rj = NEXTQ(restconf_job *, rj);
+	} while (rj && rj != list);
+    return NULL;
+}
+
+/*! Time in microseconds from t0 to t1
+ */
+static uint64_t
+restconf_job_usec(struct timeval *t0,
+		  struct timeval *t1)
+{
+    struct timeval t;
+
+    timersub(t1, t0, &t);
+    return (uint64_t)t.tv_sec*1000000 + t.tv_usec;
+}
+
+/*! Thread: make queued jobs until exit
+ * Signals are blocked in threads, they are handled by the event loop
+ * @param[in]  arg  Not used
+ */
+static void *
+restconf_thread_main(void *arg)
+{
+    restconf_worker *rw = restconf_worker_self();
+    restconf_job    *rj;
+    struct timeval   t0;
+    struct timeval   t1;
+    int              ret;
+    char             c = 0;
+
+    clicon_log_thread_disable();
+    pthread_mutex_lock(&_threads_lock);
+    while (1){
+	while (!_threads_exit && _jobs_queued == NULL)
+	    pthread_cond_wait(&_threads_cond, &_threads_lock);
+	if (_threads_exit)
+	    break;
+	rj = _jobs_queued;
+	DELQ(rj, _jobs_queued, restconf_job *);
+	_jobs_queued_nr--;
+	ADDQ(rj, _jobs_running);
+	gettimeofday(&t0, NULL);
+	rw->rw_jobs_wait_us += restconf_job_usec(&rj->rj_queued, &t0);
+	pthread_mutex_unlock(&_threads_lock);
+	ret = rj->rj_fn(rj->rj_arg);
+	gettimeofday(&t1, NULL);
+	pthread_mutex_lock(&_threads_lock);
+	rw->rw_jobs_run_us += restconf_job_usec(&t0, &t1);
+	rj->rj_status = ret < 0 ? -1 : 1;
+	DELQ(rj, _jobs_running, restconf_job *);
+	/* Wake up event loop if it has no done jobs, see restconf_threads_input */
+	if (_jobs_done == NULL &&
+	    write(_threads_pipe[1], &c, 1) < 0 && errno != EAGAIN)
+	    clicon_debug(1, "%s write: %s", __FUNCTION__, strerror(errno));
+	ADDQ(rj, _jobs_done);
+    }
+    pthread_mutex_unlock(&_threads_lock);
+    return NULL;
+}
+
+/*! Event loop: call done callback of done jobs
+ * Jobs are taken one by one from the done list, so that a done callback may cancel
+ * other done jobs.
+ * @param[in]  s    Read end of pipe
+ * @param[in]  arg  Clixon handle
+ */
+static int
+restconf_threads_input(int   s,
+		       void *arg)
+{
+    int           retval = 0;
+    clicon_handle h = (clicon_handle)arg;
+    restconf_job *rj;
+    char          buf[64];
+    int           status;
+
+    /* Drain pipe before taking jobs, a job done after this writes again */
+    while (read(s, buf, sizeof(buf)) > 0)
+	;
+    while (1){
+	pthread_mutex_lock(&_threads_lock);
+	if ((rj = _jobs_done) != NULL)
+	    DELQ(rj, _jobs_done, restconf_job *);
+	pthread_mutex_unlock(&_threads_lock);
+	if (rj == NULL)
+	    break;
+	status = rj->rj_canceled ? 0 : rj->rj_status;
+	if (rj->rj_done(h, status, rj->rj_arg) < 0)
+	    retval = -1;
+	free(rj);
+    }
+    return retval;
+}
+
+/*! Start thread pool
+ * @param[in]  h        Clixon handle
+ * @param[in]  nr       Number of threads, if 0 no pool is started, all jobs are made inline
+ * @param[in]  queuelen Max number of jobs waiting for a thread
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @note Call after fork of workers, threads do not survive fork
+ * @note Yang specs must not be changed after this, since the threads read them
+ */
+int
+restconf_threads_init(clicon_handle h,
+		      int           nr,
+		      int           queuelen)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    sigset_t   set;
+    sigset_t   oset;
+    int        i;
+    int        flags;
+    int        ret;
+
+    clicon_debug(1, "%s threads:%d queue:%d", __FUNCTION__, nr, queuelen);
+    if (nr <= 0)
+	goto ok;
+    /* Yang child indexes are otherwise built lazily on lookup, build them before threads
+     * read them */
+    if ((yspec = clicon_dbspec_yang(h)) != NULL &&
+	yang_index_build(yspec, 1) < 0)
+	goto done;
+    if (pipe(_threads_pipe) < 0){
+	clicon_err(OE_UNIX, errno, "pipe");
+	goto done;
+    }
+    for (i=0; i<2; i++)
+	if ((flags = fcntl(_threads_pipe[i], F_GETFL, 0)) < 0 ||
+	    fcntl(_threads_pipe[i], F_SETFL, flags | O_NONBLOCK) < 0){
+	    clicon_err(OE_UNIX, errno, "fcntl");
+	    goto done;
+	}
+    if (clixon_event_reg_fd(_threads_pipe[0], restconf_threads_input, h, "restconf threads") < 0)
+	goto done;
+    if ((_threads = calloc(nr, sizeof(pthread_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    _jobs_queued_len = queuelen > 0 ? queuelen : 1;
+    /* Threads inherit signal mask: block all signals in threads */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, &oset);
+    for (i=0; i<nr; i++){
+	if ((ret = pthread_create(&_threads[i], NULL, restconf_thread_main, NULL)) != 0){
+	    pthread_sigmask(SIG_SETMASK, &oset, NULL);
+	    clicon_err(OE_UNIX, ret, "pthread_create");
+	    goto done;
+	}
+	_threads_nr++;
+    }
+    pthread_sigmask(SIG_SETMASK, &oset, NULL);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if thread pool is started
+ * @retval  1  Yes, jobs may be submitted
+ * @retval  0  No, see restconf_threads_init
+ */
+int
+restconf_threads_enabled(void)
+{
+    return _threads_nr > 0;
+}
+
+/*! Submit a job to be made by a thread
+ * When the job is done, its done callback is called from the event loop exactly once,
+ * also if the job is canceled.
+ * @param[in]  fn    Job, made in a thread
+ * @param[in]  done  Called in event loop when job is done or canceled
+ * @param[in]  arg   Argument to fn and done, owned by the job until done is called
+ * @param[out] id    Job id, for cancel
+ * @retval     1     Job queued
+ * @retval     0     No thread pool, or queue is full: make job inline, done will not be called
+ * @retval    -1     Error
+ */
+int
+restconf_threads_submit(restconf_job_fn      *fn,
+			restconf_job_done_fn *done,
+			void                 *arg,
+			uint32_t             *id)
+{
+    int              retval = -1;
+    restconf_worker *rw = restconf_worker_self();
+    restconf_job    *rj = NULL;
+
+    if (_threads_nr == 0)
+	return 0;
+    if ((rj = malloc(sizeof(*rj))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(rj, 0, sizeof(*rj));
+    rj->rj_fn = fn;
+    rj->rj_done = done;
+    rj->rj_arg = arg;
+    gettimeofday(&rj->rj_queued, NULL);
+    pthread_mutex_lock(&_threads_lock);
+    if (_jobs_queued_nr >= _jobs_queued_len){
+	rw->rw_jobs_inline++;
+	pthread_mutex_unlock(&_threads_lock);
+	retval = 0;
+	goto done;
+    }
+    if (++_jobs_id == 0) /* 0 is no job */
+	_jobs_id++;
+    rj->rj_id = _jobs_id;
+    ADDQ(rj, _jobs_queued);
+    if (++_jobs_queued_nr > rw->rw_jobs_queued_max)
+	rw->rw_jobs_queued_max = _jobs_queued_nr;
+    rw->rw_jobs++;
+    pthread_cond_signal(&_threads_cond);
+    pthread_mutex_unlock(&_threads_lock);
+    if (id)
+	*id = rj->rj_id;
+    clicon_debug(1, "%s id:%u", __FUNCTION__, rj->rj_id);
+    rj = NULL;
+    retval = 1;
+ done:
+    if (rj)
+	free(rj);
+    return retval;
+}
+
+/*! Cancel a job, its done callback is called with status 0
+ * If the job has not started, it is removed and the callback is called directly.
+ * Otherwise the callback is called when the job is done, the job itself is not interrupted.
+ * @param[in]  h   Clixon handle
+ * @param[in]  id  Job id, see restconf_threads_submit
+ * @retval     0   OK, also if no job with id
+ * @retval    -1   Error in done callback
+ */
+int
+restconf_threads_cancel(clicon_handle h,
+			uint32_t      id)
+{
+    restconf_job *rj;
+
+    clicon_debug(1, "%s id:%u", __FUNCTION__, id);
+    pthread_mutex_lock(&_threads_lock);
+    if ((rj = restconf_job_find(_jobs_queued, id)) != NULL){
+	DELQ(rj, _jobs_queued, restconf_job *);
+	_jobs_queued_nr--;
+    }
+    else if ((rj = restconf_job_find(_jobs_running, id)) != NULL ||
+	     (rj = restconf_job_find(_jobs_done, id)) != NULL){
+	rj->rj_canceled = 1;
+	rj = NULL;
+    }
+    pthread_mutex_unlock(&_threads_lock);
+    if (rj){
+	if (rj->rj_done(h, 0, rj->rj_arg) < 0){
+	    free(rj);
+	    return -1;
+	}
+	free(rj);
+    }
+    return 0;
+}
+
+/*! Stop thread pool
+ * Wait for running jobs, and cancel all jobs not done
+ * @param[in]  h   Clixon handle
+ */
+int
+restconf_threads_exit(clicon_handle h)
+{
+    restconf_job *rj;
+    int           i;
+
+    if (_threads_pipe[0] == -1) /* Not started */
+	return 0;
+    clicon_debug(1, "%s", __FUNCTION__);
+    pthread_mutex_lock(&_threads_lock);
+    _threads_exit = 1;
+    pthread_cond_broadcast(&_threads_cond);
+    pthread_mutex_unlock(&_threads_lock);
+    for (i=0; i<_threads_nr; i++)
+	pthread_join(_threads[i], NULL);
+    if (_threads)
+	free(_threads);
+    _threads = NULL;
+    _threads_nr = 0;
+    _threads_exit = 0;
+    /* No threads left, no lock needed */
+    while ((rj = _jobs_queued) != NULL){
+	DELQ(rj, _jobs_queued, restconf_job *);
+	rj->rj_done(h, 0, rj->rj_arg);
+	free(rj);
+    }
+    _jobs_queued_nr = 0;
+    while ((rj = _jobs_done) != NULL){
+	DELQ(rj, _jobs_done, restconf_job *);
+	rj->rj_done(h, 0, rj->rj_arg);
+	free(rj);
+    }
+    clixon_event_unreg_fd(_threads_pipe[0], restconf_threads_input);
+    for (i=0; i<2; i++)
+	if (_threads_pipe[i] != -1){
+	    close(_threads_pipe[i]);
+	    _threads_pipe[i] = -1;
+	}
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Thread pool of native restconf for CPU-intensive jobs
+ */
+
+#ifndef _RESTCONF_THREADS_H_
+#define _RESTCONF_THREADS_H_
+
+/*
+ * Types
+ */
+/*! Job made in a thread, see restconf_threads_submit
+ * Must only make computations on data owned by the job, see restconf_threads.c
+ * @param[in]  arg     Argument given to restconf_threads_submit
+ * @retval     0       OK
+ * @retval    -1       Failed
+ */
+typedef int (restconf_job_fn)(void *arg);
+
+/*! Callback when job is done, called from the event loop
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: job done, 0: canceled, -1: job failed
+ * @param[in]  arg     Argument given to restconf_threads_submit
+ */
+typedef int (restconf_job_done_fn)(clicon_handle h, int status, void *arg);
+
+/*
+ * Prototypes
+ */
+int restconf_threads_init(clicon_handle h, int nr, int queuelen);
+int restconf_threads_enabled(void);
+int restconf_threads_submit(restconf_job_fn *fn, restconf_job_done_fn *done, void *arg, uint32_t *id);
+int restconf_threads_cancel(clicon_handle h, uint32_t id);
+int restconf_threads_exit(clicon_handle h);
+
+#endif /* _RESTCONF_THREADS_H_ */
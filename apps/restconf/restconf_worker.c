@@ -0,0 +1,372 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Native restconf worker processes and their supervisor
+  * If restconf is configured with more than one worker, the restconf process becomes a
+  * supervisor that forks the workers and restarts them if they exit:
+  *
+  *  +------------+  fork   +----------+   accept   +-------------------------+
+  *  | supervisor | ------> | worker 0 | <--------- | server sockets worker 0 |
+  *  +------------+         +----------+            +-------------------------+
+  *        |        fork    +----------+   accept   +-------------------------+
+  *        +--------------> | worker 1 | <--------- | server sockets worker 1 |
+  *                         +----------+            +-------------------------+
+  *
+  * Each worker has its own server sockets bound with SO_REUSEPORT to the configured addresses,
+  * so that the kernel distributes new connections between workers. The sockets are opened by
+  * the supervisor before the workers are forked, so that a restarted worker gets the same
+  * sockets, including connections that arrived while it was not running.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+/* restconf */
+#include "restconf_worker.h"
+
+/* A worker that exits sooner than this (seconds) after start is restarted after this delay,
+ * so that a worker that fails at start does not make the supervisor fork continuously
+ */
+#define RESTCONF_WORKER_RESTART_DELAY 1
+
+/* Workers in shared memory, or NULL if restconf is a single process */
+static restconf_worker *_workers = NULL;
+static int              _workers_nr = 0;
+
+/* Index of this worker: -1 in the supervisor, 0 in a single process */
+static int              _worker_id = 0;
+
+/* Statistics of a single restconf process, when not run with workers */
+static restconf_worker  _worker_single = {0,};
+
+/* Set by signal handlers in supervisor */
+static volatile sig_atomic_t _worker_sig_child = 0;
+static volatile sig_atomic_t _worker_sig_stats = 0;
+
+/*! Get index of this worker
+ * Use it to select the server sockets of this worker
+ * @retval  id  Worker index, 0 if restconf is a single process
+ * @retval  -1  This is the supervisor
+ */
+int
+restconf_worker_id(void)
+{
+    return _worker_id;
+}
+
+/*! Get worker struct of this process, eg to increment statistics
+ * @retval  rw  Worker struct, statistics of the process itself if restconf is a single process
+ */
+restconf_worker *
+restconf_worker_self(void)
+{
+    if (_workers != NULL && _worker_id >= 0)
+	return &_workers[_worker_id];
+    return &_worker_single;
+}
+
+/*! Signal handler of SIGCHLD in supervisor, workers are reaped in restconf_workers_run
+ */
+static void
+restconf_worker_sig_child(int arg)
+{
+    _worker_sig_child++;
+}
+
+/*! Signal handler of SIGUSR1 in supervisor: log worker statistics
+ */
+static void
+restconf_worker_sig_stats(int arg)
+{
+    _worker_sig_stats++;
+}
+
+/*! Log statistics of all workers and their sum
+ */
+static int
+restconf_workers_stats_log(void)
+{
+    restconf_worker *rw;
+    uint64_t         accepts = 0;
+    uint64_t         conns = 0;
+    uint64_t         requests = 0;
+    uint64_t         jobs = 0;
+    uint64_t         jobs_inline = 0;
+    uint32_t         restarts = 0;
+    int              i;
+
+    for (i=0; i<_workers_nr; i++){
+	rw = &_workers[i];
+	clicon_log(LOG_NOTICE, "%s: worker %d pid: %u restarts: %u accepts: %" PRIu64 " conns: %" PRIu64 " requests: %" PRIu64,
+		   __PROGRAM__, i, rw->rw_pid, rw->rw_restarts,
+		   rw->rw_accepts, rw->rw_conns, rw->rw_requests);
+	if (rw->rw_jobs || rw->rw_jobs_inline)
+	    clicon_log(LOG_NOTICE, "%s: worker %d jobs: %" PRIu64 " inline: %" PRIu64 " queued max: %u wait: %" PRIu64 "us run: %" PRIu64 "us",
+		       __PROGRAM__, i, rw->rw_jobs, rw->rw_jobs_inline, rw->rw_jobs_queued_max,
+		       rw->rw_jobs_wait_us, rw->rw_jobs_run_us);
+	accepts += rw->rw_accepts;
+	conns += rw->rw_conns;
+	requests += rw->rw_requests;
+	jobs += rw->rw_jobs;
+	jobs_inline += rw->rw_jobs_inline;
+	restarts += rw->rw_restarts;
+    }
+    clicon_log(LOG_NOTICE, "%s: workers: %d restarts: %u accepts: %" PRIu64 " conns: %" PRIu64 " requests: %" PRIu64 " jobs: %" PRIu64 " inline: %" PRIu64,
+	       __PROGRAM__, _workers_nr, restarts, accepts, conns, requests, jobs, jobs_inline);
+    return 0;
+}
+
+/*! Fork a worker
+ * @param[in]  h        Clicon handle
+ * @param[in]  id       Worker index
+ * @param[in]  oset     Signal mask to restore in the worker
+ * @param[out] isworker Set to 1 in the worker process
+ * @retval     0        OK, in supervisor or worker depending on isworker
+ * @retval    -1        Error
+ */
+static int
+restconf_worker_fork(clicon_handle h,
+		     int           id,
+		     sigset_t     *oset,
+		     int          *isworker)
+{
+    int              retval = -1;
+    restconf_worker *rw = &_workers[id];
+    pid_t            pid;
+    int              s;
+
+    if ((pid = fork()) < 0){
+	clicon_err(OE_UNIX, errno, "fork");
+	goto done;
+    }
+    if (pid == 0){ /* Worker */
+	_worker_id = id;
+	rw->rw_pid = getpid();
+	rw->rw_conns = 0;
+	if (set_signal(SIGCHLD, SIG_DFL, NULL) < 0 ||
+	    set_signal(SIGUSR1, SIG_IGN, NULL) < 0){
+	    clicon_err(OE_DAEMON, errno, "Setting signal");
+	    goto done;
+	}
+	if (sigprocmask(SIG_SETMASK, oset, NULL) < 0){
+	    clicon_err(OE_UNIX, errno, "sigprocmask");
+	    goto done;
+	}
+	/* The supervisor may have a backend socket open, eg if it read the restconf
+	 * config from the backend. Do not share it with other workers, but open a
+	 * socket and get a backend session of its own on first rpc, see session_id_check */
+	if ((s = clicon_client_socket_get(h)) >= 0){
+	    close(s);
+	    clicon_client_socket_set(h, -1);
+	}
+	clicon_data_del(h, "session-id");
+	*isworker = 1;
+	goto ok;
+    }
+    rw->rw_pid = pid;
+    gettimeofday(&rw->rw_started, NULL);
+    clicon_debug(1, "%s worker %d pid: %u", __FUNCTION__, id, pid);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Reap exited workers and restart them
+ * @param[in]  h        Clicon handle
+ * @param[in]  oset     Signal mask to restore in a worker
+ * @param[out] isworker Set to 1 in a restarted worker process
+ * @retval     0        OK, in supervisor or worker depending on isworker
+ * @retval    -1        Error
+ */
+static int
+restconf_workers_reap(clicon_handle h,
+		      sigset_t     *oset,
+		      int          *isworker)
+{
+    int              retval = -1;
+    restconf_worker *rw = NULL;
+    pid_t            pid;
+    int              status;
+    int              i;
+    struct timeval   now;
+    struct timeval   t;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0){
+	for (i=0; i<_workers_nr; i++)
+	    if (_workers[i].rw_pid == pid)
+		break;
+	if (i == _workers_nr)
+	    continue;
+	rw = &_workers[i];
+	rw->rw_pid = 0;
+	rw->rw_conns = 0;
+	if (WIFSIGNALED(status))
+	    clicon_log(LOG_WARNING, "%s: worker %d pid: %u killed by signal %d",
+		       __PROGRAM__, i, pid, WTERMSIG(status));
+	else
+	    clicon_log(LOG_WARNING, "%s: worker %d pid: %u exited with status %d",
+		       __PROGRAM__, i, pid, WEXITSTATUS(status));
+	if (clixon_exit_get() == 1)
+	    continue;
+	gettimeofday(&now, NULL);
+	timersub(&now, &rw->rw_started, &t);
+	if (t.tv_sec < RESTCONF_WORKER_RESTART_DELAY)
+	    sleep(RESTCONF_WORKER_RESTART_DELAY);
+	rw->rw_restarts++;
+	if (restconf_worker_fork(h, i, oset, isworker) < 0)
+	    goto done;
+	if (*isworker)
+	    break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Run restconf as supervisor of worker processes
+ * The supervisor forks the workers and waits for them to exit and restarts them, until it is
+ * terminated with SIGTERM or SIGINT, whereby the workers are terminated as well.
+ * A worker returns directly and serves the server sockets of its index, see restconf_worker_id
+ * Sending SIGUSR1 to the supervisor logs statistics of all workers.
+ * @param[in]  h   Clicon handle
+ * @param[in]  nr  Number of workers. If 1 or less do not fork, restconf is a single process
+ * @retval     1   This is a worker or a single process, serve requests
+ * @retval     0   This is the supervisor and it is terminated
+ * @retval    -1   Error
+ */
+int
+restconf_workers_run(clicon_handle h,
+		     int           nr)
+{
+    int              retval = -1;
+    sigset_t         set;
+    sigset_t         oset;
+    int              blocked = 0;
+    int              isworker = 0;
+    int              i;
+    restconf_worker *rw;
+
+    if (nr <= 1){
+	retval = 1;
+	goto done;
+    }
+    if ((_workers = mmap(NULL, nr*sizeof(restconf_worker), PROT_READ|PROT_WRITE,
+			 MAP_SHARED|MAP_ANONYMOUS, -1, 0)) == MAP_FAILED){
+	_workers = NULL;
+	clicon_err(OE_UNIX, errno, "mmap");
+	goto done;
+    }
+    memset(_workers, 0, nr*sizeof(restconf_worker));
+    _workers_nr = nr;
+    _worker_id = -1;
+    /* Signals are only handled in sigsuspend below */
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGINT);
+    if (sigprocmask(SIG_BLOCK, &set, &oset) < 0){
+	clicon_err(OE_UNIX, errno, "sigprocmask");
+	goto done;
+    }
+    blocked++;
+    if (set_signal(SIGCHLD, restconf_worker_sig_child, NULL) < 0 ||
+	set_signal(SIGUSR1, restconf_worker_sig_stats, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    for (i=0; i<nr; i++){
+	if (restconf_worker_fork(h, i, &oset, &isworker) < 0)
+	    goto done;
+	if (isworker)
+	    goto worker;
+    }
+    clicon_log(LOG_NOTICE, "%s: %u Started %d workers", __PROGRAM__, getpid(), nr);
+    while (clixon_exit_get() != 1){
+	if (_worker_sig_child){
+	    _worker_sig_child = 0;
+	    if (restconf_workers_reap(h, &oset, &isworker) < 0)
+		goto done;
+	    if (isworker)
+		goto worker;
+	}
+	if (_worker_sig_stats){
+	    _worker_sig_stats = 0;
+	    restconf_workers_stats_log();
+	}
+	if (clixon_exit_get() != 1 && _worker_sig_child == 0)
+	    sigsuspend(&oset);
+    }
+    /* Terminate workers and wait for them */
+    for (i=0; i<nr; i++){
+	rw = &_workers[i];
+	if (rw->rw_pid != 0)
+	    kill(rw->rw_pid, SIGTERM);
+    }
+    for (i=0; i<nr; i++){
+	rw = &_workers[i];
+	if (rw->rw_pid != 0 && waitpid(rw->rw_pid, NULL, 0) == rw->rw_pid)
+	    rw->rw_pid = 0;
+    }
+    restconf_workers_stats_log();
+    retval = 0;
+ done:
+    if (blocked && sigprocmask(SIG_SETMASK, &oset, NULL) < 0)
+	clicon_err(OE_UNIX, errno, "sigprocmask");
+    return retval;
+ worker:
+    /* Signal mask is restored in restconf_worker_fork */
+    return 1;
+}
@@ -0,0 +1,70 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Native restconf worker processes and their supervisor
+ */
+
+#ifndef _RESTCONF_WORKER_H_
+#define _RESTCONF_WORKER_H_
+
+/*
+ * Types
+ */
+/* Restconf worker process and its statistics
+ * Kept in memory shared by supervisor and workers so that the supervisor can aggregate
+ * statistics. Counters are only written by the worker itself, job counters by its threads
+ * with the thread pool lock held, see restconf_threads.c
+ */
+typedef struct {
+    pid_t          rw_pid;        /* Process id of worker, 0 if not running */
+    uint32_t       rw_restarts;   /* Number of times the worker has been restarted */
+    struct timeval rw_started;    /* Time of last start */
+    uint64_t       rw_accepts;    /* Accepted connections */
+    uint64_t       rw_conns;      /* Currently open connections */
+    uint64_t       rw_requests;   /* Restconf requests */
+    uint64_t       rw_jobs;       /* Jobs made by threads, see restconf_threads_submit */
+    uint64_t       rw_jobs_inline; /* Jobs made in event loop since thread queue was full */
+    uint32_t       rw_jobs_queued_max; /* Max number of jobs waiting for a thread */
+    uint64_t       rw_jobs_wait_us; /* Total time jobs waited for a thread (us) */
+    uint64_t       rw_jobs_run_us; /* Total time jobs ran in a thread (us) */
+} restconf_worker;
+
+/*
+ * Prototypes
+ */
+int              restconf_worker_id(void);
+restconf_worker *restconf_worker_self(void);
+int              restconf_workers_run(clicon_handle h, int nr);
+
+#endif /* _RESTCONF_WORKER_H_ */
@@ -58,9 +58,11 @@
  */
 #define IDENTITYREF_KLUDGE
 
-/*! Optimize special list key searches in XPATH finds
- * Identify xpaths that search for exactly a list key, eg: "y[k=3]" and then call
- * binary search. This only works if "y" has proper yang binding and is sorted by system
+/*! Optimize list searches in XPATH finds
+ * Plan each xpath step using the leading predicates, eg: "y[k=3]", "y[k1=3]" (key prefix),
+ * "y[i='x']" (search index) or "y[k>3]" (range), and then call binary search.
+ * This only works if "y" has proper yang binding and is config data.
+ * Descendant steps, eg "//y", skip subtrees that cannot contain "y" according to yang.
  */
 #define XPATH_LIST_OPTIMIZE
 
@@ -72,6 +74,12 @@
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Allocate XML nodes from slabs of fixed size nodes instead of one malloc per node
+ * Freed nodes are reused but slab memory is never returned.
+ * Undefine when debugging memory errors with valgrind, which cannot see slab nodes.
+ */
+#define XML_NODE_SLAB
+
 /*! Let state data be ordered-by system
  * RFC 7950 is cryptic about this
  * It says in 7.7.7:
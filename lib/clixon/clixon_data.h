@@ -56,6 +56,8 @@ typedef struct {
     cxobj    *de_xml;      /* cache */
     int       de_modified; /* Dirty since loaded/copied/committed/etc XXX:nocache? */
     int       de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
+    int       de_journal;  /* Nr of edits in journal not yet compacted into datastore file */
+    int       de_dirtymark;/* Cache equals running except in XML_FLAG_DIRTY subtrees */
 } db_elmnt;
 
 /*
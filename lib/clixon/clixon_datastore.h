@@ -44,6 +44,11 @@
  */
 /* Internal functions */
 int xmldb_db2file(clicon_handle h, const char *db, char **filename);
+int xmldb_db2journal(clicon_handle h, const char *db, char **filename);
+int xmldb_db2journaltmp(clicon_handle h, const char *db, char **filename);
+int xmldb_journal_reset(clicon_handle h, const char *db);
+int xmldb_journal_recover(clicon_handle h, const char *db);
+int xmldb_dirtymark_reset(clicon_handle h, const char *db);
 
 /* API */
 int xmldb_validate_db(const char *db);
@@ -58,6 +63,7 @@ int xmldb_get0_clear(clicon_handle h, cxobj *x);
 int xmldb_get0_free(clicon_handle h, cxobj **xp);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
 int xmldb_copy(clicon_handle h, const char *from, const char *to);
+int xmldb_copy_tree(clicon_handle h, const char *from, const char *to, cxobj *xt);
 int xmldb_lock(clicon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clicon_handle h, const char *db);
 int xmldb_unlock_all(clicon_handle h, uint32_t id);
@@ -70,10 +76,12 @@ int xmldb_create(clicon_handle h, const char *db);
 int xmldb_db_reset(clicon_handle h, const char *db);
 
 cxobj *xmldb_cache_get(clicon_handle h, const char *db);
+int xmldb_cache_set(clicon_handle h, const char *db, cxobj *xt);
 
 int xmldb_modified_get(clicon_handle h, const char *db);
 int xmldb_modified_set(clicon_handle h, const char *db, int value);
 int xmldb_empty_get(clicon_handle h, const char *db);
+int xmldb_dirtymark_get(clicon_handle h, const char *db);
 int xmldb_dump(clicon_handle h, FILE *f, cxobj *xt);
 int xmldb_print(clicon_handle h, FILE *f);
 
@@ -59,6 +59,10 @@ int clixon_event_reg_fd(int fd, int (*fn)(int, void*), void *arg, char *str);
 
 int clixon_event_unreg_fd(int s, int (*fn)(int, void*));
 
+int clixon_event_reg_fd_out(int fd, int (*fn)(int, void*), void *arg, char *str);
+
+int clixon_event_unreg_fd_out(int s, int (*fn)(int, void*));
+
 int clixon_event_reg_timeout(struct timeval t,  int (*fn)(int, void*), 
 			     void *arg, char *str);
 
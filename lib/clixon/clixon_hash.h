@@ -38,19 +38,22 @@
 #ifndef _CLIXON_HASH_H_
 #define _CLIXON_HASH_H_
 
+/* Hash entry */
 struct clicon_hash {
-    qelem_t	h_qelem;
     char       *h_key;
+    uint32_t    h_hval;  /* Hash value of key */
     size_t	h_vlen;
     void       *h_val;
 };
-typedef struct clicon_hash *clicon_hash_t;
+
+/* Hash table, see clixon_hash.c */
+typedef struct clicon_hash_table clicon_hash_t;
 
 clicon_hash_t *clicon_hash_init (void);
 int            clicon_hash_free (clicon_hash_t *);
-clicon_hash_t  clicon_hash_lookup (clicon_hash_t *head, const char *key);
+struct clicon_hash *clicon_hash_lookup (clicon_hash_t *head, const char *key);
 void          *clicon_hash_value (clicon_hash_t *head, const char *key, size_t *vlen);
-clicon_hash_t  clicon_hash_add (clicon_hash_t *head, const char *key, void *val, size_t vlen);
+struct clicon_hash *clicon_hash_add (clicon_hash_t *head, const char *key, void *val, size_t vlen);
 int            clicon_hash_del (clicon_hash_t *head, const char *key);
 int            clicon_hash_dump(clicon_hash_t *head, FILE *f);
 int            clicon_hash_keys(clicon_hash_t *hash, char ***vector, size_t *nkeys);
@@ -6,6 +6,14 @@
 #ifndef _CLIXON_NETNS_H_
 #define _CLIXON_NETNS_H_
 
+/*
+ * Constants
+ */
+/* Socket flag to clixon_netns_socket, not passed to socket(2): set SO_REUSEPORT so that
+ * several sockets, eg one per process, may be bound to the same address and port
+ */
+#define CLIXON_SOCK_REUSEPORT 0x40000000
+
 /*
  * Prototypes
  */
@@ -58,6 +58,25 @@ struct clicon_msg {
     char        op_body[0]; /* rest of message, actual data */
 };
 
+/* High-water mark of data queued in a send buffer (struct clicon_msg_buf).
+ * Above it, the rest of a reply is written later, see clicon_msg_stream_write,
+ * and the backend drops notifications and disconnects the subscriber.
+ */
+#define CLICON_MSG_SND_HIWAT (1024*1024)
+
+/* Buffer of partial clicon messages on a non-blocking socket, for receiving
+ * (see clicon_msg_rcv_nb) or sending (see clicon_msg_flush). Zero is empty.
+ */
+struct clicon_msg_buf {
+    char       *mb_buf;     /* Data, or NULL */
+    size_t      mb_start;   /* Start of data not yet consumed */
+    size_t      mb_end;     /* End of data */
+    size_t      mb_max;     /* Allocated size of mb_buf */
+};
+
+/* Reply written to a send buffer in parts, see clicon_msg_stream_write */
+typedef struct clicon_msg_stream clicon_msg_stream;
+
 /*
  * Prototypes
  */ 
@@ -69,6 +88,8 @@ struct clicon_msg *clicon_msg_encode(uint32_t id, const char *format, ...) __att
 #else
 struct clicon_msg *clicon_msg_encode(uint32_t id, const char *format, ...);
 #endif
+struct clicon_msg *clicon_msg_encode_xml(uint32_t id, cxobj *x, int32_t depth);
+int clicon_msg_binary(struct clicon_msg *msg);
 int clicon_msg_decode(struct clicon_msg *msg, yang_stmt *yspec, uint32_t *id, cxobj **xml, cxobj **xerr);
 
 int clicon_connect_unix(clicon_handle h, char *sockpath);
@@ -85,6 +106,8 @@ int clicon_rpc_connect_inet(clicon_handle         h,
 
 int clicon_rpc(int sock, struct clicon_msg *msg, char **xret);
 
+int clicon_rpc_xml(int sock, struct clicon_msg *msg, cxobj **xret);
+
 int clicon_rpc1(int sock, cbuf *msgin, cbuf *msgret);
 
 int clicon_msg_send(int s, struct clicon_msg *msg);
@@ -95,9 +118,22 @@ int clicon_msg_rcv(int s, struct clicon_msg **msg, int *eof);
 
 int clicon_msg_rcv1(int s, cbuf *cb, int *eof);
 
-int send_msg_notify_xml(clicon_handle h, int s, cxobj *xev);
-
-int send_msg_reply(int s, char *data, uint32_t datalen);
+int clicon_msg_buf_reset(struct clicon_msg_buf *mb);
+size_t clicon_msg_buf_len(struct clicon_msg_buf *mb);
+int clicon_msg_rcv_nb(int s, struct clicon_msg_buf *mb, int *eof);
+int clicon_msg_buf_get(struct clicon_msg_buf *mb, struct clicon_msg **msg);
+int clicon_msg_buf_put(struct clicon_msg_buf *mb, struct clicon_msg *msg);
+int clicon_msg_flush(int s, struct clicon_msg_buf *mb);
+
+int send_msg_notify_xml(clicon_handle h, int s, struct clicon_msg_buf *mb, cxobj *xev);
+
+int send_msg_reply(int s, struct clicon_msg_buf *mb, char *data, uint32_t datalen);
+int send_msg_reply_xml(int s, struct clicon_msg_buf *mb, cxobj *x, int32_t depth,
+		       clicon_msg_stream **msp);
+int send_msg_reply_stream(int s, struct clicon_msg_buf *mb, cxobj *x, int32_t depth,
+			  clicon_msg_stream **msp);
+int clicon_msg_stream_write(int s, struct clicon_msg_buf *mb, clicon_msg_stream *ms);
+int clicon_msg_stream_free(clicon_msg_stream *ms);
 
 int detect_endtag(char *tag, char  ch, int  *state);
 
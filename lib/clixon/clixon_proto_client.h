@@ -42,9 +42,26 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+/*
+ * Types
+ */
+/*! Callback with reply of asynchronous rpc, see clicon_rpc_async
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  1: reply in xret, 0: canceled, -1: failed
+ * @param[in]  xret    Reply as xml tree if status is 1, consumed by callback: free with xml_free
+ * @param[in]  arg     Argument given to clicon_rpc_async
+ */
+typedef int (clicon_rpc_async_cb)(clicon_handle h, int status, cxobj *xret, void *arg);
+
+/*
+ * Prototypes
+ */
 int clicon_rpc_connect(clicon_handle h, int *sock0);
 int clicon_rpc_msg(clicon_handle h, struct clicon_msg *msg, cxobj **xret0);
 int clicon_rpc_msg_persistent(clicon_handle h, struct clicon_msg *msg, cxobj **xret0, int *sock0);
+int clicon_rpc_async(clicon_handle h, struct clicon_msg *msg, clicon_rpc_async_cb *fn, void *arg, uint32_t *id);
+int clicon_rpc_async_cancel(clicon_handle h, uint32_t id);
+int clicon_rpc_async_exit(clicon_handle h);
 int clicon_rpc_netconf(clicon_handle h, char *xmlst, cxobj **xret, int *sp);
 int clicon_rpc_netconf_xml(clicon_handle h, cxobj *xml, cxobj **xret, int *sp);
 int clicon_rpc_get_config(clicon_handle h, char *username, char *db, char *xpath, cvec *nsc, cxobj **xret);
@@ -55,6 +72,8 @@ int clicon_rpc_delete_config(clicon_handle h, char *db);
 int clicon_rpc_lock(clicon_handle h, char *db);
 int clicon_rpc_unlock(clicon_handle h, char *db);
 int clicon_rpc_get(clicon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, cxobj **xret);
+int clicon_rpc_get_async(clicon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth,
+			 clicon_rpc_async_cb *fn, void *arg, uint32_t *id);
 int clicon_rpc_close_session(clicon_handle h);
 int clicon_rpc_kill_session(clicon_handle h, uint32_t session_id);
 int clicon_rpc_validate(clicon_handle h, char *db);
@@ -84,6 +84,13 @@ static inline char * strdup4(char *str)
     return dup;
 }
 
+/*! Check if two strings are equal, where one is typically interned
+ * Equal interned strings are the same pointer, so check pointer equality before strcmp.
+ * If both strings are known to be interned, pointer equality is sufficient.
+ * @see clixon_string_intern
+ */
+#define clixon_streq(s1, s2) ((s1) == (s2) || strcmp((s1), (s2)) == 0)
+
 /*
  * Prototypes
  */ 
@@ -107,6 +114,8 @@ int    nodeid_split(char *nodeid,	char **prefix, char **id);
 char  *clixon_trim(char *str);
 char  *clixon_trim2(char *str, char *trims);
 int   clicon_strcmp(char *s1, char *s2);
+char *clixon_string_intern(const char *str);
+int   clixon_string_release(char *istr);
 
 #ifndef HAVE_STRNDUP
 char *clicon_strndup (const char *, size_t);
@@ -48,5 +48,6 @@ int xml_yang_validate_add(clicon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_list_key_only(cxobj *xt, cxobj **xret);
 int xml_yang_validate_all(clicon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_all_top(clicon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_changed(clicon_handle h, cxobj *xt, cxobj **avec, int alen, cxobj **dvec, int dlen, cxobj **cvec, int clen, cxobj **xret);
 
 #endif  /* _CLIXON_VALIDATE_H_ */
@@ -92,6 +92,16 @@ enum cxobj_type {CX_ERROR=-1,
 		 CX_ATTR, 
 		 CX_BODY};
 
+/* Type of typed value of XML body, used when comparing leaf values
+ * @see xml_value_typed_get
+ */
+enum xml_value_type{
+    XV_NONE = 0, /* Not set */
+    XV_STRING,   /* Compare as string */
+    XV_INT,      /* Signed integer, or decimal64 with fraction-digits of the yang type */
+    XV_UINT,     /* Unsigned integer or boolean */
+};
+
 /* How to bind yang to XML top-level when parsing 
  * Assume an XML tree x with parent xp (or NULL) and a set of children c1,c2:   
  *
@@ -165,6 +175,10 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 #define XML_FLAG_NONE      0x20 /* Node is added as NONE */
 #define XML_FLAG_DEFAULT   0x40 /* Added when a value is set as default @see xml_default */
 #define XML_FLAG_TOP       0x80 /* Top datastore symbol */
+#define XML_FLAG_DIRTY     0x100 /* Node or descendant edited since datastore cache was
+				  * equal to running @see xmldb_dirtymark_get */
+#define XML_FLAG_DIFFDIRTY 0x200 /* Top: xml_diff only descends into XML_FLAG_DIRTY
+				  * nodes of second tree */
 
 /*
  * Prototypes
@@ -198,6 +212,8 @@ int       xml_flag_reset(cxobj *xn, uint16_t flag);
 char     *xml_value(cxobj *xn);
 int       xml_value_set(cxobj *xn, char *val);
 int       xml_value_append(cxobj *xn, char *val);
+enum xml_value_type xml_value_typed_get(cxobj *xn, int64_t *ival);
+int       xml_value_typed_set(cxobj *xn, enum xml_value_type vtype, int64_t ival);
 enum cxobj_type xml_type(cxobj *xn);
 
 int       xml_child_nr(cxobj *xn);
@@ -216,8 +232,6 @@ cxobj    *xml_new(char *name, cxobj *xn_parent, enum cxobj_type type);
 cxobj    *xml_new_body(char *name, cxobj *parent, char *val);
 yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
-cg_var   *xml_cv(cxobj *x);
-int       xml_cv_set(cxobj *x, cg_var *cv);
 cxobj    *xml_find(cxobj *xn_parent, char *name);
 int       xml_addsub(cxobj *xp, cxobj *xc);
 cxobj    *xml_wrap_all(cxobj *xp, char *tag);
@@ -40,6 +40,15 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/* Flush callback of clicon_xml2cbuf_flush, called with a full buffer */
+typedef int (clicon_xml_flush_cb)(cbuf *cb, void *arg);
+
+/* Position of an XML tree printed in steps, see clicon_xml2cbuf_step */
+typedef struct xml2cbuf_pos xml2cbuf_pos;
+
 /*
  * Prototypes
  */
@@ -47,6 +56,11 @@ int clicon_xml2file_cb(FILE *f, cxobj *x, int level, int prettyprint, clicon_out
 int clicon_xml2file(FILE *f, cxobj *x, int level, int prettyprint);
 int xml_print(FILE *f, cxobj *xn);
 int clicon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth);
+int clicon_xml2cbuf_flush(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth,
+			  size_t threshold, clicon_xml_flush_cb *fn, void *arg);
+xml2cbuf_pos *clicon_xml2cbuf_pos_new(cxobj *x, int level, int prettyprint, int32_t depth);
+int clicon_xml2cbuf_pos_free(xml2cbuf_pos *xp);
+int clicon_xml2cbuf_step(cbuf *cb, xml2cbuf_pos *xp, size_t threshold);
 char *clicon_xml2str(cxobj *x);
 int xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 
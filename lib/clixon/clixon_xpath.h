@@ -132,6 +132,10 @@ int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
+int   xpath_cache_pin(const char *xpath);
+int   xpath_cache_size_set(int size);
+int   xpath_cache_stats(uint64_t *hits, uint64_t *misses, uint64_t *entries);
+int   xpath_cache_exit(void);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
 
 #if defined(__GNUC__) && __GNUC__ >= 3
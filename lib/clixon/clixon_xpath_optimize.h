@@ -41,7 +41,10 @@
 
 int  xpath_list_optimize_stats(int *hits);
 int  xpath_list_optimize_set(int enable); 
+int  xpath_optimize_explain(cbuf *cb);
 void xpath_optimize_exit(void);
 int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
+int  xpath_optimize_descendant(xpath_tree *xs, cxobj *xv, cvec *nsc, int localonly,
+			       cxobj ***xvec0, int *xlen0);
 
 #endif /* _CLIXON_XPATH_OPTIMIZE_H */
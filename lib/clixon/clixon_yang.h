@@ -61,6 +61,10 @@
 #define YANG_FLAG_INDEX 0x08  /* This yang node under list is (extra) index. --> you can access
 			       * list elements using this index with binary search */
 #endif
+#define YANG_FLAG_INDEXED 0x10 /* Child index and yang order of children are valid,
+				* see yang_index_build */
+#define YANG_FLAG_REINDEX 0x20 /* Children changed after indexing, index is rebuilt on 
+				* next lookup */
 
 /*
  * Types
@@ -230,6 +234,8 @@ int        ys_module_by_xml(yang_stmt *ysp, struct xml *xt, yang_stmt **ymodp);
 yang_stmt *ys_module(yang_stmt *ys);
 int        ys_real_module(yang_stmt *ys, yang_stmt **ymod);
 yang_stmt *ys_spec(yang_stmt *ys);
+int        yang_index_build(yang_stmt *ys, int recurse);
+int        yang_index_reset(yang_stmt *ys);
 yang_stmt *yang_find(yang_stmt *yn, int keyword, const char *argument);
 int        yang_match(yang_stmt *yn, int keyword, char *argument);
 yang_stmt *yang_find_datanode(yang_stmt *yn, char *argument);
@@ -120,6 +120,181 @@ xmldb_db2file(clicon_handle  h,
     return retval;
 }
 
+/*! Translate from symbolic database name to journal filename in file-system
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * The journal holds edits not yet written to the datastore file, 
+ * see CLICON_XMLDB_JOURNAL
+ * @see xmldb_db2file
+ */
+int
+xmldb_db2journal(clicon_handle  h, 
+		 const char    *db,
+		 char         **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+	clicon_err(OE_XML, errno, "dbdir not set");
+	goto done;
+    }
+    cprintf(cb, "%s/%s_db.journal", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Translate from symbolic database name to temporary file used when compacting journal
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see xmldb_journal_recover
+ */
+int
+xmldb_db2journaltmp(clicon_handle  h, 
+		    const char    *db,
+		    char         **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+	clicon_err(OE_XML, errno, "dbdir not set");
+	goto done;
+    }
+    cprintf(cb, "%s/%s_db.tmp", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove journal of a database, if any
+ * Call this when the datastore file has been written in full, or replaced.
+ * A temporary file of an interrupted compaction is also removed, since it is older
+ * than the datastore file.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Symbolic database name, eg "candidate", "running"
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+xmldb_journal_reset(clicon_handle h, 
+		    const char   *db)
+{
+    int       retval = -1;
+    char     *filename = NULL;
+    db_elmnt *de;
+    
+    if (xmldb_db2journal(h, db, &filename) < 0)
+	goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+	clicon_err(OE_DB, errno, "unlink %s", filename);
+	goto done;
+    }
+    free(filename);
+    filename = NULL;
+    if (xmldb_db2journaltmp(h, db, &filename) < 0)
+	goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+	clicon_err(OE_DB, errno, "unlink %s", filename);
+	goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de->de_journal = 0;
+    retval = 0;
+ done:
+    if (filename)
+	free(filename);
+    return retval;
+}
+
+/*! Recover from an interrupted compaction of the journal into the datastore file
+ *
+ * A compaction writes the temporary file, removes the journal, and then renames the
+ * temporary file to the datastore file, see xmldb_write_file.
+ * If the journal is still there, the temporary file may be incomplete and is removed:
+ * the journal is replayed on the old datastore file.
+ * Otherwise the temporary file is complete and replaces the datastore file.
+ * In neither case is an edit applied twice.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Symbolic database name, eg "candidate", "running"
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+xmldb_journal_recover(clicon_handle h, 
+		      const char   *db)
+{
+    int         retval = -1;
+    char       *tmpfile = NULL;
+    char       *journalfile = NULL;
+    char       *dbfile = NULL;
+    struct stat st;
+
+    if (xmldb_db2journaltmp(h, db, &tmpfile) < 0)
+	goto done;
+    if (lstat(tmpfile, &st) < 0)
+	goto ok;
+    if (xmldb_db2journal(h, db, &journalfile) < 0)
+	goto done;
+    if (lstat(journalfile, &st) == 0){
+	clicon_log(LOG_NOTICE, "%s: %s: removing incomplete compaction of journal",
+		   __FUNCTION__, db);
+	if (unlink(tmpfile) < 0){
+	    clicon_err(OE_DB, errno, "unlink %s", tmpfile);
+	    goto done;
+	}
+    }
+    else {
+	clicon_log(LOG_NOTICE, "%s: %s: completing compaction of journal",
+		   __FUNCTION__, db);
+	if (xmldb_db2file(h, db, &dbfile) < 0)
+	    goto done;
+	if (rename(tmpfile, dbfile) < 0){
+	    clicon_err(OE_DB, errno, "rename %s", tmpfile);
+	    goto done;
+	}
+    }
+ ok:
+    retval = 0;
+ done:
+    if (tmpfile)
+	free(tmpfile);
+    if (journalfile)
+	free(journalfile);
+    if (dbfile)
+	free(dbfile);
+    return retval;
+}
+
 /*! Ensure database name is correct
  * @param[in]   db    Name of database 
  * @retval  0   OK
@@ -178,12 +353,166 @@ xmldb_disconnect(clicon_handle h)
     return retval;
 }
 
+/*! Reset dirty marks of an XML tree, only descend into marked subtrees
+ * @param[in]  x   XML tree
+ * @see XML_FLAG_DIRTY
+ */
+static int
+xmldb_dirtymark_clear(cxobj *x)
+{
+    cxobj *xc = NULL;
+
+    xml_flag_reset(x, XML_FLAG_DIRTY);
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	if (xml_flag(xc, XML_FLAG_DIRTY))
+	    xmldb_dirtymark_clear(xc);
+    return 0;
+}
+
+/*! Invalidate dirty marks of a datastore cache
+ * If db is running, all other datastores are invalidated since they no longer
+ * can be compared to running using the marks.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see xmldb_dirtymark_get
+ */
+int
+xmldb_dirtymark_reset(clicon_handle h,
+		      const char   *db)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de;
+
+    if (strcmp(db, "running") == 0){
+	if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+	    goto done;
+	for (i = 0; i < klen; i++) 
+	    if ((de = clicon_db_elmnt_get(h, keys[i])) != NULL)
+		de->de_dirtymark = 0;
+    }
+    else if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de->de_dirtymark = 0;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Update dirty marks of datastore caches after copying from one db to another
+ * After copying to running, both caches are equal to running. After copying from
+ * running, the destination is. Otherwise, the destination inherits the marks
+ * of the source.
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval -1  Error
+ * @retval  0  OK
+ */
+static int
+xmldb_dirtymark_copy(clicon_handle h,
+		     const char   *from,
+		     const char   *to)
+{
+    int       retval = -1;
+    db_elmnt *de1; /* from */
+    db_elmnt *de2; /* to */
+
+    de1 = clicon_db_elmnt_get(h, from);
+    de2 = clicon_db_elmnt_get(h, to);
+    if (strcmp(to, "running") == 0){
+	if (xmldb_dirtymark_reset(h, to) < 0)
+	    goto done;
+	if (de2 && de2->de_xml)
+	    xmldb_dirtymark_clear(de2->de_xml);
+	if (de1 && de1->de_xml){
+	    xmldb_dirtymark_clear(de1->de_xml);
+	    de1->de_dirtymark = 1;
+	}
+    }
+    else if (de2 && de2->de_xml){
+	if (strcmp(from, "running") == 0){
+	    xmldb_dirtymark_clear(de2->de_xml);
+	    de2->de_dirtymark = 1;
+	}
+	else
+	    de2->de_dirtymark = de1 ? de1->de_dirtymark : 0;
+    }
+    else if (de2)
+	de2->de_dirtymark = 0;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy datastore file and journal (if any) from db1 to db2
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval -1  Error
+ * @retval  0  OK
+ */
+static int 
+xmldb_copy_file(clicon_handle h, 
+		const char   *from, 
+		const char   *to)
+{
+    int                 retval = -1;
+    char               *fromfile = NULL;
+    char               *tofile = NULL;
+    db_elmnt           *de1 = NULL; /* from */
+    db_elmnt           *de2 = NULL; /* to */
+    struct stat         sb;
+
+    /* Complete an interrupted compaction of the source file, if any */
+    if (xmldb_journal_recover(h, from) < 0)
+	goto done;
+    /* Remove old journal first, it should never be replayed on the new file */
+    if (xmldb_journal_reset(h, to) < 0)
+	goto done;
+    if (xmldb_db2file(h, from, &fromfile) < 0)
+	goto done;
+    if (xmldb_db2file(h, to, &tofile) < 0)
+	goto done;
+    if (clicon_file_copy(fromfile, tofile) < 0)
+	goto done;
+    /* Copy journal of edits not yet written to the file, if any */
+    free(fromfile);
+    fromfile = NULL;
+    free(tofile);
+    tofile = NULL;
+    if (xmldb_db2journal(h, from, &fromfile) < 0)
+	goto done;
+    if (lstat(fromfile, &sb) == 0){
+	if (xmldb_db2journal(h, to, &tofile) < 0)
+	    goto done;
+	if (clicon_file_copy(fromfile, tofile) < 0)
+	    goto done;
+	if ((de1 = clicon_db_elmnt_get(h, from)) != NULL &&
+	    (de2 = clicon_db_elmnt_get(h, to)) != NULL)
+	    de2->de_journal = de1->de_journal;
+    }
+    retval = 0;
+ done:
+    if (fromfile)
+	free(fromfile);
+    if (tofile)
+	free(tofile);
+    return retval;
+}
+
 /*! Copy database from db1 to db2
  * @param[in]  h     Clicon handle
  * @param[in]  from  Source database
  * @param[in]  to    Destination database
  * @retval -1  Error
  * @retval  0  OK
+ * @see xmldb_copy_tree  Reuse an existing copy of the source tree
   */
 int 
 xmldb_copy(clicon_handle h, 
@@ -191,8 +520,6 @@ xmldb_copy(clicon_handle h,
 	   const char   *to)
 {
     int                 retval = -1;
-    char               *fromfile = NULL;
-    char               *tofile = NULL;
     db_elmnt           *de1 = NULL; /* from */
     db_elmnt           *de2 = NULL; /* to */
     db_elmnt            de0 = {0,};
@@ -239,20 +566,117 @@ xmldb_copy(clicon_handle h,
     clicon_db_elmnt_set(h, to, &de0);
 
     /* Copy the files themselves (above only in-memory cache) */
-    if (xmldb_db2file(h, from, &fromfile) < 0)
+    if (xmldb_copy_file(h, from, to) < 0)
 	goto done;
-    if (xmldb_db2file(h, to, &tofile) < 0)
+    if (xmldb_dirtymark_copy(h, from, to) < 0)
 	goto done;
-    if (clicon_file_copy(fromfile, tofile) < 0)
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy database from db1 to db2 using an existing copy of the db1 tree as db2 cache
+ *
+ * Same as xmldb_copy but instead of making a new copy of the db1 cache, the cache
+ * of db2 is replaced by xt. This avoids copying the whole tree, eg when committing
+ * a transaction whose target tree already is a copy of the candidate.
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @param[in]  xt    Private copy of the from tree, eg from xmldb_get0 with copy.
+ *                   On success, xt is owned by the datastore cache.
+ *                   If NULL, the db2 cache is removed and db2 is read from file until
+ *                   a tree is installed with xmldb_cache_set
+ * @retval -1  Error
+ * @retval  0  OK
+ * @note Only with DATASTORE_CACHE, since in zerocopy mode xmldb_get0 may return the
+ *       cache itself
+ * @note Default values in xt are not removed, the caller must do that before calling,
+ *       see xmldb_get0_clear
+ * @see xmldb_copy
+ */
+int 
+xmldb_copy_tree(clicon_handle h, 
+		const char   *from, 
+		const char   *to,
+		cxobj        *xt)
+{
+    int       retval = -1;
+    db_elmnt *de2 = NULL; /* to */
+    db_elmnt  de0 = {0,};
+
+    if (clicon_datastore_cache(h) != DATASTORE_CACHE){
+	clicon_err(OE_DB, EINVAL, "Only allowed with datastore cache");
+	goto done;
+    }
+    if (xt != NULL && xml_flag(xt, XML_FLAG_TOP) == 0){
+	clicon_err(OE_DB, EINVAL, "xt is not top of tree");
+	goto done;
+    }
+    if (xt != NULL &&
+	(de2 = clicon_db_elmnt_get(h, to)) != NULL && de2->de_xml == xt){
+	clicon_err(OE_DB, EINVAL, "xt is cache of %s", to);
+	goto done;
+    }
+    if (xmldb_copy_file(h, from, to) < 0)
+	goto done;
+    /* xmldb_copy_file may update de2 */
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL){
+	de0 = *de2;
+	if (de0.de_xml)
+	    xml_free(de0.de_xml);
+    }
+    de0.de_xml = xt; /* The new tree */
+    clicon_db_elmnt_set(h, to, &de0);
+    if (xmldb_dirtymark_copy(h, from, to) < 0)
 	goto done;
     retval = 0;
  done:
-    if (fromfile)
-	free(fromfile);
-    if (tofile)
-	free(tofile);
     return retval;
+}
 
+/*! Install a tree as datastore cache, replacing the existing cache, if any
+ *
+ * The tree must be equal to the datastore file, eg after xmldb_copy_tree with 
+ * NULL tree.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database
+ * @param[in]  xt    Top of XML tree without default values. Owned by the cache on success
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see xmldb_copy_tree
+ */
+int 
+xmldb_cache_set(clicon_handle h, 
+		const char   *db,
+		cxobj        *xt)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+
+    if (clicon_datastore_cache(h) != DATASTORE_CACHE){
+	clicon_err(OE_DB, EINVAL, "Only allowed with datastore cache");
+	goto done;
+    }
+    if (xt == NULL || xml_flag(xt, XML_FLAG_TOP) == 0){
+	clicon_err(OE_DB, EINVAL, "xt is NULL or not top of tree");
+	goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+	de0 = *de;
+	if (de0.de_xml && de0.de_xml != xt)
+	    xml_free(de0.de_xml);
+    }
+    de0.de_xml = xt;
+    /* Running has no marks, other caches are not compared to running */
+    xmldb_dirtymark_clear(xt);
+    if (strcmp(db, "running") != 0)
+	de0.de_dirtymark = 0;
+    clicon_db_elmnt_set(h, db, &de0);
+    retval = 0;
+ done:
+    return retval;
 }
 
 /*! Lock database
@@ -419,6 +843,10 @@ xmldb_delete(clicon_handle h,
 	    clicon_err(OE_DB, errno, "truncate %s", filename);
 	    goto done;
 	}
+    if (xmldb_journal_reset(h, db) < 0)
+	goto done;
+    if (xmldb_dirtymark_reset(h, db) < 0)
+	goto done;
     retval = 0;
  done:
     if (filename)
@@ -454,6 +882,8 @@ xmldb_create(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "open(%s)", filename);
 	goto done;
     }
+    if (xmldb_dirtymark_reset(h, db) < 0)
+	goto done;
    retval = 0;
  done:
     if (filename)
@@ -539,6 +969,25 @@ xmldb_empty_get(clicon_handle h,
     return de->de_empty;
 }
 
+/*! Get dirty-mark flag from datastore
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database name
+ * @retval     0     Dirty marks of db cache are not valid, or no cache
+ * @retval     1     Db cache is equal to running except in XML_FLAG_DIRTY subtrees
+ * @see xml_diff which uses the marks to skip unchanged subtrees
+ */
+int
+xmldb_dirtymark_get(clicon_handle h,
+		    const char   *db)
+{
+    db_elmnt *de;
+    
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	de->de_xml == NULL)
+	return 0;
+    return de->de_dirtymark;
+}
+
 /*! Set modified flag from datastore
  * @param[in]  h     Clicon handle
  * @param[in]  db    Database name
@@ -586,6 +1035,7 @@ xmldb_print(clicon_handle h,
 	fprintf(f, "  XML:      %p\n", de->de_xml);
 	fprintf(f, "  Modified: %d\n", de->de_modified);
 	fprintf(f, "  Empty:    %d\n", de->de_empty);
+	fprintf(f, "  Dirtymark:%d\n", de->de_dirtymark);
     }
     retval = 0;
  done:
@@ -82,6 +82,7 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_write.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -455,6 +456,10 @@ xmldb_readfile(clicon_handle    h,
     cxobj           *xmodfile = NULL;
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
+    char            *journalfile = NULL;
+    struct stat      st;
+    int              nr = 0;
+    cxobj           *xb = NULL;          /* Bound copy for journal replay */
 
     if (yb != YB_MODULE && yb != YB_NONE){
 	clicon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -470,6 +475,9 @@ xmldb_readfile(clicon_handle    h,
 	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
 	goto done;
     }
+    /* Complete or undo an interrupted compaction of the journal, if any */
+    if (xmldb_journal_recover(h, db) < 0)
+	goto done;
     /* Parse file into internal XML tree from different formats */
     if ((fp = fopen(dbfile, "r")) == NULL) {
 	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
@@ -597,6 +605,35 @@ xmldb_readfile(clicon_handle    h,
 	if (xml_sort_recurse(x0) < 0)
 	    goto done;
     }
+    /* Apply edits in journal not yet written to datastore file, if any */
+    if (xmldb_db2journal(h, db, &journalfile) < 0)
+	goto done;
+    if (lstat(journalfile, &st) == 0){
+	if (yb == YB_NONE){
+	    /* Edits require yang binding, but the caller expects an unbound tree, eg
+	     * startup upgrade. Replay the journal on a bound copy, compact it into the
+	     * file with the module-state of the file, and read the file again.
+	     */
+	    if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &xb, NULL, NULL, xerr)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	    /* Module-state is bound to be written as JSON, if possible */
+	    if (xmodfile && xml_bind_yang0(xmodfile, YB_MODULE, yspec, NULL) < 0)
+		goto done;
+	    if (xmldb_write_file(h, db, xb, xmodfile) < 0)
+		goto done;
+	    retval = xmldb_readfile(h, db, YB_NONE, yspec, xp, de, msdiff0, xerr);
+	    goto done;
+	}
+	if (xmldb_journal_replay(h, db, yspec1?yspec1:yspec, x0, &nr) < 0)
+	    goto done;
+	if (de){
+	    de->de_journal = nr;
+	    if (xml_child_nr(x0))
+		de->de_empty = 0;
+	}
+    }
     if (xp){
 	*xp = x0;
 	x0 = NULL;
@@ -618,6 +655,10 @@ xmldb_readfile(clicon_handle    h,
 	fclose(fp);
     if (dbfile)
 	free(dbfile);
+    if (journalfile)
+	free(journalfile);
+    if (xb)
+	xml_free(xb);
     if (x0)
 	xml_free(x0);
     return retval;
@@ -777,6 +818,8 @@ xmldb_get_cache(clicon_handle    h,
     cxobj     *x1t = NULL;
     db_elmnt   de0 = {0,};
     int        ret;
+    int        lazy;
+    cxobj     *xc;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
@@ -799,12 +842,30 @@ xmldb_get_cache(clicon_handle    h,
     else
 	x0t = de->de_xml;
 
+    /* Lazy defaults: default values are not added to the cache, only to the
+     * result tree below. Then the xpath cannot select default values, but
+     * that does not matter if the whole tree is selected.
+     */
+    lazy = clicon_option_bool(h, "CLICON_XMLDB_LAZY_DEFAULTS") ||
+	xpath == NULL || strcmp(xpath, "/") == 0;
     if (yb == YB_MODULE && !xml_spec(x0t)){
-	if ((ret = xml_bind_yang(x0t, YB_MODULE, yspec, xerr)) < 0)
+	if (clicon_option_bool(h, "CLICON_XMLDB_LAZY_DEFAULTS")){
+	    /* Only bind top-level trees not already bound, eg read with YB_NONE */
+	    xc = NULL;
+	    while ((xc = xml_child_each(x0t, xc, CX_ELMNT)) != NULL) {
+		if (xml_spec(xc) != NULL)
+		    continue;
+		if ((ret = xml_bind_yang0(xc, YB_MODULE, yspec, xerr)) < 0)
+		    goto done;
+		if (ret == 0)
+		    goto fail;
+	    }
+	}
+	else if ((ret = xml_bind_yang(x0t, YB_MODULE, yspec, xerr)) < 0)
 	    goto done;
-	if (ret == 0)
+	else if (ret == 0)
 	    ; /* XXX */
-	else {
+	else if (!lazy){
 	    /* Add default global values (to make xpath below include defaults) */
 	    if (xml_global_defaults(h, x0t, nsc, xpath, yspec, 0) < 0)
 		goto done;
@@ -859,16 +920,18 @@ xmldb_get_cache(clicon_handle    h,
 	if (xml_apply(x1t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
 	    goto done;
     }
-    /* Remove global defaults from cache 
-     * Mark non-presence containers */
-    if (xml_apply(x0t, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_TRANSIENT) < 0)
-	goto done;
-    /* clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x0t, XML_FLAG_DEFAULT, 1) < 0)
-	goto done;
-    /* Clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x0t, XML_FLAG_TRANSIENT, 1) < 0)
-	goto done;
+    if (!lazy){
+	/* Remove global defaults from cache 
+	 * Mark non-presence containers */
+	if (xml_apply(x0t, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_TRANSIENT) < 0)
+	    goto done;
+	/* clear XML tree of defaults */
+	if (xml_tree_prune_flagged(x0t, XML_FLAG_DEFAULT, 1) < 0)
+	    goto done;
+	/* Clear XML tree of defaults */
+	if (xml_tree_prune_flagged(x0t, XML_FLAG_TRANSIENT, 1) < 0)
+	    goto done;
+    }
     if (yb != YB_NONE){
 	/* Add default global values */
 	if (xml_global_defaults(h, x1t, nsc, xpath, yspec, 0) < 0)
@@ -268,6 +268,21 @@ check_when_condition(cxobj              *x0p,
     goto done;
 }
 
+/*! Mark node and its ancestors as edited
+ * Stop at first marked ancestor, since its ancestors are already marked.
+ * @param[in]  x   XML node in datastore tree
+ * @see XML_FLAG_DIRTY
+ */
+static int
+text_modify_dirty(cxobj *x)
+{
+    while (x && xml_flag(x, XML_FLAG_DIRTY) == 0){
+	xml_flag_set(x, XML_FLAG_DIRTY);
+	x = xml_parent(x);
+    }
+    return 0;
+}
+
 /*! Modify a base tree x0 with x1 with yang spec y according to operation op
  * @param[in]  h        Clicon handle
  * @param[in]  x0       Base xml tree (can be NULL in add scenarios)
@@ -332,6 +347,8 @@ text_modify(clicon_handle       h,
 	clicon_err(OE_XML, EINVAL, "x1 is missing");
 	goto done;
     }
+    /* Children of x0p may change, mark for xml_diff */
+    text_modify_dirty(x0p);
     if ((ret = check_when_condition(x0p, x1, y0, cbret)) < 0)
 	goto done;
     if (ret == 0)
@@ -650,6 +667,7 @@ text_modify(clicon_handle       h,
 		    goto done;
 		if (xml_copy(x1, x0) < 0)
 		    goto done;
+		text_modify_dirty(x0);
 		break;
 	    } /* anyxml, anydata */
 	    if (x0==NULL){
@@ -680,6 +698,7 @@ text_modify(clicon_handle       h,
 		if (op==OP_NONE)
 		    xml_flag_set(x0, XML_FLAG_NONE); /* Mark for potential deletion */
 	    }
+	    text_modify_dirty(x0);
 	    /* First pass: Loop through children of the x1 modification tree 
 	     * collect matching nodes from x0 in x0vec (no changes to x0 children)
 	     */
@@ -958,6 +977,306 @@ text_modify_top(clicon_handle       h,
     goto done;
 } /* text_modify_top */
 
+/*! Clean up datastore tree after modification
+ * Remove empty NONE nodes and non-presence containers
+ * @param[in]  x0     Top-level datastore tree
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+text_modify_cleanup(cxobj *x0)
+{
+    int retval = -1;
+    
+    /* Remove NONE nodes if all subs recursively are also NONE */
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+	goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
+		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
+	goto done;
+    /* Mark non-presence containers */
+    if (xml_apply(x0, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_TRANSIENT) < 0)
+	goto done;
+    /* Clear XML tree of defaults */
+    if (xml_tree_prune_flagged(x0, XML_FLAG_TRANSIENT, 1) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Append an edit to the journal of a datastore
+ * The journal is a sequence of records on the form:
+ *   <edit operation="merge"><config>...</config></edit>
+ * where <config> is the modification tree of xmldb_put including namespace
+ * declarations of its context.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  op     Top-level operation
+ * @param[in]  x1     Modification tree, top-level symbol is <config>
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_journal_replay
+ */
+static int
+xmldb_journal_append(clicon_handle       h,
+		     const char         *db,
+		     enum operation_type op,
+		     cxobj              *x1)
+{
+    int     retval = -1;
+    char   *filename = NULL;
+    FILE   *f = NULL;
+    cxobj  *xc = NULL;
+    cvec   *nsc = NULL;
+    cg_var *cv;
+    char   *prefix;
+
+    /* Namespace declarations may be in ancestors of x1, eg <rpc> */
+    if (xml_nsctx_node(x1, &nsc) < 0)
+	goto done;
+    if ((xc = xml_dup(x1)) == NULL)
+	goto done;
+    cv = NULL;
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+	prefix = cv_name_get(cv);
+	if (prefix == NULL){
+	    if (xml_find_type_value(xc, NULL, "xmlns", CX_ATTR) != NULL)
+		continue;
+	}
+	else if (xml_find_type_value(xc, "xmlns", prefix, CX_ATTR) != NULL)
+	    continue;
+	if (xmlns_set(xc, prefix, cv_string_get(cv)) < 0)
+	    goto done;
+    }
+    if (xmldb_db2journal(h, db, &filename) < 0)
+	goto done;
+    if ((f = fopen(filename, "a")) == NULL){
+	clicon_err(OE_CFG, errno, "Opening file %s", filename);
+	goto done;
+    }
+    fprintf(f, "<edit operation=\"%s\">", xml_operation2str(op));
+    if (clicon_xml2file(f, xc, 0, 0) < 0)
+	goto done;
+    fprintf(f, "</edit>\n");
+    if (fflush(f) != 0){
+	clicon_err(OE_CFG, errno, "Writing file %s", filename);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (filename)
+	free(filename);
+    if (xc)
+	xml_free(xc);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Replay the journal of a datastore onto a tree read from the datastore file
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     Datastore tree read from file, yang bound and sorted
+ * @param[out] nr     Number of edits replayed (if not NULL)
+ * @retval     0      OK
+ * @retval    -1      Error
+ * Edits are made without NACM checks since they were checked when first made.
+ * An edit that fails is logged and skipped, eg if yang has changed.
+ * The journal is never replayed on a file it has been compacted into, since the 
+ * journal is removed before the compacted file replaces the datastore file.
+ * @see xmldb_journal_append
+ * @see xmldb_write_file
+ */
+int
+xmldb_journal_replay(clicon_handle h,
+		     const char   *db,
+		     yang_stmt    *yspec,
+		     cxobj        *x0,
+		     int          *nr)
+{
+    int                 retval = -1;
+    char               *filename = NULL;
+    FILE               *f = NULL;
+    cxobj              *xj = NULL;
+    cxobj              *xe;
+    cxobj              *xc;
+    cxobj              *xerr = NULL;
+    cbuf               *cbret = NULL;
+    char               *opstr;
+    enum operation_type op;
+    int                 i = 0;
+    int                 ret;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+	goto done;
+    if ((f = fopen(filename, "r")) == NULL){
+	if (errno == ENOENT)
+	    goto ok;
+	clicon_err(OE_UNIX, errno, "open(%s)", filename);
+	goto done;
+    }
+    if (clixon_xml_parse_file(f, YB_NONE, NULL, &xj, NULL) < 0)
+	goto done;
+    if ((cbret = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    xe = NULL;
+    while ((xe = xml_child_each(xj, xe, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xe), "edit") != 0)
+	    continue;
+	i++;
+	op = OP_MERGE;
+	if ((opstr = xml_find_value(xe, "operation")) != NULL &&
+	    xml_operation(opstr, &op) < 0)
+	    goto done;
+	if ((xc = xml_find_type(xe, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL)
+	    continue;
+	cbuf_reset(cbret);
+	if ((ret = xml_bind_yang(xc, YB_MODULE, yspec, &xerr)) < 0)
+	    goto done;
+	if (ret == 1){
+	    if (xml_sort_recurse(xc) < 0)
+		goto done;
+	    if ((ret = text_modify_top(h, x0, x0, xc, xc, yspec, op, NULL, NULL, 1, cbret)) < 0)
+		goto done;
+	}
+	if (ret == 0){
+	    clicon_log(LOG_WARNING, "%s: %s: edit %d not applied: %s", __FUNCTION__,
+		       filename, i, cbuf_get(cbret));
+	    if (xerr){
+		xml_free(xerr);
+		xerr = NULL;
+	    }
+	}
+    }
+    if (text_modify_cleanup(x0) < 0)
+	goto done;
+ ok:
+    if (nr)
+	*nr = i;
+    retval = 0;
+ done:
+    if (cbret)
+	cbuf_free(cbret);
+    if (xerr)
+	xml_free(xerr);
+    if (xj)
+	xml_free(xj);
+    if (f)
+	fclose(f);
+    if (filename)
+	free(filename);
+    return retval;
+}
+
+/*! Write a datastore tree to the datastore file, including all edits in its journal
+ *
+ * If there is a journal, this is a compaction of the journal into the datastore file.
+ * Then the tree is first written to a temporary file, which replaces the datastore 
+ * file only after the journal is removed. An interrupted compaction is completed or
+ * undone when the datastore is read, so that no edit is applied twice. 
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  xt     Datastore tree, top-level symbol is <config>
+ * @param[in]  xmodst Module-state written with the tree, or NULL. Not consumed.
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_journal_recover
+ */
+int
+xmldb_write_file(clicon_handle h,
+		 const char   *db,
+		 cxobj        *xt,
+		 cxobj        *xmodst)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    char       *journalfile = NULL;
+    char       *tmpfile = NULL;
+    char       *filename;
+    FILE       *f = NULL;
+    cxobj      *xms = NULL;
+    char       *format;
+    int         pretty;
+    struct stat st;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if (dbfile==NULL){
+	clicon_err(OE_XML, 0, "dbfile NULL");
+	goto done;
+    }
+    filename = dbfile;
+    if (xmldb_db2journal(h, db, &journalfile) < 0)
+	goto done;
+    if (lstat(journalfile, &st) == 0){
+	if (xmldb_db2journaltmp(h, db, &tmpfile) < 0)
+	    goto done;
+	filename = tmpfile;
+    }
+    if (xmodst){
+	if ((xms = xml_dup(xmodst)) == NULL)
+	    goto done;
+	if (xml_addsub(xt, xms) < 0)
+	    goto done;
+    }
+    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
+	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
+	goto done;
+    }
+    if ((f = fopen(filename, "w")) == NULL){
+	clicon_err(OE_CFG, errno, "Creating file %s", filename);
+	goto done;
+    } 
+    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
+    if (strcmp(format,"json")==0){
+	if (xml2json(f, xt, pretty) < 0)
+	    goto done;
+    }
+    else if (clicon_xml2file(f, xt, 0, pretty) < 0)
+	goto done;
+    if (fflush(f) != 0){
+	clicon_err(OE_CFG, errno, "Writing file %s", filename);
+	goto done;
+    }
+    fclose(f);
+    f = NULL;
+    if (tmpfile){
+	/* The temporary file is complete: remove the journal, then replace the file */
+	if (unlink(journalfile) < 0){
+	    clicon_err(OE_DB, errno, "unlink %s", journalfile);
+	    goto done;
+	}
+	if (rename(tmpfile, dbfile) < 0){
+	    clicon_err(OE_DB, errno, "rename %s", tmpfile);
+	    goto done;
+	}
+    }
+    /* All edits are now in the file */
+    if (xmldb_journal_reset(h, db) < 0)
+	goto done;
+    retval = 0;
+ done:
+    /* Remove modules state after writing to file */
+    if (xms)
+	xml_purge(xms);
+    if (f != NULL)
+	fclose(f);
+    if (dbfile)
+	free(dbfile);
+    if (journalfile)
+	free(journalfile);
+    if (tmpfile)
+	free(tmpfile);
+    return retval;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -991,22 +1310,17 @@ xmldb_put(clicon_handle       h,
 	  cbuf               *cbret)
 {
     int         retval = -1;
-    char       *dbfile = NULL;
-    FILE       *f = NULL;
     cbuf       *cb = NULL;
     yang_stmt  *yspec;
     cxobj      *x0 = NULL;
     db_elmnt   *de = NULL;
     int         ret;
     cxobj      *xnacm = NULL;
-    cxobj      *xmodst = NULL;
-    cxobj      *x;
     int         permit = 0; /* nacm permit all */
-    char       *format;
     cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
-    int         pretty;
     cxobj      *xerr = NULL;
+    int         journal;
 
     if (cbret == NULL){
 	clicon_err(OE_XML, EINVAL, "cbret is NULL");
@@ -1068,17 +1382,7 @@ xmldb_put(clicon_handle       h,
 	goto fail;
     }
 
-    /* Remove NONE nodes if all subs recursively are also NONE */
-    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
-	goto done;
-    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
-		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
-	goto done;
-    /* Mark non-presence containers */
-    if (xml_apply(x0, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_TRANSIENT) < 0)
-	goto done;
-    /* Clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x0, XML_FLAG_TRANSIENT, 1) < 0)
+    if (text_modify_cleanup(x0) < 0)
 	goto done;
 #if 0 /* debug */
     if (xml_apply0(x0, -1, xml_sort_verify, NULL) < 0)
@@ -1090,55 +1394,42 @@ xmldb_put(clicon_handle       h,
 	db_elmnt de0 = {0,};
 	if (de != NULL)
 	    de0 = *de;
-	if (de0.de_xml == NULL)
+	if (de0.de_xml == NULL){
 	    de0.de_xml = x0;
+	    de0.de_dirtymark = 0; /* Read from file, not compared to running */
+	}
 	de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
 	clicon_db_elmnt_set(h, db, &de0);
     }
-    if (xmldb_db2file(h, db, &dbfile) < 0)
-	goto done;
-    if (dbfile==NULL){
-	clicon_err(OE_XML, 0, "dbfile NULL");
+    /* Other caches can no longer be compared to running using dirty marks */
+    if (strcmp(db, "running") == 0 &&
+	xmldb_dirtymark_reset(h, db) < 0)
 	goto done;
+    /* Append the edit to the journal instead of writing the whole file, unless
+     * the journal is full, in which case it is compacted into the file below. 
+     * Only with cache since the cached tree is written on compaction */
+    if ((journal = clicon_option_int(h, "CLICON_XMLDB_JOURNAL")) > 0 &&
+	x1 != NULL &&
+	(de = clicon_db_elmnt_get(h, db)) != NULL &&
+	de->de_xml != NULL &&
+	de->de_journal < journal){
+	if (xmldb_journal_append(h, db, op, x1) < 0)
+	    goto done;
+	de->de_journal++;
+	goto ok;
     }
     /* Add module revision info before writing to file)
      * Only if CLICON_XMLDB_MODSTATE is set
      */
-    if ((x = clicon_modst_cache_get(h, 1)) != NULL){
-	if ((xmodst = xml_dup(x)) == NULL)
-	    goto done;
-	if (xml_addsub(x0, xmodst) < 0)
-	    goto done;
-    }
-    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
-	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
-	goto done;
-    }
-    if ((f = fopen(dbfile, "w")) == NULL){
-	clicon_err(OE_CFG, errno, "Creating file %s", dbfile);
-	goto done;
-    } 
-    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
-    if (strcmp(format,"json")==0){
-	if (xml2json(f, x0, pretty) < 0)
-	    goto done;
-    }
-    else if (clicon_xml2file(f, x0, 0, pretty) < 0)
-	goto done;
-    /* Remove modules state after writing to file
-     */
-    if (xmodst && xml_purge(xmodst) < 0)
+    if (xmldb_write_file(h, db, x0, clicon_modst_cache_get(h, 1)) < 0)
 	goto done;
+ ok:
     retval = 1;
  done:
-    if (f != NULL)
-	fclose(f);
     if (xerr)
 	xml_free(xerr);
     if (nsc)
 	xml_nsctx_free(nsc);
-    if (dbfile)
-	free(dbfile);
     if (cb)
 	cbuf_free(cb);
     if (x0 && clicon_datastore_cache(h) == DATASTORE_NOCACHE)
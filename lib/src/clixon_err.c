@@ -201,6 +201,9 @@ clicon_err_fn(const char *fn,
     int     retval = -1;
     struct clixon_err_cats *cec;
     
+    /* Leave global error state to the main thread, see clicon_log_thread_disable */
+    if (clicon_log_thread_disabled())
+	return -1;
     /* Set the global variables */
     clicon_errno    = category;
     clicon_suberrno = suberr;
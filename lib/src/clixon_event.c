@@ -44,13 +44,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#else
+#include <sys/select.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -68,15 +75,24 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of file descriptors with input handled per event loop iteration */
+#define EVENT_MAXFDS 64
+
+/* Events registered or ready on a file descriptor */
+#define EVENT_IN  0x01 /* Input, see clixon_event_reg_fd */
+#define EVENT_OUT 0x02 /* Output, see clixon_event_reg_fd_out */
+
 /*
  * Types
  */
 struct event_data{
-    struct event_data *e_next;     /* next in list */
+    struct event_data *e_next;     /* next registration on same fd */
     int (*e_fn)(int, void*);            /* function */
     enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
     int e_fd;                      /* File descriptor */
+    int e_file;                    /* fd cannot be polled, eg a regular file: always ready */
     struct timeval e_time;         /* Timeout */
+    uint64_t e_seq;                /* Timeout registration order, for equal timeouts */
     void *e_arg;                   /* function argument */
     char e_string[EVENT_STRLEN];             /* string for debugging */
 };
@@ -85,8 +101,23 @@ struct event_data{
  * Internal variables
  * XXX consider use handle variables instead of global
  */
-static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+/* File descriptor registrations indexed by fd, each a list of registrations on that fd */
+static struct event_data **ee = NULL;
+/* Output registrations indexed by fd, same length as ee */
+static struct event_data **ee_out = NULL;
+static int ee_len = 0;              /* Length of ee and ee_out vectors */
+
+/* Timeout registrations as a binary min-heap ordered by time */
+static struct event_data **ee_timers = NULL;
+static size_t ee_timers_len = 0;    /* Nr of timeouts in heap */
+static size_t ee_timers_max = 0;    /* Allocated length of heap */
+static uint64_t ee_timers_seq = 0;  /* Registration counter */
+
+#ifdef HAVE_EPOLL_CREATE1
+static int   ee_epfd = -1;          /* epoll instance */
+static pid_t ee_eppid = 0;          /* Process that created the epoll instance */
+#endif
+static int   ee_files = 0;          /* Nr of fds that cannot be polled, see e_file */
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
@@ -160,26 +191,192 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
-/*! Register a callback function to be called on input on a file descriptor.
- *
+/*! Get events registered on a file descriptor
+ * @param[in]  fd      File descriptor
+ * @retval     events  EVENT_IN and/or EVENT_OUT, or 0 if not registered
+ */
+static int
+event_fd_events(int fd)
+{
+    int events = 0;
+
+    if (fd < ee_len){
+	if (ee[fd])
+	    events |= EVENT_IN;
+	if (ee_out[fd])
+	    events |= EVENT_OUT;
+    }
+    return events;
+}
+
+/*! Check if file descriptor cannot be polled, see e_file
+ */
+static int
+event_fd_file(int fd)
+{
+    return (ee[fd] && ee[fd]->e_file) || (ee_out[fd] && ee_out[fd]->e_file);
+}
+
+/*! Grow registration vectors so that fd fits
  * @param[in]  fd  File descriptor
- * @param[in]  fn  Function to call when input available on fd
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_fd_grow(int fd)
+{
+    struct event_data **ev;
+    int                 len;
+
+    if (fd < ee_len)
+	return 0;
+    len = ee_len ? ee_len : EVENT_MAXFDS;
+    while (len <= fd)
+	len *= 2;
+    if ((ev = realloc(ee, len*sizeof(*ee))) == NULL){
+	clicon_err(OE_EVENTS, errno, "realloc");
+	return -1;
+    }
+    memset(&ev[ee_len], 0, (len-ee_len)*sizeof(*ee));
+    ee = ev;
+    if ((ev = realloc(ee_out, len*sizeof(*ee_out))) == NULL){
+	clicon_err(OE_EVENTS, errno, "realloc");
+	return -1;
+    }
+    memset(&ev[ee_len], 0, (len-ee_len)*sizeof(*ee_out));
+    ee_out = ev;
+    ee_len = len;
+    return 0;
+}
+
+#ifdef HAVE_EPOLL_CREATE1
+/*! Update epoll instance after a registration change on a file descriptor
+ * @param[in]  epfd    epoll instance
+ * @param[in]  fd      File descriptor
+ * @param[in]  before  Events registered before the change, see event_fd_events
+ * @retval     0       OK
+ * @retval    -1       Error, errno set
+ */
+static int
+event_epoll_ctl(int epfd,
+		int fd,
+		int before)
+{
+    struct epoll_event ev = {0,};
+    int                events;
+    int                op;
+
+    if ((events = event_fd_events(fd)) == before)
+	return 0;
+    if (before == 0)
+	op = EPOLL_CTL_ADD;
+    else if (events == 0)
+	op = EPOLL_CTL_DEL;
+    else
+	op = EPOLL_CTL_MOD;
+    if (events & EVENT_IN)
+	ev.events |= EPOLLIN;
+    if (events & EVENT_OUT)
+	ev.events |= EPOLLOUT;
+    ev.data.fd = fd;
+    return epoll_ctl(epfd, op, fd, &ev);
+}
+
+/*! Add file descriptor to epoll instance
+ * If fd cannot be polled (eg a regular file), it is marked as always ready, which is
+ * the same as select() does.
+ * @param[in]  epfd  epoll instance
+ * @param[in]  fd    File descriptor, registered in ee or ee_out
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+event_epoll_add(int epfd,
+		int fd)
+{
+    struct event_data *e;
+
+    if (event_epoll_ctl(epfd, fd, 0) < 0){
+	if (errno != EPERM){
+	    clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	    return -1;
+	}
+	for (e = ee[fd]; e; e = e->e_next)
+	    e->e_file = 1;
+	for (e = ee_out[fd]; e; e = e->e_next)
+	    e->e_file = 1;
+	ee_files++;
+    }
+    return 0;
+}
+
+/*! Get epoll instance, create it if not created (by this process)
+ * A child process that continues to use the event loop after fork() must not
+ * modify the epoll instance of its parent, instead a new is created.
+ * @retval    epfd  epoll instance
+ * @retval    -1    Error
+ */
+static int
+event_epoll_get(void)
+{
+    int fd;
+
+    if (ee_epfd != -1 && ee_eppid == getpid())
+	return ee_epfd;
+    if (ee_epfd != -1) /* Inherited from parent process */
+	close(ee_epfd);
+    if ((ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+	clicon_err(OE_EVENTS, errno, "epoll_create1");
+	return -1;
+    }
+    ee_eppid = getpid();
+    /* Add file descriptors registered before (or in parent process) */
+    ee_files = 0;
+    for (fd = 0; fd < ee_len; fd++)
+	if (event_fd_events(fd) && event_epoll_add(ee_epfd, fd) < 0)
+	    return -1;
+    return ee_epfd;
+}
+#endif /* HAVE_EPOLL_CREATE1 */
+
+/*! Register a callback function on input or output on a file descriptor
+ * @param[in]  fd  File descriptor
+ * @param[in]  out 0: input, 1: output
+ * @param[in]  fn  Function to call when fd is ready
  * @param[in]  arg Argument to function fn
  * @param[in]  str Describing string for logging
- * @code
- * int fn(int fd, void *arg){
- * }
- * clixon_event_reg_fd(fd, fn, (void*)42, "call fn on input on fd");
- * @endcode 
+ * @see clixon_event_reg_fd
+ * @see clixon_event_reg_fd_out
  */
-int
-clixon_event_reg_fd(int   fd, 
-		    int (*fn)(int, void*), 
-		    void *arg, 
-		    char *str)
+static int
+event_fd_reg(int   fd,
+	     int   out,
+	     int (*fn)(int, void*), 
+	     void *arg, 
+	     char *str)
 {
-    struct event_data *e;
+    struct event_data  *e;
+    struct event_data **list;
+#ifdef HAVE_EPOLL_CREATE1
+    int                 epfd;
+    int                 before;
+#endif
 
+    if (fd < 0){
+	clicon_err(OE_EVENTS, EBADF, "fd %d", fd);
+	return -1;
+    }
+#ifndef HAVE_EPOLL_CREATE1
+    if (fd >= FD_SETSIZE){
+	clicon_err(OE_EVENTS, EBADF, "fd %d larger than FD_SETSIZE", fd);
+	return -1;
+    }
+#else
+    if ((epfd = event_epoll_get()) < 0)
+	return -1;
+#endif
+    if (event_fd_grow(fd) < 0)
+	return -1;
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
 	clicon_err(OE_EVENTS, errno, "malloc");
 	return -1;
@@ -190,10 +387,101 @@ clixon_event_reg_fd(int   fd,
     e->e_fn = fn;
     e->e_arg = arg;
     e->e_type = EVENT_FD;
-    e->e_next = ee;
-    ee = e;
+    e->e_file = event_fd_file(fd);
+#ifdef HAVE_EPOLL_CREATE1
+    before = event_fd_events(fd);
+#endif
+    list = out ? &ee_out[fd] : &ee[fd];
+    e->e_next = *list;
+    *list = e;
+#ifdef HAVE_EPOLL_CREATE1
+    /* First registration on fd */
+    if (before == 0){
+	if (event_epoll_add(epfd, fd) < 0)
+	    goto fail;
+    }
+    else if (!e->e_file && event_epoll_ctl(epfd, fd, before) < 0){
+	clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	goto fail;
+    }
+#endif
     clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
     return 0;
+#ifdef HAVE_EPOLL_CREATE1
+ fail:
+    *list = e->e_next;
+    free(e);
+    return -1;
+#endif
+}
+
+/*! Deregister a callback on input or output on a file descriptor
+ * @param[in]  s   File descriptor
+ * @param[in]  out 0: input, 1: output
+ * @param[in]  fn  Function to call when fd is ready
+ * @see event_fd_reg
+ */
+static int
+event_fd_unreg(int   s,
+	       int   out,
+	       int (*fn)(int, void*))
+{
+    struct event_data *e, **e_prev;
+    int                found = 0;
+#ifdef HAVE_EPOLL_CREATE1
+    int                before;
+#endif
+
+    if (s < 0 || s >= ee_len)
+	return -1;
+#ifdef HAVE_EPOLL_CREATE1
+    before = event_fd_events(s);
+#endif
+    e_prev = out ? &ee_out[s] : &ee[s];
+    for (e = *e_prev; e; e = e->e_next){
+	if (fn == e->e_fn) {
+	    found++;
+	    *e_prev = e->e_next;
+	    _ee_unreg++;
+	    break;
+	}
+	e_prev = &e->e_next;
+    }
+    if (!found)
+	return -1;
+    /* Last registration on fd */
+    if (e->e_file){
+	if (event_fd_events(s) == 0)
+	    ee_files--;
+    }
+#ifdef HAVE_EPOLL_CREATE1
+    /* If fd already is closed, it is already removed from epoll */
+    else if (ee_epfd != -1 && ee_eppid == getpid())
+	event_epoll_ctl(ee_epfd, s, before);
+#endif
+    free(e);
+    return 0;
+}
+
+/*! Register a callback function to be called on input on a file descriptor.
+ *
+ * @param[in]  fd  File descriptor
+ * @param[in]  fn  Function to call when input available on fd
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @code
+ * int fn(int fd, void *arg){
+ * }
+ * clixon_event_reg_fd(fd, fn, (void*)42, "call fn on input on fd");
+ * @endcode 
+ */
+int
+clixon_event_reg_fd(int   fd, 
+		    int (*fn)(int, void*), 
+		    void *arg, 
+		    char *str)
+{
+    return event_fd_reg(fd, 0, fn, arg, str);
 }
 
 /*! Deregister a file descriptor callback
@@ -207,21 +495,106 @@ int
 clixon_event_unreg_fd(int   s, 
 		      int (*fn)(int, void*))
 {
-    struct event_data *e, **e_prev;
-    int found = 0;
+    return event_fd_unreg(s, 0, fn);
+}
 
-    e_prev = &ee;
-    for (e = ee; e; e = e->e_next){
-	if (fn == e->e_fn && s == e->e_fd) {
-	    found++;
-	    *e_prev = e->e_next;
-	    _ee_unreg++;
-	    free(e);
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Typically registered when a non-blocking write would block, and deregistered
+ * when all pending data is written. Output callbacks on a fd are called before input
+ * callbacks. An error or hangup on fd is reported to both.
+ * @param[in]  fd  File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @see clixon_event_unreg_fd_out
+ */
+int
+clixon_event_reg_fd_out(int   fd, 
+			int (*fn)(int, void*), 
+			void *arg, 
+			char *str)
+{
+    return event_fd_reg(fd, 1, fn, arg, str);
+}
+
+/*! Deregister a file descriptor output callback
+ * @param[in]  s   File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @see clixon_event_reg_fd_out
+ */
+int
+clixon_event_unreg_fd_out(int   s, 
+			  int (*fn)(int, void*))
+{
+    return event_fd_unreg(s, 1, fn);
+}
+
+/*! Compare two timeouts, equal times are ordered by registration
+ */
+static int
+event_timer_cmp(struct event_data *e1,
+		struct event_data *e2)
+{
+    if (timercmp(&e1->e_time, &e2->e_time, <))
+	return -1;
+    if (timercmp(&e1->e_time, &e2->e_time, >))
+	return 1;
+    return e1->e_seq < e2->e_seq ? -1 : 1;
+}
+
+/*! Move timeout at position i in heap up until heap is ordered
+ */
+static void
+event_timer_up(size_t i)
+{
+    struct event_data *e = ee_timers[i];
+    size_t             p;
+
+    while (i > 0){
+	p = (i-1)/2;
+	if (event_timer_cmp(ee_timers[p], e) < 0)
 	    break;
-	}
-	e_prev = &e->e_next;
+	ee_timers[i] = ee_timers[p];
+	i = p;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Move timeout at position i in heap down until heap is ordered
+ */
+static void
+event_timer_down(size_t i)
+{
+    struct event_data *e = ee_timers[i];
+    size_t             c;
+
+    while ((c = 2*i+1) < ee_timers_len){
+	if (c+1 < ee_timers_len && event_timer_cmp(ee_timers[c+1], ee_timers[c]) < 0)
+	    c++;
+	if (event_timer_cmp(e, ee_timers[c]) < 0)
+	    break;
+	ee_timers[i] = ee_timers[c];
+	i = c;
     }
-    return found?0:-1;
+    ee_timers[i] = e;
+}
+
+/*! Remove timeout at position i from heap
+ * @param[in]  i  Position in heap
+ * @retval     e  Removed timeout
+ */
+static struct event_data *
+event_timer_remove(size_t i)
+{
+    struct event_data *e = ee_timers[i];
+
+    if (i < --ee_timers_len){
+	ee_timers[i] = ee_timers[ee_timers_len];
+	event_timer_down(i);
+	event_timer_up(i);
+    }
+    return e;
 }
 
 /*! Call a callback function at an absolute time
@@ -236,9 +609,9 @@ clixon_event_unreg_fd(int   s,
  *   t1.tv_sec = 1; t1.tv_usec = 0;
  *   timeradd(&t, &t1, &t);
  *   clixon_event_reg_timeout(t, fn, NULL, "call every second");
- * } 
+ * }
  * @endcode 
- * 
+ *
  * Note that the timestamp is an absolute timestamp, not relative.
  * Note also that the callback is not periodic, you need to make a new 
  * registration for each period, see example above.
@@ -253,8 +626,19 @@ clixon_event_reg_timeout(struct timeval t,
 			 void          *arg, 
 			 char          *str)
 {
-    struct event_data *e, *e1, **e_prev;
-
+    struct event_data  *e;
+    struct event_data **ev;
+    size_t              len;
+
+    if (ee_timers_len == ee_timers_max){
+	len = ee_timers_max ? 2*ee_timers_max : EVENT_MAXFDS;
+	if ((ev = realloc(ee_timers, len*sizeof(*ee_timers))) == NULL){
+	    clicon_err(OE_EVENTS, errno, "realloc");
+	    return -1;
+	}
+	ee_timers = ev;
+	ee_timers_max = len;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
 	clicon_err(OE_EVENTS, errno, "malloc");
 	return -1;
@@ -265,15 +649,10 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-	if (timercmp(&e->e_time, &e1->e_time, <))
-	    break;
-	e_prev = &e1->e_next;
-    }
-    e->e_next = e1;
-    *e_prev = e;
+    e->e_seq = ee_timers_seq++;
+    /* Insert into heap */
+    ee_timers[ee_timers_len++] = e;
+    event_timer_up(ee_timers_len-1);
     clicon_debug(2, "%s: %s", __FUNCTION__, str); 
     return 0;
 }
@@ -291,20 +670,18 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*), 
 			   void *arg)
 {
-    struct event_data *e, **e_prev;
-    int found = 0;
+    struct event_data *e;
+    size_t             i;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
+    for (i = 0; i < ee_timers_len; i++){
+	e = ee_timers[i];
 	if (fn == e->e_fn && arg == e->e_arg) {
-	    found++;
-	    *e_prev = e->e_next;
+	    event_timer_remove(i);
 	    free(e);
-	    break;
+	    return 0;
 	}
-	e_prev = &e->e_next;
     }
-    return found?0:-1;
+    return -1;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -313,59 +690,225 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
  * @retval     0    Nothing to read/empty fd
  * @retval     1    Something to read on fd
  */
-int 
+int
 clixon_event_poll(int fd)
 {
     int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
+    struct pollfd  pfd = {0,};
 
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-	clicon_err(OE_EVENTS, errno, "select");
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+	clicon_err(OE_EVENTS, errno, "poll");
     return retval;
 }
 
+/*! Wait for input or output on registered file descriptors, or until timeout
+ * @param[in]  tp     Max time to wait, or NULL to wait until ready
+ * @param[out] fds    Vector of ready file descriptors
+ * @param[out] events Vector of ready events (EVENT_IN/EVENT_OUT) of each fd in fds
+ * @param[in]  len    Length of fds and events vectors
+ * @retval     n      Number of ready file descriptors in fds
+ * @retval    -1      Error, errno set
+ */
+static int
+event_wait(struct timeval *tp,
+	   int            *fds,
+	   int            *events,
+	   int             len)
+{
+    int                n = 0;
+    int                fd;
+#ifdef HAVE_EPOLL_CREATE1
+    struct epoll_event evs[EVENT_MAXFDS];
+    int                epfd;
+    int                ms;
+    int                i;
+    uint32_t           ev;
+
+    if ((epfd = event_epoll_get()) < 0)
+	return -1;
+    if (ee_files)
+	ms = 0;
+    else if (tp == NULL)
+	ms = -1;
+    else if (tp->tv_sec >= INT_MAX/1000 - 1)
+	ms = INT_MAX;
+    else /* Round up, do not wake up before timeout */
+	ms = tp->tv_sec*1000 + (tp->tv_usec+999)/1000;
+    if (len > EVENT_MAXFDS)
+	len = EVENT_MAXFDS;
+    if ((n = epoll_wait(epfd, evs, len, ms)) < 0)
+	return -1;
+    for (i = 0; i < n; i++){
+	fds[i] = evs[i].data.fd;
+	ev = evs[i].events;
+	events[i] = 0;
+	if (ev & (EPOLLIN|EPOLLHUP|EPOLLERR))
+	    events[i] |= EVENT_IN;
+	if (ev & (EPOLLOUT|EPOLLHUP|EPOLLERR))
+	    events[i] |= EVENT_OUT;
+    }
+    /* Files are always ready */
+    for (fd = 0; ee_files && fd < ee_len && n < len; fd++)
+	if (event_fd_file(fd)){
+	    fds[n] = fd;
+	    events[n++] = EVENT_IN|EVENT_OUT;
+	}
+#else /* HAVE_EPOLL_CREATE1 */
+    fd_set             rset;
+    fd_set             wset;
+
+    FD_ZERO(&rset);
+    FD_ZERO(&wset);
+    for (fd = 0; fd < ee_len; fd++){
+	if (ee[fd])
+	    FD_SET(fd, &rset);
+	if (ee_out[fd])
+	    FD_SET(fd, &wset);
+    }
+    if (select(FD_SETSIZE, &rset, &wset, NULL, tp) < 0)
+	return -1;
+    for (fd = 0; fd < ee_len && n < len; fd++){
+	events[n] = 0;
+	if (ee[fd] && FD_ISSET(fd, &rset))
+	    events[n] |= EVENT_IN;
+	if (ee_out[fd] && FD_ISSET(fd, &wset))
+	    events[n] |= EVENT_OUT;
+	if (events[n])
+	    fds[n++] = fd;
+    }
+#endif /* HAVE_EPOLL_CREATE1 */
+    return n;
+}
+
+/*! Call all timeouts that have expired
+ * Timeouts registered by the callbacks themselves are not called until next
+ * event loop iteration, so that timeouts do not starve file descriptor input.
+ * @retval  0  OK
+ * @retval -1  Error in callback
+ */
+static int
+event_timers_dispatch(void)
+{
+    struct event_data *e;
+    struct timeval     t0;
+    size_t             nr;
+
+    if (ee_timers_len == 0)
+	return 0;
+    gettimeofday(&t0, NULL);
+    nr = ee_timers_len;
+    while (nr-- && ee_timers_len &&
+	   !timercmp(&ee_timers[0]->e_time, &t0, >)){
+	if (clixon_exit_get() == 1)
+	    break;
+	e = event_timer_remove(0);
+	clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
+	if ((*e->e_fn)(0, e->e_arg) < 0){
+	    free(e);
+	    return -1;
+	}
+	free(e);
+    }
+    return 0;
+}
+
+/*! Call all callbacks in a list of registrations on a file descriptor
+ * @param[in]  e0  First registration
+ * @retval     1   OK, but a file descriptor was deregistered in a callback
+ * @retval     0   OK
+ * @retval    -1   Error in callback
+ */
+static int
+event_fd_call(struct event_data *e0)
+{
+    struct event_data *e;
+    struct event_data *e_next;
+
+    for (e = e0; e; e = e_next){
+	if (clixon_exit_get() == 1)
+	    break;
+	e_next = e->e_next;
+	clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
+	if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+	    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
+	    return -1;
+	}
+	if (_ee_unreg){
+	    _ee_unreg = 0;
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/*! Call all callbacks registered on a ready file descriptor
+ * Output callbacks are called before input callbacks.
+ * @param[in]  fd      File descriptor
+ * @param[in]  events  Ready events, EVENT_IN and/or EVENT_OUT
+ * @retval     1       OK, but a file descriptor was deregistered in a callback
+ * @retval     0       OK
+ * @retval    -1       Error in callback
+ */
+static int
+event_fd_dispatch(int fd,
+		  int events)
+{
+    int ret;
+
+    if (event_fd_events(fd) == 0){
+#ifdef HAVE_EPOLL_CREATE1
+	/* Closed and deregistered but still open in another process */
+	epoll_ctl(ee_epfd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+	return 0;
+    }
+    if ((events & EVENT_OUT) && ee_out[fd] &&
+	(ret = event_fd_call(ee_out[fd])) != 0)
+	return ret;
+    if ((events & EVENT_IN) && ee[fd])
+	return event_fd_call(ee[fd]);
+    return 0;
+}
+
 /*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
- * There is an issue with fairness that timeouts may take over all events
- * One could try to poll the file descriptors after a timeout?
+ * Uses epoll if available, otherwise select.
+ * In each iteration, all expired timeouts are called first, then all file
+ * descriptors with input or output. If a file descriptor is deregistered by a callback,
+ * the remaining are handled in the next iteration.
  * @retval  0  OK
  * @retval -1  Error: eg select, callback, timer, 
  */
 int
 clixon_event_loop(clicon_handle h)
 {
-    struct event_data *e;
-    struct event_data *e_next;
     int                n;
+    int                i;
+    int                ret;
     struct timeval     t;
     struct timeval     t0;
-    struct timeval     tnull = {0,};
-    fd_set             fdset;
+    struct timeval    *tp;
+    int                fds[EVENT_MAXFDS];
+    int                events[EVENT_MAXFDS];
     int                retval = -1;
 
     while (clixon_exit_get() != 1){
-	FD_ZERO(&fdset);
 	if (clicon_sig_child_get()){
 	    /* Go through processes and wait for child processes */
 	    if (clixon_process_waitpid(h) < 0)
 		goto err;
 	    clicon_sig_child_set(0);
 	}
-	for (e=ee; e; e=e->e_next)
-	    if (e->e_type == EVENT_FD)
-		FD_SET(e->e_fd, &fdset);
-	if (ee_timers != NULL){
+	tp = NULL;
+	if (ee_timers_len){
 	    gettimeofday(&t0, NULL);
-	    timersub(&ee_timers->e_time, &t0, &t); 
+	    timersub(&ee_timers[0]->e_time, &t0, &t);
 	    if (t.tv_sec < 0)
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
-	    else
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
+		timerclear(&t);
+	    tp = &t;
 	}
-	else
-	    n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+	n = event_wait(tp, fds, events, EVENT_MAXFDS);
 	if (clixon_exit_get() == 1){
 	    break;
 	}
@@ -404,34 +947,16 @@ clixon_event_loop(clicon_handle h)
 		clicon_err(OE_EVENTS, errno, "select");
 	    goto err;
 	}
-	if (n==0){ /* Timeout */
-	    e = ee_timers;
-	    ee_timers = ee_timers->e_next;
-	    clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
-	    if ((*e->e_fn)(0, e->e_arg) < 0){
-		free(e);
-		goto err;
-	    }
-	    free(e);
-	}
+	if (event_timers_dispatch() < 0)
+	    goto err;
 	_ee_unreg = 0;
-	for (e=ee; e; e=e_next){
-	    if (clixon_exit_get() == 1){
+	for (i = 0; i < n; i++){
+	    if (clixon_exit_get() == 1)
+		break;
+	    if ((ret = event_fd_dispatch(fds[i], events[i])) < 0)
+		goto err;
+	    if (ret == 1)
 		break;
-	    }
-	    e_next = e->e_next;
-	    if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
-		clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
-		if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
-		    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
-		    goto err;
-
-		}
-		if (_ee_unreg){
-		    _ee_unreg = 0;
-		    break;
-		}
-	    }
 	}
 	clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
 	continue;
@@ -447,18 +972,40 @@ int
 clixon_event_exit(void)
 {
     struct event_data *e, *e_next;
-    
-    e_next = ee;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
+    int                fd;
+    size_t             i;
+
+    for (fd = 0; fd < ee_len; fd++){
+	e_next = ee[fd];
+	while ((e = e_next) != NULL){
+	    e_next = e->e_next;
+	    free(e);
+	}
+	e_next = ee_out[fd];
+	while ((e = e_next) != NULL){
+	    e_next = e->e_next;
+	    free(e);
+	}
     }
+    if (ee)
+	free(ee);
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
-    }
+    if (ee_out)
+	free(ee_out);
+    ee_out = NULL;
+    ee_len = 0;
+    ee_files = 0;
+    for (i = 0; i < ee_timers_len; i++)
+	free(ee_timers[i]);
+    if (ee_timers)
+	free(ee_timers);
     ee_timers = NULL;
+    ee_timers_len = 0;
+    ee_timers_max = 0;
+#ifdef HAVE_EPOLL_CREATE1
+    if (ee_epfd != -1 && ee_eppid == getpid())
+	close(ee_epfd);
+    ee_epfd = -1;
+#endif
     return 0;
 }
@@ -40,6 +40,9 @@
  * A simple implementation of a associative array style data store. Keys
  * are always strings while values can be some arbitrary data referenced
  * by void*.
+ * The table uses open addressing with linear probing on FNV-1a hash values. 
+ * The number of slots is a power of two and is doubled when the table gets
+ * more than 3/4 full.
  *
  * XXX: functions such as hash_keys(), hash_value() etc are currently returning
  * pointers to the actual data storage. Should probably make copies.
@@ -98,19 +101,92 @@
 #include "clixon_err.h"
 #include "clixon_hash.h"
 
-#define HASH_SIZE	1031	/* Number of hash buckets. Should be a prime */ 
+#define HASH_SIZE	16	/* Initial number of slots. Must be a power of two */ 
 #define align4(s) (((s)/4)*4 + 4)
 
-/*! A very simplistic algorithm to calculate a hash bucket index
+/* FNV-1a 32-bit parameters */
+#define FNV_OFFSET	2166136261U
+#define FNV_PRIME	16777619U
+
+/*
+ * Hash table
+ * Vector of slots, each either empty (NULL) or pointing to an entry.
+ * An entry is placed in the first empty slot after the slot given by its hash
+ * value (linear probing).
+ */
+struct clicon_hash_table {
+    struct clicon_hash **ht_vec;  /* Vector of slots */
+    size_t               ht_size; /* Number of slots, power of two */
+    size_t               ht_nr;   /* Number of entries */
+};
+
+/*! Calculate FNV-1a hash value of a string
  */
 static uint32_t
-hash_bucket(const char *str)
+hash_fnv1a(const char *str)
+{
+    uint32_t n = FNV_OFFSET;
+
+    while(*str){
+	n ^= (uint8_t)*str++;
+	n *= FNV_PRIME;
+    }
+    return n;
+}
+
+/*! Find slot of key, or the empty slot where it should be inserted
+ *
+ * @param[in] hash   Hash table
+ * @param[in] key    Variable name
+ * @param[in] hval   Hash value of key
+ * @retval    i      Slot index
+ */
+static size_t
+hash_slot(clicon_hash_t *hash,
+	  const char    *key,
+	  uint32_t       hval)
+{
+    size_t              mask = hash->ht_size - 1;
+    size_t              i;
+    struct clicon_hash *h;
+
+    for (i = hval & mask; (h = hash->ht_vec[i]) != NULL; i = (i + 1) & mask)
+	if (h->h_hval == hval && strcmp(h->h_key, key) == 0)
+	    break;
+    return i;
+}
+
+/*! Resize hash table and re-insert all entries
+ *
+ * @param[in] hash   Hash table
+ * @param[in] size   New number of slots, power of two and larger than number of entries
+ * @retval    0      OK
+ * @retval   -1      Error
+ */
+static int
+hash_resize(clicon_hash_t *hash,
+	    size_t         size)
 {
-    uint32_t n = 0;
+    struct clicon_hash **vec;
+    struct clicon_hash  *h;
+    size_t               i;
+    size_t               j;
 
-    while(*str)
-	n += (uint32_t)*str++;
-    return n % HASH_SIZE;
+    if ((vec = calloc(size, sizeof(*vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    for (i = 0; i < hash->ht_size; i++){
+	if ((h = hash->ht_vec[i]) == NULL)
+	    continue;
+	for (j = h->h_hval & (size - 1); vec[j] != NULL; j = (j + 1) & (size - 1))
+	    ;
+	vec[j] = h;
+    }
+    free(hash->ht_vec);
+    hash->ht_vec = vec;
+    hash->ht_size = size;
+    return 0;
 }
 
 /*! Initialize hash table.
@@ -122,14 +198,20 @@ hash_bucket(const char *str)
 clicon_hash_t *
 clicon_hash_init(void)
 {
-  clicon_hash_t *hash;
-
-  if ((hash = (clicon_hash_t *)malloc(sizeof(clicon_hash_t) * HASH_SIZE)) == NULL){
-      clicon_err(OE_UNIX, errno, "malloc");
-      return NULL;
-  }
-  memset(hash, 0, sizeof(clicon_hash_t)*HASH_SIZE);
-  return hash;
+    clicon_hash_t *hash;
+
+    if ((hash = (clicon_hash_t *)malloc(sizeof(*hash))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(hash, 0, sizeof(*hash));
+    if ((hash->ht_vec = calloc(HASH_SIZE, sizeof(*hash->ht_vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	free(hash);
+	return NULL;
+    }
+    hash->ht_size = HASH_SIZE;
+    return hash;
 }
 
 /*! Free hash table.
@@ -141,17 +223,18 @@ clicon_hash_init(void)
 int
 clicon_hash_free(clicon_hash_t *hash)
 {
-    int i;
-    clicon_hash_t tmp;
-    for (i = 0; i < HASH_SIZE; i++) {
-	while (hash[i]) {
-	    tmp = hash[i];
-	    DELQ(tmp, hash[i], clicon_hash_t);
-	    free(tmp->h_key);
-	    free(tmp->h_val);
-	    free(tmp);
+    size_t              i;
+    struct clicon_hash *h;
+
+    for (i = 0; i < hash->ht_size; i++) {
+	if ((h = hash->ht_vec[i]) != NULL){
+	    free(h->h_key);
+	    if (h->h_val)
+		free(h->h_val);
+	    free(h);
 	}
     }
+    free(hash->ht_vec);
     free(hash);
     return 0;
 }
@@ -163,23 +246,11 @@ clicon_hash_free(clicon_hash_t *hash)
  * @retval    variable Hash variable structure on success
  * @retval    NULL     Not found
  */
-clicon_hash_t
+struct clicon_hash *
 clicon_hash_lookup(clicon_hash_t *hash, 
 		   const char    *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
-
-    bkt = hash_bucket(key);
-    h = hash[bkt];
-    if (h) {
-	do {
-	    if (!strcmp(h->h_key, key))
-		return h;
-	    h = NEXTQ(clicon_hash_t, h);
-	} while (h != hash[bkt]);
-    }
-    return NULL;
+    return hash->ht_vec[hash_slot(hash, key, hash_fnv1a(key))];
 }
 
 /*! Get value of hash
@@ -194,7 +265,7 @@ clicon_hash_value(clicon_hash_t *hash,
 		  const char    *key, 
 		  size_t        *vlen)
 {
-    clicon_hash_t h;
+    struct clicon_hash *h;
 
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -219,15 +290,17 @@ clicon_hash_value(clicon_hash_t *hash,
  * @retval    NULL   Error
  * @note special case val is NULL and vlen==0
  */
-clicon_hash_t
+struct clicon_hash *
 clicon_hash_add(clicon_hash_t *hash, 
 		const char    *key, 
 		void          *val, 
 		size_t         vlen)
 {
-    void         *newval = NULL;
-    clicon_hash_t h;
-    clicon_hash_t new = NULL;
+    void               *newval = NULL;
+    struct clicon_hash *h;
+    struct clicon_hash *new = NULL;
+    uint32_t            hval;
+    size_t              i;
     
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -240,9 +313,11 @@ clicon_hash_add(clicon_hash_t *hash,
 	goto catch;
     }
     /* If variable exist, don't allocate a new. just replace value */
-    h = clicon_hash_lookup(hash, key);
+    hval = hash_fnv1a(key);
+    i = hash_slot(hash, key, hval);
+    h = hash->ht_vec[i];
     if (h == NULL) {
-	if ((new = (clicon_hash_t)malloc(sizeof(*new))) == NULL){
+	if ((new = (struct clicon_hash *)malloc(sizeof(*new))) == NULL){
 	    clicon_err(OE_UNIX, errno, "malloc");
 	    goto catch;
 	}
@@ -253,7 +328,7 @@ clicon_hash_add(clicon_hash_t *hash,
 	    clicon_err(OE_UNIX, errno, "strdup");
 	    goto catch;
 	}
-	
+	new->h_hval = hval;
 	h = new;
     }
     
@@ -266,6 +341,17 @@ clicon_hash_add(clicon_hash_t *hash,
 	}
 	memcpy(newval, val, vlen);
     }
+
+    /* Insert only if new variable, grow if more than 3/4 full */
+    if (new){
+	if (4 * (hash->ht_nr + 1) > 3 * hash->ht_size){
+	    if (hash_resize(hash, 2 * hash->ht_size) < 0)
+		goto catch;
+	    i = hash_slot(hash, key, hval);
+	}
+	hash->ht_vec[i] = new;
+	hash->ht_nr++;
+    }
     
     /* Free old value if existing variable */
     if (h->h_val)
@@ -273,13 +359,11 @@ clicon_hash_add(clicon_hash_t *hash,
     h->h_val = newval;
     h->h_vlen =  vlen;
 
-    /* Add to list only if new variable */
-    if (new)
-	INSQ(h, hash[hash_bucket(key)]);
-
     return h;
 
 catch:
+    if (newval)
+	free(newval);
     if (new) {
 	if (new->h_key)
 	    free(new->h_key);
@@ -296,25 +380,41 @@ catch:
  *
  * @retval    0       OK
  * @retval   -1       Key not found
+ * @note Entries following the deleted entry are moved back to keep probe 
+ *       sequences unbroken, no tombstones are used.
  */
 int
 clicon_hash_del(clicon_hash_t *hash, 
 		const char    *key)
 {
-    clicon_hash_t h;
+    struct clicon_hash *h;
+    size_t              mask;
+    size_t              i;
+    size_t              j;
+    size_t              k;
 
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
 	return -1;
     }
-    h = clicon_hash_lookup(hash, key);
-    if (h == NULL)
+    mask = hash->ht_size - 1;
+    i = hash_slot(hash, key, hash_fnv1a(key));
+    if ((h = hash->ht_vec[i]) == NULL)
 	return -1;
-    
-    DELQ(h, hash[hash_bucket(key)], clicon_hash_t);
-  
+    hash->ht_vec[i] = NULL;
+    hash->ht_nr--;
+    /* Move back entries whose home slot k is not cyclically in (i, j] */
+    for (j = (i + 1) & mask; hash->ht_vec[j] != NULL; j = (j + 1) & mask){
+	k = hash->ht_vec[j]->h_hval & mask;
+	if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+	    continue;
+	hash->ht_vec[i] = hash->ht_vec[j];
+	hash->ht_vec[j] = NULL;
+	i = j;
+    }
     free(h->h_key);
-    free(h->h_val);
+    if (h->h_val)
+	free(h->h_val);
     free(h);
 
     return 0;
@@ -335,9 +435,7 @@ clicon_hash_keys(clicon_hash_t *hash,
 		 size_t        *nkeys)
 {
     int           retval = -1;
-    int           bkt;
-    clicon_hash_t h;
-    char        **tmp;
+    size_t        i;
     char        **keys = NULL;
 
     if (hash == NULL){
@@ -345,22 +443,14 @@ clicon_hash_keys(clicon_hash_t *hash,
 	return -1;
     }
     *nkeys = 0;
-    for (bkt = 0; bkt < HASH_SIZE; bkt++) {
-	h = hash[bkt];
-	do {
-	    if (h == NULL)
-		break;
-	    tmp = realloc(keys, ((*nkeys)+1) * sizeof(char *));
-	    if (tmp == NULL){
-		clicon_err(OE_UNIX, errno, "realloc");
-		goto catch;
-	    }
-	    keys = tmp;
-	    keys[*nkeys] = h->h_key;
-	    (*nkeys)++;
-	    h = NEXTQ(clicon_hash_t, h);
-	} while (h != hash[bkt]);
+    if (hash->ht_nr &&
+	(keys = malloc(hash->ht_nr * sizeof(char *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto catch;
     }
+    for (i = 0; i < hash->ht_size; i++)
+	if (hash->ht_vec[i] != NULL)
+	    keys[(*nkeys)++] = hash->ht_vec[i]->h_key;
     if (vector){
 	*vector = keys;
 	keys = NULL;
@@ -371,7 +461,6 @@ catch:
 	free(keys);
     return retval;
 }
-
 /*! Dump contents of hash to FILE pointer.
  *
  * @param[in]   hash  	Hash structure
@@ -944,12 +944,14 @@ xml2json_cbuf(cbuf      *cb,
 }
 
 /*! Translate a vector of xml objects to JSON Cligen buffer.
- * This is done by adding a top pseudo-object, and add the vector as subs,
- * and then not printing the top pseudo-object using the 'flat' option.
+ * The vector is printed as the children of a top pseudo-object which is itself not
+ * printed, as xml2json1_cbuf with the 'flat' option. 
+ * The objects are printed in place, ie not copied to a new tree, so namespaces of their
+ * ancestors are used, and the tree is not modified (except namespace cache).
  * @param[out] cb     Cligen buffer to write to
  * @param[in]  vec    Vector of xml objecst
  * @param[in]  veclen Length of vector
- * @param[in]  pretty Set if output is pretty-printed (2 for debug)
+ * @param[in]  pretty Set if output is pretty-printed
  * @retval     0      OK
  * @retval    -1      Error
  * @note This only works if the vector is uniform, ie same object name.
@@ -963,48 +965,34 @@ xml2json_cbuf_vec(cbuf      *cb,
 		  int        pretty)
 {
     int    retval = -1;
-    int    level = 0;
-    cxobj *xp = NULL;
+    int    level = 1;
     int    i;
-    cxobj *xc;
-    cvec  *nsc = NULL; 
+    enum array_element_type arraytype;
 
-    if ((xp = xml_new("xml2json", NULL, CX_ELMNT)) == NULL)
-	goto done;
-    /* Make a copy of old and graft it into new top-object
-     * Also copy namespace context */
+    if (veclen == 0){ /* See nullchild */
+	cprintf(cb, "{}");
+	goto ok;
+    }
+    cprintf(cb, "{%s", pretty?"\n":"");
     for (i=0; i<veclen; i++){
-	if (xml_nsctx_node(vec[i], &nsc) < 0)
-	    goto done;
-	if ((xc = xml_dup(vec[i])) == NULL)
+	arraytype = array_eval(i?vec[i-1]:NULL,
+			       vec[i],
+			       i<veclen-1?vec[i+1]:NULL);
+	if (xml2json1_cbuf(cb, 
+			   vec[i],
+			   arraytype,
+			   level+1, pretty,
+			   0, NULL) < 0)
 	    goto done;
-	xml_addsub(xp, xc);
-	nscache_replace(xc, nsc); 
-	nsc = NULL; /* nsc consumed */
-    }
-    if (0){
-	cprintf(cb, "[%s", pretty?"\n":" ");
-	level++;
+	if (i < veclen-1)
+	    cprintf(cb, ",%s", pretty?"\n":"");
     }
-    if (xml2json1_cbuf(cb, 
-		       xp, 
-		       NO_ARRAY,
-		       level+1, pretty,
-		       1, NULL) < 0)
-	goto done;
-
-    if (0){
-	level--;
-	cprintf(cb, "%s]%s", 
+    cprintf(cb, "%s%*s}", 
 	    pretty?"\n":"",
-	    pretty?"\n":""); /* top object */
-    }
+	    pretty?(level*JSON_INDENT):0, "");
+ ok:
     retval = 0;
  done:
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (xp)
-	xml_free(xp);
     return retval;
 }
 
@@ -73,6 +73,10 @@ static int _logflags = 0x0;
 /* Set to open file to write debug messages directly to file */
 static FILE *_logfile = NULL;
 
+/* Set in threads that must not log or touch the global error state, such as restconf
+ * job threads, see clicon_log_thread_disable */
+static __thread int _log_thread_disabled = 0;
+
 /*! Initialize system logger.
  *
  * Make syslog(3) calls with specified ident and gates calls of level upto specified level (upto).
@@ -165,6 +169,30 @@ clicon_get_logflags(void)
     return _logflags;
 }
 
+/*! Disable logging, debug and errors in the calling thread
+ *
+ * After this call, clicon_log and clicon_debug print nothing, and clicon_err does not set
+ * the global error variables, in the calling thread only. Other threads are not affected.
+ * Use this in threads that run library code while the main thread owns the log and error
+ * state.
+ * @see clicon_log_thread_disabled
+ */
+int
+clicon_log_thread_disable(void)
+{
+    _log_thread_disabled = 1;
+    return 0;
+}
+
+/*! Return 1 if logging, debug and errors are disabled in the calling thread
+ * @see clicon_log_thread_disable
+ */
+int
+clicon_log_thread_disabled(void)
+{
+    return _log_thread_disabled;
+}
+
 /*! Mimic syslog and print a time on file f
  */
 static int
@@ -190,7 +218,7 @@ static char *
 slogtime(void)
 {
     struct timeval tv;
-    struct tm     *tm;
+    struct tm      tm;
     char           *str;
 
     /* Example: "Apr 14 11:30:52: " len=17+1 */
@@ -199,10 +227,10 @@ slogtime(void)
 	return NULL;
     }
     gettimeofday(&tv, NULL);
-    tm = localtime((time_t*)&tv.tv_sec);
+    localtime_r((time_t*)&tv.tv_sec, &tm);
     snprintf(str, 18, "%s %2d %02d:%02d:%02d: ", 
-	     mon2name(tm->tm_mon), tm->tm_mday,
-	     tm->tm_hour, tm->tm_min, tm->tm_sec);
+	     mon2name(tm.tm_mon), tm.tm_mday,
+	     tm.tm_hour, tm.tm_min, tm.tm_sec);
     return str;
 }
 #endif
@@ -265,6 +293,8 @@ clicon_log(int         level,
     char   *msg    = NULL;
     int     retval = -1;
 
+    if (_log_thread_disabled)
+	return 0;
     /* first round: compute length of debug message */
     va_start(args, format);
     len = vsnprintf(NULL, 0, format, args);
@@ -355,6 +385,8 @@ clicon_debug(int         dbglevel,
 
     if (dbglevel > _clixon_debug) /* compare debug mask with global variable */
 	return 0;
+    if (_log_thread_disabled)
+	return 0;
     /* first round: compute length of debug message */
     va_start(args, format);
     len = vsnprintf(NULL, 0, format, args);
@@ -557,7 +557,9 @@ clicon_options_main(clicon_handle h)
     /* Set clixon_conf pointer to handle */
     if (clicon_conf_xml_set(h, xconfig) < 0)
 	goto done;
-
+    if (clicon_option_exists(h, "CLICON_XPATH_CACHE_SIZE") &&
+	xpath_cache_size_set(clicon_option_int(h, "CLICON_XPATH_CACHE_SIZE")) < 0)
+	goto done;
     retval = 0;
  done:
     if (yspec)
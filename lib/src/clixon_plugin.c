@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <errno.h>
 #include <dlfcn.h>
@@ -48,6 +49,7 @@
 #include <syslog.h>
 
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/param.h>
 
 /* cligen */
@@ -93,14 +95,33 @@ struct clixon_plugin{
  * 
  * When namespace and name match, the callback is made
  */
-typedef struct {
+typedef struct rpc_callback {
     qelem_t       rc_qelem;	/* List header */
     clicon_rpc_cb rc_callback;  /* RPC Callback */
     void         *rc_arg;	/* Application specific argument to cb */
     char         *rc_namespace;/* Namespace to combine with name tag */
     char         *rc_name;	/* Xml/json tag/name */
+    struct rpc_callback *rc_next; /* Next callback with same namespace and name */
 } rpc_callback_t;
 
+/*
+ * All RPC callbacks registered with the same namespace and name, and statistics
+ * of calls to them.
+ * Entries are looked up by name in a hash table, entries with the same name but
+ * different namespaces are chained with re_next.
+ */
+typedef struct rpc_entry {
+    qelem_t           re_qelem;     /* List header, all entries in registration order */
+    struct rpc_entry *re_next;      /* Next entry with same name (other namespace) */
+    char             *re_namespace; /* Namespace of rpc */
+    char             *re_name;      /* Name of rpc */
+    rpc_callback_t   *re_first;     /* First callback, chained with rc_next */
+    rpc_callback_t   *re_last;      /* Last callback */
+    uint64_t          re_calls;     /* Number of calls */
+    struct timeval    re_total;     /* Accumulated time of all calls */
+    struct timeval    re_max;       /* Longest call */
+} rpc_entry_t;
+
 /*
  * Upgrade callbacks for backend upgrade of datastore
  * Register upgrade callbacks in plugin_init() with a module and a "from" and "to"
@@ -121,6 +142,8 @@ typedef struct {
 struct plugin_module_struct {
     clixon_plugin_t    *ms_plugin_list;
     rpc_callback_t     *ms_rpc_callbacks;
+    rpc_entry_t        *ms_rpc_entries;  /* RPC callbacks grouped by namespace and name */
+    clicon_hash_t      *ms_rpc_hash;     /* RPC name -> rpc_entry_t* */
     upgrade_callback_t *ms_upgrade_callbacks;
 };
 typedef struct plugin_module_struct plugin_module_struct;
@@ -814,6 +837,80 @@ rpc_callback_dump(clicon_handle h)
 }
 #endif
 
+/*! Find RPC entry given namespace and name
+ *
+ * @param[in]  ms    Plugin module struct
+ * @param[in]  ns    Namespace of rpc
+ * @param[in]  name  RPC name
+ * @retval     re    RPC entry
+ * @retval     NULL  Not found
+ */
+static rpc_entry_t *
+rpc_entry_find(plugin_module_struct *ms,
+	       const char           *ns,
+	       const char           *name)
+{
+    rpc_entry_t *re = NULL;
+    void        *p;
+
+    if (ms->ms_rpc_hash == NULL)
+	goto done;
+    if ((p = clicon_hash_value(ms->ms_rpc_hash, name, NULL)) == NULL)
+	goto done;
+    for (re = *(rpc_entry_t **)p; re != NULL; re = re->re_next)
+	if (strcmp(re->re_namespace, ns) == 0)
+	    break;
+ done:
+    return re;
+}
+
+/*! Create a new RPC entry and add it to the name hash table
+ *
+ * @param[in]  ms    Plugin module struct
+ * @param[in]  ns    Namespace of rpc
+ * @param[in]  name  RPC name
+ * @retval     re    New RPC entry
+ * @retval     NULL  Error
+ */
+static rpc_entry_t *
+rpc_entry_new(plugin_module_struct *ms,
+	      const char           *ns,
+	      const char           *name)
+{
+    rpc_entry_t *re = NULL;
+    void        *p;
+
+    if (ms->ms_rpc_hash == NULL &&
+	(ms->ms_rpc_hash = clicon_hash_init()) == NULL)
+	goto done;
+    if ((re = malloc(sizeof(rpc_entry_t))) == NULL) {
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(re, 0, sizeof(*re));
+    if ((re->re_namespace = strdup(ns)) == NULL ||
+	(re->re_name = strdup(name)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto fail;
+    }
+    /* Push first on chain of entries with same name */
+    if ((p = clicon_hash_value(ms->ms_rpc_hash, name, NULL)) != NULL)
+	re->re_next = *(rpc_entry_t **)p;
+    /* It is the pointer to re that should be copied by hash */
+    if (clicon_hash_add(ms->ms_rpc_hash, name, &re, sizeof(re)) == NULL)
+	goto fail;
+    ADDQ(re, ms->ms_rpc_entries);
+ done:
+    return re;
+ fail:
+    if (re->re_namespace)
+	free(re->re_namespace);
+    if (re->re_name)
+	free(re->re_name);
+    free(re);
+    return NULL;
+}
+
 /*! Register a RPC callback by appending a new RPC to the list
  *
  * @param[in]  h         clicon handle
@@ -833,6 +930,7 @@ rpc_callback_register(clicon_handle  h,
 		      const char    *name)
 {
     rpc_callback_t *rc = NULL;
+    rpc_entry_t    *re;
     plugin_module_struct *ms = plugin_module_struct_get(h);
 
     clicon_debug(1, "%s %s", __FUNCTION__, name);
@@ -853,6 +951,15 @@ rpc_callback_register(clicon_handle  h,
     rc->rc_arg  = arg;
     rc->rc_namespace  = strdup(ns);
     rc->rc_name  = strdup(name);
+    if ((re = rpc_entry_find(ms, ns, name)) == NULL &&
+	(re = rpc_entry_new(ms, ns, name)) == NULL)
+	goto done;
+    /* Append to entry to keep registration order */
+    if (re->re_last)
+	re->re_last->rc_next = rc;
+    else
+	re->re_first = rc;
+    re->re_last = rc;
     ADDQ(rc, ms->ms_rpc_callbacks);
     return 0;
  done:
@@ -872,17 +979,31 @@ static int
 rpc_callback_delete_all(clicon_handle h)
 {
     rpc_callback_t *rc;
+    rpc_entry_t    *re;
     plugin_module_struct *ms = plugin_module_struct_get(h);
 
-    if (ms != NULL)
-	while((rc = ms->ms_rpc_callbacks) != NULL) {
-	    DELQ(rc, ms->ms_rpc_callbacks, rpc_callback_t *);
-	    if (rc->rc_namespace)
-		free(rc->rc_namespace);
-	    if (rc->rc_name)
-		free(rc->rc_name);
-	    free(rc);
-	}
+    if (ms == NULL)
+	return 0;
+    while((rc = ms->ms_rpc_callbacks) != NULL) {
+	DELQ(rc, ms->ms_rpc_callbacks, rpc_callback_t *);
+	if (rc->rc_namespace)
+	    free(rc->rc_namespace);
+	if (rc->rc_name)
+	    free(rc->rc_name);
+	free(rc);
+    }
+    while((re = ms->ms_rpc_entries) != NULL) {
+	DELQ(re, ms->ms_rpc_entries, rpc_entry_t *);
+	if (re->re_namespace)
+	    free(re->re_namespace);
+	if (re->re_name)
+	    free(re->re_name);
+	free(re);
+    }
+    if (ms->ms_rpc_hash){
+	clicon_hash_free(ms->ms_rpc_hash);
+	ms->ms_rpc_hash = NULL;
+    }
     return 0;
 }
 
@@ -899,6 +1020,8 @@ rpc_callback_delete_all(clicon_handle h)
  * @note that several callbacks can be registered. They need to cooperate on
  * return values, ie if one writes cbret, the other needs to handle that by
  * leaving it, replacing it or amending it.
+ * @note Callbacks are looked up by name in a hash table. If xn is bound to a 
+ * YANG rpc, its namespace is taken from YANG, otherwise from the XML.
  */
 int
 rpc_callback_call(clicon_handle h,
@@ -908,10 +1031,14 @@ rpc_callback_call(clicon_handle h,
 {
     int            retval = -1;
     rpc_callback_t *rc;
+    rpc_entry_t    *re;
+    yang_stmt      *ye;
     char           *name;
     char           *prefix;
-    char           *ns;
+    char           *ns = NULL;
     int             nr = 0; /* How many callbacks */
+    struct timeval  t0;
+    struct timeval  t1;
     plugin_module_struct *ms = plugin_module_struct_get(h);
 
     if (ms == NULL){
@@ -919,27 +1046,76 @@ rpc_callback_call(clicon_handle h,
 	goto done;
     }
     name = xml_name(xe);
-    prefix = xml_prefix(xe);
-    xml2ns(xe, prefix, &ns);
-    if ((rc = ms->ms_rpc_callbacks) != NULL)
-	do {
-	    if (strcmp(rc->rc_name, name) == 0 &&
-		ns && rc->rc_namespace &&
-		strcmp(rc->rc_namespace, ns) == 0){
-		if (rc->rc_callback(h, xe, cbret, arg, rc->rc_arg) < 0){
-		    clicon_debug(1, "%s Error in: %s", __FUNCTION__, rc->rc_name);
-		    goto done;
-		}
-		nr++;
-	    }
-	    rc = NEXTQ(rpc_callback_t *, rc);
-	} while (rc != ms->ms_rpc_callbacks);
+    if ((ye = xml_spec(xe)) != NULL && yang_keyword_get(ye) == Y_RPC)
+	ns = yang_find_mynamespace(ye);
+    else{
+	prefix = xml_prefix(xe);
+	xml2ns(xe, prefix, &ns);
+    }
+    if (ns == NULL || (re = rpc_entry_find(ms, ns, name)) == NULL)
+	goto ok;
+    gettimeofday(&t0, NULL);
+    for (rc = re->re_first; rc != NULL; rc = rc->rc_next){
+	if (rc->rc_callback(h, xe, cbret, arg, rc->rc_arg) < 0){
+	    clicon_debug(1, "%s Error in: %s", __FUNCTION__, rc->rc_name);
+	    goto done;
+	}
+	nr++;
+    }
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &t1);
+    timeradd(&re->re_total, &t1, &re->re_total);
+    if (timercmp(&t1, &re->re_max, >))
+	re->re_max = t1;
+    re->re_calls++;
+ ok:
     retval = nr; /* 0: none found, >0 nr of handlers called */
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
     return retval;
 }
 
+/*! Get RPC callback statistics
+ *
+ * For each registered RPC: number of calls, and total and max time in
+ * microseconds spent in its callbacks.
+ * @param[in]  h       clicon handle
+ * @param[out] cb      CLIgen buf, XML <rpc> elements appended, see clixon-lib.yang
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see rpc_callback_call  where statistics are collected
+ */
+int
+rpc_callback_stats(clicon_handle h,
+		   cbuf         *cb)
+{
+    int          retval = -1;
+    rpc_entry_t *re;
+    plugin_module_struct *ms = plugin_module_struct_get(h);
+
+    if (ms == NULL){
+	clicon_err(OE_PLUGIN, EINVAL, "plugin module not initialized");
+	goto done;
+    }
+    if ((re = ms->ms_rpc_entries) != NULL)
+	do {
+	    cprintf(cb, "<rpc><namespace>");
+	    if (xml_chardata_cbuf_append(cb, re->re_namespace) < 0)
+		goto done;
+	    cprintf(cb, "</namespace><name>%s</name>", re->re_name);
+	    cprintf(cb, "<calls>%" PRIu64 "</calls>", re->re_calls);
+	    cprintf(cb, "<total-time>%" PRIu64 "</total-time>",
+		    (uint64_t)re->re_total.tv_sec*1000000 + re->re_total.tv_usec);
+	    cprintf(cb, "<max-time>%" PRIu64 "</max-time>",
+		    (uint64_t)re->re_max.tv_sec*1000000 + re->re_max.tv_usec);
+	    cprintf(cb, "</rpc>");
+	    re = NEXTQ(rpc_entry_t *, re);
+	} while (re != ms->ms_rpc_entries);
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*--------------------------------------------------------------------
  * Upgrade callbacks for backend upgrade of datastore
  */
@@ -45,6 +45,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -75,9 +77,28 @@
 #include "clixon_sig.h"
 #include "clixon_xml.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_bin.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_sort.h"
 #include "clixon_options.h"
 #include "clixon_proto.h"
 
+/* Buffer size when streaming XML replies, see send_msg_reply_stream */
+#define MSG_STREAM_CHUNK 65536
+
+/* Minimal allocation and read size of message buffers, see clicon_msg_buf */
+#define MSG_BUF_MIN 8192
+
+/* Reply written in parts, see send_msg_reply_stream and clicon_msg_stream_write */
+struct clicon_msg_stream{
+    xml2cbuf_pos      *ms_pos;  /* Position of XML text reply, or NULL */
+    cbuf              *ms_cb;   /* Print buffer of XML text reply */
+    struct clicon_msg *ms_msg;  /* Binary encoded reply, or NULL */
+    size_t             ms_off;  /* Bytes of ms_msg written */
+    int                ms_done; /* Whole reply written or queued */
+};
+
 static int _atomicio_sig = 0;
 
 /*! Formats (showas) derived from XML
@@ -167,7 +188,96 @@ clicon_msg_encode(uint32_t      id,
     return msg;
 }
 
+/*! Encode a clicon netconf message from an XML tree using binary encoding
+ *
+ * The receiver detects the encoding, see clicon_msg_decode.
+ * @param[in] id      Session id of client
+ * @param[in] x       XML netconf tree, eg <rpc>
+ * @param[in] depth   Limit levels of child resources: -1 is all, see clicon_xml2cbuf
+ * @retval    NULL    Error
+ * @retval    msg     Clicon message to send to eg clicon_msg_send()
+ * @see clicon_msg_encode for XML text encoding
+ */
+struct clicon_msg *
+clicon_msg_encode_xml(uint32_t id,
+		      cxobj   *x,
+		      int32_t  depth)
+{
+    struct clicon_msg *msg = NULL;
+    char              *buf = NULL;
+    size_t             len;
+
+    if (clixon_xml2bin(x, depth, sizeof(*msg), &buf, &len) < 0)
+	return NULL;
+    if (len > UINT32_MAX){
+	clicon_err(OE_PROTO, EMSGSIZE, "Message too large");
+	free(buf);
+	return NULL;
+    }
+    msg = (struct clicon_msg *)buf;
+    msg->op_len = htonl(len);
+    msg->op_id = htonl(id);
+    return msg;
+}
+
+/*! Check if a clicon netconf message is binary encoded
+ * @param[in]  msg    CLICON msg
+ * @retval     1      Binary encoding
+ * @retval     0      XML text
+ * @see clicon_msg_encode_xml
+ */
+int
+clicon_msg_binary(struct clicon_msg *msg)
+{
+    return clixon_bin_detect(msg->op_body, ntohl(msg->op_len) - sizeof(*msg));
+}
+
+/*! Decode a binary encoded clicon netconf message and bind yang as an RPC
+ * @see clicon_msg_decode
+ * @see _xml_parse  Same yang binding as YB_RPC
+ */
+static int
+clicon_msg_decode_bin(struct clicon_msg *msg, 
+		      yang_stmt         *yspec,
+		      cxobj            **xml,
+		      cxobj            **xerr)
+{
+    int    retval = -1;
+    cxobj *x;
+    int    failed = 0;
+    int    ret;
+
+    if (clixon_bin2xml(msg->op_body, ntohl(msg->op_len) - sizeof(*msg), xml) < 0)
+	goto done;
+    x = NULL;
+    while ((x = xml_child_each(*xml, x, CX_ELMNT)) != NULL) {
+	/* Verify namespaces */
+	if (xml2ns_recurse(x) < 0)
+	    goto done;
+	if (yspec == NULL)
+	    continue;
+	if ((ret = xml_bind_yang_rpc(x, yspec, xerr)) < 0)
+	    goto done;
+	if (ret == 0){ /* Add message-id */
+	    if (*xerr && clixon_xml_attr_copy(x, *xerr, "message-id") < 0)
+		goto done;
+	    failed++;
+	}
+    }
+    if (failed)
+	goto fail;
+    if (yspec && xml_sort_recurse(*xml) < 0)
+	goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Decode a clicon netconf message
+ * The message may be XML text or binary encoded
  * @param[in]  msg    CLICON msg
  * @param[in]  yspec  Yang specification, (can be NULL)
  * @param[out] id     Session id
@@ -176,6 +286,8 @@ clicon_msg_encode(uint32_t      id,
  * @retval     1      Parse OK and all yang assignment made
  * @retval     0      Parse OK but yang assigment not made (or only partial)
  * @retval    -1      Error with clicon_err called. Includes parse error
+ * @see clicon_msg_encode
+ * @see clicon_msg_encode_xml
  */
 int
 clicon_msg_decode(struct clicon_msg *msg, 
@@ -192,10 +304,17 @@ clicon_msg_decode(struct clicon_msg *msg,
     if (id)
 	*id = ntohl(msg->op_id);
     /* body */
-    xmlstr = msg->op_body;
-    clicon_debug(1, "%s %s", __FUNCTION__, xmlstr);
-    if ((ret = clixon_xml_parse_string(xmlstr, yspec?YB_RPC:YB_NONE, yspec, xml, xerr)) < 0)
-	goto done;
+    if (clicon_msg_binary(msg)){
+	clicon_debug(1, "%s binary len:%u", __FUNCTION__, ntohl(msg->op_len));
+	if ((ret = clicon_msg_decode_bin(msg, yspec, xml, xerr)) < 0)
+	    goto done;
+    }
+    else {
+	xmlstr = msg->op_body;
+	clicon_debug(1, "%s %s", __FUNCTION__, xmlstr);
+	if ((ret = clixon_xml_parse_string(xmlstr, yspec?YB_RPC:YB_NONE, yspec, xml, xerr)) < 0)
+	    goto done;
+    }
     if (ret == 0)
 	goto fail;
     retval = 1;
@@ -419,6 +538,270 @@ clicon_msg_rcv(int                s,
     return retval;
 }
 
+/*! Reserve space for at least len more bytes at the end of a message buffer
+ * Unconsumed data is moved to the start of the buffer if at least half of it is
+ * consumed, otherwise the buffer grows.
+ * @param[in]  mb   Message buffer
+ * @param[in]  len  Number of bytes
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+msg_buf_reserve(struct clicon_msg_buf *mb,
+		size_t                 len)
+{
+    size_t max;
+    char  *buf;
+
+    if (mb->mb_max - mb->mb_end >= len)
+	return 0;
+    if (mb->mb_start && mb->mb_start >= mb->mb_end - mb->mb_start){
+	memmove(mb->mb_buf, mb->mb_buf + mb->mb_start, mb->mb_end - mb->mb_start);
+	mb->mb_end -= mb->mb_start;
+	mb->mb_start = 0;
+	if (mb->mb_max - mb->mb_end >= len)
+	    return 0;
+    }
+    max = mb->mb_max ? 2*mb->mb_max : MSG_BUF_MIN;
+    if (max < mb->mb_end + len)
+	max = mb->mb_end + len;
+    if ((buf = realloc(mb->mb_buf, max)) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	return -1;
+    }
+    mb->mb_buf = buf;
+    mb->mb_max = max;
+    return 0;
+}
+
+/*! All data of a message buffer is consumed, reuse it unless it is large
+ * @param[in]  mb   Message buffer
+ */
+static void
+msg_buf_empty(struct clicon_msg_buf *mb)
+{
+    mb->mb_start = mb->mb_end = 0;
+    if (mb->mb_max > MSG_STREAM_CHUNK)
+	clicon_msg_buf_reset(mb);
+}
+
+/*! Free data of a message buffer and reset it
+ * @param[in]  mb   Message buffer
+ * @retval     0    OK
+ */
+int
+clicon_msg_buf_reset(struct clicon_msg_buf *mb)
+{
+    if (mb->mb_buf)
+	free(mb->mb_buf);
+    memset(mb, 0, sizeof(*mb));
+    return 0;
+}
+
+/*! Get number of bytes in a message buffer not yet consumed
+ * @param[in]  mb   Message buffer
+ * @retval     len  Number of bytes, 0 if empty
+ */
+size_t
+clicon_msg_buf_len(struct clicon_msg_buf *mb)
+{
+    return mb->mb_end - mb->mb_start;
+}
+
+/*! Receive available data of CLICON messages on a non-blocking socket
+ *
+ * Read what is available on the socket into a receive buffer, without waiting for
+ * the rest of a message. Complete messages are then taken from the buffer with
+ * clicon_msg_buf_get. When the header of a message is received, room is made for
+ * the whole message so that it is read without reallocations.
+ * @param[in]     s    Non-blocking socket
+ * @param[in,out] mb   Receive buffer
+ * @param[out]    eof  Set if eof encountered
+ * @retval        0    OK, including when no data is available
+ * @retval       -1    Error
+ * Note: caller must ensure that s is closed if eof is set after call.
+ * @see clicon_msg_rcv  Blocking receive of one message
+ */
+int
+clicon_msg_rcv_nb(int                    s,
+		  struct clicon_msg_buf *mb,
+		  int                   *eof)
+{
+    int      retval = -1;
+    size_t   len;
+    size_t   want = MSG_BUF_MIN;
+    uint32_t mlen;
+    ssize_t  n;
+
+    *eof = 0;
+    len = mb->mb_end - mb->mb_start;
+    if (len >= sizeof(struct clicon_msg)){
+	memcpy(&mlen, mb->mb_buf + mb->mb_start, sizeof(mlen)); /* op_len */
+	mlen = ntohl(mlen);
+	if (mlen > len && mlen - len > want)
+	    want = mlen - len;
+    }
+    if (msg_buf_reserve(mb, want) < 0)
+	goto done;
+    if ((n = read(s, mb->mb_buf + mb->mb_end, mb->mb_max - mb->mb_end)) < 0){
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	    goto ok;
+	if (errno != ECONNRESET){ /* Connection reset by peer is eof */
+	    clicon_err(OE_CFG, errno, "read");
+	    goto done;
+	}
+	n = 0;
+    }
+    if (n == 0)
+	*eof = 1;
+    mb->mb_end += n;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get next complete CLICON message from a receive buffer
+ * @param[in,out] mb   Receive buffer, see clicon_msg_rcv_nb
+ * @param[out]    msg  CLICON msg data structure. Free with free()
+ * @retval        1    Complete message returned in msg
+ * @retval        0    No complete message in buffer
+ * @retval       -1    Error, malformed message
+ */
+int
+clicon_msg_buf_get(struct clicon_msg_buf *mb,
+		   struct clicon_msg    **msg)
+{
+    int      retval = -1;
+    size_t   len;
+    uint32_t mlen;
+
+    len = mb->mb_end - mb->mb_start;
+    if (len < sizeof(struct clicon_msg)){
+	retval = 0;
+	goto done;
+    }
+    memcpy(&mlen, mb->mb_buf + mb->mb_start, sizeof(mlen)); /* op_len */
+    mlen = ntohl(mlen);
+    if (mlen < sizeof(struct clicon_msg)){
+	clicon_err(OE_PROTO, EBADMSG, "message too short (%u)", mlen);
+	goto done;
+    }
+    if (len < mlen){
+	retval = 0;
+	goto done;
+    }
+    clicon_debug(2, "%s: rcv msg len=%u", __FUNCTION__, mlen);
+    if (mb->mb_start == 0 && len == mlen){
+	/* Message is the whole buffer: hand it over */
+	*msg = (struct clicon_msg *)mb->mb_buf;
+	memset(mb, 0, sizeof(*mb));
+    }
+    else{
+	if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
+	    clicon_err(OE_CFG, errno, "malloc");
+	    goto done;
+	}
+	memcpy(*msg, mb->mb_buf + mb->mb_start, mlen);
+	mb->mb_start += mlen;
+	if (mb->mb_start == mb->mb_end)
+	    msg_buf_empty(mb);
+    }
+    if (clicon_debug_get() > 1)
+	msg_dump(*msg);
+    retval = 1;
+ done:
+    return retval;
+}
+
+/*! Append a CLICON message to a send buffer, to be written by clicon_msg_flush
+ * @param[in,out] mb   Send buffer
+ * @param[in]     msg  CLICON msg data structure
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+int
+clicon_msg_buf_put(struct clicon_msg_buf *mb,
+		   struct clicon_msg     *msg)
+{
+    size_t len = ntohl(msg->op_len);
+
+    clicon_debug(2, "%s: send msg len=%zu", __FUNCTION__, len);
+    if (clicon_debug_get() > 2)
+	msg_dump(msg);
+    if (msg_buf_reserve(mb, len) < 0)
+	return -1;
+    memcpy(mb->mb_buf + mb->mb_end, msg, len);
+    mb->mb_end += len;
+    return 0;
+}
+
+/*! Write queued data of a send buffer to a non-blocking socket
+ * Write as much as the socket accepts without blocking.
+ * @param[in]     s    Non-blocking socket
+ * @param[in,out] mb   Send buffer, eg queued by send_msg_reply
+ * @retval        1    All queued data is written
+ * @retval        0    Data remains in buffer, the socket would block
+ * @retval       -1    Error, errno set, eg EPIPE if peer has closed the socket
+ */
+int
+clicon_msg_flush(int                    s,
+		 struct clicon_msg_buf *mb)
+{
+    ssize_t n;
+    int     e;
+
+    while (mb->mb_start < mb->mb_end){
+	if ((n = write(s, mb->mb_buf + mb->mb_start, mb->mb_end - mb->mb_start)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		return 0;
+	    e = errno;
+	    clicon_err(OE_CFG, e, "write");
+	    errno = e;
+	    return -1;
+	}
+	mb->mb_start += n;
+    }
+    msg_buf_empty(mb);
+    return 1;
+}
+
+/*! Write data of a message to a socket, or queue it in a send buffer
+ * Queued data is written without blocking when a chunk is queued, the rest by
+ * clicon_msg_flush.
+ * @param[in]  s     Socket
+ * @param[in]  mb    Send buffer, or NULL to write and block until all data is written
+ * @param[in]  data  Data
+ * @param[in]  len   Length of data
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+msg_write(int                    s,
+	  struct clicon_msg_buf *mb,
+	  void                  *data,
+	  size_t                 len)
+{
+    if (mb == NULL){
+	if (atomicio((ssize_t (*)(int, void *, size_t))write, 
+		     s, data, len) < 0){
+	    clicon_err(OE_CFG, errno, "atomicio");
+	    return -1;
+	}
+	return 0;
+    }
+    if (msg_buf_reserve(mb, len) < 0)
+	return -1;
+    memcpy(mb->mb_buf + mb->mb_end, data, len);
+    mb->mb_end += len;
+    if (mb->mb_end - mb->mb_start >= MSG_STREAM_CHUNK &&
+	clicon_msg_flush(s, mb) < 0)
+	return -1;
+    return 0;
+}
+
 /*! Receive a message using plain ascii 
  * @param[in]   s      socket (unix or inet) to communicate with backend
  * @param[out]  cb1    cligen buf struct containing the incoming message
@@ -638,6 +1021,48 @@ clicon_rpc(int                sock,
     return retval;
 }
 
+/*! Send a clicon_msg message and receive result as XML tree
+ *
+ * Same as clicon_rpc but the reply is decoded to an XML tree, and may be XML text
+ * or binary encoded.
+ * @param[in]  sock    Socket / file descriptor
+ * @param[in]  msg     CLICON msg data structure. It has fixed header and variable body.
+ * @param[out] xret    Returned data as netconf xml tree. Free with xml_free
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see clicon_rpc
+ */
+int
+clicon_rpc_xml(int                sock,
+	       struct clicon_msg *msg, 
+	       cxobj            **xret)
+{
+    int                retval = -1;
+    struct clicon_msg *reply = NULL;
+    int                eof;
+
+    if (clicon_msg_send(sock, msg) < 0)
+	goto done;
+    if (clicon_msg_rcv(sock, &reply, &eof) < 0)
+	goto done;
+    if (eof){
+	clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	close(sock); /* assume socket */
+	errno = ESHUTDOWN;
+	goto done;
+    }
+    /* Cannot bind yang here because need to know RPC name (eg "lock") in order to associate yang
+     * to reply.
+     */
+    if (clicon_msg_decode(reply, NULL, NULL, xret, NULL) < 0)
+	goto done;
+    retval = 0;
+  done:
+    if (reply)
+	free(reply);
+    return retval;
+}
+
 /*! Send a netconf message and recieve result.
  *
  * TBD: timeout, interrupt?
@@ -680,21 +1105,34 @@ clicon_rpc1(int   sock,
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
  * @param[in]  s       Socket to communicate with client
+ * @param[in]  mb      Send buffer to queue reply in, or NULL to write to s directly
  * @param[in]  data    Returned data as byte-string.
  * @param[in]  datalen Length of returned data XXX  may be unecessary if always string?
  * @retval     0       OK
  * @retval     -1      Error
+ * @see clicon_msg_flush  Write queued reply
  */
 int 
-send_msg_reply(int      s, 
-	       char    *data, 
-	       uint32_t datalen)
+send_msg_reply(int                    s, 
+	       struct clicon_msg_buf *mb,
+	       char                  *data, 
+	       uint32_t               datalen)
 {
     int                retval = -1;
     struct clicon_msg *reply = NULL;
+    struct clicon_msg  hdr = {0,};
     uint32_t           len;
 
     len = sizeof(*reply) + datalen;
+    if (mb != NULL){
+	hdr.op_len = htonl(len);
+	if (msg_write(s, mb, &hdr, sizeof(hdr)) < 0)
+	    goto done;
+	if (datalen > 0 && msg_write(s, mb, data, datalen) < 0)
+	    goto done;
+	retval = 0;
+	goto done;
+    }
     if ((reply = (struct clicon_msg *)malloc(len)) == NULL)
 	goto done;
     memset(reply, 0, len);
@@ -710,25 +1148,279 @@ send_msg_reply(int      s,
     return retval;
 }
 
+/*! Create a reply written in parts
+ * @retval  ms    Reply stream, free with clicon_msg_stream_free
+ * @retval  NULL  Error
+ */
+static clicon_msg_stream *
+msg_stream_new(void)
+{
+    clicon_msg_stream *ms;
+
+    if ((ms = malloc(sizeof(*ms))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(ms, 0, sizeof(*ms));
+    return ms;
+}
+
+/*! Free a reply written in parts, eg if the peer has closed the socket
+ * @param[in]  ms  Reply stream, see send_msg_reply_stream
+ */
+int
+clicon_msg_stream_free(clicon_msg_stream *ms)
+{
+    if (ms->ms_pos)
+	clicon_xml2cbuf_pos_free(ms->ms_pos);
+    if (ms->ms_cb)
+	cbuf_free(ms->ms_cb);
+    if (ms->ms_msg)
+	free(ms->ms_msg);
+    free(ms);
+    return 0;
+}
+
+/*! Write the next parts of a reply to a socket or send buffer
+ * @param[in]  s      Socket
+ * @param[in]  mb     Send buffer, or NULL to write to s directly
+ * @param[in]  ms     Reply stream
+ * @param[in]  hiwat  Stop when more than this is queued in mb, 0 means no limit
+ * @retval     1      Whole reply written or queued
+ * @retval     0      Stopped at hiwat, more to write
+ * @retval    -1      Error
+ */
+static int
+msg_stream_write(int                    s,
+		 struct clicon_msg_buf *mb,
+		 clicon_msg_stream     *ms,
+		 size_t                 hiwat)
+{
+    int    retval = -1;
+    size_t len;
+    int    ret;
+
+    while (!ms->ms_done){
+	if (mb != NULL && hiwat && clicon_msg_buf_len(mb) >= hiwat){
+	    retval = 0;
+	    goto done;
+	}
+	if (ms->ms_msg != NULL){ /* Binary */
+	    len = ntohl(ms->ms_msg->op_len) - ms->ms_off;
+	    if (len > MSG_STREAM_CHUNK)
+		len = MSG_STREAM_CHUNK;
+	    if (msg_write(s, mb, (char*)ms->ms_msg + ms->ms_off, len) < 0)
+		goto done;
+	    ms->ms_off += len;
+	    ms->ms_done = (ms->ms_off == ntohl(ms->ms_msg->op_len));
+	    continue;
+	}
+	if ((ret = clicon_xml2cbuf_step(ms->ms_cb, ms->ms_pos, MSG_STREAM_CHUNK)) < 0)
+	    goto done;
+	len = cbuf_len(ms->ms_cb);
+	if (ret == 1){ /* Include null-termination as send_msg_reply */
+	    len++;
+	    ms->ms_done = 1;
+	}
+	if (len && msg_write(s, mb, cbuf_get(ms->ms_cb), len) < 0)
+	    goto done;
+	cbuf_reset(ms->ms_cb);
+    }
+    retval = 1;
+ done:
+    return retval;
+}
+
+/*! Write the next parts of a reply to a send buffer
+ *
+ * Print or copy the next parts of a reply to a send buffer until more than
+ * CLICON_MSG_SND_HIWAT is queued, or the reply is done. Call it again when the
+ * send buffer has been written, see clicon_msg_flush.
+ * @param[in]  s    Socket
+ * @param[in]  mb   Send buffer
+ * @param[in]  ms   Reply stream, see send_msg_reply_stream and send_msg_reply_xml
+ * @retval     1    Whole reply queued, free ms with clicon_msg_stream_free
+ * @retval     0    More to write
+ * @retval    -1    Error, errno set, eg EPIPE if peer has closed the socket
+ */
+int
+clicon_msg_stream_write(int                    s,
+			struct clicon_msg_buf *mb,
+			clicon_msg_stream     *ms)
+{
+    return msg_stream_write(s, mb, ms, CLICON_MSG_SND_HIWAT);
+}
+
+/*! Send a binary encoded XML reply to a client
+ *
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  mb      Send buffer to queue reply in, or NULL to write to s directly
+ * @param[in]  x       XML reply, eg <rpc-reply>
+ * @param[in]  depth   Limit levels of child resources: -1 is all, see clicon_xml2cbuf
+ * @param[out] msp     If set, at most CLICON_MSG_SND_HIWAT is queued in mb, and the rest
+ *                     of the reply is returned here, or NULL if done.
+ *                     See clicon_msg_stream_write
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see send_msg_reply  for XML text replies
+ */
+int
+send_msg_reply_xml(int                    s,
+		   struct clicon_msg_buf *mb,
+		   cxobj                 *x,
+		   int32_t                depth,
+		   clicon_msg_stream    **msp)
+{
+    int                retval = -1;
+    struct clicon_msg *reply = NULL;
+    clicon_msg_stream *ms = NULL;
+    int                ret;
+
+    if (msp)
+	*msp = NULL;
+    if ((reply = clicon_msg_encode_xml(0, x, depth)) == NULL)
+	goto done;
+    if (mb == NULL){
+	if (clicon_msg_send(s, reply) < 0)
+	    goto done;
+	retval = 0;
+	goto done;
+    }
+    if ((ms = msg_stream_new()) == NULL)
+	goto done;
+    ms->ms_msg = reply;
+    reply = NULL;
+    if ((ret = msg_stream_write(s, mb, ms, msp?CLICON_MSG_SND_HIWAT:0)) < 0)
+	goto done;
+    if (ret == 0){
+	*msp = ms;
+	ms = NULL;
+    }
+    retval = 0;
+  done:
+    if (ms)
+	clicon_msg_stream_free(ms);
+    if (reply)
+	free(reply);
+    return retval;
+}
+
+/*! Flush callback counting the length of an XML reply
+ * @see send_msg_reply_stream
+ */
+static int
+msg_stream_count(cbuf *cb,
+		 void *arg)
+{
+    uint64_t *len = (uint64_t *)arg;
+
+    *len += cbuf_len(cb);
+    return 0;
+}
+
+/*! Send an XML text reply to a client, streamed in bounded chunks
+ *
+ * Same message as send_msg_reply of the printed XML, but the whole string is never
+ * built in memory. The XML is printed in chunks of size MSG_STREAM_CHUNK: first to
+ * count the length of the message header, then again written chunk by chunk to
+ * the socket. Small replies that fit in one chunk are printed only once.
+ * If a send buffer is given, chunks the socket does not accept without blocking are
+ * queued in it.
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  mb      Send buffer to queue reply in, or NULL to write to s directly
+ * @param[in]  x       XML reply, eg <rpc-reply>. If the reply is returned in msp, x
+ *                     must not be changed or freed until the reply stream is freed
+ * @param[in]  depth   Limit levels of child resources: -1 is all, see clicon_xml2cbuf
+ * @param[out] msp     If set, at most CLICON_MSG_SND_HIWAT is queued in mb, and the rest
+ *                     of the reply is returned here, or NULL if done.
+ *                     See clicon_msg_stream_write
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see send_msg_reply_xml  for binary encoded replies
+ */
+int
+send_msg_reply_stream(int                    s,
+		      struct clicon_msg_buf *mb,
+		      cxobj                 *x,
+		      int32_t                depth,
+		      clicon_msg_stream    **msp)
+{
+    int                   retval = -1;
+    cbuf                 *cb = NULL;
+    uint64_t              len = 0;
+    struct clicon_msg     hdr = {0,};
+    clicon_msg_stream    *ms = NULL;
+    int                   ret;
+
+    if (msp)
+	*msp = NULL;
+    if ((cb = cbuf_new_alloc(MSG_STREAM_CHUNK)) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf_flush(cb, x, 0, 0, depth, MSG_STREAM_CHUNK,
+			      msg_stream_count, &len) < 0)
+	goto done;
+    if (len == 0){ /* Fits in one chunk */
+	retval = send_msg_reply(s, mb, cbuf_get(cb), cbuf_len(cb)+1);
+	goto done;
+    }
+    len += cbuf_len(cb) + 1; /* Include null-termination as send_msg_reply */
+    if (len > UINT32_MAX - sizeof(hdr)){
+	clicon_err(OE_PROTO, EMSGSIZE, "Reply too large: %" PRIu64 " bytes", len);
+	goto done;
+    }
+    hdr.op_len = htonl(sizeof(hdr) + len);
+    clicon_debug(2, "%s: send msg len=%" PRIu64, __FUNCTION__, sizeof(hdr) + len);
+    if (msg_write(s, mb, &hdr, sizeof(hdr)) < 0)
+	goto done;
+    /* Print again, in parts up to the high-water mark if msp is set */
+    if ((ms = msg_stream_new()) == NULL)
+	goto done;
+    if ((ms->ms_pos = clicon_xml2cbuf_pos_new(x, 0, 0, depth)) == NULL)
+	goto done;
+    cbuf_reset(cb);
+    ms->ms_cb = cb;
+    cb = NULL;
+    if ((ret = msg_stream_write(s, mb, ms, (mb&&msp)?CLICON_MSG_SND_HIWAT:0)) < 0)
+	goto done;
+    if (ret == 0){
+	*msp = ms;
+	ms = NULL;
+    }
+    retval = 0;
+  done:
+    if (ms)
+	clicon_msg_stream_free(ms);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
  * @param[in]  s       Socket to communicate with client
- * @param[in]  level
+ * @param[in]  mb      Send buffer to queue message in, or NULL to write to s directly
  * @param[in]  event
  * @retval     0       OK
  * @retval     -1      Error
  * @see send_msg_notify_xml
  */
 static int
-send_msg_notify(int           s, 
-		char         *event)
+send_msg_notify(int                    s, 
+		struct clicon_msg_buf *mb,
+		char                  *event)
 {
     int                retval = -1;
     struct clicon_msg *msg = NULL;
 
     if ((msg=clicon_msg_encode(0, "%s", event)) == NULL)
 	goto done;
-    if (clicon_msg_send(s, msg) < 0)
+    if (mb != NULL){
+	if (msg_write(s, mb, msg, ntohl(msg->op_len)) < 0)
+	    goto done;
+    }
+    else if (clicon_msg_send(s, msg) < 0)
 	goto done;
     retval = 0;
   done:
@@ -741,15 +1433,17 @@ send_msg_notify(int           s,
  *
  * @param[in]  h       Clicon handle
  * @param[in]  s       Socket to communicate with client
+ * @param[in]  mb      Send buffer to queue message in, or NULL to write to s directly
  * @param[in]  xev     Event as XML
  * @retval     0       OK
  * @retval     -1      Error
  * @see send_msg_notify XXX beauty contest
  */
 int
-send_msg_notify_xml(clicon_handle h,
-		    int           s, 
-		    cxobj        *xev)
+send_msg_notify_xml(clicon_handle          h,
+		    int                    s, 
+		    struct clicon_msg_buf *mb,
+		    cxobj                 *xev)
 {
     int                retval = -1;
     cbuf              *cb = NULL;
@@ -760,7 +1454,7 @@ send_msg_notify_xml(clicon_handle h,
     }
     if (clicon_xml2cbuf(cb, xev, 0, 0, -1) < 0)
 	goto done;
-    if (send_msg_notify(s, cbuf_get(cb)) < 0)
+    if (send_msg_notify(s, mb, cbuf_get(cb)) < 0)
 	goto done;
     retval = 0;
   done:
@@ -49,6 +49,7 @@
 #include <errno.h>
 #include <assert.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
@@ -73,6 +74,7 @@
 #include "clixon_xpath.h"
 #include "clixon_proto.h"
 #include "clixon_err.h"
+#include "clixon_event.h"
 #include "clixon_stream.h"
 #include "clixon_err_string.h"
 #include "clixon_xml_nsctx.h"
@@ -82,6 +84,37 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_proto_client.h"
 
+/* Asynchronous rpc request waiting for reply, see clicon_rpc_async
+ */
+struct rpc_async_req {
+    qelem_t              ra_qelem;  /* List header */
+    uint32_t             ra_id;     /* Request id */
+    clicon_rpc_async_cb *ra_fn;     /* Reply callback, or NULL if canceled */
+    void                *ra_arg;    /* Argument to ra_fn */
+};
+
+/* Backend connection for asynchronous rpcs
+ * Requests are pipelined and the backend replies in request order on each connection.
+ */
+struct rpc_async_conn {
+    clicon_handle         rs_h;        /* Clixon handle */
+    int                   rs_s;        /* Non-blocking socket, or -1 if not connected */
+    struct clicon_msg_buf rs_rcv;      /* Received partial replies */
+    struct clicon_msg_buf rs_snd;      /* Requests not yet written */
+    int                   rs_out;      /* Output callback registered */
+    struct rpc_async_req *rs_pending;  /* Requests in send order */
+    int                   rs_npending; /* Number of requests in rs_pending */
+};
+
+/* Pool of backend connections for asynchronous rpcs, created on first request */
+static struct rpc_async_conn *_rpc_async_conns = NULL;
+static int                    _rpc_async_nr = 0;
+/* Last request id */
+static uint32_t               _rpc_async_id = 0;
+
+static int rpc_async_input(int s, void *arg);
+static int rpc_async_output(int s, void *arg);
+
 /*! Connect to internal netconf socket
  */
 int
@@ -142,7 +175,6 @@ clicon_rpc_msg(clicon_handle      h,
 	       cxobj            **xret0)
 {
     int     retval = -1;
-    char   *retdata = NULL;
     cxobj  *xret = NULL;
     int     s = -1;
 
@@ -156,18 +188,9 @@ clicon_rpc_msg(clicon_handle      h,
 	    goto done;
 	clicon_client_socket_set(h, s);
     }
-    if (clicon_rpc(s, msg, &retdata) < 0)
+    /* Reply may be XML text or binary */
+    if (clicon_rpc_xml(s, msg, &xret) < 0)
 	goto done;
-
-    clicon_debug(1, "%s retdata:%s", __FUNCTION__, retdata);
-
-    if (retdata){
-	/* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
-	 * to reply.
-	 */
-	if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
-	    goto done;
-    }
     if (xret0){
 	*xret0 = xret;
 	xret = NULL;
@@ -178,13 +201,286 @@ clicon_rpc_msg(clicon_handle      h,
 	close(s);
 	clicon_client_socket_set(h, -1);
     }
-    if (retdata)
-	free(retdata);
     if (xret)
 	xml_free(xret);
     return retval;
 }
 
+/*! Close an asynchronous rpc connection and call callbacks of its pending requests
+ * @param[in]  rs      Connection
+ * @param[in]  status  Status to callbacks: 0 canceled, -1 failed
+ * @retval     0       OK
+ * @retval    -1       Error from a callback
+ */
+static int
+rpc_async_conn_close(struct rpc_async_conn *rs,
+		     int                    status)
+{
+    int                   retval = 0;
+    struct rpc_async_req *ra;
+
+    if (rs->rs_s != -1){
+	if (rs->rs_out)
+	    clixon_event_unreg_fd_out(rs->rs_s, rpc_async_output);
+	clixon_event_unreg_fd(rs->rs_s, rpc_async_input);
+	close(rs->rs_s);
+	rs->rs_s = -1;
+    }
+    rs->rs_out = 0;
+    clicon_msg_buf_reset(&rs->rs_rcv);
+    clicon_msg_buf_reset(&rs->rs_snd);
+    while ((ra = rs->rs_pending) != NULL){
+	DELQ(ra, rs->rs_pending, struct rpc_async_req *);
+	rs->rs_npending--;
+	if (ra->ra_fn && ra->ra_fn(rs->rs_h, status, NULL, ra->ra_arg) < 0)
+	    retval = -1;
+	free(ra);
+    }
+    return retval;
+}
+
+/*! Backend socket is writable: write queued requests
+ * Replies are read meanwhile, since the backend may wait for its replies to be read
+ * before it reads more requests.
+ * @param[in]  s    Socket
+ * @param[in]  arg  Connection
+ */
+static int
+rpc_async_output(int   s,
+		 void *arg)
+{
+    struct rpc_async_conn *rs = (struct rpc_async_conn *)arg;
+    int                    ret;
+
+    if ((ret = clicon_msg_flush(s, &rs->rs_snd)) < 0)
+	return rpc_async_conn_close(rs, -1);
+    if (ret == 1){ /* All written */
+	clixon_event_unreg_fd_out(s, rpc_async_output);
+	rs->rs_out = 0;
+    }
+    return 0;
+}
+
+/*! Backend socket has input: dispatch complete replies to their requests
+ * @param[in]  s    Socket
+ * @param[in]  arg  Connection
+ */
+static int
+rpc_async_input(int   s,
+		void *arg)
+{
+    int                   retval = -1;
+    struct rpc_async_conn *rs = (struct rpc_async_conn *)arg;
+    struct rpc_async_req *ra;
+    struct clicon_msg    *reply = NULL;
+    cxobj                *xret = NULL;
+    int                   eof = 0;
+    int                   ret;
+
+    if (clicon_msg_rcv_nb(s, &rs->rs_rcv, &eof) < 0)
+	goto fail;
+    while (rs->rs_s == s && (ret = clicon_msg_buf_get(&rs->rs_rcv, &reply)) != 0){
+	if (ret < 0)
+	    goto fail;
+	if ((ra = rs->rs_pending) == NULL){
+	    clicon_err(OE_PROTO, EBADMSG, "Reply without request");
+	    goto fail;
+	}
+	DELQ(ra, rs->rs_pending, struct rpc_async_req *);
+	rs->rs_npending--;
+	if (clicon_msg_decode(reply, NULL, NULL, &xret, NULL) < 0)
+	    ret = ra->ra_fn ? ra->ra_fn(rs->rs_h, -1, NULL, ra->ra_arg) : 0;
+	else if (ra->ra_fn){
+	    ret = ra->ra_fn(rs->rs_h, 1, xret, ra->ra_arg);
+	    xret = NULL; /* consumed by callback */
+	}
+	else
+	    ret = 0;
+	free(ra);
+	free(reply);
+	reply = NULL;
+	if (xret){
+	    xml_free(xret);
+	    xret = NULL;
+	}
+	if (ret < 0)
+	    goto done;
+    }
+    if (eof && rs->rs_s == s){
+	clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	goto fail;
+    }
+    retval = 0;
+ done:
+    if (reply)
+	free(reply);
+    return retval;
+ fail:
+    retval = rpc_async_conn_close(rs, -1);
+    goto done;
+}
+
+/*! Send an rpc to the backend without waiting for the reply
+ *
+ * The reply is given to a callback from the event loop. Several requests may be
+ * outstanding at once, on a small pool of backend connections, see
+ * CLICON_RPC_ASYNC_SOCKETS. The callback is called exactly once per request:
+ *   status 1:  with the reply as xml tree, consumed by the callback
+ *   status 0:  request canceled, see clicon_rpc_async_cancel
+ *   status -1: backend connection failed, no reply. 
+ * @param[in]  h      Clixon handle
+ * @param[in]  msg    Encoded message, see clicon_rpc_encode. Not consumed
+ * @param[in]  fn     Reply callback
+ * @param[in]  arg    Argument to fn
+ * @param[out] id     Request id, for cancel
+ * @retval     0      OK, request sent or queued
+ * @retval    -1      Error, fn will not be called
+ * @note The pooled connections use the session-id of the message, ie they act as the
+ * same session as the synchronous socket of clicon_rpc_msg. The backend releases the
+ * locks of a session when its last connection is closed, and kill-session closes all
+ * its connections.
+ * @see clicon_rpc_msg  synchronous rpc
+ */
+int
+clicon_rpc_async(clicon_handle        h,
+		 struct clicon_msg   *msg,
+		 clicon_rpc_async_cb *fn,
+		 void                *arg,
+		 uint32_t            *id)
+{
+    int                    retval = -1;
+    struct rpc_async_conn *rs = NULL;
+    struct rpc_async_req  *ra = NULL;
+    int                    i;
+    int                    s = -1;
+    int                    flags;
+    int                    ret;
+
+    if (_rpc_async_conns == NULL){
+	if ((_rpc_async_nr = clicon_option_int(h, "CLICON_RPC_ASYNC_SOCKETS")) <= 0){
+	    _rpc_async_nr = 0;
+	    clicon_err(OE_PROTO, EINVAL, "Asynchronous rpcs not enabled, see CLICON_RPC_ASYNC_SOCKETS");
+	    goto done;
+	}
+	if ((_rpc_async_conns = calloc(_rpc_async_nr, sizeof(*_rpc_async_conns))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	for (i=0; i<_rpc_async_nr; i++){
+	    _rpc_async_conns[i].rs_h = h;
+	    _rpc_async_conns[i].rs_s = -1;
+	}
+    }
+    /* Least loaded connection */
+    for (i=0; i<_rpc_async_nr; i++)
+	if (rs == NULL || _rpc_async_conns[i].rs_npending < rs->rs_npending)
+	    rs = &_rpc_async_conns[i];
+    if (rs->rs_s == -1){
+	if (clicon_rpc_connect(h, &s) < 0)
+	    goto done;
+	if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+	    fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0){
+	    clicon_err(OE_UNIX, errno, "fcntl");
+	    close(s);
+	    goto done;
+	}
+	if (clixon_event_reg_fd(s, rpc_async_input, rs, "backend rpc reply") < 0){
+	    close(s);
+	    goto done;
+	}
+	rs->rs_s = s;
+    }
+    if ((ra = malloc(sizeof(*ra))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ra, 0, sizeof(*ra));
+    if (clicon_msg_buf_put(&rs->rs_snd, msg) < 0)
+	goto done;
+    if (!rs->rs_out){
+	if ((ret = clicon_msg_flush(rs->rs_s, &rs->rs_snd)) < 0){
+	    rpc_async_conn_close(rs, -1);
+	    goto done;
+	}
+	if (ret == 0){ /* Write the rest when writable */
+	    if (clixon_event_reg_fd_out(rs->rs_s, rpc_async_output, rs, "backend rpc request") < 0)
+		goto done;
+	    rs->rs_out = 1;
+	}
+    }
+    if (++_rpc_async_id == 0) /* 0 is not a request id */
+	_rpc_async_id++;
+    ra->ra_id = _rpc_async_id;
+    ra->ra_fn = fn;
+    ra->ra_arg = arg;
+    ADDQ(ra, rs->rs_pending);
+    rs->rs_npending++;
+    if (id)
+	*id = ra->ra_id;
+    ra = NULL;
+    retval = 0;
+ done:
+    if (ra)
+	free(ra);
+    return retval;
+}
+
+/*! Cancel an asynchronous rpc
+ * The callback is called with status 0, and the reply is discarded when it arrives
+ * @param[in]  h   Clixon handle
+ * @param[in]  id  Request id, see clicon_rpc_async
+ * @retval     1   Canceled
+ * @retval     0   Not found, eg reply already given
+ * @retval    -1   Error from callback
+ */
+int
+clicon_rpc_async_cancel(clicon_handle h,
+			uint32_t      id)
+{
+    struct rpc_async_conn *rs;
+    struct rpc_async_req  *ra;
+    clicon_rpc_async_cb   *fn;
+    int                    i;
+
+    for (i=0; i<_rpc_async_nr; i++){
+	rs = &_rpc_async_conns[i];
+	if ((ra = rs->rs_pending) == NULL)
+	    continue;
+	do {
+	    if (ra->ra_id == id && ra->ra_fn != NULL){
+		fn = ra->ra_fn;
+		ra->ra_fn = NULL;
+		if (fn(h, 0, NULL, ra->ra_arg) < 0)
+		    return -1;
+		return 1;
+	    }
+	    ra = NEXTQ(struct rpc_async_req *, ra);
+	} while (ra && ra != rs->rs_pending);
+    }
+    return 0;
+}
+
+/*! Close asynchronous rpc connections, pending requests are canceled
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error from callback
+ */
+int
+clicon_rpc_async_exit(clicon_handle h)
+{
+    int retval = 0;
+    int i;
+
+    for (i=0; i<_rpc_async_nr; i++)
+	if (rpc_async_conn_close(&_rpc_async_conns[i], 0) < 0)
+	    retval = -1;
+    if (_rpc_async_conns)
+	free(_rpc_async_conns);
+    _rpc_async_conns = NULL;
+    _rpc_async_nr = 0;
+    return retval;
+}
+
 /*! Send internal netconf rpc from client to backend and return a persistent socket
  * @param[in]   h      CLICON handle
  * @param[in]   msg    Encoded message. Deallocate with free
@@ -200,7 +496,6 @@ clicon_rpc_msg_persistent(clicon_handle      h,
 			  int               *sock0)
 {
     int     retval = -1;
-    char   *retdata = NULL;
     cxobj  *xret = NULL;
     int     s = -1;
 
@@ -215,18 +510,9 @@ clicon_rpc_msg_persistent(clicon_handle      h,
     /* Create a socket and connect to it, either UNIX, IPv4 or IPv6 per config options */
     if (clicon_rpc_connect(h, &s) < 0)
 	goto done;
-    if (clicon_rpc(s, msg, &retdata) < 0)
+    /* Reply may be XML text or binary */
+    if (clicon_rpc_xml(s, msg, &xret) < 0)
 	goto done;
-
-    clicon_debug(1, "%s retdata:%s", __FUNCTION__, retdata);
-
-    if (retdata){
-	/* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
-	 * to reply.
-	 */
-	if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
-	    goto done;
-    }
     if (xret0){
 	*xret0 = xret;
 	xret = NULL;
@@ -238,8 +524,6 @@ clicon_rpc_msg_persistent(clicon_handle      h,
  done:
     if (s >= 0)
 	close(s);
-    if (retdata)
-	free(retdata);
     if (xret)
 	xml_free(xret);
     return retval;
@@ -274,6 +558,39 @@ session_id_check(clicon_handle h,
     return retval;
 }
 
+/*! Encode an internal netconf rpc given as text, binary encoded if CLICON_IPC_BINARY is set
+ * The backend replies using the same encoding as the request
+ * @param[in]  h           clicon handle
+ * @param[in]  session_id  Session id
+ * @param[in]  xmlstr      XML netconf rpc as string
+ * @retval     msg         Encoded message. Free with free
+ * @retval     NULL        Error
+ * @see clicon_msg_encode_xml
+ */
+static struct clicon_msg *
+clicon_rpc_encode(clicon_handle h,
+		  uint32_t      session_id,
+		  char         *xmlstr)
+{
+    struct clicon_msg *msg = NULL;
+    cxobj             *xt = NULL;
+    cxobj             *xrpc;
+
+    if (!clicon_option_bool(h, "CLICON_IPC_BINARY"))
+	return clicon_msg_encode(session_id, "%s", xmlstr);
+    if (clixon_xml_parse_string(xmlstr, YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    if ((xrpc = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL){
+	clicon_err(OE_NETCONF, EINVAL, "Missing rpc");
+	goto done;
+    }
+    msg = clicon_msg_encode_xml(session_id, xrpc, -1);
+ done:
+    if (xt)
+	xml_free(xt);
+    return msg;
+}
+
 /*! Generic xml netconf clicon rpc for persistent
  * Want to go over to use netconf directly between client and server,...
  * @param[in]  h       clicon handle
@@ -349,6 +666,8 @@ clicon_rpc_netconf_xml(clicon_handle  h,
     yang_stmt *yspec;
     cxobj     *xerr = NULL;
     int        ret;
+    uint32_t   session_id;
+    struct clicon_msg *msg = NULL;
 
     if ((cb = cbuf_new()) == NULL){
 	clicon_err(OE_XML, errno, "cbuf_new");
@@ -359,10 +678,24 @@ clicon_rpc_netconf_xml(clicon_handle  h,
 	goto done;
     }
     rpcname = xml_name(xname); /* Store rpc name and use in yang binding after reply */
-    if (clicon_xml2cbuf(cb, xml, 0, 0, -1) < 0)
-	goto done;
-    if (clicon_rpc_netconf(h, cbuf_get(cb), xret, sp) < 0)
-	goto done;
+    if (clicon_option_bool(h, "CLICON_IPC_BINARY")){
+	if (session_id_check(h, &session_id) < 0)
+	    goto done;
+	if ((msg = clicon_msg_encode_xml(session_id, xml, -1)) == NULL)
+	    goto done;
+	if (sp){
+	    if (clicon_rpc_msg_persistent(h, msg, xret, sp) < 0)
+		goto done;
+	}
+	else if (clicon_rpc_msg(h, msg, xret) < 0)
+	    goto done;
+    }
+    else {
+	if (clicon_xml2cbuf(cb, xml, 0, 0, -1) < 0)
+	    goto done;
+	if (clicon_rpc_netconf(h, cbuf_get(cb), xret, sp) < 0)
+	    goto done;
+    }
     if ((xreply = xml_find_type(*xret, NULL, "rpc-reply", CX_ELMNT)) != NULL &&
 	xml_find_type(xreply, NULL, "rpc-error", CX_ELMNT) == NULL){
 	yspec = clicon_dbspec_yang(h);
@@ -383,6 +716,8 @@ clicon_rpc_netconf_xml(clicon_handle  h,
     }
     retval = 0;
  done:
+    if (msg)
+	free(msg);
     if (xerr)
 	xml_free(xerr);
     if (cb)
@@ -462,7 +797,7 @@ clicon_rpc_get_config(clicon_handle h,
 	cprintf(cb, "/>");
     }
     cprintf(cb, "</get-config></rpc>");
-    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+    if ((msg = clicon_rpc_encode(h, session_id, cbuf_get(cb))) == NULL)
 	goto done;
     if (clicon_rpc_msg(h, msg, &xret) < 0)
 	goto done;
@@ -752,58 +1087,19 @@ clicon_rpc_unlock(clicon_handle h,
     return retval;
 }
 
-/*! Get database configuration and state data
- * @param[in]  h         Clicon handle
- * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
- * @param[in]  namespace Namespace associated w xpath
- * @param[in]  nsc       Namespace context for filter
- * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
- * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
- * @param[out] xt        XML tree. Free with xml_free. 
- *                       Either <config> or <rpc-error>. 
- * @retval    0          OK
- * @retval   -1          Error, fatal or xml
- * @note if xpath is set but namespace is NULL, the default, netconf base 
- *       namespace will be used which is most probably wrong.
- * @code
- *  cxobj *xt = NULL;
- *  cvec *nsc = NULL;
- *
- *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
- *     err;
- *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
- *     err;
- *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
- *     clixon_netconf_error(xerr, "clicon_rpc_get", NULL);
- *     err;
- *  }
- *  if (xt)
- *     xml_free(xt);
- *  if (nsc)
- *     xml_nsctx_free(nsc);
- * @endcode
- * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
- * @see clixon_netconf_error
- * @note the netconf return message is yang populated, as well as the return data
+/*! Encode a get rpc, see clicon_rpc_get
  */
-int
-clicon_rpc_get(clicon_handle   h, 
-	       char           *xpath,
-	       cvec           *nsc, /* namespace context for filter */
-	       netconf_content content,
-	       int32_t         depth,
-	       cxobj         **xt)
+static struct clicon_msg *
+rpc_get_msg(clicon_handle   h,
+	    char           *xpath,
+	    cvec           *nsc,
+	    netconf_content content,
+	    int32_t         depth)
 {
-    int                retval = -1;
     struct clicon_msg *msg = NULL;
     cbuf              *cb = NULL;
-    cxobj             *xret = NULL;
-    cxobj             *xerr = NULL;
-    cxobj             *xd;
     char              *username;
     uint32_t           session_id;
-    int                ret;
-    yang_stmt         *yspec;
     
     if (session_id_check(h, &session_id) < 0)
 	goto done;
@@ -832,11 +1128,31 @@ clicon_rpc_get(clicon_handle   h,
 	cprintf(cb, "/>");
     }
     cprintf(cb, "</get></rpc>");
-    if ((msg = clicon_msg_encode(session_id,
-				 "%s", cbuf_get(cb))) == NULL)
-	goto done;
-    if (clicon_rpc_msg(h, msg, &xret) < 0)
-	goto done;
+    msg = clicon_rpc_encode(h, session_id, cbuf_get(cb));
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return msg;
+}
+
+/*! Get data or error of a get reply, see clicon_rpc_get
+ * @param[in]  h     Clicon handle
+ * @param[in]  xret  Reply, <rpc-reply>
+ * @param[out] xt    <data> or <rpc-error>, removed from xret. Free with xml_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+rpc_get_reply(clicon_handle h,
+	      cxobj        *xret,
+	      cxobj       **xt)
+{
+    int                retval = -1;
+    cxobj             *xerr = NULL;
+    cxobj             *xd;
+    int                ret;
+    yang_stmt         *yspec;
+
     /* Send xml error back: first check error, then ok */
     if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL)
 	xd = xml_parent(xd); /* point to rpc-reply */
@@ -866,10 +1182,65 @@ clicon_rpc_get(clicon_handle   h,
     }
     retval = 0;
   done:
-    if (cb)
-	cbuf_free(cb);
     if (xerr)
 	xml_free(xerr);
+    return retval;
+}
+
+/*! Get database configuration and state data
+ * @param[in]  h         Clicon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  namespace Namespace associated w xpath
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[out] xt        XML tree. Free with xml_free. 
+ *                       Either <config> or <rpc-error>. 
+ * @retval    0          OK
+ * @retval   -1          Error, fatal or xml
+ * @note if xpath is set but namespace is NULL, the default, netconf base 
+ *       namespace will be used which is most probably wrong.
+ * @code
+ *  cxobj *xt = NULL;
+ *  cvec *nsc = NULL;
+ *
+ *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
+ *     err;
+ *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
+ *     err;
+ *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+ *     clixon_netconf_error(xerr, "clicon_rpc_get", NULL);
+ *     err;
+ *  }
+ *  if (xt)
+ *     xml_free(xt);
+ *  if (nsc)
+ *     xml_nsctx_free(nsc);
+ * @endcode
+ * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
+ * @see clixon_netconf_error
+ * @note the netconf return message is yang populated, as well as the return data
+ */
+int
+clicon_rpc_get(clicon_handle   h, 
+	       char           *xpath,
+	       cvec           *nsc, /* namespace context for filter */
+	       netconf_content content,
+	       int32_t         depth,
+	       cxobj         **xt)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    
+    if ((msg = rpc_get_msg(h, xpath, nsc, content, depth)) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+	goto done;
+    if (rpc_get_reply(h, xret, xt) < 0)
+	goto done;
+    retval = 0;
+  done:
     if (xret)
 	xml_free(xret);
     if (msg)
@@ -877,6 +1248,82 @@ clicon_rpc_get(clicon_handle   h,
     return retval;
 }
 
+/* Reply callback of clicon_rpc_get_async */
+struct rpc_get_async_arg {
+    clicon_rpc_async_cb *ga_fn;
+    void                *ga_arg;
+};
+
+/*! Reply of asynchronous get: get data or error and call the callback
+ */
+static int
+rpc_get_async_cb(clicon_handle h,
+		 int           status,
+		 cxobj        *xret,
+		 void         *arg)
+{
+    int                       retval;
+    struct rpc_get_async_arg *ga = (struct rpc_get_async_arg *)arg;
+    cxobj                    *xt = NULL;
+
+    if (status == 1 && rpc_get_reply(h, xret, &xt) < 0)
+	status = -1;
+    if (xret)
+	xml_free(xret);
+    retval = ga->ga_fn(h, status, xt, ga->ga_arg); /* xt consumed by callback */
+    free(ga);
+    return retval;
+}
+
+/*! Get database configuration and state data without waiting for the reply
+ * Same as clicon_rpc_get, but the data is given to a callback as with clicon_rpc_async
+ * @param[in]  h         Clicon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  fn        Callback, called with <data> or <rpc-error> as xret, consumed by fn
+ * @param[in]  arg       Argument to fn
+ * @param[out] id        Request id, for cancel
+ * @retval     0         OK
+ * @retval    -1         Error, fn will not be called
+ * @see clicon_rpc_get
+ * @see clicon_rpc_async
+ */
+int
+clicon_rpc_get_async(clicon_handle        h, 
+		     char                *xpath,
+		     cvec                *nsc,
+		     netconf_content      content,
+		     int32_t              depth,
+		     clicon_rpc_async_cb *fn,
+		     void                *arg,
+		     uint32_t            *id)
+{
+    int                       retval = -1;
+    struct clicon_msg        *msg = NULL;
+    struct rpc_get_async_arg *ga = NULL;
+
+    if ((msg = rpc_get_msg(h, xpath, nsc, content, depth)) == NULL)
+	goto done;
+    if ((ga = malloc(sizeof(*ga))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    ga->ga_fn = fn;
+    ga->ga_arg = arg;
+    if (clicon_rpc_async(h, msg, rpc_get_async_cb, ga, id) < 0)
+	goto done;
+    ga = NULL;
+    retval = 0;
+  done:
+    if (ga)
+	free(ga);
+    if (msg)
+	free(msg);
+    return retval;
+}
+
 /*! Send a close a netconf user session. Socket is also closed if still open
  * @param[in] h        CLICON handle
  * @retval    0        OK
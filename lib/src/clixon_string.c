@@ -49,9 +49,15 @@
 
 /* clicon */
 #include "clixon_queue.h"
+#include "clixon_hash.h"
 #include "clixon_string.h"
 #include "clixon_err.h"
 
+/* Table of interned strings, value is reference count
+ * @see clixon_string_intern
+ */
+static clicon_hash_t *_string_intern = NULL;
+
 /*! Split string into a vector based on character delimiters. Using malloc
  *
  * The given string is split into a vector where the delimiter can be
@@ -832,6 +838,54 @@ clicon_strcmp(char *s1,
     return strcmp(s1, s2);
 }
 
+/*! Intern a string, ie return a shared copy of it
+ *
+ * Equal strings share the same storage, which is reference counted. Used for
+ * names and prefixes of XML nodes of which there are few distinct values.
+ * @param[in]  str   String
+ * @retval     istr  Interned string, do not modify, release with clixon_string_release
+ * @retval     NULL  Error
+ * @see clixon_string_release
+ */
+char *
+clixon_string_intern(const char *str)
+{
+    struct clicon_hash *h;
+    size_t              refs = 1;
+
+    if (_string_intern == NULL &&
+	(_string_intern = clicon_hash_init()) == NULL)
+	return NULL;
+    if ((h = clicon_hash_lookup(_string_intern, str)) != NULL){
+	(*(size_t *)h->h_val)++;
+	return h->h_key;
+    }
+    if ((h = clicon_hash_add(_string_intern, str, &refs, sizeof(refs))) == NULL)
+	return NULL;
+    return h->h_key;
+}
+
+/*! Release an interned string, free it when no longer referenced
+ * @param[in]  istr  String returned by clixon_string_intern
+ * @retval     0     OK
+ * @retval    -1     Error, string not interned
+ * @see clixon_string_intern
+ */
+int
+clixon_string_release(char *istr)
+{
+    struct clicon_hash *h;
+
+    if (_string_intern == NULL ||
+	(h = clicon_hash_lookup(_string_intern, istr)) == NULL){
+	clicon_err(OE_UNIX, EINVAL, "String not interned: %s", istr);
+	return -1;
+    }
+    if (--(*(size_t *)h->h_val) == 0)
+	return clicon_hash_del(_string_intern, istr);
+    return 0;
+}
+
 /*! strndup() for systems without it, such as xBSD
  */
 #ifndef HAVE_STRNDUP
@@ -78,9 +78,163 @@
 #include "clixon_yang_module.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_map.h"
+#include "clixon_xml_sort.h"
+#include "clixon_data.h"
 #include "clixon_validate.h"
 
+/* Key of leafref target value index in clicon data */
+#define LEAFREF_INDEX "leafref_index"
+
+/*! Get leafref target value index of current validation, if any
+ * @param[in]  h     Clicon handle
+ * @retval     index Hash table of leafref target value sets
+ * @retval     NULL  No index, eg validation not started by xml_yang_validate_all_top
+ */
+static clicon_hash_t *
+leafref_index_get(clicon_handle h)
+{
+    size_t len;
+    void  *p;
+
+    if ((p = clicon_hash_value(clicon_data(h), LEAFREF_INDEX, &len)) != NULL)
+	return *(clicon_hash_t **)p;
+    return NULL;
+}
+
+/*! Set or clear leafref target value index of current validation
+ * @param[in]  h     Clicon handle
+ * @param[in]  index Hash table of leafref target value sets, or NULL to clear
+ */
+static int
+leafref_index_set(clicon_handle  h,
+		  clicon_hash_t *index)
+{
+    if (index == NULL)
+	return clicon_hash_del(clicon_data(h), LEAFREF_INDEX);
+    /* Copy the pointer to index, not what it points to */
+    if (clicon_hash_add(clicon_data(h), LEAFREF_INDEX, &index, sizeof(index)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Free leafref target value index including all value sets
+ * @param[in]  index Hash table of leafref target value sets
+ */
+static int
+leafref_index_free(clicon_hash_t *index)
+{
+    char  **keys = NULL;
+    size_t  nkeys = 0;
+    size_t  i;
+    void   *p;
+
+    if (clicon_hash_keys(index, &keys, &nkeys) < 0)
+	return -1;
+    for (i=0; i<nkeys; i++)
+	if ((p = clicon_hash_value(index, keys[i], NULL)) != NULL)
+	    clicon_hash_free(*(clicon_hash_t **)p);
+    if (keys)
+	free(keys);
+    clicon_hash_free(index);
+    return 0;
+}
+
+/*! Find the node a leafref path is evaluated from, independently of the leafref node
+ *
+ * A path is context-independent given its anchor if it is absolute, or if it starts
+ * with one or several "../" steps, and it does not use current() or deref().
+ * Then all leafrefs with the same path and anchor reference the same target values.
+ * @param[in]  xt      XML leafref node
+ * @param[in]  path    Leafref path
+ * @param[out] xanchor Anchor node, NULL if absolute path
+ * @retval     1       Path is context-independent given anchor
+ * @retval     0       Path depends on leafref node, index cannot be used
+ */
+static int
+leafref_anchor(cxobj  *xt,
+	       char   *path,
+	       cxobj **xanchor)
+{
+    char  *p = path;
+    cxobj *x = xt;
+
+    if (strstr(path, "current(") != NULL || strstr(path, "deref(") != NULL)
+	return 0;
+    while (isspace(*p))
+	p++;
+    if (*p == '/'){
+	*xanchor = NULL;
+	return 1;
+    }
+    if (strncmp(p, "../", 3) != 0)
+	return 0;
+    while (strncmp(p, "../", 3) == 0){
+	if ((x = xml_parent(x)) == NULL)
+	    return 0;
+	p += 3;
+    }
+    *xanchor = x;
+    return 1;
+}
+
+/*! Get set of target values of a leafref path, building it on first use
+ * @param[in]  index  Hash table of leafref target value sets
+ * @param[in]  xt     XML leafref node
+ * @param[in]  ypath  Yang path statement of leafref
+ * @param[in]  xanchor Anchor node of path, NULL if absolute
+ * @param[in]  nsc    Namespace context of path
+ * @param[out] setp   Set of target values (bodies as keys)
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+leafref_index_values(clicon_hash_t  *index,
+		     cxobj          *xt,
+		     yang_stmt      *ypath,
+		     cxobj          *xanchor,
+		     cvec           *nsc,
+		     clicon_hash_t **setp)
+{
+    int            retval = -1;
+    char           key[64];
+    void          *p;
+    clicon_hash_t *set = NULL;
+    cxobj        **xvec = NULL;
+    size_t         xlen = 0;
+    char          *body;
+    int            i;
+
+    snprintf(key, sizeof(key), "%p:%p", ypath, xanchor);
+    if ((p = clicon_hash_value(index, key, NULL)) != NULL){
+	*setp = *(clicon_hash_t **)p;
+	goto ok;
+    }
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, yang_argument_get(ypath)) < 0) 
+	goto done;
+    if ((set = clicon_hash_init()) == NULL)
+	goto done;
+    for (i = 0; i < xlen; i++) {
+	if ((body = xml_body(xvec[i])) == NULL)
+	    continue;
+	if (clicon_hash_add(set, body, NULL, 0) == NULL)
+	    goto done;
+    }
+    if (clicon_hash_add(index, key, &set, sizeof(set)) == NULL)
+	goto done;
+    *setp = set;
+    set = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (set)
+	clicon_hash_free(set);
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
+ * @param[in]  h     Clicon handle
  * @param[in]  xt    XML leaf node of type leafref
  * @param[in]  ys    Yang spec of leaf
  * @param[in]  ytype Yang type statement belonging to the XML node
@@ -96,24 +250,32 @@
  *      references the typedef. (ie ys)
  *   o  Otherwise, the context node is the node in the data tree for which
  *      the "path" statement is defined. (ie yc)
+ * If a leafref index is set up by xml_yang_validate_all_top, the target values of
+ * context-independent paths are looked up in the index instead of evaluating the
+ * path and comparing each target for every leafref.
  */
 static int
-validate_leafref(cxobj     *xt,
-		 yang_stmt *ys,
-		 yang_stmt *ytype,
-		 cxobj    **xret)
+validate_leafref(clicon_handle h,
+		 cxobj        *xt,
+		 yang_stmt    *ys,
+		 yang_stmt    *ytype,
+		 cxobj       **xret)
 {
-    int          retval = -1;
-    yang_stmt   *ypath;
-    cxobj      **xvec = NULL;
-    cxobj       *x;
-    int          i;
-    size_t       xlen = 0;
-    char        *leafrefbody;
-    char        *leafbody;
-    cvec        *nsc = NULL;
-    cbuf        *cberr = NULL;
-    char        *path;
+    int            retval = -1;
+    yang_stmt     *ypath;
+    cxobj        **xvec = NULL;
+    cxobj         *x;
+    int            i;
+    size_t         xlen = 0;
+    char          *leafrefbody;
+    char          *leafbody;
+    cvec          *nsc = NULL;
+    cbuf          *cberr = NULL;
+    char          *path;
+    clicon_hash_t *index;
+    clicon_hash_t *set = NULL;
+    cxobj         *xanchor = NULL;
+    int            found = 0;
     
     if ((leafrefbody = xml_body(xt)) == NULL)
 	goto ok;
@@ -126,16 +288,25 @@ validate_leafref(cxobj     *xt,
     if (xml_nsctx_node(xt, &nsc) < 0)
 	goto done;
     path = yang_argument_get(ypath);
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path) < 0) 
-	goto done;
-    for (i = 0; i < xlen; i++) {
-	x = xvec[i];
-	if ((leafbody = xml_body(x)) == NULL)
-	    continue;
-	if (strcmp(leafbody, leafrefbody) == 0)
-	    break;
+    if ((index = leafref_index_get(h)) != NULL &&
+	leafref_anchor(xt, path, &xanchor) == 1){
+	if (leafref_index_values(index, xt, ypath, xanchor, nsc, &set) < 0)
+	    goto done;
+	found = clicon_hash_lookup(set, leafrefbody) != NULL;
     }
-    if (i==xlen){
+    else {
+	if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path) < 0) 
+	    goto done;
+	for (i = 0; i < xlen; i++) {
+	    x = xvec[i];
+	    if ((leafbody = xml_body(x)) == NULL)
+		continue;
+	    if (strcmp(leafbody, leafrefbody) == 0)
+		break;
+	}
+	found = i < xlen;
+    }
+    if (!found){
 	if ((cberr = cbuf_new()) == NULL){
 	    clicon_err(OE_UNIX, errno, "cbuf_new");
 	    goto done;
@@ -593,50 +764,35 @@ check_mandatory(cxobj     *xt,
     goto done;
 }
 
-/*! New element last in list, check if already exists if sp return -1
+/*! New element last in list sorted by system, check if it is equal to previous element
  * @param[in]  vec   Vector of existing entries (new is last)
  * @param[in]  i1    The new entry is placed at vec[i1]
  * @param[in]  vlen  Lenght of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
  * @retval     0     OK, entry is unique
  * @retval    -1     Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @note Only valid if entries are sorted by key, otherwise use a hash set of key tuples
+ * @see check_unique_list
  */
 static int
 check_insert_duplicate(char **vec,
 		       int    i1,
-		       int    vlen,
-		       int    sorted)
+		       int    vlen)
 {
     int i;
     int v;
     char *b;
 
-    if (sorted){
-	/* Just go look at previous element to see if it is duplicate (sorted by system) */
-	if (i1 == 0)
+    /* Just go look at previous element to see if it is duplicate (sorted by system) */
+    if (i1 == 0)
+	return 0;
+    i = i1-1;
+    for (v=0; v<vlen; v++){
+	b = vec[i*vlen+v];
+	if (b == NULL || strcmp(b, vec[i1*vlen+v]))
 	    return 0;
-	i = i1-1;
-	for (v=0; v<vlen; v++){
-	    b = vec[i*vlen+v];
-	    if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-		return 0;
-	}
-	/* here we have passed thru all keys of previous element and they are all equal */
-	return -1;
-    }
-    else{
-	for (i=0; i<i1; i++){
-	    for (v=0; v<vlen; v++){
-		b = vec[i*vlen+v];
-		if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-		    break;
-	    }
-	    if (v==vlen) /* duplicate */
-		break;
-	}
-	return i==i1?0:-1;
     }
+    /* here we have passed thru all keys of previous element and they are all equal */
+    return -1;
 }
 
 /*! Given a list with unique constraint, detect duplicates
@@ -648,7 +804,6 @@ check_insert_duplicate(char **vec,
  * @retval     1     Validation OK
  * @retval     0     Validation failed (cbret set)
  * @retval    -1     Error
- * @note It would be possible to cache the vector built below
  * All key leafs MUST be present for all list entries.
  * The combined values of all the leafs specified in the key are used to
  * uniquely identify a list entry.  All key leafs MUST be given values
@@ -661,20 +816,24 @@ check_unique_list(cxobj     *x,
 		  yang_stmt *yu,
 		  cxobj    **xret)
 {
-    int       retval = -1;
-    cvec      *cvk; /* unique vector */
-    cg_var    *cvi; /* unique node name */
-    cxobj     *xi;
-    char     **vec = NULL; /* 2xmatrix */
-    int        vlen;
-    int        i;
-    int        v;
-    char      *bi;
-    int        sorted;
+    int            retval = -1;
+    cvec          *cvk; /* unique vector */
+    cg_var        *cvi; /* unique node name */
+    cxobj         *xi;
+    char         **vec = NULL; /* 2xmatrix */
+    int            vlen;
+    int            i;
+    int            v;
+    char          *bi;
+    int            sorted;
+    clicon_hash_t *set = NULL; /* Set of key tuples if not sorted */
+    cbuf          *cb = NULL;  /* Key tuple */
+    int            dup;
     
-    /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+    /* If list and is sorted by system, then it is assumed elements are in key-order and
+     * only the previous element needs to be compared.
+     * Other cases are "unique" constraint or list sorted by user where each key tuple
+     * is looked up in a hash set of previous tuples.
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
 	      yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -684,17 +843,29 @@ check_unique_list(cxobj     *x,
 	/* No keys: no checks necessary */
 	goto ok;
     }
-    if ((vec = calloc(vlen*xml_child_nr(xt), sizeof(char*))) == NULL){
-	clicon_err(OE_UNIX, errno, "calloc");
-	goto done;
+    if (sorted){
+	if ((vec = calloc(vlen*xml_child_nr(xt), sizeof(char*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+    }
+    else{
+	if ((set = clicon_hash_init()) == NULL)
+	    goto done;
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
     }
-    /* A vector is built with key-values, for each iteration check "backward" in the vector
-     * for duplicates
+    /* For each element, check "backward" for duplicates, either in the vector
+     * or in the set
      */
     i = 0; /* x element index */
     do {
 	cvi = NULL;
 	v = 0; /* index in each tuple */
+	if (cb)
+	    cbuf_reset(cb);
 	while ((cvi = cvec_each(cvk, cvi)) != NULL){
 	    /* RFC7950: Sec 7.8.3.1: entries that do not have value for all
 	     * referenced leafs are not taken into account */
@@ -702,11 +873,20 @@ check_unique_list(cxobj     *x,
 		break;
 	    if ((bi = xml_body(xi)) == NULL)
 		break;
-	    vec[i*vlen + v++] = bi;
+	    if (sorted)
+		vec[i*vlen + v++] = bi;
+	    else /* Length-prefixed to make tuple unambiguous */
+		cprintf(cb, "%zu:%s", strlen(bi), bi);
 	}
 	if (cvi==NULL){
 	    /* Last element (i) is newly inserted, see if it is already there */
-	    if (check_insert_duplicate(vec, i, vlen, sorted) < 0){
+	    if (sorted)
+		dup = check_insert_duplicate(vec, i, vlen) < 0;
+	    else if ((dup = clicon_hash_lookup(set, cbuf_get(cb)) != NULL) == 0){
+		if (clicon_hash_add(set, cbuf_get(cb), NULL, 0) == NULL)
+		    goto done;
+	    }
+	    if (dup){
 		if (netconf_data_not_unique_xml(xret, x, cvk) < 0)
 		    goto done;
 		goto fail;
@@ -716,9 +896,12 @@ check_unique_list(cxobj     *x,
 	i++;
     } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
  ok:
-    /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
+    if (cb)
+	cbuf_free(cb);
+    if (set)
+	clicon_hash_free(set);
     if (vec)
 	free(vec);
     return retval;
@@ -1099,6 +1282,155 @@ xml_yang_validate_list_key_only(cxobj        *xt,
     goto done;
 }
 
+/*! Validate constraints of a single XML node that may depend on other nodes, not recursive
+ * Check leafrefs, identityrefs, must and when.
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML node to be validated
+ * @param[in]  ys    Yang spec of xt
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see xml_yang_validate_all
+ */
+static int
+xml_yang_validate_node(clicon_handle h,
+		       cxobj        *xt,
+		       yang_stmt    *ys,
+		       cxobj       **xret)
+{
+    int        retval = -1;
+    yang_stmt *yc;  /* yang child */
+    yang_stmt *ye;  /* yang must error-message */
+    char      *xpath;
+    int        nr;
+    int        ret;
+    cbuf      *cb = NULL;
+    cvec      *nsc = NULL;
+
+    if (yang_config(ys) == 0)
+	goto ok;
+    /* Node-specific validation */
+    switch (yang_keyword_get(ys)){
+    case Y_LEAF:
+	/* fall thru */
+    case Y_LEAF_LIST:
+	/* Special case if leaf is leafref, then first check against
+	   current xml tree
+	*/
+	/* Get base type yc */
+	if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	if (strcmp(yang_argument_get(yc), "leafref") == 0){
+	    if ((ret = validate_leafref(h, xt, ys, yc, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	else if (strcmp(yang_argument_get(yc), "identityref") == 0){
+	    if ((ret = validate_identityref(xt, ys, yc, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	break;
+    default:
+	break;
+    }
+    /* must sub-node RFC 7950 Sec 7.5.3. Can be several.
+     * XXX. use yang path instead? */
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	if (yang_keyword_get(yc) != Y_MUST)
+	    continue;
+	xpath = yang_argument_get(yc); /* "must" has xpath argument */
+	/* the context node is the node in the accessible tree for
+	 * which the "must" statement is defined.
+	 * The set of namespace declarations is the set of all "import" statements'
+	 */
+	if (xml_nsctx_yang(yc, &nsc) < 0)
+	    goto done;
+	if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
+	    goto done;
+	if (!nr){
+	    ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed MUST xpath '%s' of '%s' in module %s",
+		    xpath, xml_name(xt),  yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application",
+					     ye?yang_argument_get(ye):cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+	if (nsc){
+	    xml_nsctx_free(nsc);
+	    nsc = NULL;
+	}
+    }
+    /* First variant of when, actual "when" sub-node RFC 7950 Sec 7.21.5. Can only be one. */
+    if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL){
+	xpath = yang_argument_get(yc); /* "when" has xpath argument */
+	/* WHEN xpath needs namespace context */
+	if (xml_nsctx_yang(ys, &nsc) < 0)
+	    goto done;
+	if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
+	    goto done;
+	if (nsc){
+	    xml_nsctx_free(nsc);
+	    nsc = NULL;
+	}
+	if (nr == 0){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed WHEN condition of %s in module %s",
+		    xml_name(xt),
+		    yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application",
+					     cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    /* Second variants of WHEN:
+     * Augmented and uses when using special info in node
+     */
+    if ((xpath = yang_when_xpath_get(ys)) != NULL){
+	if ((nr = xpath_vec_bool(xml_parent(xt), yang_when_nsc_get(ys),
+				 "%s", xpath)) < 0)
+	    goto done;
+	if (nr == 0){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed augmented 'when' condition '%s' of node '%s' in module '%s'",
+		    xpath,
+		    xml_name(xt),
+		    yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application",
+					     cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+ ok:
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Validate a single XML node with yang specification for all (not only added) entries
  * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
  * @param[in]  xt  XML node to be validated
@@ -1121,23 +1453,18 @@ xml_yang_validate_list_key_only(cxobj        *xt,
  */
 int
 xml_yang_validate_all(clicon_handle h,
-		      cxobj        *xt, 
+		      cxobj        *xt,
 		      cxobj       **xret)
 {
     int        retval = -1;
     yang_stmt *ys;  /* yang node */
-    yang_stmt *yc;  /* yang child */
-    yang_stmt *ye;  /* yang must error-message */
-    char      *xpath;
-    int        nr;
     int        ret;
     cxobj     *x;
     cxobj     *xp;
     char      *ns = NULL;
     cbuf      *cb = NULL;
-    cvec      *nsc = NULL;
 
-    /* if not given by argument (overide) use default link 
+    /* if not given by argument (overide) use default link
        and !Node has a config sub-statement and it is false */
     ys=xml_spec(xt);
     if (ys==NULL){
@@ -1162,120 +1489,13 @@ xml_yang_validate_all(clicon_handle h,
 	    goto done;
 	goto fail;
     }
-    if (yang_config(ys) != 0){
-	/* Node-specific validation */
-	switch (yang_keyword_get(ys)){
-	case Y_ANYXML:
-	case Y_ANYDATA:
-	    goto ok;
-	    break;
-	case Y_LEAF:
-	    /* fall thru */
-	case Y_LEAF_LIST:
-	    /* Special case if leaf is leafref, then first check against
-	       current xml tree
- 	    */
-	    /* Get base type yc */
-	    if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
-		goto done;
-	    if (strcmp(yang_argument_get(yc), "leafref") == 0){
-		if ((ret = validate_leafref(xt, ys, yc, xret)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-		}
-	    else if (strcmp(yang_argument_get(yc), "identityref") == 0){
-		if ((ret = validate_identityref(xt, ys, yc, xret)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-	    }
-	    break;
-	default:
-	    break;
-	}
-	/* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
-	 * XXX. use yang path instead? */
-	yc = NULL;
-	while ((yc = yn_each(ys, yc)) != NULL) {
-	    if (yang_keyword_get(yc) != Y_MUST)
-		continue;
-	    xpath = yang_argument_get(yc); /* "must" has xpath argument */
-	    /* the context node is the node in the accessible tree for
-	     * which the "must" statement is defined. 
-	     * The set of namespace declarations is the set of all "import" statements' 
-	     */
-           if (xml_nsctx_yang(yc, &nsc) < 0)
-               goto done;
-	    if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
-		goto done;
-	    if (!nr){
-		ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed MUST xpath '%s' of '%s' in module %s",
-			xpath, xml_name(xt),  yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 ye?yang_argument_get(ye):cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	    if (nsc){
-		xml_nsctx_free(nsc);
-		nsc = NULL;
-	    }
-	}
-	/* First variant of when, actual "when" sub-node RFC 7950 Sec 7.21.5. Can only be one. */
-	if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL){
-	    xpath = yang_argument_get(yc); /* "when" has xpath argument */
-	    /* WHEN xpath needs namespace context */
-	    if (xml_nsctx_yang(ys, &nsc) < 0)
-		goto done;
-	    if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
-		goto done;
-	    if (nsc){
-		xml_nsctx_free(nsc);
-		nsc = NULL;
-	    }
-	    if (nr == 0){
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed WHEN condition of %s in module %s",
-			xml_name(xt),
-			yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	}
-	/* Second variants of WHEN:
-	 * Augmented and uses when using special info in node
-	 */
-	if ((xpath = yang_when_xpath_get(ys)) != NULL){
-	    if ((nr = xpath_vec_bool(xml_parent(xt), yang_when_nsc_get(ys),
-				     "%s", xpath)) < 0)
-		goto done;
-	    if (nr == 0){
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed augmented 'when' condition '%s' of node '%s' in module '%s'",
-			xpath,
-			xml_name(xt),
-			yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	}
-    }
+    if (yang_config(ys) != 0 &&
+	(yang_keyword_get(ys) == Y_ANYXML || yang_keyword_get(ys) == Y_ANYDATA))
+	goto ok;
+    if ((ret = xml_yang_validate_node(h, xt, ys, xret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
 	if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
@@ -1296,13 +1516,12 @@ xml_yang_validate_all(clicon_handle h,
  done:
     if (cb)
 	cbuf_free(cb);
-    if (nsc)
-	xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
+
 /*! Translate a single xml node to a cligen variable vector. Note not recursive 
  * @param[out] xret    Error XML tree (if ret == 0). Free with xml_free after use
  * @retval     1     Validation OK
@@ -1314,15 +1533,474 @@ xml_yang_validate_all_top(clicon_handle h,
 			  cxobj        *xt, 
 			  cxobj       **xret)
 {
-    int    ret;
-    cxobj *x;
+    int            retval = -1;
+    int            ret;
+    cxobj         *x;
+    clicon_hash_t *index = NULL;
 
+    /* Leafref target values are indexed during this validation, the tree is not 
+     * modified meanwhile */
+    if (leafref_index_get(h) == NULL){
+	if ((index = clicon_hash_init()) == NULL)
+	    goto done;
+	if (leafref_index_set(h, index) < 0)
+	    goto done;
+    }
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-	if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
+	if ((ret = xml_yang_validate_all(h, x, xret)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+    }
+    if ((retval = check_list_unique_minmax(xt, xret)) < 1)
+	goto done;
+    retval = 1;
+ done:
+    if (index){
+	leafref_index_set(h, NULL);
+	leafref_index_free(index);
+    }
+    return retval;
+}
+
+/*! Add names of descendants of an XML node to a set
+ * @param[in]  x        XML node
+ * @param[in]  names    Set of names
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+validate_subtree_names(cxobj         *x,
+		       clicon_hash_t *names)
+{
+    cxobj *xc;
+
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+	if (clicon_hash_lookup(names, xml_name(xc)) == NULL &&
+	    clicon_hash_add(names, xml_name(xc), NULL, 0) == NULL)
+	    return -1;
+	if (validate_subtree_names(xc, names) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Add names of an XML node, its ancestors and its descendants to a set
+ * @param[in]  x        XML node
+ * @param[in]  names    Set of names
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+validate_changed_names(cxobj         *x,
+		       clicon_hash_t *names)
+{
+    cxobj *xp;
+
+    if (validate_subtree_names(x, names) < 0)
+	return -1;
+    for (xp = x; xp != NULL; xp = xml_parent(xp)){
+	if (clicon_hash_lookup(names, xml_name(xp)) == NULL &&
+	    clicon_hash_add(names, xml_name(xp), NULL, 0) == NULL)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Check if an XPath expression may observe a node with any of the given names
+ *
+ * Names in an expression are node tests of location steps. The check is conservative:
+ * function names, operators and names in predicates are also considered.
+ * @param[in]  xpath  XPath expression, eg must, when or leafref path
+ * @param[in]  names  Set of local names of changed nodes
+ * @retval     1      Expression may observe a node with one of the names
+ * @retval     0      Expression does not observe any of the names
+ * @retval    -1      Error
+ */
+static int
+xpath_observes(char          *xpath,
+	       clicon_hash_t *names)
+{
+    int    retval = -1;
+    char  *p = xpath;
+    char  *s;
+    char  *t;
+    char  *name = NULL;
+    char   q;
+
+    while (*p != '\0'){
+	if (*p == '\'' || *p == '"'){ /* Skip literal */
+	    q = *p++;
+	    while (*p != '\0' && *p != q)
+		p++;
+	    if (*p != '\0')
+		p++;
+	    continue;
+	}
+	if (*p == '*') /* Wildcard: any node */
+	    goto observes;
+	if (!isalpha(*p) && *p != '_'){
+	    p++;
+	    continue;
+	}
+	s = p;
+	while (isalnum(*p) || *p == '_' || *p == '-' || *p == '.')
+	    p++;
+	if (p[0] == ':' && p[1] == ':'){ /* Axis name */
+	    p += 2;
+	    continue;
+	}
+	if (p[0] == ':'){ /* Prefix, local name or wildcard follows */
+	    p++;
+	    continue;
+	}
+	for (t = p; isspace(*t); t++);
+	if (*t == '('){ /* Function or node type test */
+	    if ((p-s == strlen("deref") && strncmp(s, "deref", p-s) == 0) ||
+		(p-s == strlen("node") && strncmp(s, "node", p-s) == 0))
+		goto observes;
+	    continue;
+	}
+	if ((name = strndup(s, p-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	if (clicon_hash_lookup(names, name) != NULL)
+	    goto observes;
+	free(name);
+	name = NULL;
+    }
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    return retval;
+ observes:
+    retval = 1;
+    goto done;
+}
+
+/*! Check if must, when or leafref constraints of a yang node may observe changed nodes
+ * @param[in]  ys     Yang data node
+ * @param[in]  names  Set of local names of changed nodes
+ * @retval     1      Constraints may observe changed nodes
+ * @retval     0      No constraints, or constraints do not observe changed nodes
+ * @retval    -1      Error
+ */
+static int
+yang_constraint_observes(yang_stmt     *ys,
+			 clicon_hash_t *names)
+{
+    yang_stmt *yc;
+    yang_stmt *ypath;
+    char      *xpath;
+    int        ret;
+
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	if (yang_keyword_get(yc) != Y_MUST && yang_keyword_get(yc) != Y_WHEN)
+	    continue;
+	if ((ret = xpath_observes(yang_argument_get(yc), names)) != 0)
 	    return ret;
     }
-    if ((ret = check_list_unique_minmax(xt, xret)) < 1)
+    if ((xpath = yang_when_xpath_get(ys)) != NULL &&
+	(ret = xpath_observes(xpath, names)) != 0)
 	return ret;
+    if (yang_keyword_get(ys) == Y_LEAF || yang_keyword_get(ys) == Y_LEAF_LIST){
+	if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
+	    return -1;
+	if (strcmp(yang_argument_get(yc), "leafref") == 0 &&
+	    (ypath = yang_find(yc, Y_PATH, NULL)) != NULL &&
+	    (ret = xpath_observes(yang_argument_get(ypath), names)) != 0)
+	    return ret;
+    }
+    return 0;
+}
+
+/*! Validate constraints of all XML instances of a yang node below a given XML node
+ * @param[in]  h      Clicon handle
+ * @param[in]  x      XML node, instance of chain[i-1] (or top)
+ * @param[in]  chain  Yang data node ancestors of the yang node, top first, node last
+ * @param[in]  i      Level of chain of children of x
+ * @param[in]  n      Length of chain
+ * @param[out] xret   Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ */
+static int
+validate_instances(clicon_handle h,
+		   cxobj        *x,
+		   yang_stmt   **chain,
+		   int           i,
+		   int           n,
+		   cxobj       **xret)
+{
+    cxobj *xc;
+    int    ret;
+
+    if (i == n)
+	return xml_yang_validate_node(h, x, chain[n-1], xret);
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	if (xml_spec(xc) != chain[i])
+	    continue;
+	if ((ret = validate_instances(h, xc, chain, i+1, n, xret)) < 1)
+	    return ret;
+    }
     return 1;
 }
+
+/*! Validate all instances of yang data nodes whose constraints may observe changed nodes
+ * @param[in]  h      Clicon handle
+ * @param[in]  xt     Top of XML tree
+ * @param[in]  yn     Yang node whose children are checked, recursively
+ * @param[in]  names  Set of local names of changed nodes
+ * @param[out] xret   Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ */
+static int
+validate_observers(clicon_handle  h,
+		   cxobj         *xt,
+		   yang_stmt     *yn,
+		   clicon_hash_t *names,
+		   cxobj        **xret)
+{
+    int           retval = -1;
+    yang_stmt    *yc;
+    yang_stmt    *y;
+    yang_stmt   **chain = NULL;
+    int           n;
+    int           i;
+    int           ret;
+    enum rfc_6020 keyw;
+
+    yc = NULL;
+    while ((yc = yn_each(yn, yc)) != NULL) {
+	keyw = yang_keyword_get(yc);
+	if (!yang_datanode(yc) && keyw != Y_CHOICE && keyw != Y_CASE)
+	    continue;
+	if (yang_config(yc) == 0)
+	    continue;
+	if (yang_datanode(yc)){
+	    if ((ret = yang_constraint_observes(yc, names)) < 0)
+		goto done;
+	    if (ret == 1){
+		/* Data node ancestors to find XML instances, top first */
+		n = 0;
+		for (y = yc; y != NULL; y = yang_parent_get(y))
+		    if (yang_datanode(y))
+			n++;
+		if ((chain = calloc(n, sizeof(*chain))) == NULL){
+		    clicon_err(OE_UNIX, errno, "calloc");
+		    goto done;
+		}
+		i = n;
+		for (y = yc; y != NULL; y = yang_parent_get(y))
+		    if (yang_datanode(y))
+			chain[--i] = y;
+		if ((ret = validate_instances(h, xt, chain, 0, n, xret)) < 0)
+		    goto done;
+		if (ret == 0)
+		    goto fail;
+		free(chain);
+		chain = NULL;
+	    }
+	}
+	if ((ret = validate_observers(h, xt, yc, names, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    retval = 1;
+ done:
+    if (chain)
+	free(chain);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate constraints of an XML node and its ancestors, including list unique and min/max
+ * @param[in]  h      Clicon handle
+ * @param[in]  x      XML node in target tree
+ * @param[in]  done   Set of nodes already validated (pointers as keys)
+ * @param[out] xret   Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ */
+static int
+validate_ancestors(clicon_handle  h,
+		   cxobj         *x,
+		   clicon_hash_t *done,
+		   cxobj        **xret)
+{
+    cxobj     *xp;
+    yang_stmt *ys;
+    char       key[32];
+    int        ret;
+
+    for (xp = x; xp != NULL; xp = xml_parent(xp)){
+	snprintf(key, sizeof(key), "%p", xp);
+	if (clicon_hash_lookup(done, key) != NULL)
+	    break; /* And all its ancestors */
+	if (clicon_hash_add(done, key, NULL, 0) == NULL)
+	    return -1;
+	if ((ys = xml_spec(xp)) != NULL){
+	    if (yang_config(ys) == 0)
+		continue;
+	    if ((ret = xml_yang_validate_node(h, xp, ys, xret)) < 1)
+		return ret;
+	}
+	else if (xml_parent(xp) != NULL)
+	    continue;
+	if ((ret = check_list_unique_minmax(xp, xret)) < 1)
+	    return ret;
+    }
+    return 1;
+}
+
+/*! Find the node in target tree corresponding to a node in source tree
+ * @param[in]  xt     Top of target tree
+ * @param[in]  xs     Node in source tree
+ * @param[out] xtp    Corresponding node in target tree, or NULL if not found
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+validate_target_find(cxobj  *xt,
+		     cxobj  *xs,
+		     cxobj **xtp)
+{
+    cxobj *xp = NULL;
+
+    *xtp = NULL;
+    if (xml_parent(xs) == NULL){
+	*xtp = xt;
+	return 0;
+    }
+    if (validate_target_find(xt, xml_parent(xs), &xp) < 0)
+	return -1;
+    if (xp == NULL || xml_spec(xs) == NULL)
+	return 0;
+    return match_base_child(xp, xs, xml_spec(xs), xtp);
+}
+
+/*! Validate a tree given the changes from a valid tree, see xml_yang_validate_all_top
+ *
+ * Only constraints that may be affected by the changes are validated:
+ * 1. Added subtrees are fully validated
+ * 2. Changed nodes, and ancestors of added, changed and deleted nodes are validated,
+ *    including list unique and min/max-elements constraints
+ * 3. All instances of yang nodes whose must, when or leafref expressions may observe
+ *    a changed node are validated. This is determined by the names in the expressions.
+ * @param[in]  h      Clicon handle
+ * @param[in]  xt     Top of target tree
+ * @param[in]  avec   Added nodes in target tree
+ * @param[in]  alen   Length of avec
+ * @param[in]  dvec   Deleted nodes in source tree
+ * @param[in]  dlen   Length of dvec
+ * @param[in]  cvec   Changed nodes in target tree
+ * @param[in]  clen   Length of cvec
+ * @param[out] xret   Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @note The source tree must be valid, otherwise errors in it may not be detected
+ * @see xml_yang_validate_all_top  which validates the whole tree
+ */
+int
+xml_yang_validate_changed(clicon_handle h,
+			  cxobj        *xt,
+			  cxobj       **avec,
+			  int           alen,
+			  cxobj       **dvec,
+			  int           dlen,
+			  cxobj       **cvec,
+			  int           clen,
+			  cxobj       **xret)
+{
+    int            retval = -1;
+    int            ret;
+    int            i;
+    cxobj         *x;
+    clicon_hash_t *names = NULL;
+    clicon_hash_t *done = NULL;
+    clicon_hash_t *index = NULL;
+    yang_stmt     *yspec;
+    yang_stmt     *ymod;
+
+    if (leafref_index_get(h) == NULL){
+	if ((index = clicon_hash_init()) == NULL)
+	    goto done;
+	if (leafref_index_set(h, index) < 0)
+	    goto done;
+    }
+    if ((names = clicon_hash_init()) == NULL)
+	goto done;
+    if ((done = clicon_hash_init()) == NULL)
+	goto done;
+    /* 1. Added subtrees */
+    for (i=0; i<alen; i++){
+	x = avec[i];
+	if (validate_changed_names(x, names) < 0)
+	    goto done;
+	if ((ret = xml_yang_validate_all(h, x, xret)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+	if ((ret = validate_ancestors(h, xml_parent(x), done, xret)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+    }
+    /* 2. Changed nodes */
+    for (i=0; i<clen; i++){
+	x = cvec[i];
+	if (validate_changed_names(x, names) < 0)
+	    goto done;
+	if ((ret = validate_ancestors(h, x, done, xret)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+    }
+    /* Deleted subtrees, validate what remains of their ancestors */
+    for (i=0; i<dlen; i++){
+	if (validate_changed_names(dvec[i], names) < 0)
+	    goto done;
+	if (validate_target_find(xt, xml_parent(dvec[i]), &x) < 0)
+	    goto done;
+	if (x != NULL &&
+	    (ret = validate_ancestors(h, x, done, xret)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+    }
+    /* 3. Constraints observing changed nodes */
+    if ((yspec = clicon_dbspec_yang(h)) != NULL){
+	ymod = NULL;
+	while ((ymod = yn_each(yspec, ymod)) != NULL) {
+	    if ((ret = validate_observers(h, xt, ymod, names, xret)) < 1){
+		retval = ret;
+		goto done;
+	    }
+	}
+    }
+    retval = 1;
+ done:
+    if (names)
+	clicon_hash_free(names);
+    if (done)
+	clicon_hash_free(done);
+    if (index){
+	leafref_index_set(h, NULL);
+	leafref_index_free(index);
+    }
+    return retval;
+}
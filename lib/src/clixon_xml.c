@@ -87,6 +87,11 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16 
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Size of the value buffer stored inline in body and attribute nodes, including null.
+ * Longer values are allocated separately.
+ */
+#define XML_BODY_INLINE 16
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -172,9 +177,6 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-				       memory) cv? */
     /*----- up to here is common to all next is element only */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
@@ -184,7 +186,6 @@ struct xml{
     cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
 				       by reference, dont free */
-    cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
@@ -205,9 +206,19 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    uint32_t          xb_len;        /* Length of value excluding null */
+    uint32_t          xb_max;        /* 0: no value, XML_BODY_INLINE: inline, else size of xb_heap */
+    union {
+	char          xb_inline[XML_BODY_INLINE]; /* Short values */
+	char         *xb_heap;       /* Long values */
+    } xb_u;
+    int64_t           xb_ival;       /* Typed value, see xml_value_typed_get */
+    uint8_t           xb_vtype;      /* Type of xb_ival, see enum xml_value_type */
 };
 
+/* Value string of body or attribute node */
+#define xml_body_str(xb) ((xb)->xb_max > XML_BODY_INLINE ? (xb)->xb_u.xb_heap : (xb)->xb_u.xb_inline)
+
 /*
  * Variables
  */
@@ -234,6 +245,63 @@ xml_type2str(enum cxobj_type type)
 /* Stats */
 uint64_t _stats_nr = 0;
 
+#ifdef XML_NODE_SLAB
+/* Number of nodes allocated at once in a slab block */
+#define XML_SLAB_NR 256
+
+/*! Slab of XML nodes of one size, free nodes are linked through their first word
+ * Blocks are never returned, freed nodes are reused by later allocations.
+ */
+struct xml_slab{
+    size_t    xs_size;    /* Node size */
+    void     *xs_free;    /* List of free nodes */
+    uint64_t  xs_blocks;  /* Number of allocated blocks */
+};
+
+static struct xml_slab _slab_elmnt = {sizeof(struct xml), NULL, 0};
+static struct xml_slab _slab_body = {sizeof(struct xmlbody), NULL, 0};
+
+/*! Allocate a node from slab, allocate a new block if no free nodes
+ * @param[in]  xs   Slab
+ * @retval     x    Node, not initialized
+ * @retval     NULL Error
+ */
+static void *
+xml_slab_alloc(struct xml_slab *xs)
+{
+    char *block;
+    void *x;
+    int   i;
+
+    if (xs->xs_free == NULL){
+	if ((block = malloc(XML_SLAB_NR*xs->xs_size)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	for (i=XML_SLAB_NR-1; i>=0; i--){
+	    *(void **)(block + i*xs->xs_size) = xs->xs_free;
+	    xs->xs_free = block + i*xs->xs_size;
+	}
+	xs->xs_blocks++;
+    }
+    x = xs->xs_free;
+    xs->xs_free = *(void **)x;
+    return x;
+}
+
+/*! Return a node to slab
+ * @param[in]  xs   Slab
+ * @param[in]  x    Node
+ */
+static void
+xml_slab_free(struct xml_slab *xs,
+	      void            *x)
+{
+    *(void **)x = xs->xs_free;
+    xs->xs_free = x;
+}
+#endif /* XML_NODE_SLAB */
+
 /*! Get global statistics about XML objects
  */
 int
@@ -257,19 +325,13 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-
-    if (x->x_name)
-	sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-	sz += strlen(x->x_prefix) + 1;
+    /* Name and prefix are interned and shared between nodes, not counted */
     switch (xml_type(x)){
     case CX_ELMNT:
 	sz += sizeof(struct xml);
 	sz += x->x_childvec_max*sizeof(struct xml*);
 	if (x->x_ns_cache)
 	    sz += cvec_size(x->x_ns_cache);
-	if (x->x_cv)
-	    sz += cv_size(x->x_cv);
 #ifdef XML_EXPLICIT_INDEX
 	if (x->x_search_index){
 	    /* XXX: only one */
@@ -284,8 +346,8 @@ xml_stats_one(cxobj    *x,
     case CX_BODY:
     case CX_ATTR:
 	sz += sizeof(struct xmlbody);
-	if (x->x_value_cb)
-	    sz += cbuf_buflen(x->x_value_cb);
+	if (((struct xmlbody*)x)->xb_max > XML_BODY_INLINE)
+	    sz += ((struct xmlbody*)x)->xb_max;
 	break;
     default:
 	break;
@@ -321,15 +383,13 @@ xml_print_stats_one(FILE   *f,
 	    fprintf(f, "  childvec: \t%u\n", (unsigned int)(x->x_childvec_max*sizeof(struct xml*)));
 	if (x->x_ns_cache)
 	    fprintf(f, "  ns-cache: \t%u\n", (unsigned int)cvec_size(x->x_ns_cache));
-	if (x->x_cv)
-	    fprintf(f, "  value-cv: \t%u\n", (unsigned int)cv_size(x->x_cv));
 	if (x->x_search_index)
 	    fprintf(f, "  search-index: \t%u\n",
 		    (unsigned int)(strlen(x->x_search_index->si_name) + 1 + clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*)));
     }
     else{
-	if (x->x_value_cb)
-	    fprintf(f, "  value-cb: \t%u\n", cbuf_buflen(x->x_value_cb));
+	if (((struct xmlbody*)x)->xb_max > XML_BODY_INLINE)
+	    fprintf(f, "  value: \t%u\n", ((struct xmlbody*)x)->xb_max);
     }
     return 0;
 }
@@ -390,7 +450,7 @@ xml_name(cxobj *xn)
 
 /*! Set name of xnode, name is copied
  * @param[in]  xn    xml node
- * @param[in]  name  new name, null-terminated string, copied by function
+ * @param[in]  name  new name, null-terminated string, interned by function
  * @retval     -1    on error with clicon-err set
  * @retval     0     OK
  */
@@ -398,16 +458,14 @@ int
 xml_name_set(cxobj *xn, 
 	     char  *name)
 {
-    if (xn->x_name){
-	free(xn->x_name);
-	xn->x_name = NULL;
-    }
-    if (name){
-	if ((xn->x_name = strdup(name)) == NULL){
-	    clicon_err(OE_XML, errno, "strdup");
-	    return -1;
-	}
-    }
+    char *iname = NULL;
+
+    if (name && (iname = clixon_string_intern(name)) == NULL)
+	return -1;
+    if (xn->x_name &&
+	clixon_string_release(xn->x_name) < 0)
+	return -1;
+    xn->x_name = iname;
     return 0;
 }
 
@@ -421,9 +479,9 @@ xml_prefix(cxobj *xn)
     return xn->x_prefix;
 }
 
-/*! Set prefix of xnode, prefix is copied
+/*! Set prefix of xnode, prefix is interned
  * @param[in]  xn      XML node
- * @param[in]  prefix  New prefix, null-terminated string, copied by function
+ * @param[in]  prefix  New prefix, null-terminated string, interned by function
  * @retval     -1      Error with clicon-err set
  * @retval     0       OK
  */
@@ -431,16 +489,14 @@ int
 xml_prefix_set(cxobj *xn, 
 	       char  *prefix)
 {
-    if (xn->x_prefix){
-	free(xn->x_prefix);
-	xn->x_prefix = NULL;
-    }
-    if (prefix){
-	if ((xn->x_prefix = strdup(prefix)) == NULL){
-	    clicon_err(OE_XML, errno, "strdup");
-	    return -1;
-	}
-    }
+    char *iprefix = NULL;
+
+    if (prefix && (iprefix = clixon_string_intern(prefix)) == NULL)
+	return -1;
+    if (xn->x_prefix &&
+	clixon_string_release(xn->x_prefix) < 0)
+	return -1;
+    xn->x_prefix = iprefix;
     return 0;
 }
 
@@ -591,6 +647,8 @@ xml_parent_set(cxobj *xn,
 	       cxobj *parent)
 {
     xn->x_up = parent;
+    if (xml_type(xn) == CX_BODY) /* Typed value depends on parent yang type */
+	((struct xmlbody*)xn)->xb_vtype = XV_NONE;
     return 0;
 }
 
@@ -657,6 +715,58 @@ xml_flag_reset(cxobj   *xn,
     return 0;
 }
 
+/*! Make room for a value of a body or attribute node, keep existing value
+ * Short values are stored inline in the node. A separate buffer is allocated for 
+ * longer values, exactly at first and then doubled, to handle repeated appends.
+ * @param[in]  xb   Body or attribute node
+ * @param[in]  len  Length of value excluding null
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_value_reserve(struct xmlbody *xb,
+		  size_t          len)
+{
+    int    retval = -1;
+    size_t max;
+    char  *str;
+
+    if (xb->xb_max == 0){ /* No value */
+	xb->xb_max = XML_BODY_INLINE;
+	xb->xb_len = 0;
+	xb->xb_u.xb_inline[0] = '\0';
+    }
+    if (len + 1 <= xb->xb_max)
+	goto ok;
+    if (len >= UINT32_MAX/2){
+	clicon_err(OE_XML, EINVAL, "value too long: %zu", len);
+	goto done;
+    }
+    if (xb->xb_max > XML_BODY_INLINE){
+	max = xb->xb_max*2;
+	if (max < len + 1)
+	    max = len + 1;
+	if ((str = realloc(xb->xb_u.xb_heap, max)) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    goto done;
+	}
+    }
+    else {
+	max = len + 1;
+	if ((str = malloc(max)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	memcpy(str, xb->xb_u.xb_inline, xb->xb_len + 1);
+    }
+    xb->xb_u.xb_heap = str;
+    xb->xb_max = max;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Get value of xnode
  * @param[in]  xn    xml node
  * @retval     value of xml node
@@ -664,9 +774,14 @@ xml_flag_reset(cxobj   *xn,
 char*
 xml_value(cxobj *xn)
 {
+    struct xmlbody *xb;
+
     if (!is_bodyattr(xn))
 	return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    xb = (struct xmlbody*)xn;
+    if (xb->xb_max == 0)
+	return NULL;
+    return xml_body_str(xb);
 }
 
 /*! Set value of xml node, value is copied
@@ -679,8 +794,9 @@ int
 xml_value_set(cxobj *xn, 
 	      char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -688,16 +804,13 @@ xml_value_set(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
-	    goto done;
-	}
-    }
-    else
-	cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    xb = (struct xmlbody*)xn;
+    len = strlen(val);
+    if (xml_value_reserve(xb, len) < 0)
+	goto done;
+    memmove(xml_body_str(xb), val, len + 1); /* val may be the old value */
+    xb->xb_len = len;
+    xb->xb_vtype = XV_NONE;
     retval = 0;
  done:
     return retval;
@@ -713,8 +826,9 @@ int
 xml_value_append(cxobj *xn, 
 		 char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -722,22 +836,62 @@ xml_value_append(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
-	    goto done;
-	}
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-	clicon_err(OE_XML, errno, "cprintf");
+    xb = (struct xmlbody*)xn;
+    len = strlen(val);
+    if (xml_value_reserve(xb, xb->xb_len + len) < 0)
 	goto done;
-    }
+    memcpy(xml_body_str(xb) + xb->xb_len, val, len + 1);
+    xb->xb_len += len;
+    xb->xb_vtype = XV_NONE;
     retval = 0;
  done:
     return retval;
 }
 
+/*! Get typed value of body node
+ * The typed value is set by xml_cmp on first comparison using the yang type of the
+ * parent, and is reset when the value or the parent changes.
+ * @param[in]  xn    Body node
+ * @param[out] ival  Integer value if type is XV_INT or XV_UINT (uint64 cast to int64)
+ * @retval     type  Type of typed value, XV_NONE if not set
+ * @see xml_value_typed_set
+ */
+enum xml_value_type
+xml_value_typed_get(cxobj   *xn,
+		    int64_t *ival)
+{
+    struct xmlbody *xb;
+
+    if (xml_type(xn) != CX_BODY)
+	return XV_NONE;
+    xb = (struct xmlbody*)xn;
+    if (ival)
+	*ival = xb->xb_ival;
+    return xb->xb_vtype;
+}
+
+/*! Set typed value of body node
+ * @param[in]  xn    Body node
+ * @param[in]  vtype Type of value
+ * @param[in]  ival  Integer value if type is XV_INT or XV_UINT
+ * @retval     0     OK
+ * @see xml_value_typed_get
+ */
+int
+xml_value_typed_set(cxobj              *xn,
+		    enum xml_value_type vtype,
+		    int64_t             ival)
+{
+    struct xmlbody *xb;
+
+    if (xml_type(xn) != CX_BODY)
+	return 0;
+    xb = (struct xmlbody*)xn;
+    xb->xb_vtype = vtype;
+    xb->xb_ival = ival;
+    return 0;
+}
+
 /*! Get type of xnode
  * @param[in]  xn    xml node
  * @retval     type of xml node
@@ -1102,24 +1256,38 @@ xml_new(char           *name,
 {
     struct xml *x = NULL;
     size_t      sz;
+#ifdef XML_NODE_SLAB
+    struct xml_slab *xs;
+#endif
     
     switch (type){
     case CX_ELMNT:
 	sz = sizeof(struct xml);
+#ifdef XML_NODE_SLAB
+	xs = &_slab_elmnt;
+#endif
 	break;
     case CX_ATTR:
     case CX_BODY:
 	sz = sizeof(struct xmlbody);
+#ifdef XML_NODE_SLAB
+	xs = &_slab_body;
+#endif
 	break;
     default:
 	clicon_err(OE_XML, EINVAL, "Invalid type: %d", type);
 	return NULL;
 	break;
     }
+#ifdef XML_NODE_SLAB
+    if ((x = xml_slab_alloc(xs)) == NULL)
+	return NULL;
+#else
     if ((x = malloc(sz)) == NULL){
 	clicon_err(OE_XML, errno, "malloc");
 	return NULL;
     }
+#endif
     memset(x, 0, sz);
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
@@ -1186,45 +1354,18 @@ int
 xml_spec_set(cxobj     *x, 
 	     yang_stmt *spec)
 {
-    if (!is_element(x))
-	return 0;
-    x->x_spec = spec;
-    return 0;
-}
-
-/*! Return (cached)  cligen variable value of xml node
- * @param[in]  x    XML node (body and leaf/leaf-list)
- * @retval     cv   CLIgen variable containing value of x body
- * @retval     NULL
- * Only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Only accessed by xml_cv_cache as part of sorting in xml_cmp
- * @see xml_cv_cache
- */
-cg_var *
-xml_cv(cxobj *x)
-{
-    if (!is_element(x))
-	return NULL;
-    return x->x_cv;
-}
+    int    i;
+    cxobj *xc;
 
-/*! Set (cached) cligen variable value of xml node
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[in]  cv  CLIgen variable containing value of x body
- * @retval     0   OK
- * Only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Only accessed by xml_cv_cache as part of sorting in xml_cmp
- * @see xml_cv_cache
- */
-int
-xml_cv_set(cxobj  *x, 
-	   cg_var *cv)
-{
     if (!is_element(x))
 	return 0;
-    if (x->x_cv)
-	cv_free(x->x_cv);
-    x->x_cv = cv;
+    if (x->x_spec != spec){
+	/* Typed values of body children depend on yang type */
+	for (i=0; i<x->x_childvec_len; i++)
+	    if ((xc = x->x_childvec[i]) != NULL && xml_type(xc) == CX_BODY)
+		((struct xmlbody*)xc)->xb_vtype = XV_NONE;
+	x->x_spec = spec;
+    }
     return 0;
 }
 
@@ -1257,7 +1398,7 @@ xml_find(cxobj *xp,
     if (!is_element(xp))
 	return NULL;
     while ((x = xml_child_each(xp, x, -1)) != NULL) 
-	if (strcmp(name, xml_name(x)) == 0)
+	if (clixon_streq(name, xml_name(x)))
 	    break; /* x is set */
     return x;
 }
@@ -1761,7 +1902,7 @@ xml_find_type(cxobj           *xt,
 	}
 	else
 	    pmatch = 1;
-	if (pmatch && strcmp(name, xml_name(x)) == 0)
+	if (pmatch && clixon_streq(name, xml_name(x)))
 	    return x;
     }
     return NULL;
@@ -1870,9 +2011,9 @@ xml_free(cxobj *x)
 	return 0;
     }
     if (x->x_name)
-	free(x->x_name);
+	clixon_string_release(x->x_name);
     if (x->x_prefix)
-	free(x->x_prefix);
+	clixon_string_release(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
 	for (i=0; i<x->x_childvec_len; i++){
@@ -1883,8 +2024,6 @@ xml_free(cxobj *x)
 	}
 	if (x->x_childvec)
 	    free(x->x_childvec);
-	if (x->x_cv)
-	    cv_free(x->x_cv);
 	if (x->x_ns_cache)
 	    xml_nsctx_free(x->x_ns_cache);
 #ifdef XML_EXPLICIT_INDEX
@@ -1893,13 +2032,17 @@ xml_free(cxobj *x)
 	break;
     case CX_BODY:
     case CX_ATTR:
-	if (x->x_value_cb)
-	    cbuf_free(x->x_value_cb);  
+	if (((struct xmlbody*)x)->xb_max > XML_BODY_INLINE)
+	    free(((struct xmlbody*)x)->xb_u.xb_heap);
 	break;
     default:
 	break;
     }
+#ifdef XML_NODE_SLAB
+    xml_slab_free(xml_type(x)==CX_ELMNT?&_slab_elmnt:&_slab_body, x);
+#else
     free(x);
+#endif
     _stats_nr--;
     return 0;
 }
@@ -1937,13 +2080,14 @@ xml_copy_one(cxobj *x0,
 	if ((s = xml_value(x0))){ /* malloced string */
 	    if (xml_value_set(x1, s) < 0)
 		goto done;
-
+	    ((struct xmlbody*)x1)->xb_vtype = ((struct xmlbody*)x0)->xb_vtype;
+	    ((struct xmlbody*)x1)->xb_ival = ((struct xmlbody*)x0)->xb_ival;
 	}
 	break;
     default:
 	break;
     }
-    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP)); /* Maybe more flags */
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_DIRTY)); /* Maybe more flags */
     retval = 0;
  done:
     return retval;
@@ -0,0 +1,594 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary encoding of XML trees, used for internal IPC between clients and backend
+ * as an alternative to XML text.
+ *
+ * Format (all integers are unsigned LEB128 varints):
+ *   magic     '\0' followed by CLIXON_BIN_MAGIC. A null first byte separates it from XML text
+ *   version   1 byte
+ *   nstr      Number of interned strings
+ *   nstr x    String: len, bytes, '\0'
+ *   node      The encoded tree, recursively:
+ *     CX_ELMNT: type, name index, prefix index+1 (0: none), nr of children, children
+ *     CX_ATTR:  type, name index, prefix index+1, value
+ *     CX_BODY:  type, value
+ *     BIN_NSATTR: type, name index, prefix index+1, value index (namespace declarations)
+ *   where value is: len, bytes, '\0'
+ * Element and attribute names, prefixes and namespaces are interned in the string table.
+ * Strings are null-terminated in the encoding so that the decoder can use them in place.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_bin.h"
+
+/*
+ * Constants
+ */
+/* Version of binary encoding */
+#define BIN_VERSION 1
+
+/* Node type of namespace declaration attribute, value is interned */
+#define BIN_NSATTR  3
+
+/* Max nesting of decoded tree, sanity check of input */
+#define BIN_DEPTH_MAX 10000
+
+/*
+ * Types
+ */
+/* Encoding buffer */
+typedef struct {
+    char   *bb_buf;
+    size_t  bb_len;
+    size_t  bb_max;
+    clicon_hash_t *bb_strtab; /* Interned strings: string -> index */
+    char  **bb_strvec;        /* Interned strings in index order */
+    size_t  bb_strlen;
+} bin_buf;
+
+/* Decoding cursor */
+typedef struct {
+    char   *bd_p;
+    char   *bd_end;
+    char  **bd_strvec;        /* Interned strings, pointing into buffer */
+    size_t  bd_strlen;
+} bin_dec;
+
+/*---------------------------------------------------------------------
+ * Encode
+ */
+
+static int
+bb_grow(bin_buf *bb,
+	size_t   n)
+{
+    size_t max;
+
+    if (bb->bb_len + n <= bb->bb_max)
+	return 0;
+    max = bb->bb_max ? bb->bb_max : 1024;
+    while (max < bb->bb_len + n)
+	max *= 2;
+    if ((bb->bb_buf = realloc(bb->bb_buf, max)) == NULL){
+	clicon_err(OE_XML, errno, "realloc");
+	return -1;
+    }
+    bb->bb_max = max;
+    return 0;
+}
+
+static int
+bb_varint(bin_buf *bb,
+	  size_t   u)
+{
+    if (bb_grow(bb, 10) < 0)
+	return -1;
+    while (u >= 0x80){
+	bb->bb_buf[bb->bb_len++] = (char)((u & 0x7f) | 0x80);
+	u >>= 7;
+    }
+    bb->bb_buf[bb->bb_len++] = (char)u;
+    return 0;
+}
+
+/*! Append string as length, bytes and null-termination */
+static int
+bb_str(bin_buf    *bb,
+       const char *str)
+{
+    size_t len = strlen(str);
+
+    if (bb_varint(bb, len) < 0 ||
+	bb_grow(bb, len+1) < 0)
+	return -1;
+    memcpy(bb->bb_buf + bb->bb_len, str, len+1);
+    bb->bb_len += len+1;
+    return 0;
+}
+
+/*! Add string to string table if not already present */
+static int
+bb_intern(bin_buf *bb,
+	  char    *str)
+{
+    size_t i;
+
+    if (str == NULL || clicon_hash_lookup(bb->bb_strtab, str) != NULL)
+	return 0;
+    i = bb->bb_strlen;
+    if (clicon_hash_add(bb->bb_strtab, str, &i, sizeof(i)) == NULL)
+	return -1;
+    if ((bb->bb_strvec = realloc(bb->bb_strvec, (i+1)*sizeof(char*))) == NULL){
+	clicon_err(OE_XML, errno, "realloc");
+	return -1;
+    }
+    bb->bb_strvec[bb->bb_strlen++] = str;
+    return 0;
+}
+
+/*! Append index of interned string, or index+1 if optional (0 is NULL) */
+static int
+bb_stridx(bin_buf *bb,
+	  char    *str,
+	  int      optional)
+{
+    size_t *ip;
+    size_t  len;
+
+    if (str == NULL)
+	return bb_varint(bb, 0);
+    if ((ip = clicon_hash_value(bb->bb_strtab, str, &len)) == NULL){
+	clicon_err(OE_XML, ENOENT, "%s not interned", str);
+	return -1;
+    }
+    return bb_varint(bb, *ip + (optional?1:0));
+}
+
+/*! Attribute is a namespace declaration: xmlns or xmlns:prefix */
+static int
+bin_isnsattr(cxobj *x)
+{
+    char *prefix = xml_prefix(x);
+
+    if (prefix == NULL)
+	return strcmp(xml_name(x), "xmlns") == 0;
+    return strcmp(prefix, "xmlns") == 0;
+}
+
+/*! Return if a child is encoded, same rules as clicon_xml2cbuf */
+static int
+bin_child_enc(cxobj  *xc,
+	      int32_t depth)
+{
+    switch (xml_type(xc)){
+    case CX_ATTR:
+	return xml_value(xc) != NULL;
+    case CX_BODY:
+	return depth-1 != 0 && xml_value(xc) != NULL;
+    case CX_ELMNT:
+	return depth-1 != 0;
+    default:
+	return 0;
+    }
+}
+
+/*! Intern all names, prefixes and namespaces of a tree */
+static int
+bin_intern_tree(bin_buf *bb,
+		cxobj   *x,
+		int32_t  depth)
+{
+    cxobj *xc;
+
+    if (bb_intern(bb, xml_name(x)) < 0 ||
+	bb_intern(bb, xml_prefix(x)) < 0)
+	return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL){
+	if (!bin_child_enc(xc, depth))
+	    continue;
+	switch (xml_type(xc)){
+	case CX_ATTR:
+	    if (bb_intern(bb, xml_name(xc)) < 0 ||
+		bb_intern(bb, xml_prefix(xc)) < 0)
+		return -1;
+	    if (bin_isnsattr(xc) &&
+		bb_intern(bb, xml_value(xc)) < 0)
+		return -1;
+	    break;
+	case CX_ELMNT:
+	    if (bin_intern_tree(bb, xc, depth-1) < 0)
+		return -1;
+	    break;
+	default:
+	    break;
+	}
+    }
+    return 0;
+}
+
+/*! Encode element and its children */
+static int
+bin_enc_tree(bin_buf *bb,
+	     cxobj   *x,
+	     int32_t  depth)
+{
+    cxobj *xc;
+    size_t n = 0;
+
+    if (bb_varint(bb, CX_ELMNT) < 0 ||
+	bb_stridx(bb, xml_name(x), 0) < 0 ||
+	bb_stridx(bb, xml_prefix(x), 1) < 0)
+	return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL)
+	if (bin_child_enc(xc, depth))
+	    n++;
+    if (bb_varint(bb, n) < 0)
+	return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL){
+	if (!bin_child_enc(xc, depth))
+	    continue;
+	switch (xml_type(xc)){
+	case CX_ATTR:
+	    if (bin_isnsattr(xc)){
+		if (bb_varint(bb, BIN_NSATTR) < 0 ||
+		    bb_stridx(bb, xml_name(xc), 0) < 0 ||
+		    bb_stridx(bb, xml_prefix(xc), 1) < 0 ||
+		    bb_stridx(bb, xml_value(xc), 0) < 0)
+		    return -1;
+	    }
+	    else if (bb_varint(bb, CX_ATTR) < 0 ||
+		     bb_stridx(bb, xml_name(xc), 0) < 0 ||
+		     bb_stridx(bb, xml_prefix(xc), 1) < 0 ||
+		     bb_str(bb, xml_value(xc)) < 0)
+		return -1;
+	    break;
+	case CX_BODY:
+	    if (bb_varint(bb, CX_BODY) < 0 ||
+		bb_str(bb, xml_value(xc)) < 0)
+		return -1;
+	    break;
+	case CX_ELMNT:
+	    if (bin_enc_tree(bb, xc, depth-1) < 0)
+		return -1;
+	    break;
+	default:
+	    break;
+	}
+    }
+    return 0;
+}
+
+/*! Encode XML tree in binary form
+ *
+ * @param[in]  x       XML element to encode (including x itself)
+ * @param[in]  depth   Limit levels of child resources: -1 is all, see clicon_xml2cbuf
+ * @param[in]  hdrlen  Reserve this many bytes before the encoding, eg for a message header
+ * @param[out] bufp    Malloced buffer with hdrlen bytes followed by encoding. Free with free()
+ * @param[out] lenp    Length of buffer including hdrlen
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_bin2xml  For decoding
+ * @see clicon_xml2cbuf For text encoding
+ */
+int
+clixon_xml2bin(cxobj   *x,
+	       int32_t  depth,
+	       size_t   hdrlen,
+	       char   **bufp,
+	       size_t  *lenp)
+{
+    int     retval = -1;
+    bin_buf bb = {0,};
+    size_t  i;
+
+    if (x == NULL || xml_type(x) != CX_ELMNT || depth == 0){
+	clicon_err(OE_XML, EINVAL, "Expected XML element");
+	goto done;
+    }
+    if ((bb.bb_strtab = clicon_hash_init()) == NULL)
+	goto done;
+    if (bin_intern_tree(&bb, x, depth) < 0)
+	goto done;
+    if (bb_grow(&bb, hdrlen + strlen(CLIXON_BIN_MAGIC) + 2) < 0)
+	goto done;
+    memset(bb.bb_buf, 0, hdrlen+1);
+    bb.bb_len = hdrlen + 1; /* magic starts with null */
+    memcpy(bb.bb_buf + bb.bb_len, CLIXON_BIN_MAGIC, strlen(CLIXON_BIN_MAGIC));
+    bb.bb_len += strlen(CLIXON_BIN_MAGIC);
+    bb.bb_buf[bb.bb_len++] = BIN_VERSION;
+    if (bb_varint(&bb, bb.bb_strlen) < 0)
+	goto done;
+    for (i=0; i<bb.bb_strlen; i++)
+	if (bb_str(&bb, bb.bb_strvec[i]) < 0)
+	    goto done;
+    if (bin_enc_tree(&bb, x, depth) < 0)
+	goto done;
+    *bufp = bb.bb_buf;
+    *lenp = bb.bb_len;
+    bb.bb_buf = NULL;
+    retval = 0;
+ done:
+    if (bb.bb_buf)
+	free(bb.bb_buf);
+    if (bb.bb_strvec)
+	free(bb.bb_strvec);
+    if (bb.bb_strtab)
+	clicon_hash_free(bb.bb_strtab);
+    return retval;
+}
+
+/*---------------------------------------------------------------------
+ * Decode
+ */
+
+static int
+bd_varint(bin_dec *bd,
+	  size_t  *u)
+{
+    size_t  v = 0;
+    int     shift = 0;
+    uint8_t c;
+
+    do {
+	if (bd->bd_p >= bd->bd_end || shift > 56)
+	    return -1;
+	c = (uint8_t)*bd->bd_p++;
+	v |= (size_t)(c & 0x7f) << shift;
+	shift += 7;
+    } while (c & 0x80);
+    *u = v;
+    return 0;
+}
+
+/*! Get null-terminated string in place */
+static int
+bd_str(bin_dec *bd,
+       char   **str)
+{
+    size_t len;
+
+    if (bd_varint(bd, &len) < 0 ||
+	len >= (size_t)(bd->bd_end - bd->bd_p) ||
+	bd->bd_p[len] != '\0')
+	return -1;
+    *str = bd->bd_p;
+    bd->bd_p += len+1;
+    return 0;
+}
+
+/*! Get interned string, optional index is index+1 where 0 is NULL */
+static int
+bd_stridx(bin_dec *bd,
+	  int      optional,
+	  char   **str)
+{
+    size_t i;
+
+    if (bd_varint(bd, &i) < 0)
+	return -1;
+    if (optional){
+	if (i == 0){
+	    *str = NULL;
+	    return 0;
+	}
+	i--;
+    }
+    if (i >= bd->bd_strlen)
+	return -1;
+    *str = bd->bd_strvec[i];
+    return 0;
+}
+
+/*! Decode a node and add it to parent 
+ * @retval  1  OK
+ * @retval  0  Malformed input
+ * @retval -1  Error
+ */
+static int
+bin_dec_node(bin_dec *bd,
+	     cxobj   *xp,
+	     int      level)
+{
+    size_t type;
+    size_t n;
+    size_t i;
+    char  *name;
+    char  *prefix;
+    char  *val;
+    cxobj *x;
+    int    ret;
+
+    if (level > BIN_DEPTH_MAX)
+	return 0;
+    if (bd_varint(bd, &type) < 0)
+	return 0;
+    switch (type){
+    case CX_ELMNT:
+	if (bd_stridx(bd, 0, &name) < 0 ||
+	    bd_stridx(bd, 1, &prefix) < 0 ||
+	    bd_varint(bd, &n) < 0 ||
+	    n > (size_t)(bd->bd_end - bd->bd_p))
+	    return 0;
+	if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+	    return -1;
+	if (prefix && xml_prefix_set(x, prefix) < 0)
+	    return -1;
+	for (i=0; i<n; i++)
+	    if ((ret = bin_dec_node(bd, x, level+1)) < 1)
+		return ret;
+	break;
+    case CX_ATTR:
+    case BIN_NSATTR:
+	if (bd_stridx(bd, 0, &name) < 0 ||
+	    bd_stridx(bd, 1, &prefix) < 0)
+	    return 0;
+	if (type == BIN_NSATTR){
+	    if (bd_stridx(bd, 0, &val) < 0)
+		return 0;
+	}
+	else if (bd_str(bd, &val) < 0)
+	    return 0;
+	if ((x = xml_new(name, xp, CX_ATTR)) == NULL)
+	    return -1;
+	if (prefix && xml_prefix_set(x, prefix) < 0)
+	    return -1;
+	if (xml_value_set(x, val) < 0)
+	    return -1;
+	break;
+    case CX_BODY:
+	if (bd_str(bd, &val) < 0)
+	    return 0;
+	if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+	    return -1;
+	if (xml_value_set(x, val) < 0)
+	    return -1;
+	break;
+    default:
+	return 0;
+    }
+    return 1;
+}
+
+/*! Check if buffer contains binary encoded XML
+ * @param[in]  buf  Buffer
+ * @param[in]  len  Length of buffer
+ * @retval     1    Binary encoding
+ * @retval     0    Not binary, eg XML text
+ */
+int
+clixon_bin_detect(const char *buf,
+		  size_t      len)
+{
+    return len > strlen(CLIXON_BIN_MAGIC)+1 && /* null, magic, version */
+	buf[0] == '\0' &&
+	memcmp(buf+1, CLIXON_BIN_MAGIC, strlen(CLIXON_BIN_MAGIC)) == 0;
+}
+
+/*! Decode binary encoded XML tree
+ *
+ * Strings are used in place, the buffer is not modified.
+ * @param[in]     buf   Buffer with encoding as produced by clixon_xml2bin (without hdrlen)
+ * @param[in]     len   Length of buffer
+ * @param[in,out] xt    Pointer to XML tree. If empty, create "top". Decoded element is added
+ * @retval        0     OK
+ * @retval       -1     Error with clicon_err called. Includes malformed input. 
+ *                      Nothing is added to xt
+ * @see clixon_xml2bin
+ * @note No yang binding is made
+ */
+int
+clixon_bin2xml(char    *buf,
+	       size_t   len,
+	       cxobj  **xt)
+{
+    int     retval = -1;
+    bin_dec bd = {0,};
+    size_t  n;
+    size_t  i;
+    cxobj  *xtop = NULL;
+    int     ret;
+    int     nr = -1;  /* Number of children of xt before decoding */
+
+    if (!clixon_bin_detect(buf, len) ||
+	(uint8_t)buf[strlen(CLIXON_BIN_MAGIC)+1] != BIN_VERSION){
+	clicon_err(OE_XML, EINVAL, "Not binary XML or wrong version");
+	goto done;
+    }
+    bd.bd_p = buf + strlen(CLIXON_BIN_MAGIC) + 2;
+    bd.bd_end = buf + len;
+    if (bd_varint(&bd, &n) < 0 ||
+	n > (size_t)(bd.bd_end - bd.bd_p))
+	goto malformed;
+    if (n && (bd.bd_strvec = calloc(n, sizeof(char*))) == NULL){
+	clicon_err(OE_XML, errno, "calloc");
+	goto done;
+    }
+    bd.bd_strlen = n;
+    for (i=0; i<n; i++)
+	if (bd_str(&bd, &bd.bd_strvec[i]) < 0)
+	    goto malformed;
+    if (*xt == NULL){
+	if ((xtop = xml_new("top", NULL, CX_ELMNT)) == NULL)
+	    goto done;
+	*xt = xtop;
+    }
+    nr = xml_child_nr(*xt);
+    if ((ret = bin_dec_node(&bd, *xt, 0)) < 0)
+	goto done;
+    if (ret == 0)
+	goto malformed;
+    if (bd.bd_p != bd.bd_end)
+	goto malformed;
+    xtop = NULL;
+    retval = 0;
+ done:
+    if (retval < 0 && xtop){
+	xml_free(xtop);
+	*xt = NULL;
+    }
+    else if (retval < 0 && nr >= 0){
+	/* Remove what was decoded before the error from the caller's tree */
+	while (xml_child_nr(*xt) > nr)
+	    xml_purge(xml_child_i(*xt, nr));
+    }
+    if (bd.bd_strvec)
+	free(bd.bd_strvec);
+    return retval;
+ malformed:
+    clicon_err(OE_XML, EINVAL, "Malformed binary XML");
+    goto done;
+}
@@ -83,6 +83,28 @@
 /* Indentation for xml pretty-print. Consider option? */
 #define XML_INDENT 3
 
+/*
+ * Types
+ */
+/* Element started but not ended by clicon_xml2cbuf_step */
+struct xml2cbuf_frame{
+    cxobj  *xf_x;       /* Element */
+    cxobj  *xf_xc;      /* Last printed child, or NULL */
+    int32_t xf_depth;   /* Depth of element, see clicon_xml2cbuf */
+    int     xf_hasbody; /* Element has body, see xml2cbuf_elmnt_end */
+};
+
+/* Position of an XML tree printed in steps, see clicon_xml2cbuf_step */
+struct xml2cbuf_pos{
+    cxobj                 *xp_x;           /* Top of tree if not started, else NULL */
+    int                    xp_level;       /* Indentation level of top */
+    int                    xp_prettyprint; /* Insert \n and spaces */
+    int32_t                xp_depth;       /* Depth of top */
+    struct xml2cbuf_frame *xp_stack;       /* Started elements, innermost last */
+    int                    xp_len;         /* Number of started elements */
+    int                    xp_max;         /* Allocated length of xp_stack */
+};
+
 /*------------------------------------------------------------------------
  * XML printing functions. Output a parse tree to file, string cligen buf
  *------------------------------------------------------------------------*/
@@ -245,38 +267,124 @@ xml_print(FILE  *f,
     return xml2file_recurse(f, x, 0, 1, fprintf);
 }
 
-/*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
- *
+static int xml2cbuf_recurse(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth,
+			    size_t threshold, clicon_xml_flush_cb *fn, void *arg);
+
+/*! Print start tag and attributes of an XML element to a cligen buffer
+ * An element without body and element children is printed as <a/>
  * @param[in,out] cb          Cligen buffer to write to
- * @param[in]     xn          Clicon xml tree
+ * @param[in]     x           XML element
  * @param[in]     level       Indentation level for prettyprint
- * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
- * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
- *
- * @code
- * cbuf *cb;
- * cb = cbuf_new();
- * if (clicon_xml2cbuf(cb, xn, 0, 1, -1) < 0)
- *   goto err;
- * fprintf(stderr, "%s", cbuf_get(cb));
- * cbuf_free(cb);
- * @endcode
- * @see  clicon_xml2file
+ * @param[in]     prettyprint Insert \n and spaces tomake the xml more readable.
+ * @param[out]    hasbody     Element has a body, argument to xml2cbuf_elmnt_end
+ * @retval        1           Start tag printed, print children and end tag
+ * @retval        0           Empty element printed
+ * @retval       -1           Error
+ * @see xml2cbuf_elmnt_end
  */
-int
-clicon_xml2cbuf(cbuf   *cb, 
-		cxobj  *x, 
-		int     level,
-		int     prettyprint,
-		int32_t depth)
+static int
+xml2cbuf_elmnt_start(cbuf  *cb,
+		     cxobj *x,
+		     int    level,
+		     int    prettyprint,
+		     int   *hasbody)
+{
+    cxobj *xc;
+    char  *namespace;
+    int    haselement;
+
+    namespace = xml_prefix(x);
+    if (prettyprint)
+	cprintf(cb, "%*s<", level*XML_INDENT, "");
+    else
+	cbuf_append_str(cb, "<");
+    if (namespace){
+	cbuf_append_str(cb, namespace);
+	cbuf_append_str(cb, ":");
+    }
+    cbuf_append_str(cb, xml_name(x));
+    *hasbody = 0;
+    haselement = 0;
+    xc = NULL;
+    /* print attributes only */
+    while ((xc = xml_child_each(x, xc, -1)) != NULL)
+	switch (xml_type(xc)){
+	case CX_ATTR:
+	    if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, -1, 0, NULL, NULL) < 0)
+		return -1;
+	    break;
+	case CX_BODY:
+	    *hasbody=1;
+	    break;
+	case CX_ELMNT:
+	    haselement=1;
+	    break;
+	default:
+	    break;
+	}
+    /* Check for special case <a/> instead of <a></a> */
+    if (*hasbody==0 && haselement==0){
+	cbuf_append_str(cb, "/>");
+	if (prettyprint)
+	    cbuf_append_str(cb, "\n");
+	return 0;
+    }
+    cbuf_append_str(cb, ">");
+    if (prettyprint && *hasbody == 0)
+	cbuf_append_str(cb, "\n");
+    return 1;
+}
+
+/*! Print end tag of an XML element to a cligen buffer
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     x           XML element
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint Insert \n and spaces tomake the xml more readable.
+ * @param[in]     hasbody     Element has a body, see xml2cbuf_elmnt_start
+ */
+static void
+xml2cbuf_elmnt_end(cbuf  *cb,
+		   cxobj *x,
+		   int    level,
+		   int    prettyprint,
+		   int    hasbody)
+{
+    char *namespace;
+
+    namespace = xml_prefix(x);
+    if (prettyprint && hasbody == 0)
+	cprintf(cb, "%*s", level*XML_INDENT, "");
+    cbuf_append_str(cb, "</");
+    if (namespace){
+	cbuf_append_str(cb, namespace);
+	cbuf_append_str(cb, ":");
+    }
+    cbuf_append_str(cb, xml_name(x));
+    cbuf_append_str(cb, ">");
+    if (prettyprint)
+	cbuf_append_str(cb, "\n");
+}
+
+/*! Print an XML tree structure to a cligen buffer, flush buffer using a callback
+ * @see clicon_xml2cbuf_flush
+ */
+static int
+xml2cbuf_recurse(cbuf                *cb, 
+		 cxobj               *x, 
+		 int                  level,
+		 int                  prettyprint,
+		 int32_t              depth,
+		 size_t               threshold,
+		 clicon_xml_flush_cb *fn,
+		 void                *arg)
 {
     int    retval = -1;
     cxobj *xc;
     char  *name;
     int    hasbody;
-    int    haselement;
     char  *namespace;
     char  *val;
+    int    ret;
     
     if (depth == 0)
 	goto ok;
@@ -298,68 +406,234 @@ clicon_xml2cbuf(cbuf   *cb,
 	cprintf(cb, "%s=\"%s\"", name, xml_value(x));
 	break;
     case CX_ELMNT:
-	if (prettyprint)
-	    cprintf(cb, "%*s<", level*XML_INDENT, "");
-	else
-	    cbuf_append_str(cb, "<");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cbuf_append_str(cb, name);
-	hasbody = 0;
-	haselement = 0;
+	if ((ret = xml2cbuf_elmnt_start(cb, x, level, prettyprint, &hasbody)) < 0)
+	    goto done;
+	if (ret == 0) /* <a/> */
+	    break;
 	xc = NULL;
-	/* print attributes only */
 	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-	    switch (xml_type(xc)){
-	    case CX_ATTR:
-		if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, -1) < 0)
+	    if (xml_type(xc) != CX_ATTR)
+		if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, depth-1, threshold, fn, arg) < 0)
 		    goto done;
-		break;
-	    case CX_BODY:
-		hasbody=1;
-		break;
-	    case CX_ELMNT:
-		haselement=1;
-		break;
-	    default:
-		break;
-	    }
-	/* Check for special case <a/> instead of <a></a> */
-	if (hasbody==0 && haselement==0) 
-	    cbuf_append_str(cb, "/>");
-	else{
-	    cbuf_append_str(cb, ">");
-	    if (prettyprint && hasbody == 0)
-		cbuf_append_str(cb, "\n");
-	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-		if (xml_type(xc) != CX_ATTR)
-		    if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, depth-1) < 0)
-			goto done;
-	    if (prettyprint && hasbody == 0)
-		cprintf(cb, "%*s", level*XML_INDENT, "");
-	    cbuf_append_str(cb, "</");
-	    if (namespace){
-		cbuf_append_str(cb, namespace);
-		cbuf_append_str(cb, ":");
-	    }
-	    cbuf_append_str(cb, name);
-	    cbuf_append_str(cb, ">");
-	}
-	if (prettyprint)
-	    cbuf_append_str(cb, "\n");
+	xml2cbuf_elmnt_end(cb, x, level, prettyprint, hasbody);
 	break;
     default:
 	break;
     }/* switch */
+    if (fn && cbuf_len(cb) >= threshold){
+	if ((*fn)(cb, arg) < 0)
+	    goto done;
+	cbuf_reset(cb);
+    }
  ok:
     retval = 0;
  done:
     return retval;
 }
 
+
+/*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
+ *
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ *
+ * @code
+ * cbuf *cb;
+ * cb = cbuf_new();
+ * if (clicon_xml2cbuf(cb, xn, 0, 1, -1) < 0)
+ *   goto err;
+ * fprintf(stderr, "%s", cbuf_get(cb));
+ * cbuf_free(cb);
+ * @endcode
+ * @see  clicon_xml2file
+ * @see  clicon_xml2cbuf_flush  bounded buffer
+ */
+int
+clicon_xml2cbuf(cbuf   *cb, 
+		cxobj  *x, 
+		int     level,
+		int     prettyprint,
+		int32_t depth)
+{
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, 0, NULL, NULL);
+}
+
+/*! Print an XML tree structure to a cligen buffer of bounded size
+ *
+ * As clicon_xml2cbuf, but whenever the buffer exceeds a threshold, the flush callback is
+ * called with the buffer after which the buffer is reset. The printed string is the
+ * concatenation of all flushed buffers and what remains in cb on return.
+ * The buffer size is bounded by threshold plus the size of a single node.
+ * @param[in,out] cb          Cligen buffer to write to, remaining printed string on return
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     threshold   Flush buffer when its length exceeds this value
+ * @param[in]     fn          Flush callback
+ * @param[in]     arg         Argument to flush callback
+ * @retval        0           OK
+ * @retval       -1           Error, also if flush callback fails
+ * @see  send_msg_reply_stream
+ */
+int
+clicon_xml2cbuf_flush(cbuf                *cb, 
+		      cxobj               *x, 
+		      int                  level,
+		      int                  prettyprint,
+		      int32_t              depth,
+		      size_t               threshold,
+		      clicon_xml_flush_cb *fn,
+		      void                *arg)
+{
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, threshold, fn, arg);
+}
+
+/*! Create a position for printing an XML tree in steps
+ * @param[in]  x           Clicon xml tree. Must not be changed or freed until printed
+ * @param[in]  level       Indentation level for prettyprint
+ * @param[in]  prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]  depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @retval     xp          Position at start of tree. Free with clicon_xml2cbuf_pos_free
+ * @retval     NULL        Error
+ * @see clicon_xml2cbuf_step
+ */
+xml2cbuf_pos *
+clicon_xml2cbuf_pos_new(cxobj  *x,
+			int     level,
+			int     prettyprint,
+			int32_t depth)
+{
+    xml2cbuf_pos *xp;
+
+    if ((xp = malloc(sizeof(*xp))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return NULL;
+    }
+    memset(xp, 0, sizeof(*xp));
+    xp->xp_x = x;
+    xp->xp_level = level;
+    xp->xp_prettyprint = prettyprint;
+    xp->xp_depth = depth;
+    return xp;
+}
+
+/*! Free a position for printing an XML tree in steps
+ * @param[in]  xp  Position, see clicon_xml2cbuf_pos_new
+ */
+int
+clicon_xml2cbuf_pos_free(xml2cbuf_pos *xp)
+{
+    if (xp->xp_stack)
+	free(xp->xp_stack);
+    free(xp);
+    return 0;
+}
+
+/*! Print a node of a tree printed in steps, and start it if it is an element
+ * @param[in,out] cb     Cligen buffer to write to
+ * @param[in]     xp     Position, the element is pushed on its stack
+ * @param[in]     x      XML node
+ * @param[in]     depth  Depth of node, see clicon_xml2cbuf
+ * @retval        0      OK
+ * @retval       -1      Error
+ */
+static int
+xml2cbuf_pos_push(cbuf         *cb,
+		  xml2cbuf_pos *xp,
+		  cxobj        *x,
+		  int32_t       depth)
+{
+    struct xml2cbuf_frame *xf;
+    int                    level;
+    int                    hasbody;
+    int                    ret;
+
+    if (depth == 0)
+	return 0;
+    level = xp->xp_level + xp->xp_len;
+    if (xml_type(x) != CX_ELMNT)
+	return xml2cbuf_recurse(cb, x, level, xp->xp_prettyprint, depth, 0, NULL, NULL);
+    if ((ret = xml2cbuf_elmnt_start(cb, x, level, xp->xp_prettyprint, &hasbody)) < 0)
+	return -1;
+    if (ret == 0) /* <a/> */
+	return 0;
+    if (xp->xp_len == xp->xp_max){
+	xp->xp_max = xp->xp_max ? 2*xp->xp_max : 16;
+	if ((xf = realloc(xp->xp_stack, xp->xp_max*sizeof(*xf))) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return -1;
+	}
+	xp->xp_stack = xf;
+    }
+    xf = &xp->xp_stack[xp->xp_len++];
+    xf->xf_x = x;
+    xf->xf_xc = NULL;
+    xf->xf_depth = depth;
+    xf->xf_hasbody = hasbody;
+    return 0;
+}
+
+/*! Print the next part of an XML tree to a cligen buffer
+ *
+ * Print from the position until the buffer length exceeds a threshold, and save the
+ * position so that the next call continues from there. Unlike clicon_xml2cbuf_flush,
+ * the caller may return to an event loop between calls, eg to wait until a socket
+ * is writable. The printed string is the same as with clicon_xml2cbuf.
+ * The tree must not be changed between calls.
+ * @param[in,out] cb          Cligen buffer to append to
+ * @param[in]     xp          Position, see clicon_xml2cbuf_pos_new
+ * @param[in]     threshold   Return when buffer length exceeds this value
+ * @retval        1           Whole tree printed
+ * @retval        0           More to print
+ * @retval       -1           Error
+ * @code
+ *  if ((xp = clicon_xml2cbuf_pos_new(x, 0, 0, -1)) == NULL)
+ *     goto err;
+ *  while ((ret = clicon_xml2cbuf_step(cb, xp, 65536)) == 0){
+ *     write(s, cbuf_get(cb), cbuf_len(cb));
+ *     cbuf_reset(cb);
+ *  }
+ *  clicon_xml2cbuf_pos_free(xp);
+ * @endcode
+ */
+int
+clicon_xml2cbuf_step(cbuf         *cb,
+		     xml2cbuf_pos *xp,
+		     size_t        threshold)
+{
+    struct xml2cbuf_frame *xf;
+    cxobj                 *x;
+    cxobj                 *xc;
+
+    if ((x = xp->xp_x) != NULL){ /* Start at top */
+	xp->xp_x = NULL;
+	if (xml2cbuf_pos_push(cb, xp, x, xp->xp_depth) < 0)
+	    return -1;
+    }
+    while (xp->xp_len > 0 && cbuf_len(cb) < threshold){
+	xf = &xp->xp_stack[xp->xp_len-1];
+	xc = xf->xf_xc;
+	while ((xc = xml_child_each(xf->xf_x, xc, -1)) != NULL &&
+	       xml_type(xc) == CX_ATTR)
+	    ;
+	if (xc == NULL){ /* All children printed */
+	    xml2cbuf_elmnt_end(cb, xf->xf_x, xp->xp_level + xp->xp_len - 1,
+			       xp->xp_prettyprint, xf->xf_hasbody);
+	    xp->xp_len--;
+	    continue;
+	}
+	xf->xf_xc = xc;
+	/* May reallocate stack */
+	if (xml2cbuf_pos_push(cb, xp, xc, xf->xf_depth-1) < 0)
+	    return -1;
+    }
+    return xp->xp_len == 0 ? 1 : 0;
+}
+
 /*! Return an xml tree as a pretty-printed malloced string.
  * @param[in]  x    XML tree
  * @retval     str  Malloced pretty-printed string (should be free:d after use)
@@ -472,10 +746,8 @@ _xml_parse(const char *str,
 	clicon_err(OE_XML, errno, "Unexpected NULL XML");
 	return -1;	
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-	clicon_err(OE_XML, errno, "strdup");
-	return -1;
-    }
+    /* No copy needed, the scanner copies the string to its own buffer */
+    xy.xy_parse_string = str;
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
@@ -544,8 +816,6 @@ _xml_parse(const char *str,
     retval = 1;
   done:
     clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
-	free(xy.xy_parse_string);
     if (xy.xy_xvec)
 	free(xy.xy_xvec);
     return retval; 
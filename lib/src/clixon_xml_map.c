@@ -543,11 +543,14 @@ cvec2xml_1(cvec   *cvv,
  * (*) "comparing" a&b here is made by xml_cmp() which judges equality from a structural
  *     perspective, ie both have the same yang spec, if they are lists, they have the
  *     the same keys. NOT that the values are equal!
+ * If dirty is set, containers and lists in x1 not marked with XML_FLAG_DIRTY are
+ * assumed to be equal to their x0 counterpart and are not traversed.
  * @see xml_diff  API function, this one is internal and recursive
  */
 static int
 xml_diff1(cxobj     *x0, 
 	  cxobj     *x1,
+	  int        dirty,
 	  cxobj   ***x0vec,
 	  int       *x0veclen,
 	  cxobj   ***x1vec,
@@ -616,7 +619,11 @@ xml_diff1(cxobj     *x0,
 			goto done;
 		}
 	    }
-	    else if (xml_diff1(x0c, x1c,   
+	    else if (dirty && yc && xml_flag(x1c, XML_FLAG_DIRTY) == 0 &&
+		     (yang_keyword_get(yc) == Y_CONTAINER ||
+		      yang_keyword_get(yc) == Y_LIST))
+		; /* Not edited since x1 was equal to x0 */
+	    else if (xml_diff1(x0c, x1c, dirty,
 			       x0vec, x0veclen, 
 			       x1vec, x1veclen, 
 			       changed_x0, changed_x1, changedlen)< 0)
@@ -643,6 +650,9 @@ xml_diff1(cxobj     *x0,
  * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
  * @param[out] changedlen Length of changed vector
  * All xml vectors should be freed after use.
+ * If x1 has XML_FLAG_DIFFDIRTY set, x1 is a copy of a datastore that is equal to x0
+ * except in subtrees marked with XML_FLAG_DIRTY, and only those are compared.
+ * @see xmldb_dirtymark_get
  */
 int
 xml_diff(yang_stmt *yspec, 
@@ -673,7 +683,7 @@ xml_diff(yang_stmt *yspec,
 	    goto done;
 	goto ok;
     }
-    if (xml_diff1(x0, x1,
+    if (xml_diff1(x0, x1, xml_flag(x1, XML_FLAG_DIFFDIRTY),
 		  first, firstlen, 
 		  second, secondlen, 
 		  changed_x0, changed_x1, changedlen) < 0)
@@ -2193,6 +2203,7 @@ xml_copy_marked(cxobj *x0,
     assert(x0 && x1);
     yt = xml_spec(x0); /* can be null */
     xml_spec_set(x1, yt);
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DIRTY)); /* see xml_diff */
    /* Copy prefix*/
     if ((prefix = xml_prefix(x0)) != NULL)
 	if (xml_prefix_set(x1, prefix) < 0)
@@ -73,34 +73,43 @@
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 
-/*! Get xml body value as cligen variable
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
+/*! Get typed value of xml leaf body, set typed value of body on first access
+ * Integer, decimal64 and boolean values are parsed once according to the yang type
+ * and stored in the body node. Other types are compared as strings.
+ * @param[in]  x     XML node (leaf/leaf-list) with body
+ * @param[out] xbp   Body node
+ * @param[out] vtp   Type of typed value
+ * @param[out] ivp   Integer value if XV_INT or XV_UINT
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_value_typed_get
  */
 static int
-xml_cv_cache(cxobj   *x,
-	     cg_var **cvp)
+xml_body_typed(cxobj               *x,
+	       cxobj              **xbp,
+	       enum xml_value_type *vtp,
+	       int64_t             *ivp)
 {
-    int          retval = -1;
-    cg_var      *cv = NULL;
-    yang_stmt   *y;
-    yang_stmt   *yrestype;
-    enum cv_type cvtype;
-    int          ret;
-    char        *reason=NULL;
-    int          options = 0;
-    uint8_t      fraction = 0;
-    char        *body;
-		 
-    if ((body = xml_body(x)) == NULL)
-	body="";
-    if ((cv = xml_cv(x)) != NULL)
+    int                 retval = -1;
+    cxobj              *xb;
+    cg_var             *cv = NULL;
+    yang_stmt          *y;
+    yang_stmt          *yrestype;
+    enum cv_type        cvtype;
+    enum xml_value_type vt;
+    int64_t             iv = 0;
+    int                 ret;
+    char               *reason=NULL;
+    int                 options = 0;
+    uint8_t             fraction = 0;
+    char               *body;
+
+    if ((xb = xml_body_get(x)) == NULL ||
+	(body = xml_value(xb)) == NULL){
+	clicon_err(OE_XML, EFAULT, "Body missing for xml symbol %s", xml_name(x));
+	goto done;
+    }
+    if ((vt = xml_value_typed_get(xb, &iv)) != XV_NONE)
 	goto ok;
     if ((y = xml_spec(x)) == NULL){
 	clicon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
@@ -109,31 +118,58 @@ xml_cv_cache(cxobj   *x,
     if (yang_type_get(y, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
 	goto done;
     yang2cv_type(yang_argument_get(yrestype), &cvtype);
-    if (cvtype==CGV_ERR){
+    switch (cvtype){
+    case CGV_ERR:
 	clicon_err(OE_YANG, errno, "yang->cligen type %s mapping failed",
 		   yang_argument_get(yrestype));
 	goto done;
+	break;
+    case CGV_INT8:   case CGV_INT16:  case CGV_INT32:  case CGV_INT64:
+    case CGV_UINT8:  case CGV_UINT16: case CGV_UINT32: case CGV_UINT64:
+    case CGV_BOOL:   case CGV_DEC64:
+	if ((cv = cv_new(cvtype)) == NULL){
+	    clicon_err(OE_YANG, errno, "cv_new");
+	    goto done;
+	}
+	if (cvtype == CGV_DEC64)
+	    cv_dec64_n_set(cv, fraction);
+	if ((ret = cv_parse1(body, cv, &reason)) < 0){
+	    clicon_err(OE_YANG, errno, "cv_parse1");
+	    goto done;
+	}
+	if (ret == 0){
+	    clicon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+	    goto done;
+	}
+	vt = XV_INT;
+	switch (cvtype){
+	case CGV_INT8:   iv = cv_int8_get(cv);   break;
+	case CGV_INT16:  iv = cv_int16_get(cv);  break;
+	case CGV_INT32:  iv = cv_int32_get(cv);  break;
+	case CGV_INT64:  iv = cv_int64_get(cv);  break;
+	case CGV_DEC64:  iv = cv_dec64_i_get(cv); break; /* Same fraction-digits */
+	default:
+	    vt = XV_UINT;
+	    switch (cvtype){
+	    case CGV_UINT8:  iv = cv_uint8_get(cv);  break;
+	    case CGV_UINT16: iv = cv_uint16_get(cv); break;
+	    case CGV_UINT32: iv = cv_uint32_get(cv); break;
+	    case CGV_UINT64: iv = (int64_t)cv_uint64_get(cv); break;
+	    default:         iv = cv_bool_get(cv);   break;
+	    }
+	    break;
+	}
+	break;
+    default: /* string, union, empty: compare body strings */
+	vt = XV_STRING;
+	break;
     }
-    if ((cv = cv_new(cvtype)) == NULL){
-	clicon_err(OE_YANG, errno, "cv_new");
-	goto done;
-    }
-    if (cvtype == CGV_DEC64)
-	cv_dec64_n_set(cv, fraction);
-	
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
-	clicon_err(OE_YANG, errno, "cv_parse1");
-	goto done;
-    }
-    if (ret == 0){
-	clicon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
-	goto done;
-    }
-    if (xml_cv_set(x, cv) < 0)
+    if (xml_value_typed_set(xb, vt, iv) < 0)
 	goto done;
  ok:
-    *cvp = cv;
-    cv = NULL;
+    *xbp = xb;
+    *vtp = vt;
+    *ivp = iv;
     retval = 0;
  done:
     if (reason)
@@ -143,15 +179,39 @@ xml_cv_cache(cxobj   *x,
     return retval;
 }
 
+/*! Compare bodies of two xml leafs/leaf-lists of same yang spec using typed values
+ * @param[in]  x1    XML node 1 with body
+ * @param[in]  x2    XML node 2 with body
+ * @param[out] eq    0 if equal, <0 if x1 is less than x2, >0 if x1 is greater than x2
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_body_typed
+ */
 static int
-xml_cv_cache_clear(cxobj *xt)
+xml_cmp_body(cxobj *x1,
+	     cxobj *x2,
+	     int   *eq)
 {
-    int    retval = -1;
-    cxobj *x = NULL;
+    int                 retval = -1;
+    cxobj              *xb1;
+    cxobj              *xb2;
+    enum xml_value_type vt1;
+    enum xml_value_type vt2;
+    int64_t             i1;
+    int64_t             i2;
 
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
-	if (xml_cv_set(x, NULL) < 0)
-	    goto done;
+    if (xml_body_typed(x1, &xb1, &vt1, &i1) < 0)
+	goto done;
+    if (xml_body_typed(x2, &xb2, &vt2, &i2) < 0)
+	goto done;
+    if (vt1 != vt2)
+	*eq = vt1 - vt2;
+    else if (vt1 == XV_INT)
+	*eq = (i1 > i2) - (i1 < i2);
+    else if (vt1 == XV_UINT)
+	*eq = ((uint64_t)i1 > (uint64_t)i2) - ((uint64_t)i1 < (uint64_t)i2);
+    else
+	*eq = strcmp(xml_value(xb1), xml_value(xb2));
     retval = 0;
  done:
     return retval;
@@ -213,8 +273,6 @@ xml_cmp(cxobj  *x1,
     char       *b1;
     char       *b2;
     char       *keyname;
-    cg_var     *cv1 = NULL; 
-    cg_var     *cv2 = NULL;
     int         nr1 = 0;
     int         nr2 = 0;
     cxobj      *x1b;
@@ -288,18 +346,8 @@ xml_cmp(cxobj  *x1,
 	else if (b2 == NULL)
 	    equal = 1;
 	else{
-	    if (xml_cv_cache(x1, &cv1) < 0) /* error case */
-		goto done;
-	    if (xml_cv_cache(x2, &cv2) < 0) /* error case */
+	    if (xml_cmp_body(x1, x2, &equal) < 0) /* error case */
 		goto done;
-	    if (cv1 != NULL && cv2 != NULL)
-		equal = cv_cmp(cv1, cv2);
-	    else if (cv1 == NULL && cv2 == NULL)
-		equal = 0;
-	    else if (cv1 == NULL)
-		equal = -1;
-	    else
-		equal = 1;
 	}
 	break;
     case Y_LIST: /* Match with key values  */
@@ -323,12 +371,8 @@ xml_cmp(cxobj  *x1,
 		else if (b2 == NULL)
 		    equal = 1;
 		else{
-		    if (xml_cv_cache(x1b, &cv1) < 0) /* error case */
+		    if (xml_cmp_body(x1b, x2b, &equal) < 0) /* error case */
 			goto done;
-		    if (xml_cv_cache(x2b, &cv2) < 0) /* error case */
-			goto done;
-		    assert(cv1 && cv2);
-		    equal = cv_cmp(cv1, cv2);
 		}
 	    }
 	    if (equal)
@@ -362,12 +406,8 @@ xml_cmp(cxobj  *x1,
 		else if (b2 == NULL)
 		    equal = 1;
 		else{
-		    if (xml_cv_cache(x1b, &cv1) < 0) /* error case */
-			goto done;
-		    if (xml_cv_cache(x2b, &cv2) < 0) /* error case */
+		    if (xml_cmp_body(x1b, x2b, &equal) < 0) /* error case */
 			goto done;
-		    assert(cv1 && cv2);
-		    equal = cv_cmp(cv1, cv2);
 		}
 	    }
 	    if (equal)
@@ -440,8 +480,6 @@ xml_sort_recurse(cxobj *xn)
 	if (ret == 1) /* This node is not sortable */
 	    goto ok;
     }
-    if (xml_cv_cache_clear(xn) < 0)
-	goto done;
     x = NULL;
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
 	if (xml_sort_recurse(x) < 0)
@@ -1242,11 +1280,12 @@ xml_find_noyang_cvk(char        *ns0,
 	     * Loop through children of the matched x (to match keyname and value) */
 	    xcc = NULL;
 	    while ((xcc = xml_child_each(xc, xcc, CX_ELMNT)) != NULL) {
+		/* Check name before namespace lookup */
+		if (!clixon_streq(keyname, xml_name(xcc))) /* Name does not match, skip */
+		    continue;
 		if (xml2ns(xcc, xml_prefix(xcc), &ns) < 0)
 		    goto done;
-		if (strcmp(ns0, ns) != 0) /* Namespace does not match, skip */
-		    continue;
-		if (strcmp(keyname, xml_name(xcc)) != 0) /* Name does not match, skip */
+		if (!clixon_streq(ns0, ns)) /* Namespace does not match, skip */
 		    continue;
 		body = xml_body(xcc);
 		if (body==NULL && (keyval==NULL || strlen(keyval) == 0)) /* both null, break */
@@ -1288,14 +1327,15 @@ xml_find_noyang_name(cxobj       *xp,
     /* Go through children linearly */
     xc = NULL;
     while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
+	/* Check name before namespace lookup */
+	if (!clixon_streq(name, xml_name(xc))) /* Name does not match, skip */
+	    continue;
 	ns = NULL;
 	if (xml2ns(xc, xml_prefix(xc), &ns) < 0)
 	    goto done;
 	if (ns == NULL)
 	    continue;
-	if (strcmp(ns0, ns) != 0) /* Namespace does not match, skip */
-	    continue;
-	if (strcmp(name, xml_name(xc)) != 0) /* Namespace does not match, skip */
+	if (!clixon_streq(ns0, ns)) /* Namespace does not match, skip */
 	    continue;
 	if (cvk){ 	/* Check indexes */
 	    if (xml_find_noyang_cvk(ns0, xc, cvk, xvec) < 0)
@@ -1582,7 +1622,7 @@ clixon_xml_find_pos(cxobj        *xp,
     u = 0;
     xc = NULL;
     while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
-	if (strcmp(name, xml_name(xc)))
+	if (name != xml_name(xc)) /* Both interned */
 	    continue;
 	if (pos == u++){ /* Found */
 	    if (clixon_xvec_append(xvec, xc) < 0)
@@ -147,6 +147,31 @@ static const map_str2int axis_type_map[] = {
     {NULL,                  -1}
 };
 
+/*! Cache entry of a parsed xpath expression
+ * @see xpath_cache_get
+ */
+struct xpath_cache_entry{
+    qelem_t     xe_qelem;   /* List header, pinned or lru list */
+    char       *xe_str;     /* XPath expression string */
+    xpath_tree *xe_tree;    /* Parsed xpath tree */
+    int         xe_pinned;  /* Schema expression, never evicted */
+    int         xe_refs;    /* Number of ongoing evaluations of xe_tree */
+};
+typedef struct xpath_cache_entry xpath_cache_entry;
+
+/* Cache of parsed xpath expressions, keyed by expression string.
+ * Schema expressions (must/when/leafref path) are pinned at YANG load time, other
+ * expressions are kept in a LRU list bounded by _xpath_cache_size
+ * @see CLICON_XPATH_CACHE_SIZE
+ */
+static clicon_hash_t     *_xpath_cache = NULL;
+static xpath_cache_entry *_xpath_cache_pinned = NULL; /* Pinned entries */
+static xpath_cache_entry *_xpath_cache_lru = NULL;    /* Unpinned entries, most recent first */
+static int                _xpath_cache_lrulen = 0;
+static int                _xpath_cache_size = 256;    /* Max unpinned entries, 0: not cached */
+static uint64_t           _xpath_cache_hits = 0;
+static uint64_t           _xpath_cache_misses = 0;
+
 
 /*
  * XPATH parse tree type
@@ -490,8 +515,12 @@ xpath_tree_free(xpath_tree *xs)
 	free(xs->xs_strnr);
     if (xs->xs_s0)
 	free(xs->xs_s0);
-    if (xs->xs_s1)
-	free(xs->xs_s1);
+    if (xs->xs_s1){
+	if (xs->xs_type == XP_NODE) /* interned */
+	    clixon_string_release(xs->xs_s1);
+	else
+	    free(xs->xs_s1);
+    }
     if (xs->xs_c0)
 	xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
@@ -560,9 +589,221 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+/*! Free a cache entry
+ */
+static int
+xpath_cache_entry_free(xpath_cache_entry *xe)
+{
+    if (xe->xe_str)
+	free(xe->xe_str);
+    if (xe->xe_tree)
+	xpath_tree_free(xe->xe_tree);
+    free(xe);
+    return 0;
+}
+
+/*! Remove least recently used unpinned entries not in use until size limit is met
+ * @param[in]  size  Max number of unpinned entries remaining
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpath_cache_evict(int size)
+{
+    xpath_cache_entry *xe;
+    xpath_cache_entry *xprev;
+    int                i;
+
+    if (_xpath_cache_lru == NULL)
+	return 0;
+    xe = PREVQ(xpath_cache_entry *, _xpath_cache_lru); /* tail */
+    for (i = _xpath_cache_lrulen; i > 0 && _xpath_cache_lrulen > size; i--){
+	xprev = PREVQ(xpath_cache_entry *, xe);
+	if (xe->xe_refs == 0){
+	    if (clicon_hash_del(_xpath_cache, xe->xe_str) < 0)
+		return -1;
+	    DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+	    _xpath_cache_lrulen--;
+	    xpath_cache_entry_free(xe);
+	}
+	xe = xprev;
+    }
+    return 0;
+}
+
+/*! Get parsed xpath tree from cache, parse and add it if not found
+ * @param[in]  xpath  String with XPATH 1.0 syntax
+ * @param[in]  pin    Pin entry, ie never evict it (schema expression)
+ * @param[out] xep    Cache entry, or NULL if not cached (caching disabled)
+ * @param[out] xptree Parsed xpath tree. If not cached, free with xpath_tree_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_cache_get(const char         *xpath,
+		int                 pin,
+		xpath_cache_entry **xep,
+		xpath_tree        **xptree)
+{
+    int                retval = -1;
+    xpath_cache_entry *xe = NULL;
+    xpath_cache_entry **xv;
+    xpath_tree        *xt = NULL;
+
+    *xep = NULL;
+    if (_xpath_cache &&
+	(xv = clicon_hash_value(_xpath_cache, xpath, NULL)) != NULL){
+	xe = *xv;
+	_xpath_cache_hits++;
+	if (!xe->xe_pinned){
+	    DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+	    if (pin){
+		_xpath_cache_lrulen--;
+		xe->xe_pinned = 1;
+		INSQ(xe, _xpath_cache_pinned);
+	    }
+	    else
+		INSQ(xe, _xpath_cache_lru);
+	}
+	*xep = xe;
+	*xptree = xe->xe_tree;
+	goto ok;
+    }
+    _xpath_cache_misses++;
+    if (xpath_parse(xpath, &xt) < 0)
+	goto done;
+    if (!pin && _xpath_cache_size == 0){
+	*xptree = xt;
+	goto ok;
+    }
+    if (_xpath_cache == NULL &&
+	(_xpath_cache = clicon_hash_init()) == NULL)
+	goto done;
+    if (!pin && xpath_cache_evict(_xpath_cache_size - 1) < 0)
+	goto done;
+    if ((xe = malloc(sizeof(*xe))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xe, 0, sizeof(*xe));
+    if ((xe->xe_str = strdup(xpath)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    xe->xe_tree = xt;
+    xt = NULL;
+    if (clicon_hash_add(_xpath_cache, xpath, &xe, sizeof(xe)) == NULL)
+	goto done;
+    if (pin){
+	xe->xe_pinned = 1;
+	INSQ(xe, _xpath_cache_pinned);
+    }
+    else{
+	INSQ(xe, _xpath_cache_lru);
+	_xpath_cache_lrulen++;
+    }
+    *xep = xe;
+    *xptree = xe->xe_tree;
+    xe = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+	xpath_tree_free(xt);
+    if (retval < 0 && xe)
+	xpath_cache_entry_free(xe);
+    return retval;
+}
+
+/*! Parse a schema xpath expression and pin it in the xpath cache
+ *
+ * Used at YANG load time for must, when and leafref path expressions, which are
+ * then never parsed again when evaluated. Also checks the xpath syntax.
+ * @param[in]  xpath  String with XPATH 1.0 syntax
+ * @retval     0      OK
+ * @retval    -1      Error, eg parse error
+ */
+int
+xpath_cache_pin(const char *xpath)
+{
+    xpath_cache_entry *xe;
+    xpath_tree        *xt = NULL;
+
+    return xpath_cache_get(xpath, 1, &xe, &xt);
+}
+
+/*! Set max number of cached non-schema xpath expressions
+ * @param[in]  size  Max number of entries, 0 means such expressions are not cached
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_XPATH_CACHE_SIZE
+ */
+int
+xpath_cache_size_set(int size)
+{
+    if (size < 0){
+	clicon_err(OE_XML, EINVAL, "Negative xpath cache size: %d", size);
+	return -1;
+    }
+    _xpath_cache_size = size;
+    return xpath_cache_evict(size);
+}
+
+/*! Get xpath cache statistics
+ * @param[out] hits     Number of expressions found in the cache
+ * @param[out] misses   Number of expressions parsed
+ * @param[out] entries  Number of cached expressions, pinned and unpinned
+ * @retval     0        OK
+ */
+int
+xpath_cache_stats(uint64_t *hits,
+		  uint64_t *misses,
+		  uint64_t *entries)
+{
+    xpath_cache_entry *xe;
+    uint64_t           nr = _xpath_cache_lrulen;
+
+    if ((xe = _xpath_cache_pinned) != NULL)
+	do {
+	    nr++;
+	    xe = NEXTQ(xpath_cache_entry *, xe);
+	} while (xe && xe != _xpath_cache_pinned);
+    if (hits)
+	*hits = _xpath_cache_hits;
+    if (misses)
+	*misses = _xpath_cache_misses;
+    if (entries)
+	*entries = nr;
+    return 0;
+}
+
+/*! Free all entries of the xpath cache
+ */
+int
+xpath_cache_exit(void)
+{
+    xpath_cache_entry *xe;
+
+    while ((xe = _xpath_cache_lru) != NULL){
+	DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+	xpath_cache_entry_free(xe);
+    }
+    while ((xe = _xpath_cache_pinned) != NULL){
+	DELQ(xe, _xpath_cache_pinned, xpath_cache_entry *);
+	xpath_cache_entry_free(xe);
+    }
+    _xpath_cache_lrulen = 0;
+    if (_xpath_cache){
+	clicon_hash_free(_xpath_cache);
+	_xpath_cache = NULL;
+    }
+    return 0;
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  * This is a raw form of xpath where you can do type conversion of the return
  * value, etc, not just a nodeset.
+ * The parsed xpath is looked up in, or added to, the xpath cache.
  * @param[in]  xcur   XML-tree where to search
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH 1.0 syntax
@@ -585,12 +826,15 @@ xpath_vec_ctx(cxobj      *xcur,
 	      int         localonly,
 	      xp_ctx    **xrp)
 {
-    int         retval = -1;
-    xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
+    int                retval = -1;
+    xpath_tree        *xptree = NULL;
+    xpath_cache_entry *xe = NULL;
+    xp_ctx             xc = {0,};
     
-    if (xpath_parse(xpath, &xptree) < 0)
+    if (xpath_cache_get(xpath, 0, &xe, &xptree) < 0)
 	goto done;
+    if (xe)
+	xe->xe_refs++; /* Protect from eviction in recursive calls */
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
@@ -604,7 +848,9 @@ xpath_vec_ctx(cxobj      *xcur,
     }
     retval = 0;
  done:
-    if (xptree)
+    if (xe)
+	xe->xe_refs--;
+    else if (xptree)
 	xpath_tree_free(xptree);
     return retval;
 }
@@ -130,16 +130,17 @@ nodetest_eval_node(cxobj      *x,
     /* Namespaces is s0, name is s1 */
     if (strcmp(xs->xs_s1, "*")==0)
 	return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-	goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+    /* Before going into namespaces, check name equality and filter out noteq
+     * Both xml and xpath node names are interned, see clixon_string_intern */
+    if (name1 != name2){
 	retval = 0; /* no match */
 	goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+	goto done;
     /* Here names are equal 
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -150,7 +151,7 @@ nodetest_eval_node(cxobj      *x,
     if (nsc != NULL) { /* solution (1) */
 	nsxpath = xml_nsctx_get(nsc, prefix2);
 	if (nsxml != NULL && nsxpath != NULL)
-	    retval = (strcmp(nsxml, nsxpath) == 0);
+	    retval = clixon_streq(nsxml, nsxpath);
 	else if (nsxpath == NULL){
 	    /* We have a namespace from xml, but none in yang.
 	     * This can happen in eg augments and ../foo, where foo is
@@ -199,8 +200,9 @@ nodetest_eval_node_localonly(cxobj      *x,
 	goto done;
     }
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) == 0){
+    /* Before going into namespaces, check name equality and filter out noteq
+     * Both names are interned */
+    if (name1 == name2){
 	retval = 1;
 	goto done;
     }
@@ -220,7 +222,7 @@ nodetest_eval_node_localonly(cxobj      *x,
  * - node() is true for any node of any type whatsoever.
  * - text() is true for any text node.
  */
-static int
+int
 nodetest_eval(cxobj      *x,
 	      xpath_tree *xs,
 	      cvec       *nsc,
@@ -338,7 +340,10 @@ xp_eval_step(xp_ctx     *xc0,
 	if (xc->xc_descendant){
 	    for (i=0; i<xc->xc_size; i++){
 		xv = xc->xc_nodeset[i];
-		if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+		if ((ret = xpath_optimize_descendant(xs, xv, nsc, localonly, &vec, &veclen)) < 0)
+		    goto done;
+		if (ret == 0 &&
+		    nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
 		    goto done;
 	    }
 	    xc->xc_descendant = 0;
@@ -63,19 +63,52 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
+#include "clixon_yang_type.h"
 #include "clixon_xml.h"
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_eval.h"
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
-static int _optimize_enable = 1;
-static int _optimize_hits = 0;
+/* Max number of comparison terms extracted from the predicates of one step */
+#define XP_TERM_MAX 16
+
+/* Access method of a planned xpath step, see xpath_plan_step */
+enum xp_access{
+    XA_SCAN,   /* No optimization, linear scan of all children */
+    XA_KEY,    /* Binary search on all, or a prefix of, list keys; or leaf-list value */
+    XA_INDEX,  /* Binary search on explicit search index (XML_EXPLICIT_INDEX) */
+    XA_RANGE,  /* Binary search of numeric range bounds on first list key */
+};
+
+/* Comparison term on the form <name> <op> <literal> extracted from a step predicate */
+struct xp_term{
+    char       *xt_name;  /* Child leaf name, or "." for the node itself */
+    int         xt_op;    /* XO_EQ, XO_LT, XO_LE, XO_GT or XO_GE */
+    xpath_tree *xt_lit;   /* Literal of type XP_PRIME_STR or XP_PRIME_NR */
+};
+
+/* Plan of how to access the children of one step */
+struct xp_plan{
+    enum xp_access xp_access;
+    char          *xp_name;    /* Child name (nodetest) */
+    yang_stmt     *xp_yang;    /* Yang of list or leaf-list child */
+    cvec          *xp_cvk;     /* XA_KEY, XA_INDEX: names and values */
+    int            xp_nkeys;   /* XA_KEY: number of keys of list */
+    char          *xp_key;     /* XA_RANGE: first key of list */
+    double         xp_lo;      /* XA_RANGE: lower bound */
+    int            xp_lostrict;/* XA_RANGE: lower bound is > (not >=) */
+    double         xp_hi;      /* XA_RANGE: upper bound */
+    int            xp_histrict;/* XA_RANGE: upper bound is < (not <=) */
+};
+
+static int          _optimize_enable = 1;
+static int          _optimize_hits = 0;
+static cbuf        *_optimize_explain = NULL; /* If set, log plans here */
+static xpath_tree  *_explain_last = NULL;     /* Last explained step, log once per step */
 #endif /* XPATH_LIST_OPTIMIZE */
 
 /* XXX development in clixon_xpath_eval */
@@ -101,252 +134,775 @@ xpath_list_optimize_set(int enable)
     return 0;
 }
 
+/*! Log the access plan of each evaluated xpath step, EXPLAIN-style
+ *
+ * One line per step is appended to cb on the form: <name>: <method> <conditions>
+ * where method is one of: key, key-prefix, index, range, descendant or scan.
+ * @param[in]  cb   Log plans to this buffer, or stop logging if NULL
+ * @retval     0    OK
+ * @code
+ *   cbuf *cb = cbuf_new();
+ *   xpath_optimize_explain(cb);
+ *   xpath_vec(x, nsc, "a/b[k='v']", &vec, &veclen);
+ *   xpath_optimize_explain(NULL);
+ *   fprintf(stdout, "%s", cbuf_get(cb));
+ * @endcode
+ */
+int
+xpath_optimize_explain(cbuf *cb)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    _optimize_explain = cb;
+    _explain_last = NULL;
+#endif
+    return 0;
+}
+
 void
 xpath_optimize_exit(void)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-	xpath_tree_free(_xmtop);
+    _optimize_explain = NULL;
+    _explain_last = NULL;
 #endif
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+/*! Skip single-child wrapper nodes of an xpath tree
+ *
+ * A simple literal or path as predicate operand is wrapped in many levels, eg
+ * RELEX->ADD->UNION->PATHEXPR->LOCPATH->RELLOCPATH->STEP
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-		    xpath_tree **xe)
+static xpath_tree *
+xp_unwrap(xpath_tree *xs)
 {
-    int         retval = -1;
-    xpath_tree *xs;
-    
-    if (_xm == NULL){
-	/* Initialize xpath-tree */
-	if (xpath_parse("_x[_y='_z']", &_xmtop) < 0) 
-	    goto done;
-	/* Go down two steps */
-	if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-	    goto done;
-	/* get nodetest tree (_x) */
-	if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++;
-	/* get predicates [_y=_z][z=2] */
-	if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-	    goto done;
-	xs->xs_match++;
-	/* get expression [_y=_z] */
-	if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-	    goto done;
-	/* get keyname (_y) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
+    while (xs && xs->xs_c1 == NULL){
+	switch (xs->xs_type){
+	case XP_EXP:
+	case XP_AND:
+	case XP_RELEX:
+	case XP_ADD:
+	case XP_UNION:
+	case XP_PATHEXPR:
+	case XP_FILTEREXPR:
+	case XP_LOCPATH:
+	    xs = xs->xs_c0;
+	    break;
+	default:
+	    return xs;
+	}
+    }
+    return xs;
+}
+
+/*! Return child leaf name (or "." for self) if xpath operand is a single step without predicates
+ */
+static char *
+xp_term_name(xpath_tree *xs)
+{
+    xpath_tree *xn;
+
+    if ((xs = xp_unwrap(xs)) == NULL ||
+	xs->xs_type != XP_RELLOCPATH ||
+	xs->xs_c1 != NULL ||
+	(xs = xs->xs_c0) == NULL ||
+	xs->xs_type != XP_STEP)
+	return NULL;
+    if (xs->xs_c1 && (xs->xs_c1->xs_c0 || xs->xs_c1->xs_c1)) /* predicates */
+	return NULL;
+    if (xs->xs_int == A_SELF)
+	return ".";
+    if (xs->xs_int != A_CHILD ||
+	(xn = xs->xs_c0) == NULL ||
+	xn->xs_type != XP_NODE ||
+	xn->xs_s1 == NULL ||
+	strcmp(xn->xs_s1, "*") == 0)
+	return NULL;
+    return xn->xs_s1;
+}
+
+/*! Return literal if xpath operand is a string or number
+ */
+static xpath_tree *
+xp_term_literal(xpath_tree *xs)
+{
+    if ((xs = xp_unwrap(xs)) == NULL)
+	return NULL;
+    if (xs->xs_type != XP_PRIME_STR && xs->xs_type != XP_PRIME_NR)
+	return NULL;
+    return xs;
+}
+
+/*! Return literal as string */
+static char *
+xp_term_str(struct xp_term *xt)
+{
+    if (xt->xt_lit->xs_type == XP_PRIME_NR)
+	return xt->xt_lit->xs_strnr;
+    return xt->xt_lit->xs_s0;
+}
+
+/*! Extract comparison terms from a conjunction of comparisons
+ *
+ * @param[in]     xs    XPath expression tree of a predicate
+ * @param[out]    terms Vector of terms
+ * @param[in,out] n     Number of terms in vector
+ * @retval        1     Whole expression is a conjunction of terms <name> <op> <literal>
+ * @retval        0     Not only simple terms (eg or, functions, positions)
+ */
+static int
+xp_term_add(xpath_tree     *xs,
+	    struct xp_term *terms,
+	    int            *n)
+{
+    xpath_tree *xl;
+    char       *name;
+    int         op;
+
+    if ((xs = xp_unwrap(xs)) == NULL)
+	return 0;
+    if ((xs->xs_type == XP_EXP || xs->xs_type == XP_AND) && xs->xs_int == XO_AND)
+	return xp_term_add(xs->xs_c0, terms, n) && xp_term_add(xs->xs_c1, terms, n);
+    if (xs->xs_type != XP_RELEX)
+	return 0;
+    op = xs->xs_int;
+    if (op != XO_EQ && op != XO_LT && op != XO_LE && op != XO_GT && op != XO_GE)
+	return 0;
+    if ((name = xp_term_name(xs->xs_c0)) != NULL &&
+	(xl = xp_term_literal(xs->xs_c1)) != NULL)
+	;
+    else if ((name = xp_term_name(xs->xs_c1)) != NULL &&
+	     (xl = xp_term_literal(xs->xs_c0)) != NULL){
+	switch (op){ /* Mirror: 3 < x is x > 3 */
+	case XO_LT: op = XO_GT; break;
+	case XO_LE: op = XO_GE; break;
+	case XO_GT: op = XO_LT; break;
+	case XO_GE: op = XO_LE; break;
+	default: break;
+	}
+    }
+    else
+	return 0;
+    if (*n >= XP_TERM_MAX)
+	return 0;
+    terms[*n].xt_name = name;
+    terms[*n].xt_op = op;
+    terms[*n].xt_lit = xl;
+    (*n)++;
+    return 1;
+}
+
+/*! Extract terms from leading predicates of a step
+ *
+ * Only leading predicates consisting entirely of terms are used. Since they do not depend on
+ * context position, filtering the children on them first gives the same result as the
+ * regular evaluation, which anyway applies all predicates on the result.
+ * @param[in]     xp    XPath tree of type PRED
+ * @param[out]    terms Vector of terms
+ * @param[in,out] n     Number of terms in vector
+ * @retval        1     All predicates used, continue with next
+ * @retval        0     Stop, predicate not used
+ */
+static int
+xp_pred_terms(xpath_tree     *xp,
+	      struct xp_term *terms,
+	      int            *n)
+{
+    int n0;
+
+    if (xp == NULL || xp->xs_type != XP_PRED)
+	return 1;
+    if (xp_pred_terms(xp->xs_c0, terms, n) == 0)
+	return 0;
+    if (xp->xs_c1 == NULL)
+	return 1;
+    n0 = *n;
+    if (xp_term_add(xp->xs_c1, terms, n) == 0){
+	*n = n0;
+	return 0;
+    }
+    return 1;
+}
+
+/*! Find first equality term of name
+ */
+static struct xp_term *
+xp_term_eq(struct xp_term *terms,
+	   int             n,
+	   char           *name)
+{
+    int i;
+
+    for (i=0; i<n; i++)
+	if (terms[i].xt_op == XO_EQ && strcmp(terms[i].xt_name, name) == 0)
+	    return &terms[i];
+    return NULL;
+}
+
+/*! Check if an equality term can be used for lookup of values of a leaf
+ *
+ * XPath compares a number literal numerically with the string value of a node, eg
+ * [k=5] matches "05" and "5.0", which a lookup of the value "5" does not find unless
+ * the leaf is numeric.
+ * @param[in]  xt   Equality term
+ * @param[in]  y    Yang of leaf (or leaf-list) of term
+ * @retval     1    Term can be used for lookup
+ * @retval     0    Term cannot be used, scan
+ */
+static int
+xp_term_lookup(struct xp_term *xt,
+	       yang_stmt      *y)
+{
+    enum cv_type cvtype;
+
+    if (xt->xt_lit->xs_type != XP_PRIME_NR)
+	return 1;
+    cvtype = yang_type2cv(y);
+    return cv_isint(cvtype) || cvtype == CGV_DEC64;
+}
+
+/*! Add name and value to a search vector
+ */
+static int
+xp_cvk_add(cvec *cvk,
+	   char *name,
+	   char *value)
+{
+    cg_var *cvi;
+
+    if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+	clicon_err(OE_XML, errno, "cvec_add");
+	return -1;
+    }
+    cv_name_set(cvi, name);
+    cv_string_set(cvi, value);
+    return 0;
+}
+
+/*! Plan access of children of an xpath step given yang of parent
+ *
+ * Choose, in order of preference:
+ * 1. key: all list keys (or leaf-list value) given with equality
+ * 2. key-prefix: first list keys given with equality in a list ordered-by system
+ * 3. index: equality on a leaf marked as explicit search index
+ * 4. range: numeric comparisons on first key of a list ordered-by system
+ * 5. scan: none of the above
+ * @param[in]  xs    XPath tree of type STEP (child axis)
+ * @param[in]  yp    Yang spec of parent (context) node
+ * @param[out] plan  Access plan, free xp_cvk after use
+ * @retval     0     OK, see plan
+ * @retval    -1     Error
+ */
+static int
+xpath_plan_step(xpath_tree     *xs,
+		yang_stmt      *yp,
+		struct xp_plan *plan)
+{
+    int            retval = -1;
+    xpath_tree    *nodetest = xs->xs_c0;
+    yang_stmt     *yc;
+    yang_stmt     *yk;
+    cvec          *cvv;
+    cg_var        *cvi;
+    struct xp_term terms[XP_TERM_MAX];
+    struct xp_term *xt;
+    int            n = 0;
+    int            i;
+    int            sorted;
+    enum cv_type   cvtype;
+    double         d;
+
+    memset(plan, 0, sizeof(*plan));
+    plan->xp_access = XA_SCAN;
+    if (nodetest == NULL || nodetest->xs_type != XP_NODE ||
+	nodetest->xs_s1 == NULL || strcmp(nodetest->xs_s1, "*") == 0)
+	goto ok;
+    plan->xp_name = nodetest->xs_s1;
+    /* revert to non-optimized if no yang */
+    if (yp == NULL || yang_keyword_get(yp) == Y_SPEC)
+	goto ok;
+    /* or if not config data (state data should not be ordered) */
+    if (yang_config_ancestor(yp) == 0)
+	goto ok;
+    if ((yc = yang_find_datanode(yp, plan->xp_name)) == NULL)
+	goto ok;
+    if (yang_keyword_get(yc) != Y_LIST && yang_keyword_get(yc) != Y_LEAF_LIST)
+	goto ok;
+    plan->xp_yang = yc;
+    xp_pred_terms(xs->xs_c1, terms, &n);
+    if (n == 0)
+	goto ok;
+    sorted = (yang_find(yc, Y_ORDERED_BY, "user") == NULL);
+    if ((plan->xp_cvk = cvec_new(0)) == NULL){
+	clicon_err(OE_YANG, errno, "cvec_new");
+	goto done;
+    }
+    if (yang_keyword_get(yc) == Y_LEAF_LIST){
+	if ((xt = xp_term_eq(terms, n, ".")) != NULL &&
+	    xp_term_lookup(xt, yc)){
+	    if (xp_cvk_add(plan->xp_cvk, ".", xp_term_str(xt)) < 0)
+		goto done;
+	    plan->xp_access = XA_KEY;
+	    plan->xp_nkeys = 1;
+	}
+	goto ok;
+    }
+    /* Keys in order as long as they are given */
+    if ((cvv = yang_cvec_get(yc)) == NULL)
+	goto ok;
+    plan->xp_nkeys = cvec_len(cvv);
+    cvi = NULL;
+    while ((cvi = cvec_each(cvv, cvi)) != NULL) {
+	if ((xt = xp_term_eq(terms, n, cv_string_get(cvi))) == NULL)
+	    break;
+	if ((yk = yang_find(yc, Y_LEAF, xt->xt_name)) == NULL ||
+	    !xp_term_lookup(xt, yk))
+	    break;
+	if (xp_cvk_add(plan->xp_cvk, xt->xt_name, xp_term_str(xt)) < 0)
 	    goto done;
-	xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-	/* get keyval (_z) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
+    }
+    /* Prefix search only in sorted lists, user-order search only finds first match */
+    if (cvec_len(plan->xp_cvk) == plan->xp_nkeys ||
+	(cvec_len(plan->xp_cvk) && sorted)){
+	plan->xp_access = XA_KEY;
+	goto ok;
+    }
+    cvec_reset(plan->xp_cvk);
+#ifdef XML_EXPLICIT_INDEX
+    for (i=0; i<n; i++){
+	xt = &terms[i];
+	if (xt->xt_op != XO_EQ ||
+	    (yk = yang_find(yc, Y_LEAF, xt->xt_name)) == NULL ||
+	    yang_flag_get(yk, YANG_FLAG_INDEX) == 0 ||
+	    !xp_term_lookup(xt, yk))
+	    continue;
+	if (xp_cvk_add(plan->xp_cvk, xt->xt_name, xp_term_str(xt)) < 0)
 	    goto done;
-	xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
+	plan->xp_access = XA_INDEX;
+	goto ok;
     }
-    *xm = _xm;
-    *xe = _xe;
+#endif
+    /* Range on first key if numeric and list sorted */
+    if (!sorted || (cvi = cvec_i(cvv, 0)) == NULL)
+	goto ok;
+    plan->xp_key = cv_string_get(cvi);
+    if ((yk = yang_find(yc, Y_LEAF, plan->xp_key)) == NULL)
+	goto ok;
+    cvtype = yang_type2cv(yk);
+    if (!cv_isint(cvtype) && cvtype != CGV_DEC64)
+	goto ok;
+    plan->xp_lo = -INFINITY;
+    plan->xp_hi = INFINITY;
+    for (i=0; i<n; i++){
+	xt = &terms[i];
+	if (xt->xt_lit->xs_type != XP_PRIME_NR ||
+	    strcmp(xt->xt_name, plan->xp_key) != 0)
+	    continue;
+	d = xt->xt_lit->xs_double;
+	switch (xt->xt_op){
+	case XO_GT:
+	case XO_GE:
+	    if (d > plan->xp_lo || (d == plan->xp_lo && xt->xt_op == XO_GT)){
+		plan->xp_lo = d;
+		plan->xp_lostrict = (xt->xt_op == XO_GT);
+	    }
+	    plan->xp_access = XA_RANGE;
+	    break;
+	case XO_LT:
+	case XO_LE:
+	    if (d < plan->xp_hi || (d == plan->xp_hi && xt->xt_op == XO_LT)){
+		plan->xp_hi = d;
+		plan->xp_histrict = (xt->xt_op == XO_LT);
+	    }
+	    plan->xp_access = XA_RANGE;
+	    break;
+	default:
+	    break;
+	}
+    }
+ ok:
     retval = 0;
  done:
     return retval;
 }
 
+/*! Log plan of step, once per step
+ */
+static int
+xpath_plan_explain(xpath_tree     *xs,
+		   struct xp_plan *plan,
+		   int             descendant)
+{
+    cbuf   *cb = _optimize_explain;
+    cg_var *cvi;
+
+    if (cb == NULL || xs == _explain_last)
+	return 0;
+    _explain_last = xs;
+    cprintf(cb, "%s%s: ", descendant?"//":"", plan->xp_name?plan->xp_name:"*");
+    switch (plan->xp_access){
+    case XA_KEY:
+	cprintf(cb, "%s", cvec_len(plan->xp_cvk)<plan->xp_nkeys?"key-prefix":"key");
+	break;
+    case XA_INDEX:
+	cprintf(cb, "index");
+	break;
+    case XA_RANGE:
+	cprintf(cb, "range");
+	if (plan->xp_lo != -INFINITY)
+	    cprintf(cb, " %s%s%g", plan->xp_key, plan->xp_lostrict?">":">=", plan->xp_lo);
+	if (plan->xp_hi != INFINITY)
+	    cprintf(cb, " %s%s%g", plan->xp_key, plan->xp_histrict?"<":"<=", plan->xp_hi);
+	break;
+    case XA_SCAN:
+	cprintf(cb, "%s", descendant?"descendant":"scan");
+	break;
+    }
+    if (plan->xp_access == XA_KEY || plan->xp_access == XA_INDEX){
+	cvi = NULL;
+	while ((cvi = cvec_each(plan->xp_cvk, cvi)) != NULL)
+	    cprintf(cb, " %s='%s'", cv_name_get(cvi), cv_string_get(cvi));
+    }
+    cprintf(cb, "\n");
+    return 0;
+}
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Find first position of list entry at or after a numeric bound on its first key
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval    -1     Error
- * @retval     0     No match
- * @retval     1     Match
- * @see xpath_optimize_init
+ * Children are assumed to be sorted on yang order and then key
+ * @param[in]  xp     Parent XML node
+ * @param[in]  low    Lower child position
+ * @param[in]  upper  Upper child position (excluded)
+ * @param[in]  yangi  Yang order of list
+ * @param[in]  key    Name of first key
+ * @param[in]  bound  Numeric bound of key
+ * @param[in]  after  If set, first entry after bound, otherwise first entry at or after bound
+ * @retval     i      Child position
+ * @retval    -1      Child without yang spec found, give up
  */
 static int
-loop_preds(xpath_tree *xt,
-	   xpath_tree *xepat,
-	   cvec       *cvk)
+xp_range_pos(cxobj  *xp,
+	     int     low,
+	     int     upper,
+	     int     yangi,
+	     char   *key,
+	     double  bound,
+	     int     after)
 {
-    int          retval = -1;
-    int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
-	
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-	if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-	    goto done;
-	if (ret == 0)
-	    goto ok;
-    }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-	if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-	    goto done;
-	if (ret == 0)
-	    goto ok;
-	if (veclen != 2)
-	    goto ok;
-	if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-	    clicon_err(OE_XML, errno, "cvec_add");	
-	    goto done;
+    int        mid;
+    int        cmp;
+    cxobj     *xc;
+    yang_stmt *y;
+    char      *b;
+    double     d;
+
+    while (low < upper){
+	mid = (low + upper) / 2;
+	xc = xml_child_i(xp, mid);
+	if ((y = xml_spec(xc)) == NULL)
+	    return -1;
+	if ((cmp = yang_order(y) - yangi) == 0){
+	    if ((b = xml_find_body(xc, key)) == NULL)
+		cmp = -1; /* empty value is smallest */
+	    else{
+		d = strtod(b, NULL);
+		cmp = d < bound ? -1 : (d > bound ? 1 : 0);
+	    }
 	}
-	cv_name_set(cvi, vec[0]->xs_s1);
-	if (vec[1]->xs_type == XP_PRIME_NR)
-	    cv_string_set(cvi, vec[1]->xs_strnr);
+	if (cmp < 0 || (cmp == 0 && after))
+	    low = mid + 1;
 	else
-	    cv_string_set(cvi, vec[1]->xs_s0);
+	    upper = mid;
+    }
+    return low;
+}
+
+/*! Get children of xv according to plan
+ *
+ * @param[in]  plan  Access plan, not XA_SCAN
+ * @param[in]  xv    Parent XML node
+ * @param[out] xvec  Found children
+ * @retval     1     OK
+ * @retval     0     Plan could not be used, use regular scan
+ * @retval    -1     Error
+ */
+static int
+xpath_plan_exec(struct xp_plan *plan,
+		cxobj          *xv,
+		clixon_xvec    *xvec)
+{
+    int    retval = -1;
+    int    low;
+    int    lo;
+    int    hi;
+    int    i;
+    int    yangi;
+    cxobj *xa;
+
+    switch (plan->xp_access){
+    case XA_KEY:
+    case XA_INDEX:
+	if (clixon_xml_find_index(xv, xml_spec(xv), NULL, plan->xp_name, plan->xp_cvk, xvec) < 0)
+	    goto done;
+	break;
+    case XA_RANGE:
+	/* Attributes are first, skip them */
+	for (low=0; low<xml_child_nr(xv); low++)
+	    if ((xa = xml_child_i(xv, low)) == NULL || xml_type(xa) != CX_ATTR)
+		break;
+	yangi = yang_order(plan->xp_yang);
+	if ((lo = xp_range_pos(xv, low, xml_child_nr(xv), yangi, plan->xp_key,
+			       plan->xp_lo, plan->xp_lostrict)) < 0)
+	    goto revert;
+	if ((hi = xp_range_pos(xv, lo, xml_child_nr(xv), yangi, plan->xp_key,
+			       plan->xp_hi, !plan->xp_histrict)) < 0)
+	    goto revert;
+	for (i=lo; i<hi; i++)
+	    if (clixon_xvec_append(xvec, xml_child_i(xv, i)) < 0)
+		goto done;
+	break;
+    case XA_SCAN:
+	goto revert;
+	break;
     }
     retval = 1;
  done:
-    if (vec)
-	free(vec);
     return retval;
- ok: /* no match, not special case */
+ revert:
     retval = 0;
     goto done;
 }
 
-/*! Pattern matching to find fastpath
+/*! Check if yang data tree below ys may contain a node with name, memoized in yh
  *
- * @param[in]  xt     XPath tree
- * @param[in]  xv     XML base node
- * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
- * @retval    -1      Error
- * @retval     0      No match - use non-optimized lookup
- * @retval     1      Match
- *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ * Conservative: all sub-statements are searched, including choice/case, input/output and
+ * extensions. Nodes without yang, such as anydata content, may contain anything.
+ * @param[in]  yh    Hash of already computed results, keyed by yang pointer
+ * @param[in]  ys    Yang node
+ * @param[in]  name  Node name
+ * @retval     1     Yes, may contain name
+ * @retval     0     No
+ * @retval    -1     Error
  */
 static int
-xpath_list_optimize_fn(xpath_tree  *xt,
-		       cxobj       *xv,
-		       clixon_xvec *xvec)
+xp_yang_contains(clicon_hash_t *yh,
+		 yang_stmt     *ys,
+		 char          *name)
 {
-    int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
-    char        *name;
-    yang_stmt   *yp;
-    yang_stmt   *yc;
-    cvec        *cvv = NULL;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
-    int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
-    cg_var      *cvi;
-    int          i;
-    
-    /* revert to non-optimized if no yang */
-    if ((yp = xml_spec(xv)) == NULL)
-	goto ok;
-    /* or if not config data (state data should not be ordered) */
-    if (yang_config_ancestor(yp) == 0)
-	goto ok;
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
-	goto done;
-    if (ret == 0)
-	goto ok; /* no match */
-    if (veclen != 2)
-	goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-	if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-	    goto ok; 
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
-	goto ok;
-    xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
-	clicon_err(OE_YANG, errno, "cvec_new");	
+    int        retval = -1;
+    char       key[32];
+    char      *val;
+    yang_stmt *yc;
+    int        ret;
+
+    if (yang_keyword_get(ys) == Y_ANYDATA || yang_keyword_get(ys) == Y_ANYXML){
+	retval = 1;
 	goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    snprintf(key, sizeof(key), "%p", ys);
+    if ((val = clicon_hash_value(yh, key, NULL)) != NULL){
+	retval = (*val == '1');
 	goto done;
-    if (ret == 0)
-	goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
-	goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-	if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-	    goto ok;
-	i++;
     }
-    /* Use 2a form since yc allready given to compute cvk */
-    if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
+    ret = 0;
+    yc = NULL;
+    while (ret == 0 && (yc = yn_each(ys, yc)) != NULL) {
+	if (yang_datanode(yc) || yang_keyword_get(yc) == Y_RPC ||
+	    yang_keyword_get(yc) == Y_ACTION || yang_keyword_get(yc) == Y_NOTIFICATION)
+	    if (strcmp(yang_argument_get(yc), name) == 0){
+		ret = 1;
+		break;
+	    }
+	if ((ret = xp_yang_contains(yh, yc, name)) < 0)
+	    goto done;
+    }
+    if (clicon_hash_add(yh, key, ret?"1":"0", 2) == NULL)
 	goto done;
-    retval = 1; /* match */
+    retval = ret;
  done:
-    if (vec)
-	free(vec);
-    if (cvk)
-	cvec_free(cvk);
     return retval;
- ok: /* no match, not special case */
+}
+
+/*! Descendant step: recursive search of all descendants pruned by yang, using plans for lists
+ *
+ * Same result and order as nodetest_recursive, but subtrees that according to yang cannot
+ * contain the node are skipped, and list children are found with the step plan.
+ */
+static int
+xp_descendant(xpath_tree    *xs,
+	      char          *name,
+	      cxobj         *xv,
+	      cvec          *nsc,
+	      int            localonly,
+	      clicon_hash_t *yh,
+	      cxobj       ***vec,
+	      int           *veclen)
+{
+    int            retval = -1;
+    struct xp_plan plan = {0,};
+    clixon_xvec   *xvec = NULL;
+    yang_stmt     *yv;
+    yang_stmt     *ys;
+    cxobj         *x;
+    int            planned = 0;
+    int            i;
+    int            ret = 0;
+
+    if ((yv = xml_spec(xv)) != NULL && yang_keyword_get(yv) != Y_SPEC){
+	if (xpath_plan_step(xs, yv, &plan) < 0)
+	    goto done;
+	/* Plan can only be used if the list does not contain itself */
+	if (plan.xp_access != XA_SCAN){
+	    if ((ret = xp_yang_contains(yh, plan.xp_yang, name)) < 0)
+		goto done;
+	}
+	if (plan.xp_access != XA_SCAN && ret == 0){
+	    if ((xvec = clixon_xvec_new()) == NULL)
+		goto done;
+	    if ((planned = xpath_plan_exec(&plan, xv, xvec)) < 0)
+		goto done;
+	}
+    }
+    x = NULL;
+    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+	ys = xml_spec(x);
+	if (planned && ys == plan.xp_yang){
+	    /* Add planned children once, in place of the list entries */
+	    if (xvec){
+		for (i=0; i<clixon_xvec_len(xvec); i++)
+		    if (cxvec_append(clixon_xvec_i(xvec, i), vec, veclen) < 0)
+			goto done;
+		clixon_xvec_free(xvec);
+		xvec = NULL;
+	    }
+	    continue;
+	}
+	if (nodetest_eval(x, xs->xs_c0, nsc, localonly) == 1)
+	    if (cxvec_append(x, vec, veclen) < 0)
+		goto done;
+	if (ys != NULL){
+	    if ((ret = xp_yang_contains(yh, ys, name)) < 0)
+		goto done;
+	    if (ret == 0)
+		continue;
+	}
+	if (xp_descendant(xs, name, x, nsc, localonly, yh, vec, veclen) < 0)
+	    goto done;
+    }
     retval = 0;
-    goto done;
+ done:
+    if (xvec)
+	clixon_xvec_free(xvec);
+    if (plan.xp_cvk)
+	cvec_free(plan.xp_cvk);
+    return retval;
 }
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/*! Identify XPATH special cases and if match, use binary search.
+/*! Plan an xpath child step and if possible, use binary search on keys, indexes or ranges
  *
+ * @param[in]     xs     XPath tree of type STEP
+ * @param[in]     xv     XML context (parent) node
+ * @param[in,out] xvec0  Found children are appended to this vector
+ * @param[in,out] xlen0  Length of xvec0
  * @retval -1  Error
  * @retval  0  Dont optimize: not special case, do normal processing
  * @retval  1  Optimization made, special case, use x (found if != NULL)
- * XXX Contains glue code between cxobj ** and clixon_xvec code 
+ * XXX Contains glue code between cxobj ** and clixon_xvec code
  */
 int
 xpath_optimize_check(xpath_tree *xs,
                      cxobj      *xv,
-	             cxobj    ***xvec0, 
+	             cxobj    ***xvec0,
 	             int        *xlen0)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    int          ret;
-    clixon_xvec *xvec = NULL;
-    
+    int            retval = -1;
+    int            ret;
+    int            i;
+    clixon_xvec   *xvec = NULL;
+    struct xp_plan plan;
+
     if (!_optimize_enable)
 	return 0; /* use regular code */
+    if (xpath_plan_step(xs, xml_spec(xv), &plan) < 0)
+	goto done;
+    xpath_plan_explain(xs, &plan, 0);
+    if (plan.xp_access == XA_SCAN){
+	retval = 0; /* use regular code */
+	goto done;
+    }
     if ((xvec = clixon_xvec_new()) == NULL)
-	return -1;
+	goto done;
     /* Glue code since xpath code uses (old) cxobj ** and search code uses (new) clixon_xvec */
-    if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
-	return -1;
+    if ((ret = xpath_plan_exec(&plan, xv, xvec)) < 0)
+	goto done;
     if (ret == 1){
-	if (clixon_xvec_extract(xvec, xvec0, xlen0) < 0)
-	    return -1;
-	clixon_xvec_free(xvec);
+	for (i=0; i<clixon_xvec_len(xvec); i++)
+	    if (cxvec_append(clixon_xvec_i(xvec, i), xvec0, xlen0) < 0)
+		goto done;
 	_optimize_hits++;
-	return 1; /* Optimized */
     }
-    else{
+    retval = ret;
+ done:
+    if (xvec)
 	clixon_xvec_free(xvec);
-	return 0; /* use regular code */
-    }
+    if (plan.xp_cvk)
+	cvec_free(plan.xp_cvk);
+    return retval;
 #else
     return 0; /* use regular code */
 #endif
 }
 
+/*! Descendant variant of xpath_optimize_check, replaces nodetest_recursive of a child step
+ *
+ * @param[in]     xs        XPath tree of type STEP
+ * @param[in]     xv        XML context node
+ * @param[in]     nsc       XML Namespace context
+ * @param[in]     localonly Skip prefix and namespace tests (non-standard)
+ * @param[in,out] xvec0     Found descendants are appended to this vector
+ * @param[in,out] xlen0     Length of xvec0
+ * @retval -1  Error
+ * @retval  0  Dont optimize, use nodetest_recursive
+ * @retval  1  Optimization made
+ */
+int
+xpath_optimize_descendant(xpath_tree *xs,
+			  cxobj      *xv,
+			  cvec       *nsc,
+			  int         localonly,
+			  cxobj    ***xvec0,
+			  int        *xlen0)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    int            retval = -1;
+    clicon_hash_t *yh = NULL;
+    struct xp_plan plan;
+
+    if (!_optimize_enable)
+	return 0;
+    /* Only named nodes can be pruned */
+    if (xpath_plan_step(xs, NULL, &plan) < 0)
+	goto done;
+    if (plan.xp_name == NULL){
+	retval = 0;
+	goto done;
+    }
+    xpath_plan_explain(xs, &plan, 1);
+    if ((yh = clicon_hash_init()) == NULL)
+	goto done;
+    if (xp_descendant(xs, plan.xp_name, xv, nsc, localonly, yh, xvec0, xlen0) < 0)
+	goto done;
+    _optimize_hits++;
+    retval = 1;
+ done:
+    if (yh)
+	clicon_hash_free(yh);
+    if (plan.xp_cvk)
+	cvec_free(plan.xp_cvk);
+    return retval;
+#else
+    return 0; /* use regular code */
+#endif
+}
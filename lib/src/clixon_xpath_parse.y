@@ -164,7 +164,7 @@ xpath_parse_exit(clixon_xpath_yacc *xpy)
  * @param[in]  i0     step-> axis_type 
  * @param[in]  numstr original string xs_double: numeric value 
  * @param[in]  s0     String 0 set if XP_PRIME_STR, XP_PRIME_FN, XP_NODE[_FN] PATHEXPRE prefix
- * @param[in]  s1     String 1 set if XP_NODE NAME
+ * @param[in]  s1     String 1 set if XP_NODE NAME (interned)
  * @param[in]  c0     Child 0
  * @param[in]  c1     Child 1
  */
@@ -196,7 +196,16 @@ xp_new(enum xp_type  type,
     else
 	xs->xs_double = 0.0;
     xs->xs_s0  = s0;
-    xs->xs_s1  = s1;
+    if (type == XP_NODE && s1 != NULL){
+	/* Node names are interned for pointer comparison with xml names */
+	if ((xs->xs_s1 = clixon_string_intern(s1)) == NULL){
+	    free(s1);
+	    goto done;
+	}
+	free(s1);
+    }
+    else
+	xs->xs_s1  = s1;
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
  done:
@@ -428,8 +437,8 @@ axisspec    : AXISNAME { clicon_debug(3,"axisspec-> AXISNAME(%d) ::", $1); $$=$1
            ;
 
 nodetest    : '*'              { $$=xp_new(XP_NODE,A_NAN,NULL, NULL, NULL, NULL, NULL); clicon_debug(3,"nodetest-> *"); } 
-            | NAME             { $$=xp_new(XP_NODE,A_NAN,NULL, NULL, $1, NULL, NULL); clicon_debug(3,"nodetest-> name(%s)",$1); } 
-            | NAME ':' NAME    { $$=xp_new(XP_NODE,A_NAN,NULL, $1, $3, NULL, NULL);clicon_debug(3,"nodetest-> name(%s) : name(%s)", $1, $3); } 
+            | NAME             { clicon_debug(3,"nodetest-> name(%s)",$1); $$=xp_new(XP_NODE,A_NAN,NULL, NULL, $1, NULL, NULL); } 
+            | NAME ':' NAME    { clicon_debug(3,"nodetest-> name(%s) : name(%s)", $1, $3); $$=xp_new(XP_NODE,A_NAN,NULL, $1, $3, NULL, NULL); } 
             | NAME ':' '*'     { $$=xp_new(XP_NODE,A_NAN,NULL, $1, NULL, NULL, NULL);clicon_debug(3,"nodetest-> name(%s) : *", $1); } 
             | FUNCTIONNAME ')' { if (($$ = xp_nodetest_function(_XPY, $1, NULL)) == NULL) YYERROR;; clicon_debug(3,"nodetest-> nodetype():%s", $1); } 
             ;
@@ -86,6 +86,33 @@
 #include "clixon_yang_type.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API*/
 
+/* Minimum number of indexed children for building a hash index, smaller nodes are
+ * searched linearly
+ */
+#define YANG_INDEX_MIN 8
+
+/*
+ * Types
+ */
+/* Entry of yang child index */
+struct yang_index_entry{
+    yang_stmt *ye_stmt;   /* Child, or data node in choice/case of child */
+    uint32_t   ye_hash;   /* Hash of argument */
+    int        ye_nested; /* Data node in choice/case, only found by yang_find_datanode */
+};
+
+/*! Hash index of the children of a yang statement on argument
+ * Open addressing with linear probing. Since there is no removal, children with the
+ * same argument are probed in child order, which gives the same first match as a
+ * linear search.
+ * @see yang_index_build
+ */
+struct yang_index{
+    uint32_t                yi_mask;     /* Number of slots - 1, number of slots is power of 2 */
+    int                     yi_includes; /* Number of include statements */
+    struct yang_index_entry yi_entry[];  /* Slots */
+};
+
 #ifdef XML_EXPLICIT_INDEX
 static int yang_search_index_extension(clicon_handle h, yang_stmt *yext, yang_stmt *ys);
 #endif
@@ -234,16 +261,30 @@ yang_argument_get(yang_stmt *ys)
  *  2c. identity types: derived instances: identityrefs, save <module>:<idref>
  *  2d. type: leafref types: derived instances.
  */
-/*! Set yang argument, not not copied
+/*! Set yang argument, argument is consumed and replaced by an interned copy
  * @param[in] ys   Yang statement node
- * @param[in] arg  Argument
+ * @param[in] arg  Argument, malloced, freed by this function
+ * @retval    0    OK
+ * @retval   -1    Error
  * Typically only done at parsing / initiation
+ * Arguments are interned so that names of XML nodes and yang data nodes are pointer equal
+ * @see clixon_string_intern
  */
 int
 yang_argument_set(yang_stmt *ys,
 		  char      *arg)
 {
-    ys->ys_argument = arg; /* not strdup/copied */
+    char *iarg = NULL;
+
+    if (arg){
+	if ((iarg = clixon_string_intern(arg)) == NULL)
+	    return -1;
+	free(arg);
+    }
+    if (ys->ys_argument)
+	clixon_string_release(ys->ys_argument);
+    ys->ys_argument = iarg;
+    yang_index_reset(ys->ys_parent);
     return 0;
 }
 
@@ -450,6 +491,7 @@ ys_new(enum rfc_6020 keyw)
     }
     memset(ys, 0, sizeof(*ys));
     ys->ys_keyword    = keyw;
+    ys->ys_order      = -1;
     /* The cvec contains stmt-specific variables. Only few stmts need variables so the
        cvec could be lazily created to save some heap and cycles. */
     if ((cvv = cvec_new(0)) == NULL){ 
@@ -475,7 +517,7 @@ ys_free1(yang_stmt *ys,
     cg_var *cv;
 
     if (ys->ys_argument){
-	free(ys->ys_argument);
+	clixon_string_release(ys->ys_argument);
 	ys->ys_argument = NULL;
     }
     if ((cv = yang_cv_get(ys)) != NULL){
@@ -494,6 +536,10 @@ ys_free1(yang_stmt *ys,
 	free(ys->ys_when_xpath);
     if (ys->ys_when_nsc)
 	cvec_free(ys->ys_when_nsc);
+    if (ys->ys_index){
+	free(ys->ys_index);
+	ys->ys_index = NULL;
+    }
     if (ys->ys_stmt)
 	free(ys->ys_stmt);
     if (self)
@@ -527,6 +573,7 @@ ys_prune(yang_stmt *yp,
     }
     yp->ys_len--;
     yp->ys_stmt[yp->ys_len] = NULL;
+    yang_index_reset(yp);
  done:
     return yc;
 }
@@ -596,6 +643,7 @@ yn_realloc(yang_stmt *yn)
 	return -1;
     }
     yn->ys_stmt[yn->ys_len - 1] = NULL; /* init field */
+    yang_index_reset(yn);
     return 0;
 }
 
@@ -624,16 +672,19 @@ ys_cp(yang_stmt *ynew,
 
     memcpy(ynew, yold, sizeof(*yold)); 
     ynew->ys_parent = NULL;
+    ynew->ys_index = NULL;
+    ynew->ys_order = -1;
+    if (yold->ys_flags & YANG_FLAG_INDEXED) /* Index copy lazily */
+	ynew->ys_flags |= YANG_FLAG_REINDEX;
+    ynew->ys_flags &= ~YANG_FLAG_INDEXED;
+    if (yold->ys_argument)
+	if ((ynew->ys_argument = clixon_string_intern(yold->ys_argument)) == NULL)
+	    goto done;
     if (yold->ys_stmt)
 	if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
 	    clicon_err(OE_YANG, errno, "calloc");
 	    goto done;
 	}
-    if (yold->ys_argument)
-	if ((ynew->ys_argument = strdup(yold->ys_argument)) == NULL){
-	    clicon_err(OE_YANG, errno, "strdup");
-	    goto done;
-	}
     yang_cv_set(ynew, NULL);
     if ((cvo = yang_cv_get(yold)) != NULL){
 	if ((cvn = cv_dup(cvo)) == NULL){
@@ -739,6 +790,7 @@ ys_replace(yang_stmt *yorig,
     if (ys_cp(yorig, yfrom) < 0)
 	goto done;
     yorig->ys_parent = yp;
+    yang_index_reset(yp);
     retval = 0;
  done:
     return retval;
@@ -817,6 +869,314 @@ yn_each(yang_stmt *yparent,
     return yc;
 }
 
+/*! Hash function of yang index (FNV-1a)
+ */
+static uint32_t
+yang_index_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+	h ^= (uint8_t)*str++;
+	h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Add a yang statement to an index
+ * @param[in]  yi      Yang index
+ * @param[in]  ys      Yang statement with argument
+ * @param[in]  nested  Data node in choice/case of child
+ */
+static void
+yang_index_add(struct yang_index *yi,
+	       yang_stmt         *ys,
+	       int                nested)
+{
+    uint32_t h;
+    uint32_t i;
+
+    h = yang_index_hash(ys->ys_argument);
+    i = h & yi->yi_mask;
+    while (yi->yi_entry[i].ye_stmt != NULL)
+	i = (i + 1) & yi->yi_mask;
+    yi->yi_entry[i].ye_stmt = ys;
+    yi->yi_entry[i].ye_hash = h;
+    yi->yi_entry[i].ye_nested = nested;
+}
+
+/*! Count and optionally add data nodes of choice/case to an index
+ * Same traversal as yang_find_datanode
+ * @param[in]  yi   Yang index, or NULL to only count
+ * @param[in]  yp   Choice or case statement
+ * @param[out] nr   Incremented with number of data nodes
+ */
+static void
+yang_index_nested(struct yang_index *yi,
+		  yang_stmt         *yp,
+		  int               *nr)
+{
+    yang_stmt *yc;
+    int        i;
+
+    for (i=0; i<yp->ys_len; i++){
+	yc = yp->ys_stmt[i];
+	if ((yp->ys_keyword == Y_CHOICE && yc->ys_keyword == Y_CASE) ||
+	    (yp->ys_keyword == Y_CASE && yc->ys_keyword == Y_CHOICE))
+	    yang_index_nested(yi, yc, nr);
+	else if (yang_datanode(yc) && yc->ys_argument){
+	    if (yi)
+		yang_index_add(yi, yc, 1);
+	    (*nr)++;
+	}
+    }
+}
+
+/*! Set yang order of nodes in a choice not reached by yang_order to -1
+ * @param[in]  yp   Choice or case statement
+ */
+static void
+yang_index_order_reset(yang_stmt *yp)
+{
+    yang_stmt *yc;
+    int        i;
+
+    for (i=0; i<yp->ys_len; i++){
+	yc = yp->ys_stmt[i];
+	yc->ys_order = -1;
+	if (yc->ys_keyword == Y_CHOICE || yc->ys_keyword == Y_CASE)
+	    yang_index_order_reset(yc);
+    }
+}
+
+/*! Precompute yang order of data nodes in a choice, same as order1_choice
+ * @param[in]     yp     Choice statement
+ * @param[in,out] index  Order of choice, incremented with its size
+ */
+static void
+yang_index_order_choice(yang_stmt *yp,
+			int       *index)
+{
+    yang_stmt  *ys;
+    yang_stmt  *yc;
+    int         i;
+    int         j;
+    int         shortcut=0;
+    int         max=0;
+
+    yp->ys_order = -1;
+    for (i=0; i<yp->ys_len; i++){
+	ys = yp->ys_stmt[i];
+	if (ys->ys_keyword == Y_CASE){
+	    ys->ys_order = -1;
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		yc->ys_order = yang_datanode(yc) ? *index + j : -1;
+		if (yc->ys_keyword == Y_CHOICE) /* Not reached by yang_order */
+		    yang_index_order_reset(yc);
+	    }
+	    if (j > max)
+		max = j;
+	}
+	else {
+	    shortcut = 1;
+	    ys->ys_order = yang_datanode(ys) ? *index : -1;
+	    if (ys->ys_keyword == Y_CHOICE)
+		yang_index_order_reset(ys);
+	}
+    }
+    if (shortcut)
+	(*index)++;
+    else
+	*index += max;
+}
+
+/*! Build hash index of children of a yang statement and precompute yang order of children
+ * @param[in]  yn   Yang statement
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_index_node(yang_stmt *yn)
+{
+    int                retval = -1;
+    struct yang_index *yi = NULL;
+    yang_stmt         *ys;
+    int                nr = 0;
+    uint32_t           size;
+    int                i;
+    int                index;
+
+    if (yn->ys_index){
+	free(yn->ys_index);
+	yn->ys_index = NULL;
+    }
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	if (ys->ys_argument)
+	    nr++;
+	if (ys->ys_keyword == Y_CHOICE)
+	    yang_index_nested(NULL, ys, &nr);
+    }
+    if (nr >= YANG_INDEX_MIN){
+	for (size = 1; size < 2*nr; size <<= 1);
+	if ((yi = calloc(1, sizeof(*yi) + size*sizeof(struct yang_index_entry))) == NULL){
+	    clicon_err(OE_YANG, errno, "calloc");
+	    goto done;
+	}
+	yi->yi_mask = size - 1;
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (ys->ys_keyword == Y_INCLUDE)
+		yi->yi_includes++;
+	    if (ys->ys_argument)
+		yang_index_add(yi, ys, 0);
+	    if (ys->ys_keyword == Y_CHOICE)
+		yang_index_nested(yi, ys, &nr);
+	}
+	yn->ys_index = yi;
+    }
+    /* Precompute yang order of children, see yang_order */
+    switch (yn->ys_keyword){
+    case Y_CHOICE: /* Ordered by parent */
+    case Y_CASE:
+	break;
+    case Y_SPEC:   /* Offset of top-level nodes of (sub)modules */
+	index = 0;
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    ys->ys_order = index;
+	    index += ys->ys_len;
+	}
+	break;
+    default:
+	index = 0;
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (ys->ys_keyword == Y_CHOICE)
+		yang_index_order_choice(ys, &index);
+	    else if (yang_datanode(ys))
+		ys->ys_order = index++;
+	    else
+		ys->ys_order = -1;
+	}
+	break;
+    }
+    yn->ys_flags |= YANG_FLAG_INDEXED;
+    yn->ys_flags &= ~YANG_FLAG_REINDEX;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Build hash index of children and precompute yang order of yang statements
+ * Done after parsing and populating. If children are changed after that, the index is
+ * reset and rebuilt on next lookup.
+ * @param[in]  ys       Yang statement
+ * @param[in]  recurse  Also build index of all descendants
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see yang_index_reset
+ */
+int
+yang_index_build(yang_stmt *ys,
+		 int        recurse)
+{
+    int i;
+
+    if (yang_index_node(ys) < 0)
+	return -1;
+    if (recurse)
+	for (i=0; i<ys->ys_len; i++)
+	    if (yang_index_build(ys->ys_stmt[i], 1) < 0)
+		return -1;
+    return 0;
+}
+
+/*! Reset index of yang statement when its children are changed
+ * Also resets indexes that depend on it: parents of choice/case since they index and order 
+ * data nodes in choice/case, and yang spec of (sub)modules since it has offsets of modules
+ * @param[in]  ys   Yang statement, or NULL
+ * @retval     0    OK
+ * @see yang_index_build
+ */
+int
+yang_index_reset(yang_stmt *ys)
+{
+    while (ys != NULL){
+	if (ys->ys_index){
+	    free(ys->ys_index);
+	    ys->ys_index = NULL;
+	}
+	if (ys->ys_flags & YANG_FLAG_INDEXED){
+	    ys->ys_flags &= ~YANG_FLAG_INDEXED;
+	    ys->ys_flags |= YANG_FLAG_REINDEX;
+	}
+	switch (ys->ys_keyword){
+	case Y_CHOICE:
+	case Y_CASE:
+	case Y_MODULE:
+	case Y_SUBMODULE:
+	    ys = ys->ys_parent;
+	    break;
+	default:
+	    ys = NULL;
+	    break;
+	}
+    }
+    return 0;
+}
+
+/*! Check if index of yang statement is valid, rebuild if children have changed
+ * @param[in]  yn   Yang statement
+ * @retval     1    Index and yang order of children valid (hash index may be NULL)
+ * @retval     0    Not indexed
+ */
+static int
+yang_index_valid(yang_stmt *yn)
+{
+    if (yn->ys_flags & YANG_FLAG_REINDEX)
+	yang_index_node(yn); /* On error, not indexed */
+    return (yn->ys_flags & YANG_FLAG_INDEXED) ? 1 : 0;
+}
+
+/*! Find first child in yang index
+ * @param[in]  yi        Yang index
+ * @param[in]  keyword   If 0 match any keyword
+ * @param[in]  argument  Argument
+ * @param[in]  datanode  If set, match data nodes also in choice/case, else only children
+ * @retval     ys        First matching yang statement in child order
+ * @retval     NULL      Not found
+ */
+static yang_stmt *
+yang_index_find(struct yang_index *yi,
+		int                keyword,
+		const char        *argument,
+		int                datanode)
+{
+    struct yang_index_entry *ye;
+    yang_stmt               *ys;
+    uint32_t                 h;
+    uint32_t                 i;
+
+    h = yang_index_hash(argument);
+    i = h & yi->yi_mask;
+    while ((ys = (ye = &yi->yi_entry[i])->ye_stmt) != NULL){
+	if (ye->ye_hash == h &&
+	    clixon_streq(argument, ys->ys_argument)){
+	    if (datanode){
+		if (yang_datanode(ys))
+		    return ys;
+	    }
+	    else if (!ye->ye_nested &&
+		     (keyword == 0 || ys->ys_keyword == keyword))
+		return ys;
+	}
+	i = (i + 1) & yi->yi_mask;
+    }
+    return NULL;
+}
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * @param[in]  yn         Yang node, current context node.
@@ -839,20 +1199,26 @@ yang_find(yang_stmt  *yn,
     char      *name;
     yang_stmt *yspec;
     yang_stmt *ym;
+    int        includes = 1;
 
-    for (i=0; i<yn->ys_len; i++){
-	ys = yn->ys_stmt[i];
-	if (keyword == 0 || ys->ys_keyword == keyword){
-	    if (argument == NULL ||
-		(ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)){
-		yret = ys;
-		break;
+    if (argument != NULL && yang_index_valid(yn) && yn->ys_index != NULL){
+	yret = yang_index_find(yn->ys_index, keyword, argument, 0);
+	includes = yn->ys_index->yi_includes;
+    }
+    else
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (keyword == 0 || ys->ys_keyword == keyword){
+		if (argument == NULL ||
+		    (ys->ys_argument && clixon_streq(argument, ys->ys_argument))){
+		    yret = ys;
+		    break;
+		}
 	    }
 	}
-    }
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
-    if (yret == NULL &&
+    if (yret == NULL && includes &&
 	(yang_keyword_get(yn) == Y_MODULE ||
 	 yang_keyword_get(yn) == Y_SUBMODULE)){
 	yspec = ys_spec(yn);
@@ -894,7 +1260,7 @@ yang_match(yang_stmt *yn,
 	    if (argument == NULL)
 		match++;
 	    else
-		if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+		if (ys->ys_argument && clixon_streq(argument, ys->ys_argument))
 		    match++;
 	}
     }
@@ -919,6 +1285,12 @@ yang_find_datanode(yang_stmt *yn,
     yang_stmt *ysmatch = NULL;
     char      *name;
 
+    if (argument != NULL && yang_index_valid(yn) && yn->ys_index != NULL){
+	if ((ysmatch = yang_index_find(yn->ys_index, 0, argument, 1)) != NULL ||
+	    yn->ys_index->yi_includes == 0)
+	    goto match;
+	goto includes;
+    }
     ys = NULL;
     while ((ys = yn_each(yn, ys)) != NULL){
 	if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -931,7 +1303,7 @@ yang_find_datanode(yang_stmt *yn,
 			if (argument == NULL)
 			    ysmatch = yc;
 			else
-			    if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+			    if (yc->ys_argument && clixon_streq(argument, yc->ys_argument))
 				ysmatch = yc;
 		    }
 		if (ysmatch)
@@ -943,13 +1315,14 @@ yang_find_datanode(yang_stmt *yn,
 		if (argument == NULL)
 		    ysmatch = ys;
 		else
-		    if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+		    if (ys->ys_argument && clixon_streq(argument, ys->ys_argument))
 			ysmatch = ys;
 		if (ysmatch)
 		    goto match;
 	    }
 	}
     }
+ includes:
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
     if (ysmatch == NULL &&
@@ -991,7 +1364,7 @@ yang_find_schemanode(yang_stmt *yn,
 	ys = yn->ys_stmt[i];
 	if (yang_keyword_get(ys) == Y_CHOICE){ 
 	    /* First check choice itself */
-	    if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0){
+	    if (ys->ys_argument && clixon_streq(argument, ys->ys_argument)){
 		ysmatch = ys;
 		goto match;
 	    }
@@ -1005,7 +1378,7 @@ yang_find_schemanode(yang_stmt *yn,
 			if (argument == NULL)
 			    ysmatch = yc;
 			else
-			    if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+			    if (yc->ys_argument && clixon_streq(argument, yc->ys_argument))
 				ysmatch = yc;
 		    }
 		if (ysmatch)
@@ -1019,7 +1392,7 @@ yang_find_schemanode(yang_stmt *yn,
 		else if (argument == NULL)
 		    ysmatch = ys;
 		else
-		    if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+		    if (ys->ys_argument && clixon_streq(argument, ys->ys_argument))
 			ysmatch = ys;
 		if (ysmatch)
 		    goto match;
@@ -1321,6 +1694,15 @@ yang_order(yang_stmt *y)
     yp = yang_parent_get(y);
     while (yang_keyword_get(yp) == Y_CASE || yang_keyword_get(yp) == Y_CHOICE)
 	yp = yp->ys_parent;
+    /* Precomputed order, see yang_index_build */
+    if (yp != NULL && yang_keyword_get(yp) != Y_SPEC && yang_index_valid(yp)){
+	if (y->ys_order < 0)
+	    return -1;
+	if (yang_keyword_get(yp) != Y_MODULE && yang_keyword_get(yp) != Y_SUBMODULE)
+	    return y->ys_order;
+	if ((ypp = yang_parent_get(yp)) != NULL && yang_index_valid(ypp))
+	    return yp->ys_order + y->ys_order;
+    }
 
     /* XML nodes with yang specs that are children of modules are special - 
      * In clixon, they are seen as an "implicit" container where the XML can come from different
@@ -2685,6 +3067,7 @@ yang_features(clicon_handle h,
 		    yt->ys_stmt[j-1] = yt->ys_stmt[j];
 		yt->ys_len--;
 		yt->ys_stmt[yt->ys_len] = NULL;
+		yang_index_reset(yt);
 		ys_free(ys);
 		continue; /* Don't increment i */
 		break;
@@ -3481,7 +3864,8 @@ yang_anydata_add(yang_stmt *yp,
 	clicon_err(OE_UNIX, errno, "strdup");
 	goto done;
     }
-    yang_argument_set(ys, name);
+    if (yang_argument_set(ys, name) < 0)
+	goto done;
     if (yn_insert(yp, ys) < 0){ /* Insert into hierarchy */
 	ys = NULL;
 	goto done;
@@ -0,0 +1,1241 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Compiled YANG cache
+ * The resolved YANG tree (after grouping expansion, augments, type resolution, etc)
+ * is saved in a binary file after each yang_spec_parse_module/_file/load_dir
+ * call, and loaded instead of parsing if the same sequence of calls is made with
+ * the same config options, plugins and unchanged YANG source files.
+ *
+ * The cache file is named by a key, which is a hash chained over all parse calls
+ * made on a yang spec:
+ *   key(n) = H(key(n-1), call(n), config, options, plugins)
+ * The cache file contains the key, the stat of all YANG source files and YANG and
+ * plugin directories, and the YANG tree in pre-order. A cache file is only used
+ * if all sources are unchanged (inode, size and modification time).
+ *
+ * Cache bookkeeping is kept in the (otherwise unused) cvec of the top-level yang
+ * spec: the first entry is the current key, the following are sources as
+ * <path>=<stat> pairs.
+ *
+ * Not saved: compiled regexps (re-compiled on demand), internal iteration state.
+ * The cache file format is host-specific (byte order, sizes)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_log.h"
+#include "clixon_err.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_yang_internal.h"
+#include "clixon_xml.h"
+#include "clixon_xml_io.h"
+#include "clixon_yang_module.h"
+#include "clixon_plugin.h"
+#include "clixon_data.h"
+#include "clixon_options.h"
+#include "clixon_yang_cache.h"
+#include "clixon_yang_cache_internal.h"
+
+/* Magic and format version of cache file. Increment version if format changes */
+#define YANG_CACHE_MAGIC   "CLIXYANG"
+#define YANG_CACHE_VERSION 1
+/* Byte order marker */
+#define YANG_CACHE_BOM     0x01020304
+
+/* Cache file suffix */
+#define YANG_CACHE_SUFFIX  ".yangcache"
+
+/* Null string or vector marker */
+#define YC_NULL            0xffffffff
+
+/* Config options with directories whose contents affects the yang tree */
+static const char *yang_cache_dirs[] = {
+    "CLICON_YANG_DIR",
+    "CLICON_YANG_MAIN_DIR",
+    "CLICON_BACKEND_DIR",
+    "CLICON_CLI_DIR",
+    "CLICON_NETCONF_DIR",
+    "CLICON_RESTCONF_DIR",
+    NULL
+};
+
+/* Read buffer of a mmap:ed cache file */
+typedef struct {
+    char *yb_p;   /* Current position */
+    char *yb_end; /* End of buffer */
+} yc_buf;
+
+/*! FNV-1a 64-bit hash of a string, including terminating null
+ */
+static uint64_t
+yc_hash(uint64_t    h,
+	const char *str)
+{
+    if (str == NULL)
+	str = "";
+    do {
+	h ^= (uint8_t)*str;
+	h *= 1099511628211ULL;
+    } while (*str++);
+    return h;
+}
+
+static int
+yc_strcmp(const void *a,
+	  const void *b)
+{
+    return strcmp(*(char **)a, *(char **)b);
+}
+
+/*! Compute next cache key from previous key, parse call, config and plugins
+ * @param[in]  h     Clicon handle
+ * @param[in]  key0  Previous key
+ * @param[in]  op    Parse operation
+ * @param[in]  arg   Parse argument, eg module name
+ * @param[in]  rev   Revision or NULL
+ * @param[out] key   New key
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang_cache_key(clicon_handle h,
+	       uint64_t      key0,
+	       const char   *op,
+	       const char   *arg,
+	       const char   *rev,
+	       uint64_t     *key)
+{
+    int              retval = -1;
+    uint64_t         k = key0;
+    cbuf            *cb = NULL;
+    cxobj           *x;
+    clicon_hash_t   *copt = clicon_options(h);
+    char           **keys = NULL;
+    size_t           klen;
+    size_t           i;
+    clixon_plugin_t *cp = NULL;
+
+    k = yc_hash(k, op);
+    k = yc_hash(k, arg);
+    k = yc_hash(k, rev);
+    /* Config file, including features and yang dirs */
+    if ((x = clicon_conf_xml(h)) != NULL){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (clicon_xml2cbuf(cb, x, 0, 0, -1) < 0)
+	    goto done;
+	k = yc_hash(k, cbuf_get(cb));
+    }
+    /* Options, eg set on command-line, in sorted order */
+    if (clicon_hash_keys(copt, &keys, &klen) < 0)
+	goto done;
+    if (klen)
+	qsort(keys, klen, sizeof(char*), yc_strcmp);
+    for (i=0; i<klen; i++){
+	k = yc_hash(k, keys[i]);
+	k = yc_hash(k, clicon_option_str(h, keys[i]));
+    }
+    /* Plugins may alter yang in extension callbacks */
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	k = yc_hash(k, clixon_plugin_name_get(cp));
+    *key = k;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Format stat of a file as a string for comparison
+ * @param[in]  st    Stat of file or directory
+ * @param[out] buf   Formatted string
+ * @param[in]  len   Length of buf
+ */
+static void
+yc_stat2str(struct stat *st,
+	    char        *buf,
+	    size_t       len)
+{
+    snprintf(buf, len, "%ju %jd %jd.%09ld",
+	     (uintmax_t)st->st_ino,
+	     (intmax_t)st->st_size,
+	     (intmax_t)st->st_mtim.tv_sec,
+	     (long)st->st_mtim.tv_nsec);
+}
+
+/*! Add or replace source file or dir in yang cache bookkeeping
+ * @param[in]  cvv   Yang cache bookkeeping vector
+ * @param[in]  path  File or directory
+ * @param[in]  st    Stat of path
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yc_source_set(cvec        *cvv,
+	      const char  *path,
+	      struct stat *st)
+{
+    int     retval = -1;
+    cg_var *cv;
+    char    buf[128];
+
+    yc_stat2str(st, buf, sizeof(buf));
+    if ((cv = cvec_find(cvv, (char*)path)) == NULL &&
+	(cv = cvec_add(cvv, CGV_STRING)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_add");
+	goto done;
+    }
+    if (cv_name_set(cv, path) == NULL ||
+	cv_string_set(cv, buf) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_string_set");
+	goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Register a YANG source file of a yang spec
+ *
+ * Called when a YANG file is parsed. Only recorded if the yang cache is active
+ * for the yang spec.
+ * @param[in]  yspec    Yang spec
+ * @param[in]  filename YANG file
+ * @param[in]  st       Stat of file before it is read
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+yang_cache_source_add(yang_stmt   *yspec,
+		      const char  *filename,
+		      struct stat *st)
+{
+    if (yspec == NULL || yspec->ys_keyword != Y_SPEC || yspec->ys_cvec == NULL)
+	return 0;
+    return yc_source_set(yspec->ys_cvec, filename, st);
+}
+
+/*---------------------------------------------------------------------
+ * Write cache file
+ */
+
+static int
+yc_write(FILE       *f,
+	 const void *p,
+	 size_t      len)
+{
+    if (len && fwrite(p, len, 1, f) != 1){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	return -1;
+    }
+    return 0;
+}
+
+static int
+yc_write_u32(FILE    *f,
+	     uint32_t u)
+{
+    return yc_write(f, &u, sizeof(u));
+}
+
+static int
+yc_write_str(FILE       *f,
+	     const char *str)
+{
+    uint32_t len;
+
+    if (str == NULL)
+	return yc_write_u32(f, YC_NULL);
+    len = strlen(str);
+    if (yc_write_u32(f, len) < 0)
+	return -1;
+    return yc_write(f, str, len);
+}
+
+/*! Write a cligen variable
+ * Values are written as strings and parsed on read. Save fails (retval 0) if
+ * the value cannot be restored this way, eg void pointers.
+ * @retval  1   OK
+ * @retval  0   Variable cannot be cached
+ * @retval -1   Error
+ */
+static int
+yc_write_cv(FILE   *f,
+	    cg_var *cv)
+{
+    int           retval = -1;
+    enum cv_type  type;
+    char         *val = NULL;
+    cg_var       *cv1 = NULL;
+    char         *reason = NULL;
+    int           ret;
+
+    if (cv == NULL){
+	retval = yc_write_u32(f, YC_NULL) < 0 ? -1 : 1;
+	goto done;
+    }
+    type = cv_type_get(cv);
+    if (yc_write_u32(f, type) < 0 ||
+	yc_write_u32(f, cv_flag(cv, (char)0xff)) < 0 ||
+	yc_write_str(f, cv_name_get(cv)) < 0)
+	goto done;
+    if (type == CGV_DEC64 &&
+	yc_write_u32(f, cv_dec64_n_get(cv)) < 0)
+	goto done;
+    if (type == CGV_VOID){
+	if (cv_void_get(cv) != NULL){
+	    retval = 0;
+	    goto done;
+	}
+    }
+    else if (cv_isstring(type)){
+	if ((val = cv_string_get(cv)) != NULL &&
+	    (val = strdup(val)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+    }
+    else if (type != CGV_EMPTY && type != CGV_ERR && !cv_flag(cv, V_UNSET)){
+	if ((val = cv2str_dup(cv)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	/* Check that value can be restored */
+	if ((cv1 = cv_new(type)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv_new");
+	    goto done;
+	}
+	if (type == CGV_DEC64)
+	    cv_dec64_n_set(cv1, cv_dec64_n_get(cv));
+	if ((ret = cv_parse1(val, cv1, &reason)) < 0)
+	    goto done;
+	if (ret == 0 || cv_cmp(cv, cv1) != 0){
+	    retval = 0;
+	    goto done;
+	}
+    }
+    if (yc_write_str(f, val) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (reason)
+	free(reason);
+    if (cv1)
+	cv_free(cv1);
+    if (val)
+	free(val);
+    return retval;
+}
+
+/*! Write a cligen vector
+ * @retval  1   OK
+ * @retval  0   Vector cannot be cached
+ * @retval -1   Error
+ */
+static int
+yc_write_cvec(FILE *f,
+	      cvec *cvv)
+{
+    cg_var *cv = NULL;
+    int     ret;
+
+    if (cvv == NULL)
+	return yc_write_u32(f, YC_NULL) < 0 ? -1 : 1;
+    if (yc_write_u32(f, cvec_len(cvv)) < 0)
+	return -1;
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+	if ((ret = yc_write_cv(f, cv)) < 1)
+	    return ret;
+    return 1;
+}
+
+/*! Collect all yang nodes of a yang spec in pre-order
+ * @param[in]     ys    Yang node
+ * @param[in,out] vec   Vector of nodes
+ * @param[in,out] len   Number of nodes in vec
+ * @param[in,out] max   Allocated length of vec
+ */
+static int
+yc_collect(yang_stmt    *ys,
+	   yang_stmt  ***vec,
+	   size_t       *len,
+	   size_t       *max)
+{
+    int i;
+
+    if (*len == *max){
+	*max = *max ? 2 * *max : 1024;
+	if ((*vec = realloc(*vec, *max * sizeof(yang_stmt *))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+    }
+    (*vec)[(*len)++] = ys;
+    for (i=0; i<ys->ys_len; i++)
+	if (yc_collect(ys->ys_stmt[i], vec, len, max) < 0)
+	    return -1;
+    return 0;
+}
+
+/* Pointer to index mapping, sorted on pointer */
+typedef struct {
+    yang_stmt *yi_ys;
+    uint32_t   yi_i;
+} yc_index;
+
+static int
+yc_index_cmp(const void *a,
+	     const void *b)
+{
+    const yang_stmt *ya = ((yc_index *)a)->yi_ys;
+    const yang_stmt *yb = ((yc_index *)b)->yi_ys;
+
+    return ya < yb ? -1 : ya > yb ? 1 : 0;
+}
+
+/*! Write pointer to yang node as pre-order index
+ * @retval  1   OK
+ * @retval  0   Node is not in the tree
+ * @retval -1   Error
+ */
+static int
+yc_write_ref(FILE      *f,
+	     yang_stmt *ys,
+	     yc_index  *index,
+	     size_t     len)
+{
+    yc_index  key = {ys, 0};
+    yc_index *yi;
+
+    if (ys == NULL)
+	return yc_write_u32(f, YC_NULL) < 0 ? -1 : 1;
+    if ((yi = bsearch(&key, index, len, sizeof(*index), yc_index_cmp)) == NULL)
+	return 0;
+    return yc_write_u32(f, yi->yi_i) < 0 ? -1 : 1;
+}
+
+/*! Write a yang node (not its children)
+ * @retval  1   OK
+ * @retval  0   Node cannot be cached
+ * @retval -1   Error
+ */
+static int
+yc_write_node(FILE      *f,
+	      yang_stmt *ys,
+	      yc_index  *index,
+	      size_t     len)
+{
+    int              ret;
+    yang_type_cache *yc;
+
+    if (yc_write_u32(f, ys->ys_keyword) < 0 ||
+	yc_write_u32(f, ys->ys_flags) < 0 ||
+	yc_write_u32(f, ys->ys_len) < 0 ||
+	yc_write_str(f, ys->ys_argument) < 0)
+	return -1;
+    if ((ret = yc_write_ref(f, ys->ys_mymodule, index, len)) < 1)
+	return ret;
+    if ((ret = yc_write_cv(f, ys->ys_cv)) < 1)
+	return ret;
+    if ((ret = yc_write_cvec(f, ys->ys_cvec)) < 1)
+	return ret;
+    if ((yc = ys->ys_typecache) == NULL){
+	if (yc_write_u32(f, 0) < 0)
+	    return -1;
+    }
+    else {
+	if (yc_write_u32(f, 1) < 0 ||
+	    yc_write_u32(f, yc->yc_options) < 0 ||
+	    yc_write_u32(f, yc->yc_fraction) < 0)
+	    return -1;
+	if ((ret = yc_write_cvec(f, yc->yc_cvv)) < 1)
+	    return ret;
+	if ((ret = yc_write_cvec(f, yc->yc_patterns)) < 1)
+	    return ret;
+	if ((ret = yc_write_ref(f, yc->yc_resolved, index, len)) < 1)
+	    return ret;
+    }
+    if (yc_write_str(f, ys->ys_when_xpath) < 0)
+	return -1;
+    return yc_write_cvec(f, ys->ys_when_nsc);
+}
+
+/*! Get cache file name given key
+ */
+static int
+yc_filename(clicon_handle h,
+	    uint64_t      key,
+	    char         *buf,
+	    size_t        len)
+{
+    snprintf(buf, len, "%s/%016" PRIx64 "%s",
+	     clicon_option_str(h, "CLICON_YANG_CACHE_DIR"), key, YANG_CACHE_SUFFIX);
+    return 0;
+}
+
+/*! Write cache file of yang spec under its current key
+ *
+ * The file is written to a temporary file and then renamed, so that concurrent
+ * processes never see a partial file.
+ * @param[in]  yspec  Yang spec
+ * @param[in]  f      Open file
+ * @retval     1      OK
+ * @retval     0      Yang spec cannot be cached
+ * @retval    -1      Error
+ */
+static int
+yang_cache_write(yang_stmt *yspec,
+		 uint64_t   key,
+		 FILE      *f)
+{
+    int          retval = -1;
+    yang_stmt  **vec = NULL;
+    size_t       len = 0;
+    size_t       max = 0;
+    yc_index    *index = NULL;
+    size_t       i;
+    cg_var      *cv;
+    int          ret;
+
+    /* Collect nodes in pre-order, excluding top-level spec */
+    for (i=0; i<yspec->ys_len; i++)
+	if (yc_collect(yspec->ys_stmt[i], &vec, &len, &max) < 0)
+	    goto done;
+    if (len && (index = malloc(len*sizeof(*index))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    for (i=0; i<len; i++){
+	index[i].yi_ys = vec[i];
+	index[i].yi_i = i;
+    }
+    if (len)
+	qsort(index, len, sizeof(*index), yc_index_cmp);
+    /* Header */
+    if (yc_write(f, YANG_CACHE_MAGIC, strlen(YANG_CACHE_MAGIC)) < 0 ||
+	yc_write_u32(f, YANG_CACHE_VERSION) < 0 ||
+	yc_write_u32(f, YANG_CACHE_BOM) < 0 ||
+	yc_write(f, &key, sizeof(key)) < 0)
+	goto done;
+    /* Sources, skip key */
+    if (yc_write_u32(f, cvec_len(yspec->ys_cvec) - 1) < 0)
+	goto done;
+    cv = cvec_i(yspec->ys_cvec, 0);
+    while ((cv = cvec_each1(yspec->ys_cvec, cv)) != NULL)
+	if (yc_write_str(f, cv_name_get(cv)) < 0 ||
+	    yc_write_str(f, cv_string_get(cv)) < 0)
+	    goto done;
+    /* Yang tree */
+    if (yc_write_u32(f, yspec->ys_len) < 0 ||
+	yc_write_u32(f, len) < 0)
+	goto done;
+    for (i=0; i<len; i++)
+	if ((ret = yc_write_node(f, vec[i], index, len)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+    retval = 1;
+ done:
+    if (index)
+	free(index);
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Save yang spec in cache file
+ *
+ * Failure to write the cache file is logged but is not an error.
+ * @param[in]  h      Clicon handle
+ * @param[in]  yspec  Yang spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see yang_cache_load
+ */
+int
+yang_cache_save(clicon_handle h,
+		yang_stmt    *yspec)
+{
+    int       retval = -1;
+    char      filename[MAXPATHLEN];
+    char      tmpname[MAXPATHLEN];
+    FILE     *f = NULL;
+    int       fd = -1;
+    uint64_t  key;
+    cg_var   *cv;
+    int       ret;
+
+    if (clicon_option_str(h, "CLICON_YANG_CACHE_DIR") == NULL ||
+	yspec->ys_cvec == NULL ||
+	(cv = cvec_i(yspec->ys_cvec, 0)) == NULL)
+	goto ok;
+    key = cv_uint64_get(cv);
+    yc_filename(h, key, filename, sizeof(filename));
+    snprintf(tmpname, sizeof(tmpname), "%s.XXXXXX", filename);
+    if ((fd = mkstemp(tmpname)) < 0){
+	clicon_log(LOG_WARNING, "%s: mkstemp(%s): %s", __FUNCTION__, tmpname, strerror(errno));
+	goto ok;
+    }
+    fchmod(fd, 0644);
+    if ((f = fdopen(fd, "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fdopen");
+	goto done;
+    }
+    fd = -1;
+    if ((ret = yang_cache_write(yspec, key, f)) < 0)
+	goto done;
+    if (fclose(f) != 0){
+	f = NULL;
+	clicon_err(OE_UNIX, errno, "fclose");
+	goto done;
+    }
+    f = NULL;
+    if (ret == 0){
+	clicon_debug(1, "%s yang spec cannot be cached", __FUNCTION__);
+	unlink(tmpname);
+	goto ok;
+    }
+    if (rename(tmpname, filename) < 0){
+	clicon_log(LOG_WARNING, "%s: rename(%s): %s", __FUNCTION__, filename, strerror(errno));
+	unlink(tmpname);
+	goto ok;
+    }
+    clicon_debug(1, "%s saved %s", __FUNCTION__, filename);
+ ok:
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (f){
+	fclose(f);
+	unlink(tmpname);
+    }
+    return retval;
+}
+
+/*---------------------------------------------------------------------
+ * Read cache file
+ * Read functions return 0 on malformed file, which is treated as a cache miss
+ */
+
+static int
+yc_read(yc_buf *yb,
+	void   *p,
+	size_t  len)
+{
+    if (yb->yb_end - yb->yb_p < len)
+	return 0;
+    memcpy(p, yb->yb_p, len);
+    yb->yb_p += len;
+    return 1;
+}
+
+static int
+yc_read_u32(yc_buf   *yb,
+	    uint32_t *u)
+{
+    return yc_read(yb, u, sizeof(*u));
+}
+
+/*! Read string
+ * @param[out] str  Malloced string, or NULL
+ * @retval     1    OK
+ * @retval     0    Malformed
+ * @retval    -1    Error
+ */
+static int
+yc_read_str(yc_buf *yb,
+	    char  **str)
+{
+    uint32_t len;
+
+    *str = NULL;
+    if (yc_read_u32(yb, &len) == 0)
+	return 0;
+    if (len == YC_NULL)
+	return 1;
+    if (yb->yb_end - yb->yb_p < len)
+	return 0;
+    if ((*str = malloc(len+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    memcpy(*str, yb->yb_p, len);
+    (*str)[len] = '\0';
+    yb->yb_p += len;
+    return 1;
+}
+
+/*! Read cligen variable
+ * @param[out] cvp  New cligen variable, or NULL
+ */
+static int
+yc_read_cv(yc_buf  *yb,
+	   cg_var **cvp)
+{
+    int       retval = -1;
+    uint32_t  type;
+    uint32_t  flags;
+    uint32_t  n;
+    char     *name = NULL;
+    char     *val = NULL;
+    cg_var   *cv = NULL;
+    char     *reason = NULL;
+    int       ret;
+
+    *cvp = NULL;
+    if (yc_read_u32(yb, &type) == 0)
+	goto fail;
+    if (type == YC_NULL)
+	goto ok;
+    if (yc_read_u32(yb, &flags) == 0)
+	goto fail;
+    if ((ret = yc_read_str(yb, &name)) < 1)
+	goto err;
+    if ((cv = cv_new(type)) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_new");
+	goto done;
+    }
+    if (name && cv_name_set(cv, name) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_name_set");
+	goto done;
+    }
+    if (type == CGV_DEC64){
+	if (yc_read_u32(yb, &n) == 0)
+	    goto fail;
+	cv_dec64_n_set(cv, n);
+    }
+    if ((ret = yc_read_str(yb, &val)) < 1)
+	goto err;
+    if (val != NULL){
+	if (cv_isstring(type)){
+	    if (cv_string_set(cv, val) == NULL){
+		clicon_err(OE_UNIX, errno, "cv_string_set");
+		goto done;
+	    }
+	}
+	else {
+	    if ((ret = cv_parse1(val, cv, &reason)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+    }
+    if (flags)
+	cv_flag_set(cv, flags);
+    *cvp = cv;
+    cv = NULL;
+ ok:
+    retval = 1;
+ done:
+    if (reason)
+	free(reason);
+    if (name)
+	free(name);
+    if (val)
+	free(val);
+    if (cv)
+	cv_free(cv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+ err: /* ret from sub-call: 0 or -1 */
+    retval = ret;
+    goto done;
+}
+
+/*! Read cligen vector
+ * @param[out] cvvp  New cligen vector, or NULL
+ */
+static int
+yc_read_cvec(yc_buf *yb,
+	     cvec  **cvvp)
+{
+    int       retval = -1;
+    uint32_t  len;
+    uint32_t  i;
+    cvec     *cvv = NULL;
+    cg_var   *cv = NULL;
+    int       ret;
+
+    *cvvp = NULL;
+    if (yc_read_u32(yb, &len) == 0){
+	retval = 0;
+	goto done;
+    }
+    if (len == YC_NULL)
+	goto ok;
+    if ((cvv = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    for (i=0; i<len; i++){
+	if ((ret = yc_read_cv(yb, &cv)) < 1 || cv == NULL){
+	    retval = ret < 0 ? -1 : 0;
+	    goto done;
+	}
+	if (cvec_append_var(cvv, cv) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_append_var");
+	    goto done;
+	}
+	cv_free(cv);
+	cv = NULL;
+    }
+    *cvvp = cvv;
+    cvv = NULL;
+ ok:
+    retval = 1;
+ done:
+    if (cv)
+	cv_free(cv);
+    if (cvv)
+	cvec_free(cvv);
+    return retval;
+}
+
+/*! Read yang node and its children in pre-order
+ * @param[in]     yb     Read buffer
+ * @param[in]     yp     Parent, node is added last to parent
+ * @param[in,out] vec    Vector of nodes in pre-order
+ * @param[in,out] refs   Unresolved references: (mymodule, resolved) per node
+ * @param[in,out] i      Next index
+ * @param[in]     len    Total number of nodes
+ */
+static int
+yc_read_node(yc_buf     *yb,
+	     yang_stmt  *yp,
+	     yang_stmt **vec,
+	     uint32_t   *refs,
+	     uint32_t   *i,
+	     uint32_t    len)
+{
+    int              retval = -1;
+    yang_stmt       *ys = NULL;
+    uint32_t         keyword;
+    uint32_t         flags;
+    uint32_t         nchildren;
+    uint32_t         u;
+    uint32_t         j;
+    uint32_t         self;
+    yang_type_cache *yc;
+    char            *arg;
+    int              ret;
+
+    if (*i >= len)
+	goto fail;
+    self = (*i)++;
+    if (yc_read_u32(yb, &keyword) == 0 ||
+	yc_read_u32(yb, &flags) == 0 ||
+	yc_read_u32(yb, &nchildren) == 0)
+	goto fail;
+    if (nchildren > len)
+	goto fail;
+    if ((ys = malloc(sizeof(*ys))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ys, 0, sizeof(*ys));
+    ys->ys_keyword = keyword;
+    ys->ys_flags = flags & ~(YANG_FLAG_INDEXED|YANG_FLAG_REINDEX); /* Index is not cached */
+    ys->ys_order = -1;
+    /* Add to parent directly so that it is freed with parent on error */
+    yp->ys_stmt[yp->ys_len++] = ys;
+    ys->ys_parent = yp;
+    vec[self] = ys;
+    if (nchildren &&
+	(ys->ys_stmt = calloc(nchildren, sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if ((ret = yc_read_str(yb, &arg)) < 1)
+	goto err;
+    if (yang_argument_set(ys, arg) < 0) /* consumes arg */
+	goto done;
+    if (yc_read_u32(yb, &refs[2*self]) == 0)
+	goto fail;
+    if ((ret = yc_read_cv(yb, &ys->ys_cv)) < 1)
+	goto err;
+    if ((ret = yc_read_cvec(yb, &ys->ys_cvec)) < 1)
+	goto err;
+    if (yc_read_u32(yb, &u) == 0)
+	goto fail;
+    refs[2*self+1] = YC_NULL;
+    if (u){
+	if ((yc = malloc(sizeof(*yc))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(yc, 0, sizeof(*yc));
+	ys->ys_typecache = yc;
+	if (yc_read_u32(yb, &u) == 0)
+	    goto fail;
+	yc->yc_options = u;
+	if (yc_read_u32(yb, &u) == 0)
+	    goto fail;
+	yc->yc_fraction = u;
+	if ((ret = yc_read_cvec(yb, &yc->yc_cvv)) < 1)
+	    goto err;
+	if ((ret = yc_read_cvec(yb, &yc->yc_patterns)) < 1)
+	    goto err;
+	if (yc_read_u32(yb, &refs[2*self+1]) == 0)
+	    goto fail;
+    }
+    if ((ret = yc_read_str(yb, &ys->ys_when_xpath)) < 1)
+	goto err;
+    if ((ret = yc_read_cvec(yb, &ys->ys_when_nsc)) < 1)
+	goto err;
+    for (j=0; j<nchildren; j++)
+	if ((ret = yc_read_node(yb, ys, vec, refs, i, len)) < 1)
+	    goto err;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+ err: /* ret from sub-call: 0 or -1 */
+    retval = ret;
+    goto done;
+}
+
+/*! Check that sources of a cache file are unchanged
+ * @retval  1   OK, all sources unchanged
+ * @retval  0   Changed or malformed
+ * @retval -1   Error
+ */
+static int
+yc_read_sources(yc_buf *yb,
+		cvec   *cvv)
+{
+    int         retval = -1;
+    uint32_t    n;
+    uint32_t    i;
+    char       *path = NULL;
+    char       *stat0 = NULL;
+    char        buf[128];
+    struct stat st;
+    cg_var     *cv;
+    int         ret;
+
+    if (yc_read_u32(yb, &n) == 0)
+	goto fail;
+    for (i=0; i<n; i++){
+	if ((ret = yc_read_str(yb, &path)) < 1 ||
+	    (ret = yc_read_str(yb, &stat0)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+	if (path == NULL || stat0 == NULL || stat(path, &st) < 0)
+	    goto fail;
+	yc_stat2str(&st, buf, sizeof(buf));
+	if (strcmp(buf, stat0) != 0){
+	    clicon_debug(1, "%s %s changed", __FUNCTION__, path);
+	    goto fail;
+	}
+	if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add");
+	    goto done;
+	}
+	if (cv_name_set(cv, path) == NULL ||
+	    cv_string_set(cv, stat0) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv_string_set");
+	    goto done;
+	}
+	free(path);
+	path = NULL;
+	free(stat0);
+	stat0 = NULL;
+    }
+    retval = 1;
+ done:
+    if (path)
+	free(path);
+    if (stat0)
+	free(stat0);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read cache file into new yang spec
+ * @param[in]  yb     Read buffer of file
+ * @param[in]  key    Expected key
+ * @param[out] ysp    New yang spec with sources in cvec
+ * @retval     1      OK
+ * @retval     0      Invalid or changed sources
+ * @retval    -1      Error
+ */
+static int
+yang_cache_read(yc_buf     *yb,
+		uint64_t    key,
+		yang_stmt **ysp)
+{
+    int         retval = -1;
+    char        magic[sizeof(YANG_CACHE_MAGIC)-1];
+    uint32_t    u;
+    uint64_t    key0;
+    uint32_t    nmod;
+    uint32_t    len;
+    uint32_t    i;
+    uint32_t    j;
+    yang_stmt  *yspec = NULL;
+    yang_stmt **vec = NULL;
+    uint32_t   *refs = NULL;
+    int         ret;
+
+    if (yc_read(yb, magic, sizeof(magic)) == 0 ||
+	memcmp(magic, YANG_CACHE_MAGIC, sizeof(magic)) != 0 ||
+	yc_read_u32(yb, &u) == 0 || u != YANG_CACHE_VERSION ||
+	yc_read_u32(yb, &u) == 0 || u != YANG_CACHE_BOM ||
+	yc_read(yb, &key0, sizeof(key0)) == 0 || key0 != key)
+	goto fail;
+    if ((yspec = yspec_new()) == NULL)
+	goto done;
+    if ((yspec->ys_cvec = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if (cvec_add(yspec->ys_cvec, CGV_UINT64) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_add");
+	goto done;
+    }
+    cv_uint64_set(cvec_i(yspec->ys_cvec, 0), key);
+    if ((ret = yc_read_sources(yb, yspec->ys_cvec)) < 1)
+	goto err;
+    if (yc_read_u32(yb, &nmod) == 0 ||
+	yc_read_u32(yb, &len) == 0 ||
+	nmod > len ||
+	len > (yb->yb_end - yb->yb_p)) /* Sanity: at least one byte per node */
+	goto fail;
+    if (len){
+	if ((vec = calloc(len, sizeof(*vec))) == NULL ||
+	    (refs = calloc(2*len, sizeof(*refs))) == NULL ||
+	    (yspec->ys_stmt = calloc(nmod, sizeof(yang_stmt *))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+    }
+    i = 0;
+    for (j=0; j<nmod; j++)
+	if ((ret = yc_read_node(yb, yspec, vec, refs, &i, len)) < 1)
+	    goto err;
+    if (i != len || yb->yb_p != yb->yb_end)
+	goto fail;
+    /* Resolve references */
+    for (i=0; i<len; i++){
+	if ((u = refs[2*i]) != YC_NULL){
+	    if (u >= len)
+		goto fail;
+	    vec[i]->ys_mymodule = vec[u];
+	}
+	if ((u = refs[2*i+1]) != YC_NULL){
+	    if (u >= len || vec[i]->ys_typecache == NULL)
+		goto fail;
+	    vec[i]->ys_typecache->yc_resolved = vec[u];
+	}
+    }
+    *ysp = yspec;
+    yspec = NULL;
+    retval = 1;
+ done:
+    if (refs)
+	free(refs);
+    if (vec)
+	free(vec);
+    if (yspec)
+	ys_free(yspec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+ err: /* ret from sub-call: 0 or -1 */
+    retval = ret;
+    goto done;
+}
+
+/*! Load yang spec from cache file, if it exists and is valid
+ *
+ * Computes a new cache key from the previous key of the yang spec and this
+ * parse call. If a valid cache file with the new key exists, the children of
+ * yspec are replaced with the cached tree.
+ * Otherwise, the caller should parse as usual, and then call yang_cache_save().
+ * @param[in]  h      Clicon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  op     Parse operation, eg "module"
+ * @param[in]  arg    Parse argument, eg module name
+ * @param[in]  rev    Revision or NULL
+ * @retval     1      Loaded from cache
+ * @retval     0      Not loaded: not enabled, not found or not valid
+ * @retval    -1      Error
+ * @see yang_cache_save
+ * @note Pointers to yang nodes in yspec obtained before this call are invalid if loaded
+ */
+int
+yang_cache_load(clicon_handle h,
+		yang_stmt    *yspec,
+		const char   *op,
+		const char   *arg,
+		const char   *rev)
+{
+    int          retval = -1;
+    char        *dir;
+    uint64_t     key0 = 0;
+    uint64_t     key;
+    cg_var      *cv;
+    cxobj       *x;
+    cxobj       *xc;
+    struct stat  st;
+    char         filename[MAXPATHLEN];
+    int          fd = -1;
+    void        *p = MAP_FAILED;
+    size_t       len = 0;
+    yc_buf       yb;
+    yang_stmt   *ynew = NULL;
+    int          i;
+    const char **d;
+    int          ret;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+	goto ok;
+    if (yspec->ys_cvec == NULL){
+	/* Only start caching on empty yang spec */
+	if (yspec->ys_len != 0)
+	    goto ok;
+	if ((yspec->ys_cvec = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	if (cvec_add(yspec->ys_cvec, CGV_UINT64) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add");
+	    goto done;
+	}
+	cv_uint64_set(cvec_i(yspec->ys_cvec, 0), 14695981039346656037ULL);
+    }
+    cv = cvec_i(yspec->ys_cvec, 0);
+    key0 = cv_uint64_get(cv);
+    if (yang_cache_key(h, key0, op, arg, rev, &key) < 0)
+	goto done;
+    cv_uint64_set(cv, key);
+    /* Directories whose contents affect which files are found, or plugins */
+    if ((x = clicon_conf_xml(h)) != NULL){
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	    for (d = yang_cache_dirs; *d; d++)
+		if (strcmp(xml_name(xc), *d) == 0)
+		    break;
+	    if (*d == NULL || xml_body(xc) == NULL)
+		continue;
+	    if (stat(xml_body(xc), &st) == 0 &&
+		yc_source_set(yspec->ys_cvec, xml_body(xc), &st) < 0)
+		goto done;
+	}
+    }
+    yc_filename(h, key, filename, sizeof(filename));
+    if ((fd = open(filename, O_RDONLY)) < 0){
+	clicon_debug(1, "%s %s not found", __FUNCTION__, filename);
+	goto ok;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+	goto ok;
+    len = st.st_size;
+    if ((p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+	clicon_err(OE_UNIX, errno, "mmap");
+	goto done;
+    }
+    yb.yb_p = p;
+    yb.yb_end = (char*)p + len;
+    if ((ret = yang_cache_read(&yb, key, &ynew)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_debug(1, "%s %s not valid", __FUNCTION__, filename);
+	goto ok;
+    }
+    /* Replace children and sources of yspec with cached */
+    for (i=0; i<yspec->ys_len; i++)
+	ys_free(yspec->ys_stmt[i]);
+    if (yspec->ys_stmt)
+	free(yspec->ys_stmt);
+    yspec->ys_stmt = ynew->ys_stmt;
+    yspec->ys_len = ynew->ys_len;
+    for (i=0; i<yspec->ys_len; i++)
+	yspec->ys_stmt[i]->ys_parent = yspec;
+    ynew->ys_stmt = NULL;
+    ynew->ys_len = 0;
+    yang_index_reset(yspec);
+    cvec_free(yspec->ys_cvec);
+    yspec->ys_cvec = ynew->ys_cvec;
+    ynew->ys_cvec = NULL;
+    clicon_debug(1, "%s loaded %s", __FUNCTION__, filename);
+    retval = 1;
+    goto done;
+ ok:
+    retval = 0;
+ done:
+    if (ynew)
+	ys_free(ynew);
+    if (p != MAP_FAILED)
+	munmap(p, len);
+    if (fd != -1)
+	close(fd);
+    return retval;
+}
@@ -93,6 +93,9 @@ struct yang_stmt{
     char              *ys_when_xpath; /* Special conditional for a "when"-associated augment/uses xpath */
     cvec              *ys_when_nsc;   /* Special conditional for a "when"-associated augment/uses namespace ctx */
     int               _ys_vector_i;   /* internal use: yn_each */
+    struct yang_index *ys_index;     /* Hash index of children, see yang_index_build */
+    int                ys_order;     /* Yang order of data node if parent is indexed,
+					for (sub)modules: offset in yang spec */
 
 };
 
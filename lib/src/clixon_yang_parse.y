@@ -312,8 +312,9 @@ ysp_add(clixon_yang_yacc *yy,
     }
     if ((ys = ys_new(keyword)) == NULL)
 	goto err;
-    /* NOTE: does not make a copy of string, ie argument is 'consumed' here */
-    yang_argument_set(ys, argument);
+    /* NOTE: argument is 'consumed' here, replaced by interned copy */
+    if (yang_argument_set(ys, argument) < 0)
+	goto err;
     if (yn_insert(yn, ys) < 0) /* Insert into hierarchy */
 	goto err; 
     if (ys_parse_sub(ys, extra) < 0)     /* Check statement-specific syntax */
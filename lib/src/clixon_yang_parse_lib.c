@@ -98,6 +98,8 @@
 #include "clixon_options.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_parse.h"
+#include "clixon_yang_cache.h"
+#include "clixon_yang_cache_internal.h"
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_parse_lib.h"
 
@@ -647,6 +649,7 @@ yang_expand_uses_node(yang_stmt *yn,
 	yg->ys_parent = yn;
 	k++;
     }
+    yang_index_reset(yn);
     /* Remove 'uses' node */
     ys_free(ys); 
     /* Remove the grouping copy */
@@ -967,6 +970,8 @@ yang_parse_filename(const char *filename,
 	clicon_err(OE_YANG, errno, "%s not found", filename);
 	goto done;
     }
+    if (yang_cache_source_add(yspec, filename, &st) < 0)
+	goto done;
     if ((fp = fopen(filename, "r")) == NULL){
 	clicon_err(OE_YANG, errno, "fopen(%s)", filename);	
 	goto done;
@@ -1367,6 +1372,25 @@ yang_sort_modules(yang_stmt          *yspec,
     return retval;
 }
 
+/*! Build child indexes of new modules and of yang spec
+ * @param[in] yspec   Yang specification
+ * @param[in] modmin  New modules start at this number
+ * @retval    0       OK
+ * @retval   -1       Error
+ * @see yang_index_build
+ */
+static int
+yang_spec_index(yang_stmt *yspec,
+		int        modmin)
+{
+    int i;
+
+    for (i=modmin; i<yang_len_get(yspec); i++)
+	if (yang_index_build(yang_child_i(yspec, i), 1) < 0)
+	    return -1;
+    return yang_index_build(yspec, 0);
+}
+
 /*! Parse top yang module including all its sub-modules. Expand and populate yang tree
  *
  * Perform secondary actions after yang parsing. These actions cannot be made at
@@ -1488,6 +1512,9 @@ yang_parse_post(clicon_handle h,
     for (i=0; i<ylen; i++)
 	if (yang_cardinality(h, ylist[i], yang_argument_get(ylist[i])) < 0)
 	    goto done;
+    /* 12. Build child indexes of new modules */
+    if (yang_spec_index(yspec, modmin) < 0)
+	goto done;
     retval = 0;
  done:
     if (ylist)
@@ -1495,6 +1522,48 @@ yang_parse_post(clicon_handle h,
     return retval;
 }
 
+/*! Pin xpath of a must, when or leafref path statement in the xpath cache
+ * @param[in]  ys   Yang statement
+ * @param[in]  arg  Not used
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ys_xpath_pin(yang_stmt *ys,
+	     void      *arg)
+{
+    switch (yang_keyword_get(ys)){
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+	if (xpath_cache_pin(yang_argument_get(ys)) < 0)
+	    return -1;
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Pin schema xpaths of modules loaded from the yang cache, normally done when parsing
+ * @param[in] yspec   Yang specification
+ * @param[in] modmin  Modules loaded from cache start at this number
+ * @retval    0       OK
+ * @retval   -1       Error
+ * @see ys_parse_sub
+ */
+static int
+yang_xpath_pin(yang_stmt *yspec,
+	       int        modmin)
+{
+    int i;
+
+    for (i=modmin; i<yang_len_get(yspec); i++)
+	if (yang_apply(yang_child_i(yspec, i), -1, ys_xpath_pin, 0, NULL) < 0)
+	    return -1;
+    return 0;
+}
+
 /*! Parse yang specification and its dependencies recursively given module
  * @param[in]  h         clicon handle
  * @param[in]  module    Module name, or absolute filename (including dir)
@@ -1513,6 +1582,7 @@ yang_spec_parse_module(clicon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+    int         ret;
 
     if (yspec == NULL){
 	clicon_err(OE_YANG, EINVAL, "yang spec is NULL");
@@ -1527,11 +1597,22 @@ yang_spec_parse_module(clicon_handle h,
     /* Do not load module if it already exists */
     if (yang_find_module_by_name_revision(yspec, name, revision) != NULL)
 	goto ok;
+    if ((ret = yang_cache_load(h, yspec, "module", name, revision)) < 0)
+	goto done;
+    if (ret == 1){
+	if (yang_xpath_pin(yspec, modmin) < 0)
+	    goto done;
+	if (yang_spec_index(yspec, 0) < 0) /* All modules replaced by cache */
+	    goto done;
+	goto ok;
+    }
     /* Find a yang module and parse it and all its submodules */
     if (yang_parse_module(h, name, revision, yspec) == NULL)
 	goto done;
     if (yang_parse_post(h, yspec, modmin) < 0)
 	goto done;
+    if (yang_cache_save(h, yspec) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -1558,6 +1639,7 @@ yang_spec_parse_file(clicon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+    int         ret;
 
     /* Apply steps 2.. on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
@@ -1574,10 +1656,21 @@ yang_spec_parse_file(clicon_handle h,
 	*index(base, '@') = '\0';
     if (yang_find(yspec, Y_MODULE, base) != NULL)
 	goto ok;
+    if ((ret = yang_cache_load(h, yspec, "file", filename, NULL)) < 0)
+	goto done;
+    if (ret == 1){
+	if (yang_xpath_pin(yspec, modmin) < 0)
+	    goto done;
+	if (yang_spec_index(yspec, 0) < 0) /* All modules replaced by cache */
+	    goto done;
+	goto ok;
+    }
     if (yang_parse_filename(filename, yspec) == NULL)
 	goto done;
     if (yang_parse_post(h, yspec, modmin) < 0)
 	goto done;
+    if (yang_cache_save(h, yspec) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -1622,6 +1715,7 @@ yang_spec_load_dir(clicon_handle h,
     uint32_t       rev0; /* revision in existing module */
     char          *oldbase = NULL;
     int            taken = 0;
+    int            ret;
     
     /* Get yang files names from yang module directory. Note that these
      * are sorted alphatetically:
@@ -1635,6 +1729,15 @@ yang_spec_load_dir(clicon_handle h,
 	goto ok;
     /* Apply post steps on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
+    if ((ret = yang_cache_load(h, yspec, "dir", dir, NULL)) < 0)
+	goto done;
+    if (ret == 1){
+	if (yang_xpath_pin(yspec, modmin) < 0)
+	    goto done;
+	if (yang_spec_index(yspec, 0) < 0) /* All modules replaced by cache */
+	    goto done;
+	goto ok;
+    }
     /* Load all yang files in dir */
     for (i = 0; i < ndp; i++) {
 	/* base = module name [+ @rev ] + .yang */
@@ -1703,6 +1806,8 @@ yang_spec_load_dir(clicon_handle h,
     }
     if (yang_parse_post(h, yspec, modmin) < 0)
 	goto done;
+    if (yang_cache_save(h, yspec) < 0)
+	goto done;
  ok:
     retval = 0;
   done:
@@ -1840,7 +1945,9 @@ ys_parse_sub(yang_stmt *ys,
 	break;
     case Y_MUST:
     case Y_WHEN:
-	if (xpath_parse(yang_argument_get(ys), NULL) < 0)
+    case Y_PATH:
+	/* Check syntax and keep parsed xpath for validation */
+	if (xpath_cache_pin(yang_argument_get(ys)) < 0)
 	    goto done;
 	break;
     case Y_REVISION:
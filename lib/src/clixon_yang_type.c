@@ -48,7 +48,7 @@
  * |                 \    /
  * |                  \  /    yang_type_cache_regex_set
  * ys_populate_leaf,   +--> compile_pattern2regexp (compile regexps)
- * xml_cv_cache (NULL) +--> cv_validate1 --> cv_validate_pattern (exec regexps)
+ * xml_cmp_body (NULL) +--> cv_validate1 --> cv_validate_pattern (exec regexps)
  * yang_type2cv (simplified)
  *
  * NOTE
@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+# Non-blocking backend client sessions, see from_client
+# A client that sends half a message and pauses must not block other sessions.
+# Check that:
+# - another session is served while the partial message is pending
+# - the partial message is dispatched when the rest arrives
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Raw unit tester of backend unix socket
+: ${clixon_util_socket:=clixon_util_socket}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/nonblock.yang
+sock=$dir/sock
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>$sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module nonblock{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container c{
+    leaf v {
+      type string;
+    }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "slow client sends half a message and pauses"
+echo "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" | $clixon_util_socket -s $sock -P 3 -D $DBG > $dir/slow.out &
+pid=$!
+sleep 1
+
+new "other session is served"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><v>x</v></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "slow client is still pending"
+if ! kill -0 $pid 2> /dev/null; then
+    err "slow client running" "slow client done"
+fi
+
+new "slow client gets reply"
+wait $pid
+if [ $? -ne 0 ]; then
+    err "0" "$?"
+fi
+match=$(grep -c "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><v>x</v></c></data></rpc-reply>" $dir/slow.out)
+if [ $match -ne 1 ]; then
+    err "<rpc-reply><data>" "$(cat $dir/slow.out)"
+fi
+
+new "Discard changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset clixon_util_socket
+
+new "endtest"
+endtest
@@ -0,0 +1,149 @@
+#!/usr/bin/env bash
+# Datastore edit journal, see CLICON_XMLDB_JOURNAL
+# Edits are appended to <db>_db.journal instead of rewriting the datastore file.
+# Check that:
+# - edits are journaled and not written to the datastore file
+# - journal follows the datastore on commit (copy)
+# - journal is replayed on restart
+# - an incomplete compaction (temporary file) is removed on restart
+# - journal is compacted into the datastore file when full
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/journal.yang
+
+# Max number of edits in journal
+: ${nr:=3}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_JOURNAL>$nr</CLICON_XMLDB_JOURNAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module journal{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix jr;
+  container c{
+    list y {
+      key "name";
+      leaf name {
+        type string;
+      }
+      leaf value {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add entry a1"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><y><name>a1</name><value>foo</value></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Add entry a2 using prefix declared in rpc"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS xmlns:jr=\"urn:example:clixon\"><edit-config><target><candidate/></target><config><jr:c><jr:y><jr:name>a2</jr:name><jr:value>bar</jr:value></jr:y></jr:c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Check candidate journal exists"
+if [ ! -f $dir/candidate_db.journal ]; then
+    err "$dir/candidate_db.journal"
+fi
+
+new "Check candidate file does not contain a2"
+expectpart "$(sudo cat $dir/candidate_db)" 0 "" --not-- "<name>a2</name>"
+
+new "Get candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><y><name>a1</name><value>foo</value></y><y><name>a2</name><value>bar</value></y></c></data></rpc-reply>]]>]]>$"
+
+new "Commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Check running journal exists"
+if [ ! -f $dir/running_db.journal ]; then
+    err "$dir/running_db.journal"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    # Compaction interrupted while writing the temporary file
+    sudo sh -c "echo '<config><c xmlns=\"urn:example:clixon\"><y>' > $dir/running_db.tmp"
+
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Get running after restart"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><y><name>a1</name><value>foo</value></y><y><name>a2</name><value>bar</value></y></c></data></rpc-reply>]]>]]>$"
+
+new "Check incomplete compaction removed"
+if [ -f $dir/running_db.tmp ]; then
+    err "no $dir/running_db.tmp"
+fi
+
+new "Delete entry a1"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><y nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><name>a1</name></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# Fill journal until compacted
+for (( i=3; i<$nr+4; i++ )); do
+    new "Add entry a$i"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><y><name>a$i</name></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+done
+
+new "Check candidate file contains a$nr after compaction"
+expectpart "$(sudo cat $dir/candidate_db)" 0 "<name>a$nr</name>" --not-- "<name>a1</name>"
+
+new "Get candidate after compaction"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/jr:c/jr:y[jr:name='a1']\" xmlns:jr=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+unset nr
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Asynchronous backend rpcs from native restconf, see CLICON_RPC_ASYNC_SOCKETS
+# GET requests on http/2 streams are sent to the backend without waiting for the reply.
+# Check that:
+# - parallel GETs on one http/2 connection get their own replies
+# - errors and HEAD are replied the same way
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ "${WITH_RESTCONF}" != "native" -o ${HAVE_LIBNGHTTP2} = false ]; then
+    echo "...skipped: only native restconf with http/2"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/async.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RPC_ASYNC_SOCKETS>2</CLICON_RPC_ASYNC_SOCKETS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module async{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type string;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+for k in a1 a2 a3 a4; do
+    new "restconf PUT list entry $k"
+    expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/async:c/a=$k -d "{\"async:a\":{\"k\":\"$k\",\"v\":\"v$k\"}}")" 0 "HTTP/$HVER 201"
+done
+
+new "restconf parallel GETs on one connection"
+expectpart "$(curl $CURLOPTS --parallel -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/async:c/a=a1 $RCPROTO://localhost/restconf/data/async:c/a=a2 $RCPROTO://localhost/restconf/data/async:c/a=a3 $RCPROTO://localhost/restconf/data/async:c/a=a4)" 0 "HTTP/$HVER 200" '{"async:a":\[{"k":"a1","v":"va1"}\]}' '{"async:a":\[{"k":"a2","v":"va2"}\]}' '{"async:a":\[{"k":"a3","v":"va3"}\]}' '{"async:a":\[{"k":"a4","v":"va4"}\]}'
+
+new "restconf GET whole container"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/async:c)" 0 "HTTP/$HVER 200" '{"async:c":{"a":\[{"k":"a1","v":"va1"},{"k":"a2","v":"va2"},{"k":"a3","v":"va3"},{"k":"a4","v":"va4"}\]}}'
+
+new "restconf GET non-existent entry"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/async:c/a=a5)" 0 "HTTP/$HVER 404" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"invalid-value","error-severity":"error","error-message":"Instance does not exist"}}}'
+
+new "restconf HEAD entry"
+expectpart "$(curl $CURLOPTS --head -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/async:c/a=a1)" 0 "HTTP/$HVER 200" "Content-Type: application/yang-data+json"
+
+new "restconf DELETE entries"
+expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/async:c)" 0 "HTTP/$HVER 204"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,192 @@
+#!/usr/bin/env bash
+# Native restconf clients that do not read their replies, over TLS
+# Replies larger than the high-water mark of a connection are written in TLS partial writes
+# when the socket is writable, see restconf_conn_write
+# Check that:
+# - a slow reader of a large reply gets the whole reply, over http/2 and http/1.1
+# - other connections are served while the slow reader reads
+# - the error reply to a plain HTTP request on the HTTPS port is written before close
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    echo "...skipped: only native restconf"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/slow.yang
+fdata=$dir/data.json
+
+RCPROTO=https # partial TLS writes
+
+# Number of list entries of large data, more than the high-water mark of 1MB
+nr=20000
+
+# Read rate of slow reader, so that the large reply takes some seconds
+rate=500k
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module slow{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type string;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+   container d{
+      leaf v{
+         type string;
+      }
+   }
+}
+EOF
+
+# Large data: nr list entries with long values
+echo -n "{\"slow:c\":{\"a\":[" > $fdata
+for (( i=1; i<=$nr; i++ )); do
+    if [ $i -gt 1 ]; then
+	echo -n "," >> $fdata
+    fi
+    echo -n "{\"k\":\"a$i\",\"v\":\"0123456789012345678901234567890123456789$i\"}" >> $fdata
+done
+echo -n "]}}" >> $fdata
+
+# Start a slow reader of the large data in the background, and check that small data is
+# read on other connections meanwhile
+# arg1: extra curl options, eg http version
+# arg2: output file
+function slow_reader()
+{
+    opts=$1
+    fout=$2
+
+    curl $CURLOPTS $opts --limit-rate $rate -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/slow:c > $fout 2>&1 &
+    pid=$!
+    sleep 1
+
+    for i in $(seq 1 5); do
+	new "restconf GET small data while slow reader $i"
+	expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/slow:d)" 0 "HTTP/$HVER 200" '{"slow:d":{"v":"x"}}'
+    done
+
+    new "slow reader is still reading"
+    if ! kill -0 $pid 2> /dev/null; then
+	err "slow reader running" "slow reader done"
+    fi
+
+    new "wait for slow reader"
+    wait $pid
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf PUT $nr list entries"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/slow:c -d @$fdata)" 0 "HTTP/$HVER 201"
+
+new "restconf PUT small data"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/slow:d -d '{"slow:d":{"v":"x"}}')" 0 "HTTP/$HVER 201"
+
+slow_reader "" $dir/slow.out
+
+new "slow reader gets whole reply"
+expectpart "$(cat $dir/slow.out)" 0 "HTTP/$HVER 200" '{"slow:c":{"a":\[{"k":"a1","v":"0123456789012345678901234567890123456789' "{\"k\":\"a$nr\",\"v\":\"0123456789012345678901234567890123456789$nr\"}\]}}"
+
+if ${HAVE_LIBNGHTTP2} && ${HAVE_LIBEVHTP}; then
+    slow_reader "--http1.1" $dir/slow1.out
+
+    new "slow http/1.1 reader gets whole reply"
+    expectpart "$(cat $dir/slow1.out)" 0 "HTTP/1.1 200" "{\"k\":\"a$nr\",\"v\":\"0123456789012345678901234567890123456789$nr\"}\]}}"
+fi
+
+# The connection is closed after the reply is written
+new "restconf plain HTTP request on HTTPS port"
+expectpart "$(curl -Ssi -X GET http://localhost:443/restconf/data/slow:d)" 0 "HTTP/1.1 400" "<error-message>The plain HTTP request was sent to HTTPS port</error-message></error></errors>"
+
+new "restconf GET small data after error"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/slow:d)" 0 "HTTP/$HVER 200" '{"slow:d":{"v":"x"}}'
+
+new "restconf DELETE large data"
+expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/slow:c)" 0 "HTTP/$HVER 204"
+
+new "restconf DELETE small data"
+expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/slow:d)" 0 "HTTP/$HVER 204"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+# Native restconf with threads for TLS handshakes and encoding of replies, see threads in
+# clixon-restconf.yang
+# The thread queue is short, so that some jobs are made in the event loop.
+# Check that:
+# - parallel GETs of large and small data on one http/2 connection get their own replies
+# - replies are the same in JSON and XML
+# - errors and HEAD are replied the same way
+# - new connections are accepted while other GETs are encoded
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ "${WITH_RESTCONF}" != "native" -o ${HAVE_LIBNGHTTP2} = false ]; then
+    echo "...skipped: only native restconf with http/2"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/threads.yang
+
+# Number of list entries of large data
+nr=1000
+
+# Define default restconfig config: RESTCONFIG, with threads
+RESTCONFIG=$(restconf_config none false | sed "s/<socket>/<threads>2<\/threads><thread-queue-length>1<\/thread-queue-length><socket>/")
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RPC_ASYNC_SOCKETS>2</CLICON_RPC_ASYNC_SOCKETS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module threads{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type string;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+   container d{
+      leaf v{
+         type string;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+# Large data: nr list entries in one PUT
+data="{\"threads:c\":{\"a\":["
+for (( i=1; i<=$nr; i++ )); do
+    if [ $i -gt 1 ]; then
+	data="$data,"
+    fi
+    data="$data{\"k\":\"a$i\",\"v\":\"va$i\"}"
+done
+data="$data]}}"
+
+new "restconf PUT $nr list entries"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:c -d "$data")" 0 "HTTP/$HVER 201"
+
+new "restconf PUT small data"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:d -d '{"threads:d":{"v":"x"}}')" 0 "HTTP/$HVER 201"
+
+new "restconf GET large data json"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:c)" 0 "HTTP/$HVER 200" '{"threads:c":{"a":\[{"k":"a1","v":"va1"},' "{\"k\":\"a$nr\",\"v\":\"va$nr\"}\]}}"
+
+new "restconf GET large data xml"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+xml" $RCPROTO://localhost/restconf/data/threads:c)" 0 "HTTP/$HVER 200" '<c xmlns="urn:example:clixon"><a><k>a1</k><v>va1</v></a>' "<a><k>a$nr</k><v>va$nr</v></a></c>"
+
+new "restconf parallel GETs of large and small data on one connection"
+expectpart "$(curl $CURLOPTS --parallel -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:c $RCPROTO://localhost/restconf/data/threads:d $RCPROTO://localhost/restconf/data/threads:c/a=a2 $RCPROTO://localhost/restconf/data/threads:c $RCPROTO://localhost/restconf/data/threads:d)" 0 "HTTP/$HVER 200" '{"threads:d":{"v":"x"}}' '{"threads:a":\[{"k":"a2","v":"va2"}\]}' "{\"k\":\"a$nr\",\"v\":\"va$nr\"}\]}}"
+
+new "restconf GET list entry"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:c/a=a$nr)" 0 "HTTP/$HVER 200" "{\"threads:a\":\[{\"k\":\"a$nr\",\"v\":\"va$nr\"}\]}"
+
+new "restconf GET non-existent entry"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:c/a=x)" 0 "HTTP/$HVER 404" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"invalid-value","error-severity":"error","error-message":"Instance does not exist"}}}'
+
+new "restconf HEAD large data"
+expectpart "$(curl $CURLOPTS --head -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:c)" 0 "HTTP/$HVER 200" "Content-Type: application/yang-data+json"
+
+# Each request is a new connection, with a TLS handshake if https
+for i in $(seq 1 10); do
+    new "restconf GET small data on new connection $i"
+    expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/threads:d)" 0 "HTTP/$HVER 200" '{"threads:d":{"v":"x"}}'
+done
+
+new "restconf DELETE large data"
+expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/threads:c)" 0 "HTTP/$HVER 204"
+
+new "restconf DELETE small data"
+expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/threads:d)" 0 "HTTP/$HVER 204"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,244 @@
+#!/usr/bin/env bash
+# Native restconf with several worker processes, see workers in clixon-restconf.yang
+# Check that:
+# - the supervisor forks the workers
+# - requests are served by the workers
+# - a killed worker is restarted by the supervisor
+# - the workers are terminated with the supervisor
+# - workers do not share the backend socket of the supervisor if the restconf config is
+#   read from the backend
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    echo "...skipped: only native restconf"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+# Processes are checked, restconf must be started by this test and not in valgrind
+if [ $RC -eq 0 -o $valgrindtest -eq 3 ]; then
+    echo "...skipped: restconf not started by test"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/workers.yang
+
+# Number of restconf workers
+nr=3
+
+# Define default restconfig config: RESTCONFIG, with workers
+RESTCONFIG=$(restconf_config none false | sed "s/<socket>/<workers>$nr<\/workers><socket>/")
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module workers{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf v{
+         type string;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "kill old restconf daemon"
+stop_restconf_pre
+
+new "start restconf daemon"
+start_restconf -f $cfg
+
+new "wait restconf"
+wait_restconf
+
+new "restconf supervisor and $nr workers running"
+# The oldest process is the supervisor, see restconf_workers_run
+spid=$(pgrep -o -x clixon_restconf)
+if [ -z "$spid" ]; then
+    err "restconf supervisor" "not running"
+fi
+pids=$(pgrep -P $spid -x clixon_restconf)
+if [ $(echo $pids | wc -w) -ne $nr ]; then
+    err "$nr workers" "$pids"
+fi
+
+new "restconf PUT"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c -d '{"workers:c":{"v":"x"}}')" 0 "HTTP/$HVER 201"
+
+# Each request is a new connection that may be accepted by any worker
+for i in $(seq 1 10); do
+    new "restconf GET $i"
+    expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c)" 0 "HTTP/$HVER 200" '{"workers:c":{"v":"x"}}'
+done
+
+new "kill restconf worker"
+wpid=$(echo $pids | awk '{print $1}')
+sudo kill -9 $wpid
+
+# Restart is delayed if the worker was recently started, see RESTCONF_WORKER_RESTART_DELAY
+sleep 2
+
+new "restconf worker restarted"
+pids2=$(pgrep -P $spid -x clixon_restconf)
+if [ $(echo $pids2 | wc -w) -ne $nr ]; then
+    err "$nr workers" "$pids2"
+fi
+for p in $pids2; do
+    if [ $p -eq $wpid ]; then
+	err "new worker" "$wpid still running"
+    fi
+done
+
+for i in $(seq 1 10); do
+    new "restconf GET after restart $i"
+    expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c)" 0 "HTTP/$HVER 200" '{"workers:c":{"v":"x"}}'
+done
+
+new "restconf DELETE"
+expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/workers:c)" 0 "HTTP/$HVER 204"
+
+new "terminate restconf supervisor"
+sudo kill $spid
+sleep 1
+
+new "restconf workers terminated"
+if [ -n "$(pgrep -x clixon_restconf)" ]; then
+    err "no restconf process" "$(pgrep -x clixon_restconf)"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Restconf config in the backend datastore: the supervisor reads it with an rpc before it
+# forks the workers, and the backend starts restconf
+if [ $BE -ne 0 ]; then
+    cfg2=$dir/conf2.xml
+    startupdb=$dir/startup_db
+    RESTCONFDIR=$(dirname $(which clixon_restconf))
+
+    cat <<EOF > $cfg2
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg2</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_INSTALLDIR>$RESTCONFDIR</CLICON_RESTCONF_INSTALLDIR>
+  <CLICON_BACKEND_RESTCONF_PROCESS>true</CLICON_BACKEND_RESTCONF_PROCESS>
+</clixon-config>
+EOF
+
+    cat <<EOF > $startupdb
+<${DATASTORE_TOP}>
+   $(echo "$RESTCONFIG" | sed "s/<restconf>/<restconf $RESTCONFNS>/")
+   <c xmlns="urn:example:clixon"><v>x</v></c>
+</${DATASTORE_TOP}>
+EOF
+
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg2
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s startup -f $cfg2"
+    start_backend -s startup -f $cfg2
+
+    new "wait backend"
+    wait_backend
+
+    new "wait restconf"
+    wait_restconf
+
+    new "restconf supervisor and $nr workers running, config from backend"
+    spid=$(pgrep -o -x clixon_restconf)
+    if [ -z "$spid" ]; then
+	err "restconf supervisor" "not running"
+    fi
+    pids=$(pgrep -P $spid -x clixon_restconf)
+    if [ $(echo $pids | wc -w) -ne $nr ]; then
+	err "$nr workers" "$pids"
+    fi
+
+    # Concurrent requests are served by several workers, each with its own backend socket
+    for i in $(seq 1 20); do
+	curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c > $dir/get$i.out 2>&1 &
+    done
+    wait
+    for i in $(seq 1 20); do
+	new "restconf concurrent GET $i"
+	expectpart "$(cat $dir/get$i.out)" 0 "HTTP/$HVER 200" '{"workers:c":{"v":"x"}}'
+    done
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    stop_backend -f $cfg2
+
+    new "kill restconf"
+    stop_restconf
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
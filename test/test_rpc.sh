@@ -201,6 +201,9 @@ LIST='<u1 xmlns="urn:example:clixon"><uk>bar</uk><val>1</val></u1><u1 xmlns="urn
 new "netconf example rpc input list with non-unique keys (should fail)"
 expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><example xmlns=\"urn:example:clixon\"><x>mandatory</x>$LIST</example></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique><uk>bar</uk></non-unique></error-info></rpc-error></rpc-reply>]]>]]>$"
 
+new "netconf stats rpc callback statistics"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats $LIBNS/></rpc>]]>]]>" "<rpc><namespace>urn:example:clixon</namespace><name>example</name><calls>[1-9][0-9]*</calls><total-time>[0-9]*</total-time><max-time>[0-9]*</max-time></rpc>"
+
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
     stop_restconf 
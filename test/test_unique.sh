@@ -5,7 +5,8 @@
 # The test adds the rfc conf that fails, then one that passes, then makes add
 # to fail it and then del to pass it.
 # Then makes a fail / pass test on the single field case
-# Last, a complex unsorted list with several sub-elements.
+# Then a complex unsorted list with several sub-elements.
+# Last, a list ordered-by user with unique values that concatenate to the same string.
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -71,6 +72,21 @@ module unique{
          type string;
        }
      }
+     list ordered {
+       description "ordered by user with two unique fields";
+       ordered-by user;
+       key "name";
+       unique "x y";
+       leaf name {
+         type string;
+       }
+       leaf x {
+         type string;
+       }
+       leaf y {
+         type string;
+       }
+     }
      leaf b{
        type string;
      }
@@ -209,6 +225,21 @@ expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><
 new "netconf discard-changes"
 expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
 
+new "Add ordered-by user list with unique concatenated values"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><c xmlns=\"urn:example:clixon\"><ordered><name>c</name><x>ab</x><y>c</y></ordered><ordered><name>a</name><x>a</x><y>bc</y></ordered><ordered><name>b</name><x>abc</x></ordered></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate ok"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Add ordered-by user duplicate last"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><ordered><name>d</name><x>ab</x><y>c</y></ordered></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate (should fail)"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique><x>ab</x></non-unique><non-unique><y>c</y></non-unique></error-info></rpc-error></rpc-reply>]]>]]>$"
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
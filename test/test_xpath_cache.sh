@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+# Test xpath cache, see CLICON_XPATH_CACHE_SIZE
+# Must, when and leafref path expressions are parsed when loading YANG and kept in the cache.
+# Check xpath cache statistics of the stats rpc:
+# - schema expressions are cached after start
+# - repeated validation and get with the same xpath filter do not parse again
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/xcache.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XPATH_CACHE_SIZE>16</CLICON_XPATH_CACHE_SIZE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module xcache{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container c{
+    list y {
+      key "name";
+      leaf name {
+        type string;
+      }
+      leaf v {
+        type int32;
+        must ". < 100" {
+          error-message "Too large v";
+        }
+      }
+    }
+    leaf ref {
+      type leafref {
+        path "../ex:y/ex:name";
+      }
+    }
+  }
+}
+EOF
+
+# Get xpath cache statistic from stats rpc
+# @param[in] $1  Name of statistic: hits, misses or entries
+function xcache_stat()
+{
+    name=$1
+
+    res=$(echo "$DEFAULTHELLO<rpc $DEFAULTNS><stats $LIBNS/></rpc>]]>]]>" | $clixon_netconf -qf $cfg)
+    echo "$res" | sed -n "s/.*<xpath-cache-$name>\([0-9]*\)<\/xpath-cache-$name>.*/\1/p"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Schema expressions are cached"
+entries=$(xcache_stat entries)
+if [ -z "$entries" ] || [ "$entries" -lt 2 ]; then
+    err "xpath-cache-entries >= 2" "$entries"
+fi
+
+new "Add config"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><y><name>a</name><v>1</v></y><y><name>b</name><v>2</v></y><ref>a</ref></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Get with xpath filter"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:y[ex:name='b']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><y><name>b</name><v>2</v></y></c></data></rpc-reply>]]>]]>$"
+
+hits0=$(xcache_stat hits)
+misses0=$(xcache_stat misses)
+
+new "Validate again"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Get with same xpath filter"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:y[ex:name='b']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><y><name>b</name><v>2</v></y></c></data></rpc-reply>]]>]]>$"
+
+hits1=$(xcache_stat hits)
+misses1=$(xcache_stat misses)
+
+new "Cache hits increase"
+if [ -z "$hits1" ] || [ "$hits1" -le "$hits0" ]; then
+    err "xpath-cache-hits > $hits0" "$hits1"
+fi
+
+new "No new xpath parsed"
+if [ "$misses1" != "$misses0" ]; then
+    err "xpath-cache-misses $misses0" "$misses1"
+fi
+
+new "Change v over must limit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><y><name>b</name><v>200</v></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Validate cached must fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-message>Too large v</error-message>"
+
+new "Discard changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,118 @@
+#!/usr/bin/env bash
+# Test xpath access plans, see XPATH_LIST_OPTIMIZE
+# Check both result and plan (clixon_util_xpath -e) of:
+# - all keys, key prefix and leaf-list value
+# - explicit search index
+# - numeric range on first key
+# - descendant steps
+# - predicates that cannot be used, eg number literal compared with string key
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:=clixon_util_xpath -Y /usr/local/share/clixon}
+
+ydir=$dir/yang
+xml=$dir/xml.xml
+
+if [ ! -d $ydir ]; then
+    mkdir $ydir
+fi
+
+cat <<EOF > $ydir/plan.yang
+module plan{
+  namespace "urn:example:plan";
+  prefix p;
+  import clixon-config {
+    prefix "cc";
+  }
+  container c{
+    list y{
+      key "k1 k2";
+      leaf k1{
+        type int32;
+      }
+      leaf k2{
+        type string;
+      }
+      leaf i{
+        type string;
+        cc:search_index;
+      }
+      leaf v{
+        type string;
+      }
+    }
+    leaf-list l{
+      type string;
+    }
+    container d{
+      list z{
+        key n;
+        leaf n{
+          type string;
+        }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $xml
+<c xmlns="urn:example:plan">
+  <y><k1>4</k1><k2>a</k2><i>x4</i><v>b</v></y>
+  <y><k1>1</k1><k2>b</k2><i>x2</i><v>a</v></y>
+  <y><k1>1</k1><k2>a</k2><i>x1</i><v>a</v></y>
+  <y><k1>3</k1><k2>a</k2><i>x3</i><v>b</v></y>
+  <y><k1>2</k1><k2>a</k2><i>x5</i><v>a</v></y>
+  <l>b</l><l>a</l>
+  <d><z><n>p</n></z><z><n>q</n></z><z><n>05</n></z></d>
+</c>
+EOF
+
+new "xpath all keys"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k1=1][k2='b']")" 0 "^nodeset:0:<y><k1>1</k1><k2>b</k2><i>x2</i><v>a</v></y>$" "^y: key k1='1' k2='b'$"
+
+new "xpath all keys with and"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k2='a' and k1=3]")" 0 "^nodeset:0:<y><k1>3</k1><k2>a</k2><i>x3</i><v>b</v></y>$" "^y: key k1='3' k2='a'$"
+
+new "xpath key prefix"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k1=1]")" 0 "^nodeset:0:<y><k1>1</k1><k2>a</k2><i>x1</i><v>a</v></y>1:<y><k1>1</k1><k2>b</k2><i>x2</i><v>a</v></y>$" "^y: key-prefix k1='1'$"
+
+new "xpath key prefix and position"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k1=1][2]")" 0 "^nodeset:0:<y><k1>1</k1><k2>b</k2><i>x2</i><v>a</v></y>$" "^y: key-prefix k1='1'$"
+
+new "xpath leaf-list value"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/l[.='b']")" 0 "^nodeset:0:<l>b</l>$" "^l: key .='b'$"
+
+new "xpath search index"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[i='x3']")" 0 "^nodeset:0:<y><k1>3</k1><k2>a</k2><i>x3</i><v>b</v></y>$" "^y: index i='x3'$"
+
+new "xpath range"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k1>1 and k1<=3]")" 0 "^nodeset:0:<y><k1>2</k1><k2>a</k2><i>x5</i><v>a</v></y>1:<y><k1>3</k1><k2>a</k2><i>x3</i><v>b</v></y>$" "^y: range k1>1 k1<=3$"
+
+new "xpath range mirrored"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[3<k1]")" 0 "^nodeset:0:<y><k1>4</k1><k2>a</k2><i>x4</i><v>b</v></y>$" "^y: range k1>3$"
+
+new "xpath range and non-key"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k1>=2][v='b']")" 0 "^nodeset:0:<y><k1>3</k1><k2>a</k2><i>x3</i><v>b</v></y>1:<y><k1>4</k1><k2>a</k2><i>x4</i><v>b</v></y>$" "^y: range k1>=2$"
+
+new "xpath non-key scan"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[v='b']")" 0 "^nodeset:0:<y><k1>3</k1><k2>a</k2><i>x3</i><v>b</v></y>1:<y><k1>4</k1><k2>a</k2><i>x4</i><v>b</v></y>$" "^y: scan$"
+
+new "xpath or is not used"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/y[k1=1 or k1=4][k2='a']")" 0 "^nodeset:0:<y><k1>1</k1><k2>a</k2><i>x1</i><v>a</v></y>1:<y><k1>4</k1><k2>a</k2><i>x4</i><v>b</v></y>$" "^y: scan$"
+
+new "xpath number literal and string key is not used"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "/c/d/z[n=5]")" 0 "^nodeset:0:<z><n>05</n></z>$" "^z: scan$"
+
+new "xpath descendant"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "//z[n='q']")" 0 "^nodeset:0:<z><n>q</n></z>$" "^//z: descendant$"
+
+new "xpath descendant all"
+expectpart "$($clixon_util_xpath -e -f $xml -y $ydir -p "//k2")" 0 "^nodeset:0:<k2>a</k2>1:<k2>b</k2>2:<k2>a</k2>3:<k2>a</k2>4:<k2>a</k2>$" "^//k2: descendant$"
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,131 @@
+#!/usr/bin/env bash
+# Yang child index and precomputed yang order, see yang_index_build
+# Check binding and sorting of nodes among many siblings:
+# - data nodes in choice/case and shortcut case
+# - nodes augmented from another module after the target is indexed
+# - sibling order follows yang order
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/yindex.yang
+fyang2=$dir/yindex-aug.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_MODULE_MAIN>yindex-aug</CLICON_YANG_MODULE_MAIN>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module yindex{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container c{
+    leaf a0 { type string; }
+    leaf a1 { type string; }
+    leaf a2 { type string; }
+    choice ch {
+      case c1 {
+        leaf b0 { type string; }
+        leaf b1 { type string; }
+      }
+      case c2 {
+        leaf b2 { type string; }
+      }
+    }
+    leaf a3 { type string; }
+    choice sh {
+      leaf s0 { type string; }
+      leaf s1 { type string; }
+    }
+    leaf a4 { type string; }
+    leaf a5 { type string; }
+    leaf a6 { type string; }
+    leaf a7 { type string; }
+    leaf a8 { type string; }
+    leaf a9 { type string; }
+  }
+}
+EOF
+
+cat <<EOF > $fyang2
+module yindex-aug{
+  yang-version 1.1;
+  namespace "urn:example:aug";
+  prefix aug;
+  import yindex {
+    prefix ex;
+  }
+  augment "/ex:c" {
+    leaf x0 { type string; }
+    leaf x1 { type string; }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add siblings in reverse order"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x1 xmlns=\"urn:example:aug\">x1</x1><x0 xmlns=\"urn:example:aug\">x0</x0><a9>9</a9><a8>8</a8><a5>5</a5><s1>s1</s1><a3>3</a3><b1>b1</b1><b0>b0</b0><a2>2</a2><a0>0</a0></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Get siblings in yang order"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a0>0</a0><a2>2</a2><b0>b0</b0><b1>b1</b1><a3>3</a3><s1>s1</s1><a5>5</a5><a8>8</a8><a9>9</a9><x0 xmlns=\"urn:example:aug\">x0</x0><x1 xmlns=\"urn:example:aug\">x1</x1></c></data></rpc-reply>]]>]]>$"
+
+new "Validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Replace case c1 with c2"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><b2>b2</b2></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "Get choice node"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c/ex:b2\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><b2>b2</b2></c></data></rpc-reply>]]>]]>$"
+
+new "Unknown node among many siblings"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a10>10</a10></c></config></edit-config></rpc>]]>]]>" "<error-tag>unknown-element</error-tag>"
+
+new "Discard changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
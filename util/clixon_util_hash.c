@@ -0,0 +1,206 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Benchmark of the clixon hash table (clixon_hash.c)
+  * Add <nr> keys, look up all keys <rounds> times, and delete all keys.
+  * The delete time includes lookups of the remaining keys after every second delete.
+  * Keys are on the form of option names, eg CLICON_KEY_17.
+  * Prints time per operation in nanoseconds and exits with -1 if a lookup fails.
+  * Example:
+  *   clixon_util_hash -n 10000 -r 100
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level> \tDebug\n"
+	    "\t-n <nr> \tNumber of keys (default: 10000)\n"
+	    "\t-r <rounds> \tNumber of lookups of all keys (default: 100)\n"
+	    ,
+	    argv0);
+    exit(0);
+}
+
+/*! Print time per operation in nanoseconds
+ */
+static void
+hash_time_print(char           *op,
+		struct timeval *t0,
+		uint64_t        nr)
+{
+    struct timeval t1;
+    uint64_t       ns;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &t1);
+    ns = ((uint64_t)t1.tv_sec*1000000 + t1.tv_usec)*1000;
+    fprintf(stdout, "%s:\t%" PRIu64 " ns/op (%" PRIu64 " ops, %ld.%06ld s)\n",
+	    op, nr?ns/nr:0, nr, (long)t1.tv_sec, (long)t1.tv_usec);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int            retval = -1;
+    int            c;
+    int            dbg = 0;
+    int            nr = 10000;
+    int            rounds = 100;
+    int            i;
+    int            j;
+    char         **keys = NULL;
+    clicon_hash_t *hash = NULL;
+    int           *v;
+    size_t         len;
+    struct timeval t0;
+
+    clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, "hD:n:r:")) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv[0]);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv[0]);
+	    break;
+	case 'n':
+	    if ((nr = atoi(optarg)) <= 0)
+		usage(argv[0]);
+	    break;
+	case 'r':
+	    if ((rounds = atoi(optarg)) < 0)
+		usage(argv[0]);
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR);
+    clicon_debug_init(dbg, NULL);
+
+    /* Generate keys before timing */
+    if ((keys = calloc(nr, sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nr; i++){
+	len = strlen("CLICON_KEY_") + 12;
+	if ((keys[i] = malloc(len)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	snprintf(keys[i], len, "CLICON_KEY_%d", i);
+    }
+    if ((hash = clicon_hash_init()) == NULL)
+	goto done;
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++)
+	if (clicon_hash_add(hash, keys[i], &i, sizeof(i)) == NULL)
+	    goto done;
+    hash_time_print("add", &t0, nr);
+    gettimeofday(&t0, NULL);
+    for (j=0; j<rounds; j++)
+	for (i=0; i<nr; i++)
+	    if ((v = clicon_hash_value(hash, keys[i], NULL)) == NULL || *v != i){
+		clicon_err(OE_UNIX, 0, "lookup of %s failed", keys[i]);
+		goto done;
+	    }
+    hash_time_print("lookup", &t0, (uint64_t)nr*rounds);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++)
+	if (clicon_hash_lookup(hash, "CLICON_NOKEY") != NULL){
+	    clicon_err(OE_UNIX, 0, "lookup of nonexistent key succeeded");
+	    goto done;
+	}
+    hash_time_print("miss", &t0, nr);
+    /* Delete every second key, check the rest remain, then delete the rest */
+    gettimeofday(&t0, NULL);
+    for (j=0; j<2; j++)
+	for (i=j; i<nr; i+=2)
+	    if (clicon_hash_del(hash, keys[i]) < 0){
+		clicon_err(OE_UNIX, 0, "delete of %s failed", keys[i]);
+		goto done;
+	    }
+	    else if (j == 0 && i+1 < nr &&
+		     ((v = clicon_hash_value(hash, keys[i+1], NULL)) == NULL || *v != i+1)){
+		clicon_err(OE_UNIX, 0, "lookup of %s after delete failed", keys[i+1]);
+		goto done;
+	    }
+    hash_time_print("delete", &t0, nr);
+    if (clicon_hash_keys(hash, NULL, &len) < 0)
+	goto done;
+    if (len != 0){
+	clicon_err(OE_UNIX, 0, "%zu keys remain after delete", len);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (hash)
+	clicon_hash_free(hash);
+    if (keys){
+	for (i=0; i<nr; i++)
+	    if (keys[i])
+		free(keys[i]);
+	free(keys);
+    }
+    return retval;
+}
@@ -54,6 +54,7 @@
 #include <fcntl.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <arpa/inet.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -72,6 +73,7 @@ usage(char *argv0)
 	    "\t-s <sockpath> \tPath to unix domain socket (or IP addr)\n"
 	    "\t-f <file>\tXML input file (overrides stdin)\n"
 	    "\t-J \t\tInput as JSON (instead of XML)\n"
+	    "\t-P <sec>\tSend first half of message, pause, then send the rest\n"
 	    ,
 	    argv0);
     exit(0);
@@ -99,6 +101,10 @@ main(int    argc,
     clicon_handle      h;
     int                dbg = 0;
     int                s;
+    int                pause = 0;
+    uint32_t           len;
+    struct clicon_msg *reply = NULL;
+    int                eof = 0;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
@@ -108,7 +114,7 @@ main(int    argc,
 
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:s:f:Ja:")) != -1)
+    while ((c = getopt(argc, argv, "hD:s:f:Ja:P:")) != -1)
 	switch (c) {
 	case 'h':
 	    usage(argv[0]);
@@ -129,6 +135,10 @@ main(int    argc,
 	case 'a':
 	    family = optarg;
 	    break;
+	case 'P':
+	    if (sscanf(optarg, "%d", &pause) != 1)
+		usage(argv[0]);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -176,10 +186,32 @@ main(int    argc,
     else
 	if (clicon_rpc_connect_inet(h, sockpath, 4535, &s) < 0)
 	    goto done;
-    if (clicon_rpc(s, msg, &retdata) < 0)
-	goto done;
+    if (pause){
+	/* Slow client: the backend receives a partial message */
+	len = ntohl(msg->op_len);
+	if (write(s, msg, len/2) < 0){
+	    clicon_err(OE_UNIX, errno, "write");
+	    goto done;
+	}
+	sleep(pause);
+	if (write(s, (char*)msg + len/2, len - len/2) < 0){
+	    clicon_err(OE_UNIX, errno, "write");
+	    goto done;
+	}
+	if (clicon_msg_rcv(s, &reply, &eof) < 0)
+	    goto done;
+	if (eof){
+	    clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of socket");
+	    goto done;
+	}
+	fprintf(stdout, "%s\n", reply->op_body);
+    }
+    else{
+	if (clicon_rpc(s, msg, &retdata) < 0)
+	    goto done;
+	fprintf(stdout, "%s\n", retdata);
+    }
     close(s);
-    fprintf(stdout, "%s\n", retdata);
     retval = 0;
  done:
     if (fp)
@@ -190,6 +222,8 @@ main(int    argc,
 	xml_free(xt);
     if (msg)
 	free(msg);
+    if (reply)
+	free(reply);
     if (cb)
 	cbuf_free(cb);
     return retval;
@@ -59,7 +59,7 @@ See https://www.w3.org/TR/xpath/
 #include "clixon/clixon.h"
 
 /* Command line options to be passed to getopt(3) */
-#define XPATH_OPTS "hD:f:p:i:n:cl:y:Y:"
+#define XPATH_OPTS "hD:f:p:i:n:cel:y:Y:"
 
 static int
 usage(char *argv0)
@@ -73,6 +73,7 @@ usage(char *argv0)
 	    "\t-i <xpath0>\t(optional) Initial XPATH string\n"
 	    "\t-n <pfx:id>\tNamespace binding (pfx=NULL for default)\n"
 	    "\t-c \t\tMap xpath to canonical form\n"
+	    "\t-e \t\tExplain: print access plan of xpath steps after result\n"
 	    "\t-l <s|e|o|f<file>> \tLog on (s)yslog, std(e)rr, std(o)ut or (f)ile (stderr is default)\n"
 	    "\t-y <filename> \tYang filename or dir (load all files)\n"
     	    "\t-Y <dir> \tYang dirs (can be several)\n"
@@ -143,6 +144,7 @@ main(int    argc,
     cxobj      *xerr = NULL; /* malloced must be freed */
     int         logdst = CLICON_LOG_STDERR;
     int         dbg = 0;
+    cbuf       *cbexplain = NULL;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init("xpath", LOG_DEBUG, logdst); 
@@ -202,6 +204,12 @@ main(int    argc,
 	case 'c': /* Map namespace to canonical form */
 	    canonical = 1;
 	    break;
+	case 'e': /* Explain xpath plan */
+	    if ((cbexplain = cbuf_new()) == NULL){
+		clicon_err(OE_XML, errno, "cbuf_new");
+		goto done;
+	    }
+	    break;
 	case 'l': /* Log destination: s|e|o|f */
 	    if ((logdst = clicon_log_opt(optarg[0])) < 0)
 		usage(argv[0]);
@@ -352,17 +360,24 @@ main(int    argc,
     }
     else
 	x = x0;
+    if (cbexplain)
+	xpath_optimize_explain(cbexplain);
     if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
 	return -1;
+    xpath_optimize_explain(NULL);
     /* Print results */
     cb = cbuf_new();
     ctx_print2(cb, xc);
     fprintf(stdout, "%s\n", cbuf_get(cb));
+    if (cbexplain)
+	fprintf(stdout, "%s", cbuf_get(cbexplain));
  ok:
     retval = 0;
  done:
     if (cb)
 	cbuf_free(cb);
+    if (cbexplain)
+	cbuf_free(cbexplain);
     if (nsc)
 	xml_nsctx_free(nsc);
     if (xc)